@@ -34,6 +34,10 @@
 
 #include <cassert>
 
+#if defined(_MSC_VER) && !defined(__GNUC__)
+#include <intrin.h>
+#endif
+
 /* === M A C R O S ========================================================= */
 
 /* === T Y P E D E F S ===================================================== */
@@ -57,23 +61,136 @@ template <class T> class loose_handle;
 template <class T> class rhandle;
 
 
+// ========================================================================
+/*!	\class	atomic_counter _handle.h	ETL/handle
+**	\brief	Integer which may be changed from several threads at once
+**
+**	Increments are relaxed. A decrement releases the writes made before it
+**	and acquires those released by the others, so whoever brings a reference
+**	count to zero sees every change made through the other references and
+**	may delete the object right away.
+*/
+class atomic_counter
+{
+public:
+#if defined(_MSC_VER) && !defined(__GNUC__)
+	typedef long value_type;
+#else
+	typedef int value_type;
+#endif
+
+private:
+	volatile value_type value_;
+
+public:
+	atomic_counter(value_type x=0):value_(x) { }
+
+#if defined(__ATOMIC_ACQ_REL)
+	value_type get()const { return __atomic_load_n(&value_, __ATOMIC_RELAXED); }
+	void set(value_type x) { __atomic_store_n(&value_, x, __ATOMIC_RELAXED); }
+	value_type increment() { return __atomic_add_fetch(&value_, 1, __ATOMIC_RELAXED); }
+	value_type decrement() { return __atomic_sub_fetch(&value_, 1, __ATOMIC_ACQ_REL); }
+	bool increment_if_nonzero()
+	{
+		value_type x = __atomic_load_n(&value_, __ATOMIC_RELAXED);
+		while(x > 0)
+			if(__atomic_compare_exchange_n(&value_, &x, x+1, true, __ATOMIC_RELAXED, __ATOMIC_RELAXED))
+				return true;
+		return false;
+	}
+#elif defined(__GNUC__)
+	value_type get()const { return value_; }
+	void set(value_type x) { value_ = x; }
+	value_type increment() { return __sync_add_and_fetch(&value_, 1); }
+	value_type decrement() { return __sync_sub_and_fetch(&value_, 1); }
+	bool increment_if_nonzero()
+	{
+		for(value_type x = value_; x > 0; x = value_)
+			if(__sync_bool_compare_and_swap(&value_, x, x+1))
+				return true;
+		return false;
+	}
+#elif defined(_MSC_VER)
+	value_type get()const { return value_; }
+	void set(value_type x) { value_ = x; }
+	value_type increment() { return _InterlockedIncrement(&value_); }
+	value_type decrement() { return _InterlockedDecrement(&value_); }
+	bool increment_if_nonzero()
+	{
+		for(value_type x = value_; x > 0; x = value_)
+			if(_InterlockedCompareExchange(&value_, x+1, x) == x)
+				return true;
+		return false;
+	}
+#else
+	// no atomic operations are known for this compiler
+	value_type get()const { return value_; }
+	void set(value_type x) { value_ = x; }
+	value_type increment() { return ++value_; }
+	value_type decrement() { return --value_; }
+	bool increment_if_nonzero() { return value_ > 0 && ++value_; }
+#endif
+}; // END of class atomic_counter
+
+// ========================================================================
+/*!	\class	atomic_pointer _handle.h	ETL/handle
+**	\brief	Pointer published by one thread and read by the others
+**
+**	set() releases the writes made before it and get() acquires them, so
+**	an object built and then set() is seen complete by whoever get()s it.
+*/
+template <class T>
+class atomic_pointer
+{
+private:
+	T * volatile value_;
+
+	// Non-copyable
+	atomic_pointer(const atomic_pointer&);
+	void operator=(const atomic_pointer&);
+
+public:
+	atomic_pointer(T *x=0):value_(x) { }
+
+#if defined(__ATOMIC_ACQ_REL)
+	T* get()const { return __atomic_load_n(&value_, __ATOMIC_ACQUIRE); }
+	void set(T *x) { __atomic_store_n(&value_, x, __ATOMIC_RELEASE); }
+#elif defined(__GNUC__)
+	T* get()const { T *x = value_; __sync_synchronize(); return x; }
+	void set(T *x) { __sync_synchronize(); value_ = x; }
+#elif defined(_MSC_VER)
+	// the interlocked functions are full barriers on every architecture
+	T* get()const { return (T*)_InterlockedCompareExchangePointer((void* volatile*)&value_, 0, 0); }
+	void set(T *x) { _InterlockedExchangePointer((void* volatile*)&value_, (void*)x); }
+#else
+	// no atomic operations are known for this compiler
+	T* get()const { return value_; }
+	void set(T *x) { value_ = x; }
+#endif
+}; // END of class atomic_pointer
+
 // ========================================================================
 /*!	\class	shared_object _handle.h	ETL/handle
 **	\brief	Shared Object Base Class
-**	\see handle, loose_handle
-**	\writeme
+**	\see handle, loose_handle, local_shared_object
+**
+**	The reference count is atomic, so handles to one object may be copied
+**	and released from any thread without locking.
 */
 class shared_object
 {
 private:
-	mutable int refcount;
-#ifdef ETL_LOCK_REFCOUNTS
-	mutable etl::mutex mtx;
-#endif
+	mutable atomic_counter refcount;
 
 protected:
 	shared_object():refcount(0) { }
 
+	//! A copy is a new object, no handle refers to it yet
+	shared_object(const shared_object&):refcount(0) { }
+
+	//! Assignment leaves the references to either object alone
+	shared_object& operator=(const shared_object&) { return *this; }
+
 #ifdef ETL_SELF_DELETING_SHARED_OBJECT
 	virtual ~shared_object() { }
 #else
@@ -83,63 +200,106 @@ protected:
 public:
 	virtual void ref()const
 	{
-#ifdef ETL_LOCK_REFCOUNTS
-		etl::mutex::lock lock(mtx);
-#endif
-		assert(refcount>=0);
-		refcount++;
+		assert(refcount.get()>=0);
+		refcount.increment();
 	}
 
 	//! Returns \c false if object needs to be deleted
 	virtual bool unref()const
 	{
-		bool ret = true;
-		{
-#ifdef ETL_LOCK_REFCOUNTS
-			etl::mutex::lock lock(mtx);
-#endif
-			assert(refcount>0);
-
-			refcount--;
+		assert(refcount.get()>0);
 
-			if(refcount==0) {
-				ret = false;
-#ifdef ETL_SELF_DELETING_SHARED_OBJECT
-				refcount=-666;
-#endif
-			}
-		}
+		if(refcount.decrement()!=0)
+			return true;
 
 #ifdef ETL_SELF_DELETING_SHARED_OBJECT
-		if (!ret)
-			delete this;
+		refcount.set(-666);
+		delete this;
 #endif
-		return ret;
+		return false;
 	}
 
 	//! Decrease reference counter without deletion of object
 	//! Returns \c false if references exeed and object should be deleted
 	virtual bool unref_inactive()const
 	{
-		bool ret = true;
-		{
-#ifdef ETL_LOCK_REFCOUNTS
-			etl::mutex::lock lock(mtx);
+		assert(refcount.get()>0);
+		return refcount.decrement()!=0;
+	}
+
+	//! Takes a reference unless the last one is already gone
+	/*!	For registries which keep loose handles to their objects: an object
+	**	whose count reached zero is being deleted by another thread and may
+	**	not be handed out again.
+	**	\return \c false if the object is being deleted */
+	bool ref_if_alive()const { return refcount.increment_if_nonzero(); }
+
+	int count()const { return refcount.get(); }
+
+}; // END of class shared_object
+
+// ========================================================================
+/*!	\class	local_shared_object _handle.h	ETL/handle
+**	\brief	Shared Object Base Class for objects used by a single thread
+**	\see handle, loose_handle, shared_object
+**
+**	Same as shared_object, but the reference count is a plain integer.
+**	Handles to such an object must never be copied or released by two
+**	threads at once.
+*/
+class local_shared_object
+{
+private:
+	mutable int refcount;
+
+protected:
+	local_shared_object():refcount(0) { }
+
+	//! A copy is a new object, no handle refers to it yet
+	local_shared_object(const local_shared_object&):refcount(0) { }
+
+	//! Assignment leaves the references to either object alone
+	local_shared_object& operator=(const local_shared_object&) { return *this; }
+
+#ifdef ETL_SELF_DELETING_SHARED_OBJECT
+	virtual ~local_shared_object() { }
+#else
+	~local_shared_object() { }
 #endif
-			assert(refcount>0);
 
-			refcount--;
+public:
+	void ref()const
+	{
+		assert(refcount>=0);
+		refcount++;
+	}
 
-			if(refcount==0)
-				ret = false;
-		}
+	//! Returns \c false if object needs to be deleted
+	bool unref()const
+	{
+		assert(refcount>0);
 
-		return ret;
+		if(--refcount!=0)
+			return true;
+
+#ifdef ETL_SELF_DELETING_SHARED_OBJECT
+		refcount=-666;
+		delete this;
+#endif
+		return false;
+	}
+
+	//! Decrease reference counter without deletion of object
+	//! Returns \c false if references exeed and object should be deleted
+	bool unref_inactive()const
+	{
+		assert(refcount>0);
+		return --refcount!=0;
 	}
 
 	int count()const { return refcount; }
 
-}; // END of class shared_object
+}; // END of class local_shared_object
 
 // ========================================================================
 /*!	\class	virtual_shared_object _handle.h	ETL/handle
@@ -350,7 +510,7 @@ public:
 class rshared_object : public shared_object
 {
 private:
-	mutable int rrefcount;
+	mutable atomic_counter rrefcount;
 
 public:
 	void *front_;
@@ -359,18 +519,24 @@ public:
 protected:
 	rshared_object():rrefcount(0),front_(0),back_(0) { }
 
+	//! A copy is a new object, no rhandle refers to it yet
+	rshared_object(const rshared_object &x):shared_object(x),rrefcount(0),front_(0),back_(0) { }
+
+	//! Assignment leaves the rhandles to either object alone
+	rshared_object& operator=(const rshared_object&) { return *this; }
+
 public:
 	virtual void rref()const
-		{ rrefcount++; }
+		{ rrefcount.increment(); }
 
 	virtual void runref()const
 	{
-		assert(rrefcount>0);
-		rrefcount--;
+		assert(rrefcount.get()>0);
+		rrefcount.decrement();
 	}
 
 	int rcount()const
-		{ return rrefcount; }
+		{ return rrefcount.get(); }
 }; // END of class rshared_object
 
 // ========================================================================
@@ -0,0 +1,223 @@
+/*! ========================================================================
+** Extended Template and Library Test Suite
+** Handle Reference Counting Across Threads Test
+** $Id$
+**
+** Copyright (c) 2016 Synfig contributors
+**
+** This package is free software; you can redistribute it and/or
+** modify it under the terms of the GNU General Public License as
+** published by the Free Software Foundation; either version 2 of
+** the License, or (at your option) any later version.
+**
+** This package is distributed in the hope that it will be useful,
+** but WITHOUT ANY WARRANTY; without even the implied warranty of
+** MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+** General Public License for more details.
+**
+** === N O T E S ===========================================================
+**
+** ========================================================================= */
+
+/* === H E A D E R S ======================================================= */
+
+#include <ETL/handle>
+#include <ETL/clock>
+#include <ETL/mutex>
+#include <pthread.h>
+#include <stdio.h>
+#include <vector>
+
+/* === M A C R O S ========================================================= */
+
+#define MAX_THREADS		8
+#define COPY_ITERATIONS	2000000
+#define DELETE_ROUNDS	20000
+
+using namespace std;
+
+/* === C L A S S E S ======================================================= */
+
+struct my_test_obj : public etl::shared_object
+{
+	static etl::atomic_counter instance_count;
+	my_test_obj() { instance_count.increment(); }
+	virtual ~my_test_obj() { instance_count.decrement(); }
+};
+
+etl::atomic_counter my_test_obj::instance_count;
+
+struct my_local_obj : public etl::local_shared_object { };
+
+//! Reference counted the way shared_object was before it used atomic operations
+struct my_locked_obj
+{
+	mutable int refcount;
+	mutable etl::mutex mtx;
+
+	my_locked_obj():refcount(0) { }
+	virtual ~my_locked_obj() { }
+
+	virtual void ref()const
+	{
+		etl::mutex::lock lock(mtx);
+		refcount++;
+	}
+
+	virtual bool unref()const
+	{
+		bool ret = true;
+		{
+			etl::mutex::lock lock(mtx);
+			if(--refcount==0)
+				ret = false;
+		}
+		if (!ret)
+			delete this;
+		return ret;
+	}
+
+	int count()const { return refcount; }
+};
+
+template <class T>
+struct copy_job
+{
+	etl::handle<T> object;
+	int iterations;
+	pthread_t thread;
+
+	//! Copies and releases the handle over and over
+	static void *run(void *x)
+	{
+		copy_job &job = *static_cast<copy_job*>(x);
+		for(int i = 0; i < job.iterations; i++)
+		{
+			etl::handle<T> copy(job.object);
+			etl::handle<T> other;
+			other = copy;
+		}
+		return NULL;
+	}
+};
+
+struct release_job
+{
+	etl::handle<my_test_obj> object;
+	pthread_t thread;
+
+	static void *run(void *x)
+	{
+		static_cast<release_job*>(x)->object.reset();
+		return NULL;
+	}
+};
+
+/* === P R O C E D U R E S ================================================= */
+
+//! Runs copy_job on \a threads threads, each on its own object or all on \a shared
+template <class T>
+double copy_threads(int threads, int iterations, const etl::handle<T> &shared)
+{
+	vector<copy_job<T> > jobs(threads);
+	etl::clock timer;
+	for(int i = 0; i < threads; i++)
+	{
+		jobs[i].object = shared ? shared : etl::handle<T>(new T());
+		jobs[i].iterations = iterations;
+		pthread_create(&jobs[i].thread, NULL, copy_job<T>::run, &jobs[i]);
+	}
+	for(int i = 0; i < threads; i++)
+		pthread_join(jobs[i].thread, NULL);
+	return timer();
+}
+
+int handle_copy_test(void)
+{
+	printf("handle: copy from several threads test: ");
+
+	{
+		etl::handle<my_test_obj> object(new my_test_obj());
+		copy_threads(MAX_THREADS, COPY_ITERATIONS/10, object);
+		if(object.count()!=1)
+		{
+			printf("FAILED!\n");
+			printf(__FILE__":%d: after copies in %d threads, count=%d, should be 1.\n",__LINE__,MAX_THREADS,object.count());
+			return 1;
+		}
+	}
+
+	if(my_test_obj::instance_count.get()!=0)
+	{
+		printf("FAILED!\n");
+		printf(__FILE__":%d: on release, instance count=%d, should be 0.\n",__LINE__,my_test_obj::instance_count.get());
+		return 1;
+	}
+
+	printf("PASSED\n");
+	return 0;
+}
+
+int handle_release_test(void)
+{
+	printf("handle: release from several threads test: ");
+
+	release_job jobs[MAX_THREADS];
+	for(int round = 0; round < DELETE_ROUNDS; round++)
+	{
+		{
+			etl::handle<my_test_obj> object(new my_test_obj());
+			for(int i = 0; i < MAX_THREADS; i++)
+				jobs[i].object = object;
+		}
+		for(int i = 0; i < MAX_THREADS; i++)
+			pthread_create(&jobs[i].thread, NULL, release_job::run, &jobs[i]);
+		for(int i = 0; i < MAX_THREADS; i++)
+			pthread_join(jobs[i].thread, NULL);
+
+		if(my_test_obj::instance_count.get()!=0)
+		{
+			printf("FAILED!\n");
+			printf(__FILE__":%d: in round %d, instance count=%d, should be 0.\n",__LINE__,round,my_test_obj::instance_count.get());
+			return 1;
+		}
+	}
+
+	printf("PASSED\n");
+	return 0;
+}
+
+template <class T>
+void copy_benchmark(const char *name)
+{
+	printf("handle: %-20s", name);
+	for(int threads = 1; threads <= MAX_THREADS; threads *= 2)
+	{
+		double separate = copy_threads<T>(threads, COPY_ITERATIONS, etl::handle<T>());
+		double shared = copy_threads<T>(threads, COPY_ITERATIONS, etl::handle<T>(new T()));
+		printf("  %d: %6.1f/%6.1f", threads,
+			threads*COPY_ITERATIONS/separate*1e-6, threads*COPY_ITERATIONS/shared*1e-6);
+	}
+	printf("\n");
+}
+
+int main()
+{
+	int error=0;
+
+	error+=handle_copy_test();
+	error+=handle_release_test();
+
+	printf("handle: copies per second (millions) by thread count, each thread on its own object / all on one\n");
+	copy_benchmark<my_locked_obj>("mutex");
+	copy_benchmark<my_test_obj>("shared_object");
+
+	printf("handle: %-20s", "local_shared_object");
+	{
+		etl::handle<my_local_obj> object(new my_local_obj());
+		double time = copy_threads<my_local_obj>(1, COPY_ITERATIONS, object);
+		printf("  1: %6.1f\n", COPY_ITERATIONS/time*1e-6);
+	}
+
+	return error;
+}
@@ -42,6 +42,7 @@
 #include "lyr_freetype.h"
 #endif
 #include <synfig/cairo_renddesc.h>
+#include <synfig/loadqueue.h>
 #include <pango/pangocairo.h>
 
 using namespace std;
@@ -68,6 +69,28 @@ SYNFIG_LAYER_SET_CATEGORY(Layer_Freetype,N_("Other"));
 SYNFIG_LAYER_SET_VERSION(Layer_Freetype,"0.2");
 SYNFIG_LAYER_SET_CVS_ID(Layer_Freetype,"$Id$");
 
+//! Faces are created through the one ft_library, which is not thread safe
+static Mutex face_mutex;
+
+/* === C L A S S E S ======================================================= */
+
+class Layer_Freetype::LoadTask: public LoadQueue::Task
+{
+	etl::handle<Layer_Freetype> layer;
+
+public:
+	explicit LoadTask(Layer_Freetype &layer): layer(&layer) { }
+
+	virtual void run()
+	{
+		Mutex::Lock lock(layer->mutex);
+		Mutex::Lock face_lock(face_mutex);
+		layer->font_queued_=false;
+		layer->new_font(layer->param_family.get(synfig::String()),
+			layer->param_style.get(int()), layer->param_weight.get(int()));
+	}
+};
+
 /* === P R O C E D U R E S ================================================= */
 
 /*Glyph::~Glyph()
@@ -92,6 +115,7 @@ TextLine::clear_and_free()
 Layer_Freetype::Layer_Freetype()
 {
 	face=0;
+	font_queued_=false;
 
 	param_size=ValueBase(Vector(0.25,0.25));
 	param_text=ValueBase(_("Text Layer"));
@@ -113,11 +137,7 @@ Layer_Freetype::Layer_Freetype()
 	set_blend_method(Color::BLEND_COMPOSITE);
 	needs_sync_=true;
 
-	synfig::String family=param_family.get(synfig::String());
-	int style=param_style.get(int());
-	int weight=param_weight.get(int());
-
-	new_font(family,style,weight);
+	load_font();
 
 	SET_INTERPOLATION_DEFAULTS();
 	SET_STATIC_DEFAULTS();
@@ -125,10 +145,31 @@ Layer_Freetype::Layer_Freetype()
 
 Layer_Freetype::~Layer_Freetype()
 {
+	Mutex::Lock lock(face_mutex);
 	if(face)
 		FT_Done_Face(face);
 }
 
+void
+Layer_Freetype::load_font()
+{
+	// A layer read from a document gets its family, style and weight one
+	// after the other, so the face is looked up once, when all of them are
+	// known, and along with the other files of the document
+	if(LoadQueue *queue = LoadQueue::current())
+	{
+		if(!font_queued_)
+		{
+			font_queued_=true;
+			queue->push(new LoadTask(*this));
+		}
+		return;
+	}
+
+	Mutex::Lock lock(face_mutex);
+	new_font(param_family.get(synfig::String()), param_style.get(int()), param_weight.get(int()));
+}
+
 void
 Layer_Freetype::new_font(const synfig::String &family, int style, int weight)
 {
@@ -471,31 +512,10 @@ Layer_Freetype::set_param(const String & param, const ValueBase &value)
 		return true;
 	}
 */
-	IMPORT_VALUE_PLUS(param_family,
-		{
-			synfig::String family=param_family.get(synfig::String());
-			int style=param_style.get(int());
-			int weight=param_weight.get(int());
-			new_font(family,style,weight);
-		}
-		);
+	IMPORT_VALUE_PLUS(param_family,load_font());
 		
-	IMPORT_VALUE_PLUS(param_weight,
-		{
-			synfig::String family=param_family.get(synfig::String());
-			int style=param_style.get(int());
-			int weight=param_weight.get(int());
-			new_font(family,style,weight);
-		}
-		);
-	IMPORT_VALUE_PLUS(param_style,
-		{
-			synfig::String family=param_family.get(synfig::String());
-			int style=param_style.get(int());
-			int weight=param_weight.get(int());
-			new_font(family,style,weight);
-		}
-		);
+	IMPORT_VALUE_PLUS(param_weight,load_font());
+	IMPORT_VALUE_PLUS(param_style,load_font());
 	IMPORT_VALUE_PLUS(param_size,
 		{
 			if(old_version)
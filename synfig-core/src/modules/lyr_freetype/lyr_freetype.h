@@ -145,6 +145,12 @@ private:
 
 	bool old_version;
 	bool needs_sync_;
+	//! Whether a LoadTask will look up the face
+	bool font_queued_;
+
+	//! Looks up the face of the layer, see LoadQueue
+	class LoadTask;
+	friend class LoadTask;
 
 	void sync();
 
@@ -170,6 +176,8 @@ public:
 	virtual synfig::Rect get_bounding_rect()const;
 
 private:
+	//! Looks up the face for the family, style and weight parameters, later if a document is being opened
+	void load_font();
 	void new_font(const synfig::String &family, int style=0, int weight=400);
 	bool new_font_(const synfig::String &family, int style=0, int weight=400);
 	bool new_face(const synfig::String &newfont);
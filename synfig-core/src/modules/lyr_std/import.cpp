@@ -44,6 +44,7 @@
 #include <synfig/valuenode.h>
 #include <synfig/canvas.h>
 #include <synfig/filesystemnative.h>
+#include <synfig/loadqueue.h>
 
 #endif
 
@@ -64,6 +65,83 @@ SYNFIG_LAYER_SET_CVS_ID(Import,"$Id$");
 
 /* === P R O C E D U R E S ================================================= */
 
+/* === C L A S S E S ======================================================= */
+
+class Import::LoadTask: public LoadQueue::Task
+{
+	Import *layer;
+	//! Reference to \c layer while the task is queued
+	etl::handle<Import> queued_layer;
+	String filename_with_path;
+	FileSystem::Identifier identifier, fallback;
+	RendDesc rend_desc;
+
+	Importer::Handle importer;
+	Surface surface;
+	bool trimmed;
+	unsigned int width, height, top, left;
+
+public:
+	LoadTask(Import &layer, const String &filename_with_path,
+	         const FileSystem::Identifier &identifier, const FileSystem::Identifier &fallback):
+		layer(&layer),
+		filename_with_path(filename_with_path),
+		identifier(identifier),
+		fallback(fallback),
+		rend_desc(layer.get_canvas()->rend_desc()),
+		trimmed(false), width(0), height(0), top(0), left(0)
+	{ }
+
+	virtual void run()
+	{
+		try
+		{
+			importer=Importer::open(identifier);
+			if(!importer)
+				importer=Importer::open(fallback);
+			if(importer && !importer->get_frame(surface,rend_desc,Time(0),trimmed,width,height,top,left))
+				synfig::warning(strprintf("Unable to get frame from \"%s\"",filename_with_path.c_str()));
+		}
+		catch(...) { importer=0; }
+	}
+
+	virtual void finish()
+	{
+		// another file was set while this one was loading
+		if(layer->abs_filename!=filename_with_path)
+			return;
+
+		layer->surface.clear();
+		layer->surface_changed();
+		if(!importer)
+		{
+			synfig::error(strprintf("Unable to create an importer object with file \"%s\"",filename_with_path.c_str()));
+			layer->importer=0;
+			return;
+		}
+
+		layer->surface=surface;
+		layer->trimmed=trimmed;
+		layer->width=width;
+		layer->height=height;
+		layer->top=top;
+		layer->left=left;
+		// the frame of a static image is the same for every layer showing it,
+		// so is its mipmap
+		if(!importer->is_animated())
+			layer->mipmap=importer->get_mipmap();
+		layer->importer=importer;
+	}
+
+	void queue(LoadQueue &queue)
+	{
+		queued_layer=layer;
+		queue.push(this);
+	}
+
+	bool loaded()const { return importer; }
+};
+
 /* === M E T H O D S ======================================================= */
 
 Import::Import():
@@ -99,6 +177,7 @@ Import::set_param(const String & param, const ValueBase &value)
 			importer=0;
 			cimporter=0;
 			surface.clear();
+			mipmap=0;
 			csurface.set_cairo_surface(NULL);
 			param_filename.set(filename);
 			return true;
@@ -145,6 +224,7 @@ Import::set_param(const String & param, const ValueBase &value)
 			importer=0;
 			cimporter=0;
 			surface.clear();
+			mipmap=0;
 			csurface.set_cairo_surface(NULL);
 			param_filename.set(filename);
 			return true;
@@ -174,37 +254,26 @@ Import::set_param(const String & param, const ValueBase &value)
 				else
 					filename_with_path=absolute_path(get_canvas()->get_file_path()+ETL_DIRECTORY_SEPARATOR+newfilename_orig);
 
-				handle<Importer> newimporter;
-
-				newimporter=Importer::open(file_system->get_identifier(filename_with_path));
-
-				if(!newimporter)
-				{
-					newimporter=Importer::open(file_system->get_identifier(get_canvas()->get_file_path()+ETL_DIRECTORY_SEPARATOR+basename(newfilename_orig)));
-					if(!newimporter)
-					{
-						synfig::error(strprintf("Unable to create an importer object with file \"%s\"",filename_with_path.c_str()));
-						importer=0;
-						filename=newfilename;
-						abs_filename=filename_with_path;
-						surface.clear();
-						param_filename.set(filename);
-						return false;
-					}
-				}
-
-				surface.clear();
-				if(!newimporter->get_frame(surface,get_canvas()->rend_desc(),Time(0),trimmed,width,height,top,left))
-				{
-					synfig::warning(strprintf("Unable to get frame from \"%s\"",filename_with_path.c_str()));
-				}
-
-				importer=newimporter;
 				filename=newfilename;
 				abs_filename=filename_with_path;
 				param_filename.set(filename);
 
-				return true;
+				// while a document is opened, the file is read later on the
+				// thread pool, along with the other files of the document
+				LoadTask *task = new LoadTask(*this, filename_with_path,
+					file_system->get_identifier(filename_with_path),
+					file_system->get_identifier(get_canvas()->get_file_path()+ETL_DIRECTORY_SEPARATOR+basename(newfilename_orig)));
+				if(LoadQueue *queue = LoadQueue::current())
+				{
+					task->queue(*queue);
+					return true;
+				}
+
+				task->run();
+				task->finish();
+				bool loaded = task->loaded();
+				delete task;
+				return loaded;
 			}
 		case OPENGL:
 			{
@@ -335,7 +404,10 @@ Import::set_time(IndependentContext context, Time time)const
 	case SOFTWARE:
 		if(get_amount() && importer &&
 		   importer->is_animated())
+		{
 			importer->get_frame(surface,get_canvas()->rend_desc(),time+time_offset,trimmed,width,height,top,left);
+			mipmap=0;
+		}
 		break;
 	case OPENGL:
 		break;
@@ -371,7 +443,10 @@ Import::set_time(IndependentContext context, Time time, const Point &pos)const
 		case SOFTWARE:
 			if(get_amount() && importer &&
 			   importer->is_animated())
+			{
 				importer->get_frame(surface,get_canvas()->rend_desc(),time+time_offset,trimmed,width,height,top,left);
+				mipmap=0;
+			}
 			break;
 		case OPENGL:
 			break;
@@ -57,6 +57,10 @@ private:
 	Importer::Handle importer;
 	CairoImporter::Handle cimporter;
 
+	//! Opens the importer and reads the first frame, see LoadQueue
+	class LoadTask;
+	friend class LoadTask;
+
 protected:
 	Import();
 
@@ -74,6 +78,8 @@ public:
 	virtual void set_time(IndependentContext context, Time time)const;
 
 	virtual void set_time(IndependentContext context, Time time, const Point &point)const;
+
+	virtual bool is_time_dependent()const { return importer && importer->is_animated(); }
 	
 	virtual void set_render_method(Context context, RenderMethod x);
 };
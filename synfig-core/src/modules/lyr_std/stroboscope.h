@@ -66,6 +66,7 @@ public:
 	virtual Color get_color(Context context, const Point &pos)const;
 
 	virtual void set_time(IndependentContext context, Time time)const;
+	virtual bool is_time_dependent()const { return true; }
 	virtual bool accelerated_render(Context context,Surface *surface,int quality, const RendDesc &renddesc, ProgressCallback *cb)const;
 	virtual bool accelerated_cairorender(Context context,cairo_t *cr, int quality, const RendDesc &renddesc, ProgressCallback *cb)const;
 };
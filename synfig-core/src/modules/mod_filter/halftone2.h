@@ -38,14 +38,14 @@
 
 /* === M A C R O S ========================================================= */
 #define HALFTONE2_IMPORT_VALUE(x)                                             \
-	if (#x=="halftone.param_"+param && x.get_type()==value.get_type())        \
+	if (Layer::is_param_member(param, #x, "halftone.param_") && x.get_type()==value.get_type()) \
 		{                                                                     \
 			x=value;                                                          \
 			return true;                                                      \
 		}                                                                     \
 
 #define HALFTONE2_EXPORT_VALUE(x)                                             \
-	if (#x=="halftone.param_"+param)                                          \
+	if (Layer::is_param_member(param, #x, "halftone.param_")) \
 		{                                                                     \
 			return x;                                                         \
 		}                                                                     \
@@ -38,7 +38,7 @@
 
 /* === M A C R O S ========================================================= */
 #define HALFTONE3_IMPORT_VALUE(x)                                             \
-	if (#x=="tone[i].param_"+param && x.get_type()==value.get_type())         \
+	if (Layer::is_param_member(param, #x, "tone[i].param_") && x.get_type()==value.get_type()) \
 		{                                                                     \
 			x=value;                                                          \
 			return true;                                                      \
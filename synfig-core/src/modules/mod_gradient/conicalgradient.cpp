@@ -40,6 +40,9 @@
 #include <synfig/valuenode.h>
 #include <synfig/angle.h>
 
+#include <cstring>
+#include <vector>
+
 #include "conicalgradient.h"
 
 #endif
@@ -252,44 +255,42 @@ ConicalGradient::accelerated_render(Context context,Surface *surface,int quality
 	}
 
 
-	int x,y;
-
-	Surface::pen pen(surface->begin());
 	const Real pw(renddesc.get_pw()),ph(renddesc.get_ph());
-	Point pos;
-	Point tl(renddesc.get_tl());
+	const Point tl(renddesc.get_tl()),br(renddesc.get_br());
 	const int w(surface->get_w());
 	const int h(surface->get_h());
-
-	if(get_amount()==1.0 && get_blend_method()==Color::BLEND_STRAIGHT)
-	{
-		if(quality<9)
-		{
-			for(y=0,pos[1]=tl[1];y<h;y++,pen.inc_y(),pen.dec_x(x),pos[1]+=ph)
-				for(x=0,pos[0]=tl[0];x<w;x++,pen.inc_x(),pos[0]+=pw)
-					pen.put_value(color_func(pos,calc_supersample(pos,pw,ph)));
-		}
-		else
-		{
-			for(y=0,pos[1]=tl[1];y<h;y++,pen.inc_y(),pen.dec_x(x),pos[1]+=ph)
-				for(x=0,pos[0]=tl[0];x<w;x++,pen.inc_x(),pos[0]+=pw)
-					pen.put_value(color_func(pos,0));
-		}
-	}
-	else
+	const Point center(param_center.get(Point()));
+	const Angle angle(param_angle.get(Angle()));
+
+	// The supersample is the smallest at the farthest corner
+	Real farthest(0);
+	for(int i=0;i<4;i++)
+		farthest=max(farthest,(Point(i&1?br[0]:tl[0],i&2?br[1]:tl[1])-center).mag());
+
+	// The gradient is baked once, instead of being searched for every pixel.
+	// The resolution is rounded down to a power of two, so the tiles of one
+	// render, each with its own farthest corner, don't bake it again.
+	const Real resolution(farthest>0?pow(2.0,floor(log(abs(pw)/(farthest*PI*2))/log(2.0))):0);
+	const etl::handle<const CompiledGradient> compiled(compiled_gradient.get(
+		param_gradient.get(Gradient()), true, param_symmetric.get(bool()), resolution));
+	const bool straight(get_amount()==1.0 && get_blend_method()==Color::BLEND_STRAIGHT);
+
+	std::vector<Color> row(w);
+	Point pos;
+	int x,y;
+	for(y=0,pos[1]=tl[1];y<h;y++,pos[1]+=ph)
 	{
-		if(quality<9)
+		for(x=0,pos[0]=tl[0];x<w;x++,pos[0]+=pw)
 		{
-			for(y=0,pos[1]=tl[1];y<h;y++,pen.inc_y(),pen.dec_x(x),pos[1]+=ph)
-				for(x=0,pos[0]=tl[0];x<w;x++,pen.inc_x(),pos[0]+=pw)
-					pen.put_value(Color::blend(color_func(pos,calc_supersample(pos,pw,ph)),pen.get_value(),get_amount(),get_blend_method()));
+			const Point centered(pos-center);
+			Angle::rot a=Angle::tan(-centered[1],centered[0]).mod();
+			a+=angle;
+			row[x]=(*compiled)(a.mod().get(),quality<9?calc_supersample(pos,pw,ph):0);
 		}
+		if(straight)
+			memcpy((*surface)[y],&row[0],w*sizeof(Color));
 		else
-		{
-			for(y=0,pos[1]=tl[1];y<h;y++,pen.inc_y(),pen.dec_x(x),pos[1]+=ph)
-				for(x=0,pos[0]=tl[0];x<w;x++,pen.inc_x(),pos[0]+=pw)
-					pen.put_value(Color::blend(color_func(pos,0),pen.get_value(),get_amount(),get_blend_method()));
-		}
+			Color::blend_span((*surface)[y],&row[0],w,get_amount(),get_blend_method());
 	}
 
 	// Mark our progress as finished
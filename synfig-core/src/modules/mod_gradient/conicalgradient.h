@@ -64,6 +64,9 @@ private:
 	float calc_supersample(const Point &x, float pw,float ph)const;
 	bool compile_mesh(cairo_pattern_t* pattern, Gradient gradient, Real radius)const;
 
+	//! The gradient as the last render baked it
+	mutable CompiledGradientCache compiled_gradient;
+
 public:
 
 	ConicalGradient();
@@ -48,6 +48,9 @@
 #include <ETL/hermite>
 #include <ETL/calculus>
 
+#include <cstring>
+#include <vector>
+
 #endif
 
 /* === M A C R O S ========================================================= */
@@ -241,7 +244,7 @@ CurveGradient::CurveGradient():
 }
 
 inline Color
-CurveGradient::color_func(const Point &point_, int quality, float supersample)const
+CurveGradient::color_func(const Point &point_, int quality, float supersample, const CompiledGradient *compiled)const
 {
 	Point origin=param_origin.get(Point());
 	Real width=param_width.get(Real());
@@ -445,6 +448,9 @@ CurveGradient::color_func(const Point &point_, int quality, float supersample)co
 		dist=(point_-origin - p1)*diff;
 	}
 
+	if(compiled)
+		return (*compiled)(dist,supersample);
+
 	if(loop)
 		dist-=floor(dist);
 
@@ -615,26 +621,27 @@ CurveGradient::accelerated_render(Context context,Surface *surface,int quality,
 	}
 
 
-	int x,y;
-
-	Surface::pen pen(surface->begin());
 	const Real pw(renddesc.get_pw()),ph(renddesc.get_ph());
-	Point pos;
-	Point tl(renddesc.get_tl());
+	const Point tl(renddesc.get_tl());
 	const int w(surface->get_w());
 	const int h(surface->get_h());
 
-	if(get_amount()==1.0 && get_blend_method()==Color::BLEND_STRAIGHT)
-	{
-		for(y=0,pos[1]=tl[1];y<h;y++,pen.inc_y(),pen.dec_x(x),pos[1]+=ph)
-			for(x=0,pos[0]=tl[0];x<w;x++,pen.inc_x(),pos[0]+=pw)
-				pen.put_value(color_func(pos,quality,calc_supersample(pos,pw,ph)));
-	}
-	else
+	// The gradient is baked once, instead of being searched for every pixel
+	const etl::handle<const CompiledGradient> compiled(compiled_gradient.get(
+		param_gradient.get(Gradient()), param_loop.get(bool()), param_zigzag.get(bool()), abs(pw)));
+	const bool straight(get_amount()==1.0 && get_blend_method()==Color::BLEND_STRAIGHT);
+
+	std::vector<Color> row(w);
+	Point pos;
+	int x,y;
+	for(y=0,pos[1]=tl[1];y<h;y++,pos[1]+=ph)
 	{
-		for(y=0,pos[1]=tl[1];y<h;y++,pen.inc_y(),pen.dec_x(x),pos[1]+=ph)
-			for(x=0,pos[0]=tl[0];x<w;x++,pen.inc_x(),pos[0]+=pw)
-				pen.put_value(Color::blend(color_func(pos,quality,calc_supersample(pos,pw,ph)),pen.get_value(),get_amount(),get_blend_method()));
+		for(x=0,pos[0]=tl[0];x<w;x++,pos[0]+=pw)
+			row[x]=color_func(pos,quality,calc_supersample(pos,pw,ph),compiled.get());
+		if(straight)
+			memcpy((*surface)[y],&row[0],w*sizeof(Color));
+		else
+			Color::blend_span((*surface)[y],&row[0],w,get_amount(),get_blend_method());
 	}
 
 	// Mark our progress as finished
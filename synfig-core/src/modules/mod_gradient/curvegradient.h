@@ -72,10 +72,13 @@ private:
 
 	void sync();
 
-	Color color_func(const Point &x, int quality=10, float supersample=0)const;
+	Color color_func(const Point &x, int quality=10, float supersample=0, const CompiledGradient *compiled=NULL)const;
 
 	float calc_supersample(const Point &x, float pw,float ph)const;
 
+	//! The gradient as the last render baked it
+	mutable CompiledGradientCache compiled_gradient;
+
 public:
 	CurveGradient();
 
@@ -43,6 +43,9 @@
 #include <synfig/value.h>
 #include <synfig/valuenode.h>
 
+#include <cstring>
+#include <vector>
+
 #endif
 
 /* === M A C R O S ========================================================= */
@@ -267,27 +270,30 @@ LinearGradient::accelerated_render(Context context,Surface *surface,int quality,
 	}
 
 
-	int x,y;
-
-	Surface::pen pen(surface->begin());
 	const Real pw(renddesc.get_pw()),ph(renddesc.get_ph());
-	Point pos;
-	Point tl(renddesc.get_tl());
+	const Point tl(renddesc.get_tl());
 	const int w(surface->get_w());
 	const int h(surface->get_h());
 	synfig::Real supersample = calc_supersample(params, pw, ph);
 
-	if(get_amount()==1.0 && get_blend_method()==Color::BLEND_STRAIGHT)
-	{
-		for(y=0,pos[1]=tl[1];y<h;y++,pen.inc_y(),pen.dec_x(x),pos[1]+=ph)
-			for(x=0,pos[0]=tl[0];x<w;x++,pen.inc_x(),pos[0]+=pw)
-				pen.put_value(color_func(params,pos,supersample));
-	}
-	else
+	// The gradient is baked once, then every row is a span of it
+	const etl::handle<const CompiledGradient> compiled(
+		compiled_gradient.get(params.gradient, params.loop, params.zigzag, supersample, supersample));
+	const Real dist = (tl - params.p1)*params.diff;
+	const Real dx = pw*params.diff[0];
+	const Real dy = ph*params.diff[1];
+	const bool straight = get_amount()==1.0 && get_blend_method()==Color::BLEND_STRAIGHT;
+
+	std::vector<Color> row(w);
+	for(int y = 0; y < h; y++)
 	{
-		for(y=0,pos[1]=tl[1];y<h;y++,pen.inc_y(),pen.dec_x(x),pos[1]+=ph)
-			for(x=0,pos[0]=tl[0];x<w;x++,pen.inc_x(),pos[0]+=pw)
-				pen.put_value(Color::blend(color_func(params,pos,supersample),pen.get_value(),get_amount(),get_blend_method()));
+		// a gradient running along the rows gives the same row every time
+		if (y == 0 || dy != 0.0)
+			compiled->fill(&row[0], w, dist + y*dy, dx);
+		if (straight)
+			memcpy((*surface)[y], &row[0], w*sizeof(Color));
+		else
+			Color::blend_span((*surface)[y], &row[0], w, get_amount(), get_blend_method());
 	}
 
 	// Mark our progress as finished
@@ -75,6 +75,9 @@ private:
 
 	bool compile_gradient(cairo_pattern_t* pattern, Gradient gradient)const;
 
+	//! The gradient as the last render baked it
+	mutable CompiledGradientCache compiled_gradient;
+
 public:
 	LinearGradient();
 
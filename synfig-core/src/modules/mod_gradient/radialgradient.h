@@ -65,6 +65,9 @@ private:
 	float calc_supersample(const Point &x, float pw,float ph)const;
 	bool compile_gradient(cairo_pattern_t* pattern, Gradient gradient)const;
 
+	//! The gradient as the last render baked it
+	mutable CompiledGradientCache compiled_gradient;
+
 public:
 
 	RadialGradient();
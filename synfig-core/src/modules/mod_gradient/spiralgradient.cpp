@@ -40,6 +40,9 @@
 #include <synfig/valuenode.h>
 #include <synfig/cairo_renddesc.h>
 
+#include <cstring>
+#include <vector>
+
 #include "spiralgradient.h"
 
 #endif
@@ -236,26 +239,41 @@ SpiralGradient::accelerated_render(Context context,Surface *surface,int quality,
 	}
 
 
-	int x,y;
-
-	Surface::pen pen(surface->begin());
 	const Real pw(renddesc.get_pw()),ph(renddesc.get_ph());
-	Point pos;
-	Point tl(renddesc.get_tl());
+	const Point tl(renddesc.get_tl());
 	const int w(surface->get_w());
 	const int h(surface->get_h());
-
-	if(get_amount()==1.0 && get_blend_method()==Color::BLEND_STRAIGHT)
-	{
-		for(y=0,pos[1]=tl[1];y<h;y++,pen.inc_y(),pen.dec_x(x),pos[1]+=ph)
-			for(x=0,pos[0]=tl[0];x<w;x++,pen.inc_x(),pos[0]+=pw)
-				pen.put_value(color_func(pos,calc_supersample(pos,pw,ph)));
-	}
-	else
+	const Point center(param_center.get(Point()));
+	const Real radius(param_radius.get(Real()));
+	const Angle angle(param_angle.get(Angle()));
+	const bool clockwise(param_clockwise.get(bool()));
+
+	// The gradient is baked once, instead of being searched for every pixel,
+	// fine enough for the supersample far from the center
+	const etl::handle<const CompiledGradient> compiled(compiled_gradient.get(
+		param_gradient.get(Gradient()), true, false, abs(0.707*pw/radius)));
+	const bool straight(get_amount()==1.0 && get_blend_method()==Color::BLEND_STRAIGHT);
+
+	std::vector<Color> row(w);
+	Point pos;
+	int x,y;
+	for(y=0,pos[1]=tl[1];y<h;y++,pos[1]+=ph)
 	{
-		for(y=0,pos[1]=tl[1];y<h;y++,pen.inc_y(),pen.dec_x(x),pos[1]+=ph)
-			for(x=0,pos[0]=tl[0];x<w;x++,pen.inc_x(),pos[0]+=pw)
-				pen.put_value(Color::blend(color_func(pos,calc_supersample(pos,pw,ph)),pen.get_value(),get_amount(),get_blend_method()));
+		for(x=0,pos[0]=tl[0];x<w;x++,pos[0]+=pw)
+		{
+			const Point centered(pos-center);
+			const Angle a(Angle::tan(-centered[1],centered[0]).mod()+angle);
+			Real dist(centered.mag()/radius);
+			if(clockwise)
+				dist+=Angle::rot(a.mod()).get();
+			else
+				dist-=Angle::rot(a.mod()).get();
+			row[x]=(*compiled)(dist,max(calc_supersample(pos,pw,ph),0.00001f));
+		}
+		if(straight)
+			memcpy((*surface)[y],&row[0],w*sizeof(Color));
+		else
+			Color::blend_span((*surface)[y],&row[0],w,get_amount(),get_blend_method());
 	}
 
 	// Mark our progress as finished
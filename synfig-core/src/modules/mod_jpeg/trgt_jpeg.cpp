@@ -194,8 +194,25 @@ jpeg_trgt::end_scanline()
 		return false;
 
 	convert_color_format(buffer, color_buffer, desc.get_w(), PF_RGB,gamma());
-	JSAMPROW *row_pointer(&buffer);
-	jpeg_write_scanlines(&cinfo, row_pointer, 1);
+
+	return write_pixels(buffer);
+}
+
+bool
+jpeg_trgt::get_pixel_format(PixelFormat &format)const
+{
+	format = PF_RGB;
+	return true;
+}
+
+bool
+jpeg_trgt::write_pixels(const unsigned char *data)
+{
+	if(!file || !ready)
+		return false;
+
+	JSAMPROW row_pointer = const_cast<JSAMPROW>(data);
+	jpeg_write_scanlines(&cinfo, &row_pointer, 1);
 
 	return true;
 }
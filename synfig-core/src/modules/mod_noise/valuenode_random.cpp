@@ -110,7 +110,7 @@ ValueNode_Random::~ValueNode_Random()
 }
 
 ValueBase
-ValueNode_Random::operator()(Time t)const
+ValueNode_Random::get_value_vfunc(Time t)const
 {
 	typedef const RandomNoise::SmoothType Smooth;
 
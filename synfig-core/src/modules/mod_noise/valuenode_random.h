@@ -56,7 +56,10 @@ public:
 	typedef etl::handle<ValueNode_Random> Handle;
 	typedef etl::handle<const ValueNode_Random> ConstHandle;
 
-	virtual ValueBase operator()(Time t)const;
+	virtual ValueBase get_value_vfunc(Time t)const;
+	//! The value depends on the time directly, not only through the links
+	virtual void get_invariance(Time t, Time &begin, Time &end)const
+		{ ValueNode::get_invariance(t, begin, end); }
 
 	virtual ~ValueNode_Random();
 
@@ -242,13 +242,28 @@ png_trgt::end_scanline()
 	if(!file || !ready)
 		return false;
 
-	if (get_alpha_mode()==TARGET_ALPHA_MODE_KEEP)
-		convert_color_format(buffer, color_buffer, desc.get_w(), PF_RGB|PF_A, gamma());
-	else
-		convert_color_format(buffer, color_buffer, desc.get_w(), PF_RGB, gamma());
+	PixelFormat pf;
+	get_pixel_format(pf);
+	convert_color_format(buffer, color_buffer, desc.get_w(), pf, gamma());
+
+	return write_pixels(buffer);
+}
+
+bool
+png_trgt::get_pixel_format(PixelFormat &format)const
+{
+	format = get_alpha_mode()==TARGET_ALPHA_MODE_KEEP ? PF_RGB|PF_A : PF_RGB;
+	return true;
+}
+
+bool
+png_trgt::write_pixels(const unsigned char *data)
+{
+	if(!file || !ready)
+		return false;
 
 	setjmp(png_jmpbuf(png_ptr));
-	png_write_row(png_ptr,buffer);
+	png_write_row(png_ptr,const_cast<png_bytep>(data));
 
 	return true;
 }
@@ -147,7 +147,23 @@ ppm::end_scanline()
 
 	convert_color_format(buffer, color_buffer, desc.get_w(), PF_RGB, gamma());
 
-	if(!fwrite(buffer,1,desc.get_w()*3,file.get()))
+	return write_pixels(buffer);
+}
+
+bool
+ppm::get_pixel_format(PixelFormat &format)const
+{
+	format = PF_RGB;
+	return true;
+}
+
+bool
+ppm::write_pixels(const unsigned char *data)
+{
+	if(!file)
+		return false;
+
+	if(!fwrite(data,1,desc.get_w()*3,file.get()))
 		return false;
 
 	return true;
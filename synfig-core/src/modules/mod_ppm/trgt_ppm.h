@@ -63,6 +63,9 @@ public:
 
 	virtual synfig::Color * start_scanline(int scanline);
 	virtual bool end_scanline();
+
+	virtual bool get_pixel_format(synfig::PixelFormat &format)const;
+	virtual bool write_pixels(const unsigned char *data);
 };
 
 /* === E N D =============================================================== */
@@ -78,6 +78,7 @@ class TypeBool: public synfig::Type
 		description.aliases.push_back(_("bool"));
 		description.local_name = N_("bool");
 		register_all<bool, to_string>();
+		register_inline<bool>();
 	}
 public:
 	static TypeBool instance;
@@ -99,6 +100,7 @@ class TypeInteger: public Type
 		description.aliases.push_back(_("integer"));
 		description.local_name = N_("integer");
 		register_all<int, to_string>();
+		register_inline<int>();
 	}
 public:
 	static TypeInteger instance;
@@ -121,6 +123,7 @@ class TypeAngle: public Type
 		description.aliases.push_back("rotations");
 		description.local_name = N_("angle");
 		register_all<Angle, to_string>();
+		register_inline<Angle>();
 	}
 public:
 	static TypeAngle instance;
@@ -169,6 +172,7 @@ private:
 		register_alias<Inner, float>();
 		register_alias<Inner, Time>();
 		register_compare(compare);
+		register_inline<Inner>();
 	}
 public:
 	static TypeReal instance;
@@ -197,6 +201,7 @@ class TypeTime: public Type
 		register_alias<Inner, Real>();
 		register_alias<Inner, Time>();
 		register_compare(compare);
+		register_inline<Inner>();
 		register_copy(identifier, TypeReal::instance.identifier, Operation::DefaultFuncs::copy<Inner>);
 		register_copy(TypeReal::instance.identifier, identifier, Operation::DefaultFuncs::copy<Inner>);
 	}
@@ -219,6 +224,7 @@ class TypeVector: public Type
 		description.aliases.push_back("point");
 		description.local_name = N_("vector");
 		register_all<Vector, to_string>();
+		register_inline<Vector>();
 	}
 public:
 	static TypeVector instance;
@@ -238,6 +244,7 @@ class TypeColor: public Type
 		description.name = "color";
 		description.local_name = N_("color");
 		register_all<Color, to_string>();
+		register_inline<Color>();
 	}
 public:
 	static TypeColor instance;
@@ -35,12 +35,12 @@
 
 #include "blur.h"
 
-#include <stdexcept>
-#include <ETL/stringf>
+#include <synfig/threadpool.h>
 
-#include <ETL/pen>
-#include <ETL/gaussian>
-#include <ETL/boxblur>
+#include <cmath>
+#include <cstring>
+#include <vector>
+#include <algorithm>
 
 #endif
 
@@ -120,7 +120,14 @@ Point Blur::operator()(synfig::Real x, synfig::Real y) const
 	return (*this)(Point(x,y));
 }
 
-//blur functions to make my life easier
+/*	The surface blurs below are built from passes which cost the same per
+**	pixel whatever the blur size: running sums along the rows or the columns
+**	for the boxes, three stacked boxes for the gaussian and per-row prefix
+**	sums for the disc. Every pass is split into bands of rows or columns
+**	which run on the shared thread pool. They are written once for any
+**	etl::surface, so Surface, CairoSurface and the float alpha surfaces
+**	share them. Pixels outside of the surface repeat the nearest edge pixel.
+*/
 
 template <typename T>
 static inline T zero()
@@ -140,325 +147,287 @@ inline CairoColorAccumulator zero<CairoColorAccumulator>()
 	return CairoColorAccumulator(0);
 }
 
-template <typename T,typename AT,class VP>
-static void GaussianBlur_2x2(etl::surface<T,AT,VP> &surface)
-{
-	int x,y;
-	AT Tmp1,Tmp2,SR0;
-
-	AT *SC0=new AT[surface.get_w()];
+namespace {
 
-	memcpy(SC0,surface[0],surface.get_w()*sizeof(AT));
+//! Runs \a pass over the \a count rows or columns of a surface of \a pixels pixels
+template <typename Pass>
+void run_bands(const Pass &pass, int count, int pixels)
+{
+	ThreadPool &pool = ThreadPool::instance();
 
-	for(y=0;y<surface.get_h();y++)
-	{
-		SR0=surface[y][0];
-		for(x=0;x<surface.get_w();x++)
-		{
-			Tmp1=(AT)(surface[y][x]);
-			Tmp2=SR0+Tmp1;
-			SR0=Tmp1;
-			surface[y][x]=(SC0[x]+Tmp2)/4;
-			SC0[x]=Tmp2;
-		}
-	}
-	delete [] SC0;
+	// small surfaces are not worth waking up the workers
+	pool.run_bands(pass, count, pixels < 128*128 ? 1 : pool.get_threads()*4);
 }
 
-template <typename T,typename AT,class VP>
-static void GaussianBlur_3x3(etl::surface<T,AT,VP> &surface)
+//! Box of variance \a variance, whole pixels up to \a radius and a
+//! weight of \a fraction for the next pixel on either side
+struct BoxLength
 {
-	int x,y,u,v,w,h;
-	AT Tmp1,Tmp2,SR0,SR1;
-
-	w=surface.get_w();
-	h=surface.get_h();
-
-	AT *SC0=new AT[w+1];
-	AT *SC1=new AT[w+1];
+	int radius;
+	float fraction;
 
-	// Setup the row buffers
-	for(x=0;x<w;x++)SC0[x]=(AT)(surface[0][x])*4;
+	explicit BoxLength(int radius = 0, float fraction = 0):
+		radius(radius), fraction(fraction) { }
 
-	for(y=0;y<=h;y++)
+	static BoxLength from_variance(Real variance)
 	{
-		if(y>=h)
-			v=h-1;
-		else
-			v=y;
-
-		SR0=SR1=surface[y][0];
-		for(x=0;x<=w;x++)
-		{
-			if(x>=w)
-				u=w-1;
-			else
-				u=x;
-
-			// Row Machine
-			Tmp1=surface[v][u];
-			Tmp2=SR0+Tmp1;
-			SR0=Tmp1;
-			Tmp1=SR1+Tmp2;
-			SR1=Tmp2;
-
-			// Column Machine
-			Tmp2=SC0[x]+Tmp1;
-			SC0[x]=Tmp1;
-			if(y&&x)
-				surface[y-1][x-1]=(SC1[x]+Tmp2)/16;
-			SC1[x]=Tmp2;
-		}
+		// a box of radius r has a variance of r(r+1)/3, the fraction
+		// covers the variance between two whole radii
+		BoxLength box((int)floor((sqrt(1.0 + 12.0*variance) - 1.0)/2.0));
+		Real r = box.radius;
+		Real s = r*(r + 1)*(2*r + 1)/3;
+		Real fraction = (variance*(2*r + 1) - s)/(2*((r + 1)*(r + 1) - variance));
+		box.fraction = (float)std::max(0.0, std::min(1.0, fraction));
+		return box;
 	}
 
-	delete [] SC0;
-	delete [] SC1;
-}
+	//! Boxes wider than the surface would only repeat the edge pixels
+	BoxLength clamped(int size)const
+		{ return radius >= size ? BoxLength(size) : *this; }
 
+	float divisor()const
+		{ return 1.0f/(2*radius + 1 + 2*fraction); }
+};
+
+//! Box blur along the rows, \a src and \a dst may be the same surface
 template <typename T,typename AT,class VP>
-inline static void GaussianBlur_5x5_(etl::surface<T,AT,VP> &surface,AT *SC0,AT *SC1,AT *SC2,AT *SC3)
+struct BoxRows
 {
-	int x,y,u,v,w,h;
-	AT Tmp1,Tmp2,SR0,SR1,SR2,SR3;
-
-	w=surface.get_w();
-	h=surface.get_h();
+	const etl::surface<T,AT,VP> &src;
+	etl::surface<T,AT,VP> &dst;
+	BoxLength box;
 
-	// Setup the row buffers
-	for(x=0;x<w;x++)SC0[x+2]=(AT)(surface[0][x])*24;
+	BoxRows(const etl::surface<T,AT,VP> &src, etl::surface<T,AT,VP> &dst, const BoxLength &box):
+		src(src), dst(dst), box(box.clamped(src.get_w())) { }
 
-	for(y=0;y<h+2;y++)
+	void operator()(int begin, int end)const
 	{
-		if(y>=h)
-			v=h-1;
-		else
-			v=y;
-
-		SR0=SR1=SR2=SR3=0;
-		SR0=(AT)(surface[v][0])*1.5;
-		for(x=0;x<w+2;x++)
-		{
-			if(x>=w)
-				u=w-1;
-			else
-				u=x;
-
-			// Row Machine
-			Tmp1=surface[v][u];
-			Tmp2=SR0+Tmp1;
-			SR0=Tmp1;
-			Tmp1=SR1+Tmp2;
-			SR1=Tmp2;
-			Tmp2=SR2+Tmp1;
-			SR2=Tmp1;
-			Tmp1=SR3+Tmp2;
-			SR3=Tmp2;
-
-			// Column Machine
-			Tmp2=SC0[x]+Tmp1;
-			SC0[x]=Tmp1;
-			Tmp1=SC1[x]+Tmp2;
-			SC1[x]=Tmp2;
-			Tmp2=SC2[x]+Tmp1;
-			SC2[x]=Tmp1;
-			if(y>1&&x>1)
-				surface[y-2][x-2]=(SC3[x]+Tmp2)/256;
-			SC3[x]=Tmp2;
-		}
-	}
-
-}
+		const int w = src.get_w();
+		const int r = box.radius;
+		const int pad = r + 1;
+		const float divisor = box.divisor();
 
-template <typename T,typename AT,class VP>
-inline static void GaussianBlur_5x5(etl::surface<T,AT,VP> &surface)
-{
-	int w=surface.get_w();
+		// the row with pad copies of the edge pixels on either side
+		std::vector<AT> row(w + 2*pad);
 
-	AT *SC0=new AT[w+2];
-	AT *SC1=new AT[w+2];
-	AT *SC2=new AT[w+2];
-	AT *SC3=new AT[w+2];
+		for(int y = begin; y < end; ++y)
+		{
+			const T *in = src[y];
+			for(int i = 0; i < pad; ++i)
+			{
+				row[i] = (AT)in[0];
+				row[pad + w + i] = (AT)in[w - 1];
+			}
+			for(int x = 0; x < w; ++x)
+				row[pad + x] = (AT)in[x];
 
-	GaussianBlur_5x5_(surface,SC0,SC1,SC2,SC3);
+			AT sum = zero<AT>();
+			for(int i = 1; i < 2*r + 1; ++i)
+				sum += row[i];
 
-	delete [] SC0;
-	delete [] SC1;
-	delete [] SC2;
-	delete [] SC3;
-}
+			T *out = dst[y];
+			for(int x = 0, c = pad; x < w; ++x, ++c)
+			{
+				sum += row[c + r];
+				if (box.fraction)
+					out[x] = (T)((sum + (row[c - r - 1] + row[c + r + 1])*box.fraction)*divisor);
+				else
+					out[x] = (T)(sum*divisor);
+				sum -= row[c - r];
+			}
+		}
+	}
+};
 
+//! Box blur along the columns, \a src and \a dst must differ
 template <typename T,typename AT,class VP>
-static void GaussianBlur_nxn(etl::surface<T,AT,VP> &surface,int n)
+struct BoxColumns
 {
-	int x,y,u,v,w,h;
-	int half_n=n/2,i;
-	float inv_divisor=pow(2.0,(n-1));
-	AT Tmp1,Tmp2;
-	inv_divisor=1.0/(inv_divisor*inv_divisor);
-
-	w=surface.get_w();
-	h=surface.get_h();
+	const etl::surface<T,AT,VP> &src;
+	etl::surface<T,AT,VP> &dst;
+	BoxLength box;
 
-    AT SR[n-1];
-	AT *SC[n-1];
+	BoxColumns(const etl::surface<T,AT,VP> &src, etl::surface<T,AT,VP> &dst, const BoxLength &box):
+		src(src), dst(dst), box(box.clamped(src.get_h())) { }
 
-	for(i=0;i<n-1;i++)
+	void operator()(int begin, int end)const
 	{
-		SC[i]=new AT[w+half_n];
-		if(!SC[i])
+		const int h = src.get_h();
+		const int r = box.radius;
+		const int count = end - begin;
+		const float divisor = box.divisor();
+
+		// running sums of the band, walking down the rows keeps
+		// the memory accesses sequential
+		std::vector<AT> sum(count);
+		for(int x = 0; x < count; ++x)
+			sum[x] = (AT)src[0][begin + x]*(float)r;
+		for(int i = 0; i < r; ++i)
 		{
-			throw(runtime_error(strprintf(__FILE__":%d:Malloc failure",__LINE__)));
-			return;
+			const T *in = src[std::min(i, h - 1)] + begin;
+			for(int x = 0; x < count; ++x)
+				sum[x] += (AT)in[x];
 		}
-	}
-
-	// Setup the first row
-//	for(x=0;x<w;x++)SC[0][x+half_n]=surface[0][x]*550.0;//*pow(2.0,(n-1))*(2.0/n);
-
-	for(y=0;y<h+half_n;y++)
-	{
-		if(y>=h)
-			v=h-1;
-		else
-			v=y;
-
-		if(y!=0)
-			memset(SR,0,(n-1)*sizeof(AT));
 
-//		SR[0]=surface[v][0]*(2.0-1.9/n);
-
-		for(x=0;x<w+half_n;x++)
+		for(int y = 0; y < h; ++y)
 		{
-			if(x>=w)
-				u=w-1;
-			else
-				u=x;
+			const T *first = src[std::max(y - r, 0)] + begin;
+			const T *last = src[std::min(y + r, h - 1)] + begin;
+			T *out = dst[y] + begin;
 
-			Tmp1=surface[v][u];
-			// Row Machine
-			for(i=0;i<half_n;i++)
+			if (box.fraction)
 			{
-				Tmp2=SR[i*2]+Tmp1;
-				SR[i*2]=Tmp1;
-				Tmp1=SR[i*2+1]+Tmp2;
-				SR[i*2+1]=Tmp2;
+				const T *before = src[std::max(y - r - 1, 0)] + begin;
+				const T *after = src[std::min(y + r + 1, h - 1)] + begin;
+				for(int x = 0; x < count; ++x)
+				{
+					sum[x] += (AT)last[x];
+					out[x] = (T)((sum[x] + ((AT)before[x] + (AT)after[x])*box.fraction)*divisor);
+					sum[x] -= (AT)first[x];
+				}
 			}
-
-			// Column Machine
-			for(i=0;i<half_n-1;i++)
+			else
 			{
-				Tmp2=SC[i*2][x]+Tmp1;
-				SC[i*2][x]=Tmp1;
-				Tmp1=SC[i*2+1][x]+Tmp2;
-				SC[i*2+1][x]=Tmp2;
+				for(int x = 0; x < count; ++x)
+				{
+					sum[x] += (AT)last[x];
+					out[x] = (T)(sum[x]*divisor);
+					sum[x] -= (AT)first[x];
+				}
 			}
-			Tmp2=SC[n-3][x]+Tmp1;
-			SC[n-3][x]=Tmp1;
-			if(y>=half_n&&x>=half_n)
-				surface[y-half_n][x-half_n]=(SC[n-2][x]+Tmp2)*inv_divisor;
-			SC[n-2][x]=Tmp2;
 		}
 	}
+};
 
-	for(i=0;i<n-1;i++)
-		delete [] SC[i];
-}
-
+//! Average of two surfaces
 template <typename T,typename AT,class VP>
-static void GaussianBlur_2x1(etl::surface<T,AT,VP> &surface)
+struct Average
 {
-	int x,y;
-	AT Tmp1,Tmp2,SR0;
+	const etl::surface<T,AT,VP> &a;
+	const etl::surface<T,AT,VP> &b;
+	etl::surface<T,AT,VP> &dst;
 
-	for(y=0;y<surface.get_h();y++)
+	Average(const etl::surface<T,AT,VP> &a, const etl::surface<T,AT,VP> &b, etl::surface<T,AT,VP> &dst):
+		a(a), b(b), dst(dst) { }
+
+	void operator()(int begin, int end)const
 	{
-		SR0=surface[y][0];
-		for(x=0;x<surface.get_w();x++)
-		{
-			Tmp1=surface[y][x];
-			Tmp2=SR0+Tmp1;
-			SR0=Tmp1;
-			surface[y][x]=(Tmp2)/2;
-		}
+		const int w = dst.get_w();
+		for(int y = begin; y < end; ++y)
+			for(int x = 0; x < w; ++x)
+				dst[y][x] = (T)(((AT)a[y][x] + (AT)b[y][x])*0.5f);
 	}
-}
+};
 
+//! Prefix sums of every row, <tt>w+1</tt> values per row
 template <typename T,typename AT,class VP>
-static void GaussianBlur_3x1(etl::surface<T,AT,VP> &surface)
+struct PrefixRows
 {
-	int x,y;
-	AT Tmp1,Tmp2,SR0,SR1;
+	const etl::surface<T,AT,VP> &src;
+	std::vector<AT> &table;
 
-	for(y=0;y<surface.get_h();y++)
+	PrefixRows(const etl::surface<T,AT,VP> &src, std::vector<AT> &table):
+		src(src), table(table) { }
+
+	void operator()(int begin, int end)const
 	{
-		SR0=SR1=surface[y][0];
-		for(x=0;x<surface.get_w();x++)
+		const int w = src.get_w();
+		for(int y = begin; y < end; ++y)
 		{
-			// Row Machine
-			Tmp1=surface[y][x];
-			Tmp2=SR0+Tmp1;
-			SR0=Tmp1;
-			Tmp1=SR1+Tmp2;
-			SR1=Tmp2;
-
-			if(x)
-				surface[y][x-1]=(Tmp1)/4;
+			const T *in = src[y];
+			AT *prefix = &table[y*(w + 1)];
+			prefix[0] = zero<AT>();
+			for(int x = 0; x < w; ++x)
+				prefix[x + 1] = prefix[x] + (AT)in[x];
 		}
 	}
-}
+};
 
+//! Disc blur from the prefix sums of the rows: every row of the
+//! disc is a span, so a pixel costs one subtraction per row
 template <typename T,typename AT,class VP>
-static void GaussianBlur_1x2(etl::surface<T,AT,VP> &surface)
+struct DiscRows
 {
-	int x,y;
-	AT Tmp1,Tmp2,SR0;
+	const std::vector<AT> &table;
+	//! Half width of the spans, from the top row of the disc down
+	const std::vector<int> &spans;
+	float divisor;
+	etl::surface<T,AT,VP> &dst;
+
+	DiscRows(const std::vector<AT> &table, const std::vector<int> &spans, float divisor, etl::surface<T,AT,VP> &dst):
+		table(table), spans(spans), divisor(divisor), dst(dst) { }
 
-	for(x=0;x<surface.get_w();x++)
+	//! Sum of the pixels \a a to \a b of a row, edge pixels repeated
+	static AT span_sum(const AT *prefix, int w, int a, int b)
 	{
-		SR0 = zero<AT>();
-		for(y=0;y<surface.get_h();y++)
+		AT sum = zero<AT>();
+		if (a < 0)
 		{
-			Tmp1=surface[y][x];
-			Tmp2=SR0+Tmp1;
-			SR0=Tmp1;
-			surface[y][x]=(Tmp2)/2;
+			sum += (prefix[1] - prefix[0])*(float)(std::min(b, -1) - a + 1);
+			a = 0;
 		}
+		if (b >= w)
+		{
+			sum += (prefix[w] - prefix[w - 1])*(float)(b - std::max(a, w) + 1);
+			b = w - 1;
+		}
+		if (a <= b)
+			sum += prefix[b + 1] - prefix[a];
+		return sum;
 	}
-}
-
-template <typename T,typename AT,class VP>
-static void GaussianBlur_1x3(etl::surface<T,AT,VP> &surface)
-{
-	int x,y;
-	AT Tmp1,Tmp2,SR0,SR1;
 
-	for(x=0;x<surface.get_w();x++)
+	void operator()(int begin, int end)const
 	{
-		SR0=SR1=surface[0][x];
-		for(y=0;y<surface.get_h();y++)
+		const int w = dst.get_w();
+		const int h = dst.get_h();
+		const int bh = (int)spans.size()/2;
+
+		for(int y = begin; y < end; ++y)
 		{
-			// Row Machine
-			Tmp1=surface[y][x];
-			Tmp2=SR0+Tmp1;
-			SR0=Tmp1;
-			Tmp1=SR1+Tmp2;
-			SR1=Tmp2;
-
-			if(y)
-				surface[y-1][x]=(Tmp1)/4;
+			T *out = dst[y];
+			for(int x = 0; x < w; ++x)
+			{
+				AT sum = zero<AT>();
+				for(int dy = -bh; dy <= bh; ++dy)
+				{
+					const int v = std::max(0, std::min(h - 1, y + dy));
+					const int half = spans[dy + bh];
+					sum += span_sum(&table[v*(w + 1)], w, x - half, x + half);
+				}
+				out[x] = (T)(sum*divisor);
+			}
 		}
 	}
+};
+
+template <typename T,typename AT,class VP>
+void copy_surface(const etl::surface<T,AT,VP> &src, etl::surface<T,AT,VP> &dst)
+{
+	for(int y = 0; y < src.get_h(); ++y)
+		memcpy(dst[y], src[y], src.get_w()*sizeof(T));
 }
 
-//THE GOOD ONE!!!!!!!!!
-bool Blur::operator()(const Surface &surface,
-					  const Vector &resolution,
-					  Surface &out) const
+template <typename T,typename AT,class VP>
+void hbox(const etl::surface<T,AT,VP> &src, etl::surface<T,AT,VP> &dst, const BoxLength &box)
 {
-	int w = surface.get_w(),
-		h = surface.get_h();
+	run_bands(BoxRows<T,AT,VP>(src, dst, box), src.get_h(), src.get_w()*src.get_h());
+}
 
-	if(w == 0 || h == 0 || resolution[0] == 0 || resolution[1] == 0) return false;
+template <typename T,typename AT,class VP>
+void vbox(const etl::surface<T,AT,VP> &src, etl::surface<T,AT,VP> &dst, const BoxLength &box)
+{
+	run_bands(BoxColumns<T,AT,VP>(src, dst, box), src.get_w(), src.get_w()*src.get_h());
+}
+
+//! Blurs \a work in place, returns \c false if the callback cancelled it
+template <typename T,typename AT,class VP>
+bool blur_surface(etl::surface<T,AT,VP> &work, int type, const Point &size, const Vector &resolution, SuperCallback &blurcall)
+{
+	typedef etl::surface<T,AT,VP> surface_type;
+
+	const int w = work.get_w(),
+			  h = work.get_h();
+	const int pixels = w*h;
 
 	const Real	pw = resolution[0]/w,
 				ph = resolution[1]/h;
@@ -466,26 +435,7 @@ bool Blur::operator()(const Surface &surface,
 	int	halfsizex = (int) (abs(size[0]*.5/pw) + 1),
 		halfsizey = (int) (abs(size[1]*.5/ph) + 1);
 
-	int x,y;
-
-	SuperCallback blurcall(cb,0,5000,5000);
-
-	Surface worksurface(w,h);
-
-	//synfig::info("Blur: check surface = %s", surface_valid(surface)?"true":"false");
-
-	// Premultiply the alpha
-	for(y=0;y<h;y++)
-	{
-		for(x=0;x<w;x++)
-		{
-			Color a = surface[y][x];
-			a.set_r(a.get_r()*a.get_a());
-			a.set_g(a.get_g()*a.get_a());
-			a.set_b(a.get_b()*a.get_a());
-			worksurface[y][x] = a;
-		}
-	}
+	surface_type temp_surface(w,h);
 
 	switch(type)
 	{
@@ -496,59 +446,28 @@ bool Blur::operator()(const Surface &surface,
 
 			if(size[0] && size[1] && w*h>2)
 			{
-				int x2,y2;
-				Surface tmp_surface(worksurface);
-
-				for(y=0;y<h;y++)
+				// the half width of every row of the ellipse
+				std::vector<int> spans(2*bh + 1);
+				int total = 0;
+				for(int y2 = -bh; y2 <= bh; y2++)
 				{
-					for(x=0;x<w;x++)
-					{
-						//accumulate all the pixels in an ellipse of w,h about the current pixel
-						Color color=Color::alpha();
-						int total=0;
-
-						for(y2=-bh;y2<=bh;y2++)
-						{
-							for(x2=-bw;x2<=bw;x2++)
-							{
-								//get the floating point distance away from the origin pixel in relative coords
-								float tmp_x=(float)x2/bw;
-								float tmp_y=(float)y2/bh;
-								tmp_x*=tmp_x;
-								tmp_y*=tmp_y;
-
-								//ignore if it's outside of the disc
-								if( tmp_x+tmp_y>1.0)
-									continue;
-
-								//cap the pixel indices to inside the surface
-								int u= x+x2,
-									v= y+y2;
-
-								if( u < 0 )					u = 0;
-								if( u >= w ) u = w-1;
-
-								if( v < 0 ) 				v = 0;
-								if( v >= h ) v = h-1;
-
-								//accumulate the color, and # of pixels added in
-								color += tmp_surface[v][u];
-								total++;
-							}
-						}
-
-						//blend the color with the original color
-						//if(get_amount()==1.0 && get_blend_method()==Color::BLEND_STRAIGHT)
-							worksurface[y][x]=color/total;
-						//else
-						//	worksurface[y][x]=Color::blend(color/total,tmp_surface[y][x],get_amount(),get_blend_method());
-					}
-					if(!blurcall.amount_complete(y,h))
+					float tmp_y = (float)y2/bh;
+					tmp_y *= tmp_y;
+					int half = 0;
+					while(half < bw)
 					{
-						//if(cb)cb->error(strprintf(__FILE__"%d: Accelerated Renderer Failure",__LINE__));
-						return false;
+						float tmp_x = (float)(half + 1)/bw;
+						if (tmp_x*tmp_x + tmp_y > 1.0) break;
+						half++;
 					}
+					spans[y2 + bh] = half;
+					total += 2*half + 1;
 				}
+
+				std::vector<AT> table((size_t)(w + 1)*h);
+				run_bands(PrefixRows<T,AT,VP>(work, table), h, pixels);
+				if(!blurcall.amount_complete(1,2)) return false;
+				run_bands(DiscRows<T,AT,VP>(table, spans, 1.0f/total, work), h, pixels*(2*bh + 1));
 				break;
 			}
 
@@ -557,47 +476,15 @@ bool Blur::operator()(const Surface &surface,
 
 	case Blur::BOX: // B O X -------------------------------------------------------
 		{
-			//horizontal part
-			//synfig::info("Blur: Starting Box blur (surface valid %d)", (int)surface_valid(worksurface));
-
-			Surface temp_surface;
-			temp_surface.set_wh(w,h);
-
 			if(size[0])
-			{
-				int length = halfsizex;
-				length=std::max(1,length);
-
-				//synfig::info("Blur: hbox blur work -> temp %d", length);
-				etl::hbox_blur(worksurface.begin(),worksurface.end(),length,temp_surface.begin());
-			}
-			else temp_surface = worksurface;
-			//synfig::info("Blur: hbox finished");
-
-			//vertical part
-			//Surface temp_surface2;
-			//temp_surface2.set_wh(w,h);
+				hbox(work, work, BoxLength(std::max(1,halfsizex)));
+			if(!blurcall.amount_complete(1,2)) return false;
 
 			if(size[1])
 			{
-				int length = halfsizey;
-				length = std::max(1,length);
-
-				//synfig::info("Blur: vbox blur temp -> work %d",length);
-				etl::vbox_blur(temp_surface.begin(),temp_surface.end(),length,worksurface.begin());
+				vbox(work, temp_surface, BoxLength(std::max(1,halfsizey)));
+				copy_surface(temp_surface, work);
 			}
-			else worksurface = temp_surface;
-			//synfig::info("Blur: vbox finished");
-
-			//blend with the original surface
-			/*int x,y;
-			for(y=0;y<h;y++)
-			{
-				for(x=0;x<w;x++)
-				{
-					worksurface[y][x]=temp_surface2[y][x];//Color::blend(temp_surface2[y][x],worksurface[y][x],get_amount(),get_blend_method());
-				}
-			}*/
 		}
 		break;
 
@@ -610,12 +497,6 @@ bool Blur::operator()(const Surface &surface,
 				1	2	1
 			*/
 
-			Surface temp_surface;
-			temp_surface.set_wh(w,h);
-
-			//Surface temp_surface2;
-			//temp_surface2.set_wh(w,h);
-
 			//horizontal part
 			if(size[0])
 			{
@@ -623,10 +504,10 @@ bool Blur::operator()(const Surface &surface,
 				length=std::max(1.0,length);
 
 				//two box blurs produces: 1 2 1
-				etl::hbox_blur(worksurface.begin(),w,h,(int)(length*3/4),temp_surface.begin());
-				etl::hbox_blur(temp_surface.begin(),w,h,(int)(length*3/4),worksurface.begin());
+				hbox(work, work, BoxLength((int)(length*3/4)));
+				hbox(work, work, BoxLength((int)(length*3/4)));
 			}
-			//else temp_surface2=worksurface;
+			if(!blurcall.amount_complete(1,2)) return false;
 
 			//vertical part
 			if(size[1])
@@ -635,63 +516,33 @@ bool Blur::operator()(const Surface &surface,
 				length=std::max(1.0,length);
 
 				//two box blurs produces: 1 2 1 on the horizontal 1 2 1
-				etl::vbox_blur(worksurface.begin(),w,h,(int)(length*3/4),temp_surface.begin());
-				etl::vbox_blur(temp_surface.begin(),w,h,(int)(length*3/4),worksurface.begin());
+				vbox(work, temp_surface, BoxLength((int)(length*3/4)));
+				vbox(temp_surface, work, BoxLength((int)(length*3/4)));
 			}
-			//else temp_surface2=temp_surface2;
-
-			/*int x,y;
-			for(y=0;y<h;y++)
-			{
-				for(x=0;x<w;x++)
-				{
-					worksurface[y][x]=temp_surface2[y][x];//Color::blend(temp_surface2[y][x],worksurface[y][x],get_amount(),get_blend_method());
-				}
-			}*/
 		}
 		break;
 
 	case Blur::CROSS: // C R O S S  -------------------------------------------------------
 		{
-			//horizontal part
-			Surface temp_surface;
-			temp_surface.set_wh(worksurface.get_w(),worksurface.get_h());
+			surface_type temp_surface2(w,h);
 
+			//horizontal part
 			if(size[0])
-			{
-				int length = halfsizex;
-				length = std::max(1,length);
-
-				etl::hbox_blur(worksurface.begin(),worksurface.end(),length,temp_surface.begin());
-			}
-			else temp_surface = worksurface;
+				hbox(work, temp_surface, BoxLength(std::max(1,halfsizex)));
+			else
+				copy_surface(work, temp_surface);
+			if(!blurcall.amount_complete(1,2)) return false;
 
 			//vertical part
-			Surface temp_surface2;
-			temp_surface2.set_wh(worksurface.get_w(),worksurface.get_h());
-
 			if(size[1])
-			{
-				int length = halfsizey;
-				length = std::max(1,length);
-
-				etl::vbox_blur(worksurface.begin(),worksurface.end(),length,temp_surface2.begin());
-			}
-			else temp_surface2 = worksurface;
+				vbox(work, temp_surface2, BoxLength(std::max(1,halfsizey)));
+			else
+				copy_surface(work, temp_surface2);
 
 			//blend the two together
-			int x,y;
-
-			for(y=0;y<h;y++)
-			{
-				for(x=0;x<w;x++)
-				{
-					worksurface[y][x] = (temp_surface[y][x]+temp_surface2[y][x])/2;//Color::blend((temp_surface[y][x]+temp_surface2[y][x])/2,worksurface[y][x],get_amount(),get_blend_method());
-				}
-			}
-
-			break;
+			run_bands(Average<T,AT,VP>(temp_surface, temp_surface2, work), h, pixels);
 		}
+		break;
 
 	case Blur::GAUSSIAN:	// G A U S S I A N ----------------------------------------------
 		{
@@ -702,143 +553,114 @@ bool Blur::operator()(const Surface &surface,
 			Real	pw = (Real)w/(resolution[0]);
 			Real 	ph = (Real)h/(resolution[1]);
 
-			Surface temp_surface;
-			Surface *gauss_surface;
-
-			//synfig::warning("Didn't crash yet b1");
-
-			//if(get_amount()==1.0 && get_blend_method()==Color::BLEND_STRAIGHT)
-				gauss_surface = &worksurface;
-			/*else
-			{
-				temp_surface = worksurface;
-				gauss_surface = &temp_surface;
-			}*/
-
-            /* Squaring the pw and ph values
+			/* Squaring the pw and ph values
 			   is necessary to insure consistent
 			   results when rendered to different
 			   resolutions.
-			   Unfortunately, this automatically
-			   squares our rendertime.
-			   There has got to be a faster way...
 			*/
 			pw=pw*pw;
 			ph=ph*ph;
 
 			int bw = (int)(abs(pw)*size[0]*GAUSSIAN_ADJUSTMENT+0.5);
 			int bh = (int)(abs(ph)*size[1]*GAUSSIAN_ADJUSTMENT+0.5);
-			int max=bw+bh;
 
-			ColorAccumulator *SC0=new ColorAccumulator[w+2];
-			ColorAccumulator *SC1=new ColorAccumulator[w+2];
-			ColorAccumulator *SC2=new ColorAccumulator[w+2];
-			ColorAccumulator *SC3=new ColorAccumulator[w+2];
-
-			//synfig::warning("Didn't crash yet b2");
-			//int i = 0;
-
-			while(bw&&bh)
+			// The blur used to be bw passes of the 1 2 1 binomial filter
+			// (in steps of 5x5, 3x3 and 2x2), a variance of bw/4 pixels.
+			// Three boxes of a third of that variance each come very
+			// close to the same gaussian in a fixed number of passes.
+			if(bw)
 			{
-				if(!blurcall.amount_complete(max-(bw+bh),max))return false;
-
-				if(bw>=4 && bh>=4)
-				{
-					etl::gaussian_blur_5x5_(gauss_surface->begin(),gauss_surface->get_w(),gauss_surface->get_h(),SC0,SC1,SC2,SC3);
-					bw-=4,bh-=4;
-				}
-				else
-				if(bw>=2 && bh>=2)
-				{
-					etl::gaussian_blur_3x3(gauss_surface->begin(),gauss_surface->end());
-					bw-=2,bh-=2;
-				}
-				else
-				if(bw>=1 && bh>=1)
-				{
-					GaussianBlur_2x2(*gauss_surface);
-					bw--,bh--;
-				}
-
-				//synfig::warning("Didn't crash yet bi - %d",i++);
+				BoxLength box(BoxLength::from_variance(bw/12.0));
+				hbox(work, work, box);
+				hbox(work, work, box);
+				hbox(work, work, box);
 			}
-			while(bw)
+			if(!blurcall.amount_complete(1,2)) return false;
+
+			if(bh)
 			{
-				if(!blurcall.amount_complete(max-(bw+bh),max))return false;
-				if(bw>=2)
-				{
-					GaussianBlur_3x1(*gauss_surface);
-					bw-=2;
-				}
-				else
-				if(bw>=1)
-				{
-					GaussianBlur_2x1(*gauss_surface);
-					bw--;
-				}
-				//synfig::warning("Didn't crash yet bi - %d",i++);
+				BoxLength box(BoxLength::from_variance(bh/12.0));
+				vbox(work, temp_surface, box);
+				vbox(temp_surface, work, box);
+				vbox(work, temp_surface, box);
+				copy_surface(temp_surface, work);
 			}
-			while(bh)
+		}
+		break;
+
+		default:
+		break;
+	}
+
+	return true;
+}
+
+//! Premultiplies or divides out the alpha of a Surface
+struct AlphaRows
+{
+	const Surface &src;
+	Surface &dst;
+	bool premultiply;
+
+	AlphaRows(const Surface &src, Surface &dst, bool premultiply):
+		src(src), dst(dst), premultiply(premultiply) { }
+
+	void operator()(int begin, int end)const
+	{
+		const int w = src.get_w();
+		for(int y = begin; y < end; ++y)
+		{
+			for(int x = 0; x < w; ++x)
 			{
-				if(!blurcall.amount_complete(max-(bw+bh),max))return false;
-				if(bh>=2)
+				Color a = src[y][x];
+				if(premultiply)
 				{
-					GaussianBlur_1x3(*gauss_surface);
-					bh-=2;
+					a.set_r(a.get_r()*a.get_a());
+					a.set_g(a.get_g()*a.get_a());
+					a.set_b(a.get_b()*a.get_a());
 				}
 				else
-				if(bh>=1)
+				if(a.get_a())
 				{
-					GaussianBlur_1x2(*gauss_surface);
-					bh--;
+					a.set_r(a.get_r()/a.get_a());
+					a.set_g(a.get_g()/a.get_a());
+					a.set_b(a.get_b()/a.get_a());
 				}
-				//synfig::warning("Didn't crash yet bi - %d",i++);
+				else a=Color::alpha();
+				dst[y][x] = a;
 			}
+		}
+	}
+};
 
-			delete [] SC0;
-			delete [] SC1;
-			delete [] SC2;
-			delete [] SC3;
+} // END of anonymous namespace
 
-			/*if(get_amount()!=1.0 || get_blend_method()!=Color::BLEND_STRAIGHT)
-			{
-				int x,y;
-				for(y=0;y<renddesc.get_h();y++)
-					for(x=0;x<renddesc.get_w();x++)
-						worksurface[y][x]=Color::blend(temp_surface[y][x],worksurface[y][x],get_amount(),get_blend_method());
-			}*/
-			//synfig::warning("Didn't crash yet b end",i++);
-		}
-		break;
+//THE GOOD ONE!!!!!!!!!
+bool Blur::operator()(const Surface &surface,
+					  const Vector &resolution,
+					  Surface &out) const
+{
+	int w = surface.get_w(),
+		h = surface.get_h();
 
-		default:
-		break;
-	}
+	if(w == 0 || h == 0 || resolution[0] == 0 || resolution[1] == 0) return false;
+
+	SuperCallback blurcall(cb,0,5000,5000);
+
+	Surface worksurface(w,h);
 
-	// Scale up the alpha
+	// Premultiply the alpha
+	run_bands(AlphaRows(surface, worksurface, true), h, w*h);
+
+	if(!blur_surface(worksurface, type, size, resolution, blurcall))
+		return false;
 
 	//be sure the surface is of the correct size
-	//surface->set_wh(renddesc.get_w(),renddesc.get_h());
 	out.set_wh(w,h);
 
 	//divide out the alpha
-	for(y=0;y<h;y++)
-	{
-		for(x=0;x<w;x++)
-		{
-			Color a = worksurface[y][x];
-			if(a.get_a())
-			{
-				a.set_r(a.get_r()/a.get_a());
-				a.set_g(a.get_g()/a.get_a());
-				a.set_b(a.get_b()/a.get_a());
-				out[y][x]=a;
-			}
-			else out[y][x]=Color::alpha();
-		}
-	}
+	run_bands(AlphaRows(worksurface, out, false), h, w*h);
 
-	//we are FRIGGGIN done....
 	blurcall.amount_complete(100,100);
 
 	return true;
@@ -859,23 +681,15 @@ bool Blur::operator()(cairo_surface_t *surface,
 
 	int w = cairosurface.get_w(),
 	h = cairosurface.get_h();
-	
+
 	if(w == 0 || h == 0 || resolution[0] == 0 || resolution[1] == 0)
 	{
 		cairosurface.unmap_cairo_image();
 		return false;
 	}
-	
-	const Real	pw = resolution[0]/w,
-	ph = resolution[1]/h;
-	
-	int	halfsizex = (int) (abs(size[0]*.5/pw) + 1),
-	halfsizey = (int) (abs(size[1]*.5/ph) + 1);
-	
-	int x,y;
-	
+
 	SuperCallback blurcall(cb,0,5000,5000);
-	
+
 	CairoSurface cairoout(out);
 	if(!cairoout.map_cairo_image())
 	{
@@ -884,310 +698,17 @@ bool Blur::operator()(cairo_surface_t *surface,
 		return false;
 	}
 
-	switch(type)
-	{
-		case Blur::DISC:	// D I S C ----------------------------------------------------------
-		{
-			int bw = halfsizex;
-			int bh = halfsizey;
-			
-			if(size[0] && size[1] && w*h>2)
-			{
-				int x2,y2;
-				
-				for(y=0;y<h;y++)
-				{
-					for(x=0;x<w;x++)
-					{
-						//accumulate all the pixels in an ellipse of w,h about the current pixel
-						Color color=Color::alpha();
-						int total=0;
-						
-						for(y2=-bh;y2<=bh;y2++)
-						{
-							for(x2=-bw;x2<=bw;x2++)
-							{
-								//get the floating point distance away from the origin pixel in relative coords
-								float tmp_x=(float)x2/bw;
-								float tmp_y=(float)y2/bh;
-								tmp_x*=tmp_x;
-								tmp_y*=tmp_y;
-								
-								//ignore if it's outside of the disc
-								if( tmp_x+tmp_y>1.0)
-									continue;
-								
-								//cap the pixel indices to inside the surface
-								int u= x+x2,
-								v= y+y2;
-								
-								if( u < 0 )					u = 0;
-								if( u >= w ) u = w-1;
-								
-								if( v < 0 ) 				v = 0;
-								if( v >= h ) v = h-1;
-								
-								//accumulate the color, and # of pixels added in
-								color += Color(cairosurface[v][u]);
-								total++;
-							}
-						}
-						
-						//blend the color with the original color
-						cairoout[y][x]=CairoColor(color/total);
-					}
-					if(!blurcall.amount_complete(y,h))
-					{
-						if(cb)cb->error(strprintf(__FILE__"%d: Accelerated Renderer Failure",__LINE__));
-						cairosurface.unmap_cairo_image();
-						cairoout.unmap_cairo_image();
-						return false;
-					}
-				}
-				break;
-			}
-			//if we don't qualify for disc blur just use box blur
-		}
-			
-		case Blur::BOX: // B O X -------------------------------------------------------
-		{
-			cairo_surface_t* temp=cairo_surface_create_similar(surface, CAIRO_CONTENT_COLOR_ALPHA, w, h);
-			CairoSurface cairotemp(temp);
-			if(!cairotemp.map_cairo_image())
-			{
-				synfig::info("cairotemp map cairo image failed");
-				return false;
-			}
-			//horizontal part
-			if(size[0])
-			{
-				int length = halfsizex;
-				length=std::max(1,length);
-				etl::hbox_blur(cairosurface.begin(),cairosurface.end(),length,cairotemp.begin());
-			}
-			else cairotemp.copy(cairosurface);
-			
-			//vertical part
-			if(size[1])
-			{
-				int length = halfsizey;
-				length = std::max(1,length);
-				etl::vbox_blur(cairotemp.begin(),cairotemp.end(),length,cairoout.begin());
-			}
-			else cairoout.copy(cairotemp);
-			cairotemp.unmap_cairo_image();
-			cairo_surface_destroy(temp);
-		}
-			break;
-			
-		case Blur::FASTGAUSSIAN:	// F A S T G A U S S I A N ----------------------------------------------
-		{
-			//fast gaussian is treated as a 3x3 type of thing, except expanded to work with the length
-			
-			/*	1	2	1
-			 2	4	2
-			 1	2	1
-			 */
-			cairo_surface_t* temp=cairo_surface_create_similar(surface, CAIRO_CONTENT_COLOR_ALPHA, w, h);
-			CairoSurface cairotemp(temp);
-			if(!cairotemp.map_cairo_image())
-			{
-				synfig::info("cairotemp map cairo image failed. Fast Gaussian");
-				return false;
-			}
-			
-			//horizontal part
-			if(size[0])
-			{
-				Real length=abs((float)w/(resolution[0]))*size[0]*0.5+1;
-				length=std::max(1.0,length);
-				
-				//two box blurs produces: 1 2 1
-				etl::hbox_blur(cairosurface.begin(),w,h,(int)(length*3/4),cairotemp.begin());
-				etl::hbox_blur(cairotemp.begin(),w,h,(int)(length*3/4),cairoout.begin());
-			}
-			else cairoout.copy(cairosurface);
-			
-			// Interchange result with temp
-			cairotemp.copy(cairoout);
-			//vertical part
-			if(size[1])
-			{
-				Real length=abs((float)h/(resolution[1]))*size[1]*0.5+1;
-				length=std::max(1.0,length);
-				
-				//two box blurs produces: 1 2 1 on the horizontal 1 2 1
-				etl::vbox_blur(cairoout.begin(),w,h,(int)(length*3/4),cairotemp.begin());
-				etl::vbox_blur(cairotemp.begin(),w,h,(int)(length*3/4),cairoout.begin());
-			}
-			else cairoout.copy(cairotemp);
-			cairotemp.unmap_cairo_image();
-			cairo_surface_destroy(temp);			
-		}
-			break;
-			
-		case Blur::CROSS: // C R O S S  -------------------------------------------------------
-		{
-			//horizontal part
-			cairo_surface_t* temp=cairo_surface_create_similar(surface, CAIRO_CONTENT_COLOR_ALPHA, w, h);
-			CairoSurface cairotemp(temp);
-			if(!cairotemp.map_cairo_image())
-			{
-				synfig::info("cairotemp map cairo image failed. Cross");
-				cairo_surface_destroy(temp);
-				return false;
-			}
-			
-			if(size[0])
-			{
-				int length = halfsizex;
-				length = std::max(1,length);
-				
-				etl::hbox_blur(cairosurface.begin(),cairosurface.end(),length,cairotemp.begin());
-			}
-			else cairotemp.copy(cairosurface);
-			
-			//vertical part
-			cairo_surface_t* temp2=cairo_surface_create_similar(surface, CAIRO_CONTENT_COLOR_ALPHA, w, h);
-			CairoSurface cairotemp2(temp2);
-			if(!cairotemp2.map_cairo_image())
-			{
-				synfig::info("cairotemp2 map cairo image failed. Cross");
-				cairotemp.unmap_cairo_image();
-				cairo_surface_destroy(temp);
-				cairo_surface_destroy(temp2);
-				return false;
-			}
-			
-			if(size[1])
-			{
-				int length = halfsizey;
-				length = std::max(1,length);
-				
-				etl::vbox_blur(cairosurface.begin(),cairosurface.end(),length,cairotemp2.begin());
-			}
-			else cairotemp2.copy(cairosurface);
-			
-			//blend the two together
-			int x,y;
-			
-			for(y=0;y<h;y++)
-			{
-				for(x=0;x<w;x++)
-				{
-					cairoout[y][x] = cairotemp[y][x]*0.5+cairotemp2[y][x]*0.5;
-				}
-			}
-			cairotemp.unmap_cairo_image();
-			cairo_surface_destroy(temp);
-			cairotemp2.unmap_cairo_image();
-			cairo_surface_destroy(temp2);
-			break;
-		}
-			
-		case Blur::GAUSSIAN:	// G A U S S I A N ----------------------------------------------
-		{
-#ifndef	GAUSSIAN_ADJUSTMENT
-#define GAUSSIAN_ADJUSTMENT		(0.05)
-#endif
-			
-			Real	pw = (Real)w/(resolution[0]);
-			Real 	ph = (Real)h/(resolution[1]);
-			
-			CairoSurface *gauss_surface;
-			cairoout.copy(cairosurface);
-			gauss_surface = &cairoout;
-            /* Squaring the pw and ph values
-			 is necessary to insure consistent
-			 results when rendered to different
-			 resolutions.
-			 Unfortunately, this automatically
-			 squares our rendertime.
-			 There has got to be a faster way...
-			 */
-			pw=pw*pw;
-			ph=ph*ph;
-			
-			int bw = (int)(abs(pw)*size[0]*GAUSSIAN_ADJUSTMENT+0.5);
-			int bh = (int)(abs(ph)*size[1]*GAUSSIAN_ADJUSTMENT+0.5);
-			int max=bw+bh;
-			
-			CairoColorAccumulator *SC0=new class CairoColorAccumulator[w+2];
-			CairoColorAccumulator *SC1=new class CairoColorAccumulator[w+2];
-			CairoColorAccumulator *SC2=new class CairoColorAccumulator[w+2];
-			CairoColorAccumulator *SC3=new class CairoColorAccumulator[w+2];
-						
-			while(bw&&bh)
-			{
-				if(!blurcall.amount_complete(max-(bw+bh),max))return false;
-				
-				if(bw>=4 && bh>=4)
-				{
-					etl::gaussian_blur_5x5_(gauss_surface->begin(),gauss_surface->get_w(),gauss_surface->get_h(),SC0,SC1,SC2,SC3);
-					bw-=4,bh-=4;
-				}
-				else
-					if(bw>=2 && bh>=2)
-					{
-						etl::gaussian_blur_3x3(gauss_surface->begin(),gauss_surface->end());
-						bw-=2,bh-=2;
-					}
-					else
-						if(bw>=1 && bh>=1)
-						{
-							GaussianBlur_2x2(*gauss_surface);
-							bw--,bh--;
-						}				
-			}
-			while(bw)
-			{
-				if(!blurcall.amount_complete(max-(bw+bh),max))return false;
-				if(bw>=2)
-				{
-					GaussianBlur_3x1(*gauss_surface);
-					bw-=2;
-				}
-				else
-					if(bw>=1)
-					{
-						GaussianBlur_2x1(*gauss_surface);
-						bw--;
-					}
-			}
-			while(bh)
-			{
-				if(!blurcall.amount_complete(max-(bw+bh),max))return false;
-				if(bh>=2)
-				{
-					GaussianBlur_1x3(*gauss_surface);
-					bh-=2;
-				}
-				else
-					if(bh>=1)
-					{
-						GaussianBlur_1x2(*gauss_surface);
-						bh--;
-					}
-			}
-			
-			delete [] SC0;
-			delete [] SC1;
-			delete [] SC2;
-			delete [] SC3;
-		}
-			break;
-			
-		default:
-			break;
-	}
+	// cairo colors are premultiplied already
+	copy_surface(cairosurface, cairoout);
+	bool success = blur_surface(cairoout, type, size, resolution, blurcall);
+
+	if(success)
+		blurcall.amount_complete(100,100);
 
-	//we are FRIGGGIN done....
-	blurcall.amount_complete(100,100);
-	
 	cairosurface.unmap_cairo_image();
 	cairoout.unmap_cairo_image();
-	
-	return true;
+
+	return success;
 }
 
 //////
@@ -1201,347 +722,16 @@ bool Blur::operator()(const etl::surface<float> &surface,
 
 	if(w == 0 || h == 0 || resolution[0] == 0 || resolution[1] == 0) return false;
 
-	const Real	pw = resolution[0]/w,
-				ph = resolution[1]/h;
-
-	int	halfsizex = (int) (abs(size[0]*.5/pw) + 1),
-		halfsizey = (int) (abs(size[1]*.5/ph) + 1);
-	int x,y;
-
 	SuperCallback blurcall(cb,0,5000,5000);
 
-	etl::surface<float> worksurface(surface);
-
 	//don't need to premultiply because we are dealing with ONLY alpha
+	etl::surface<float> worksurface(surface);
 
-	switch(type)
-	{
-	case Blur::DISC:	// D I S C ----------------------------------------------------------
-		{
-			int bw = halfsizex;
-			int bh = halfsizey;
-
-			if(size[0] && size[1] && w*h>2)
-			{
-				int x2,y2;
-				etl::surface<float> tmp_surface(worksurface);
-
-				for(y=0;y<h;y++)
-				{
-					for(x=0;x<w;x++)
-					{
-						//accumulate all the pixels in an ellipse of w,h about the current pixel
-						float a = 0;
-						int total=0;
-
-						for(y2=-bh;y2<=bh;y2++)
-						{
-							for(x2=-bw;x2<=bw;x2++)
-							{
-								//get the floating point distance away from the origin pixel in relative coords
-								float tmp_x=(float)x2/bw;
-								float tmp_y=(float)y2/bh;
-								tmp_x*=tmp_x;
-								tmp_y*=tmp_y;
-
-								//ignore if it's outside of the disc
-								if( tmp_x+tmp_y>1.0)
-									continue;
-
-								//cap the pixel indices to inside the surface
-								int u= x+x2,
-									v= y+y2;
-
-								if( u < 0 )					u = 0;
-								if( u >= w ) u = w-1;
-
-								if( v < 0 ) 				v = 0;
-								if( v >= h ) v = h-1;
-
-								//accumulate the color, and # of pixels added in
-								a += tmp_surface[v][u];
-								total++;
-							}
-						}
-
-						//blend the color with the original color
-						//if(get_amount()==1.0 && get_blend_method()==Color::BLEND_STRAIGHT)
-							worksurface[y][x]=a/total;
-						//else
-						//	worksurface[y][x]=Color::blend(color/total,tmp_surface[y][x],get_amount(),get_blend_method());
-					}
-					if(!blurcall.amount_complete(y,h))
-					{
-						//if(cb)cb->error(strprintf(__FILE__"%d: Accelerated Renderer Failure",__LINE__));
-						return false;
-					}
-				}
-				break;
-			}
-
-			//if we don't qualify for disc blur just use box blur
-		}
-
-	case Blur::BOX: // B O X -------------------------------------------------------
-		{
-			//horizontal part
-			etl::surface<float> temp_surface;
-			temp_surface.set_wh(w,h);
-
-			if(size[0])
-			{
-				int length = halfsizex;
-				length=std::max(1,length);
-
-				etl::hbox_blur(worksurface.begin(),worksurface.end(),length,temp_surface.begin());
-			}
-			else temp_surface = worksurface;
-
-			//vertical part
-			//etl::surface<float> temp_surface2;
-			//temp_surface2.set_wh(w,h);
-
-			if(size[1])
-			{
-				int length = halfsizey;
-				length = std::max(1,length);
-				etl::vbox_blur(temp_surface.begin(),temp_surface.end(),length,worksurface.begin());
-			}
-			else worksurface = temp_surface;
-
-			//blend with the original surface
-			/*int x,y;
-			for(y=0;y<h;y++)
-			{
-				for(x=0;x<w;x++)
-				{
-					worksurface[y][x]=temp_surface2[y][x];//Color::blend(temp_surface2[y][x],worksurface[y][x],get_amount(),get_blend_method());
-				}
-			}*/
-		}
-		break;
-
-	case Blur::FASTGAUSSIAN:	// F A S T G A U S S I A N ----------------------------------------------
-		{
-			//fast gaussian is treated as a 3x3 type of thing, except expanded to work with the length
-
-			/*	1	2	1
-				2	4	2
-				1	2	1
-			*/
-
-			etl::surface<float> temp_surface;
-			temp_surface.set_wh(w,h);
-
-			//etl::surface<float> temp_surface2;
-			//temp_surface2.set_wh(w,h);
-
-			//horizontal part
-			if(size[0])
-			{
-				Real length=abs((float)w/(resolution[0]))*size[0]*0.5+1;
-				length=std::max(1.0,length);
-
-				//two box blurs produces: 1 2 1
-				etl::hbox_blur(worksurface.begin(),w,h,(int)(length*3/4),temp_surface.begin());
-				etl::hbox_blur(temp_surface.begin(),w,h,(int)(length*3/4),worksurface.begin());
-			}
-			//else temp_surface2=worksurface;
-
-			//vertical part
-			if(size[1])
-			{
-				Real length=abs((float)h/(resolution[1]))*size[1]*0.5+1;
-				length=std::max(1.0,length);
-
-				//two box blurs produces: 1 2 1 on the horizontal 1 2 1
-				etl::vbox_blur(worksurface.begin(),w,h,(int)(length*3/4),temp_surface.begin());
-				etl::vbox_blur(temp_surface.begin(),w,h,(int)(length*3/4),worksurface.begin());
-			}
-			//else temp_surface2=temp_surface2;
-
-			/*int x,y;
-			for(y=0;y<h;y++)
-			{
-				for(x=0;x<w;x++)
-				{
-					worksurface[y][x]=temp_surface2[y][x];//Color::blend(temp_surface2[y][x],worksurface[y][x],get_amount(),get_blend_method());
-				}
-			}*/
-		}
-		break;
-
-	case Blur::CROSS: // C R O S S  -------------------------------------------------------
-		{
-			//horizontal part
-			etl::surface<float> temp_surface;
-			temp_surface.set_wh(worksurface.get_w(),worksurface.get_h());
-
-			if(size[0])
-			{
-				int length = halfsizex;
-				length = std::max(1,length);
-
-				etl::hbox_blur(worksurface.begin(),worksurface.end(),length,temp_surface.begin());
-			}
-			else temp_surface = worksurface;
-
-			//vertical part
-			etl::surface<float> temp_surface2;
-			temp_surface2.set_wh(worksurface.get_w(),worksurface.get_h());
-
-			if(size[1])
-			{
-				int length = halfsizey;
-				length = std::max(1,length);
-
-				etl::vbox_blur(worksurface.begin(),worksurface.end(),length,temp_surface2.begin());
-			}
-			else temp_surface2 = worksurface;
-
-			//blend the two together
-			int x,y;
-
-			for(y=0;y<h;y++)
-			{
-				for(x=0;x<w;x++)
-				{
-					worksurface[y][x] = (temp_surface[y][x]+temp_surface2[y][x])/2;//Color::blend((temp_surface[y][x]+temp_surface2[y][x])/2,worksurface[y][x],get_amount(),get_blend_method());
-				}
-			}
-
-			break;
-		}
-
-	case Blur::GAUSSIAN:	// G A U S S I A N ----------------------------------------------
-		{
-			#ifndef	GAUSSIAN_ADJUSTMENT
-			#define GAUSSIAN_ADJUSTMENT		(0.05)
-			#endif
-
-			Real	pw = (Real)w/(resolution[0]);
-			Real 	ph = (Real)h/(resolution[1]);
-
-			//etl::surface<float> temp_surface;
-			etl::surface<float> *gauss_surface;
-
-			//if(get_amount()==1.0 && get_blend_method()==Color::BLEND_STRAIGHT)
-				gauss_surface = &worksurface;
-			/*else
-			{
-				temp_surface = worksurface;
-				gauss_surface = &temp_surface;
-			}*/
-
-            /* Squaring the pw and ph values
-			   is necessary to insure consistent
-			   results when rendered to different
-			   resolutions.
-			   Unfortunately, this automatically
-			   squares our rendertime.
-			   There has got to be a faster way...
-			*/
-			pw=pw*pw;
-			ph=ph*ph;
-
-			int bw = (int)(abs(pw)*size[0]*GAUSSIAN_ADJUSTMENT+0.5);
-			int bh = (int)(abs(ph)*size[1]*GAUSSIAN_ADJUSTMENT+0.5);
-			int max=bw+bh;
-
-			float *SC0=new float[w+2];
-			float *SC1=new float[w+2];
-			float *SC2=new float[w+2];
-			float *SC3=new float[w+2];
-
-			memset(SC0,0,(w+2)*sizeof(float));
-			memset(SC0,0,(w+2)*sizeof(float));
-			memset(SC0,0,(w+2)*sizeof(float));
-			memset(SC0,0,(w+2)*sizeof(float));
-
-			//int i = 0;
-
-			while(bw&&bh)
-			{
-				if(!blurcall.amount_complete(max-(bw+bh),max))return false;
-
-				if(bw>=4 && bh>=4)
-				{
-					etl::gaussian_blur_5x5_(gauss_surface->begin(),gauss_surface->get_w(),gauss_surface->get_h(),SC0,SC1,SC2,SC3);
-					bw-=4,bh-=4;
-				}
-				else
-				if(bw>=2 && bh>=2)
-				{
-					etl::gaussian_blur_3x3(gauss_surface->begin(),gauss_surface->end());
-					bw-=2,bh-=2;
-				}
-				else
-				if(bw>=1 && bh>=1)
-				{
-					GaussianBlur_2x2(*gauss_surface);
-					bw--,bh--;
-				}
-			}
-
-			while(bw)
-			{
-				if(!blurcall.amount_complete(max-(bw+bh),max))return false;
-				if(bw>=2)
-				{
-					GaussianBlur_3x1(*gauss_surface);
-					bw-=2;
-				}
-				else
-				if(bw>=1)
-				{
-					GaussianBlur_2x1(*gauss_surface);
-					bw--;
-				}
-			}
-
-			while(bh)
-			{
-				if(!blurcall.amount_complete(max-(bw+bh),max))return false;
-				if(bh>=2)
-				{
-					GaussianBlur_1x3(*gauss_surface);
-					bh-=2;
-				}
-				else
-				if(bh>=1)
-				{
-					GaussianBlur_1x2(*gauss_surface);
-					bh--;
-				}
-			}
-
-			delete [] SC0;
-			delete [] SC1;
-			delete [] SC2;
-			delete [] SC3;
-
-			/*if(get_amount()!=1.0 || get_blend_method()!=Color::BLEND_STRAIGHT)
-			{
-				int x,y;
-				for(y=0;y<renddesc.get_h();y++)
-					for(x=0;x<renddesc.get_w();x++)
-						worksurface[y][x]=Color::blend(temp_surface[y][x],worksurface[y][x],get_amount(),get_blend_method());
-			}*/
-		}
-		break;
-
-		default:
-		break;
-	}
-
-	//be sure the surface is of the correct size
-	//surface->set_wh(renddesc.get_w(),renddesc.get_h());
-	out.set_wh(w,h);
+	if(!blur_surface(worksurface, type, size, resolution, blurcall))
+		return false;
 
-	//divide out the alpha - don't need to cause we rock
 	out = worksurface;
 
-	//we are FRIGGGIN done....
 	blurcall.amount_complete(100,100);
 
 	return true;
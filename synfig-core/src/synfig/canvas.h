@@ -43,6 +43,7 @@
 #include "node.h"
 #include "guid.h"
 #include "filesystem.h"
+#include "mutex.h"
 
 /* === M A C R O S ========================================================= */
 
@@ -251,6 +252,10 @@ private:
 	/*! \see get_grow_value set_grow_value */
 	Real grow_value;
 
+	//! Held by the layers pasting the canvas while they set its time and grow value
+	/*! \see get_render_mutex() */
+	mutable RecMutex render_mutex_;
+
 
 	/*
  -- ** -- S I G N A L S -------------------------------------------------------
@@ -640,6 +645,9 @@ public:
 	Real get_grow_value()const;
 	void set_grow_value(Real x);
 
+	//! Guards the time and the grow value while a layer pasting the canvas renders it
+	RecMutex &get_render_mutex()const { return render_mutex_; }
+
 #if 0
 	void show_canvas_ancestry(String file, int line, String note)const;
 	void show_canvas_ancestry()const;
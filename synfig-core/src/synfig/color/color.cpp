@@ -40,6 +40,7 @@
 #include <iomanip>
 
 #include "colorblendingfunctions.h"
+#include "colorblendingspans.h"
 
 #endif
 
@@ -202,6 +203,35 @@ Color::clamped()const
 }
 
 
+// WARNING: any change here must be coordinated with
+// other specializations of the functions, for example
+// for CairoColor
+static const blendfunc blend_vtable[Color::BLEND_END]=
+{
+	blendfunc_COMPOSITE<Color>,	// 0
+	blendfunc_STRAIGHT<Color>,
+	blendfunc_BRIGHTEN<Color>,
+	blendfunc_DARKEN<Color>,
+	blendfunc_ADD<Color>,
+	blendfunc_SUBTRACT<Color>,		// 5
+	blendfunc_MULTIPLY<Color>,
+	blendfunc_DIVIDE<Color>,
+	blendfunc_COLOR<Color>,
+	blendfunc_HUE<Color>,
+	blendfunc_SATURATION<Color>,	// 10
+	blendfunc_LUMINANCE<Color>,
+	blendfunc_BEHIND<Color>,
+	blendfunc_ONTO<Color>,
+	blendfunc_ALPHA_BRIGHTEN<Color>,
+	blendfunc_ALPHA_DARKEN<Color>,	// 15
+	blendfunc_SCREEN<Color>,
+	blendfunc_HARD_LIGHT<Color>,
+	blendfunc_DIFFERENCE<Color>,
+	blendfunc_ALPHA_OVER<Color>,
+	blendfunc_OVERLAY<Color>,		// 20
+	blendfunc_STRAIGHT_ONTO<Color>,
+};
+
 Color
 Color::blend(Color a, Color b,float amount, Color::BlendMethod type)
 {
@@ -212,35 +242,27 @@ Color::blend(Color a, Color b,float amount, Color::BlendMethod type)
 
 	assert(type<BLEND_END);
 
-	const static blendfunc vtable[BLEND_END]=
-	{
-        // WARNING: any change here must be coordinated with
-        // other specializations of the functions, for example
-        // for CairoColor
-		blendfunc_COMPOSITE<Color>,	// 0
-		blendfunc_STRAIGHT<Color>,
-		blendfunc_BRIGHTEN<Color>,
-		blendfunc_DARKEN<Color>,
-		blendfunc_ADD<Color>,
-		blendfunc_SUBTRACT<Color>,		// 5
-		blendfunc_MULTIPLY<Color>,
-		blendfunc_DIVIDE<Color>,
-		blendfunc_COLOR<Color>,
-		blendfunc_HUE<Color>,
-		blendfunc_SATURATION<Color>,	// 10
-		blendfunc_LUMINANCE<Color>,
-		blendfunc_BEHIND<Color>,
-		blendfunc_ONTO<Color>,
-		blendfunc_ALPHA_BRIGHTEN<Color>,
-		blendfunc_ALPHA_DARKEN<Color>,	// 15
-		blendfunc_SCREEN<Color>,
-		blendfunc_HARD_LIGHT<Color>,
-		blendfunc_DIFFERENCE<Color>,
-		blendfunc_ALPHA_OVER<Color>,
-		blendfunc_OVERLAY<Color>,		// 20
-		blendfunc_STRAIGHT_ONTO<Color>,
-	};
-
-	return vtable[type](a,b,amount);
+	return blend_vtable[type](a,b,amount);
 }
 
+void
+Color::blend_span(Color *dest, const Color *src, int count, float amount, Color::BlendMethod type)
+{
+	if(fabsf(amount)<=COLOR_EPSILON)return;
+
+	assert(type<BLEND_END);
+
+	// the vectorized version does the bulk of the span,
+	// the remaining colors are blended one by one
+	int i=0;
+	const blendspanfunc func(get_blend_span_functions()[type]);
+	if(func)
+		i=func(dest,src,count,amount);
+
+	const blendfunc scalar(blend_vtable[type]);
+	for(;i<count;i++)
+	{
+		Color a(src[i]);
+		dest[i]=scalar(a,dest[i],amount);
+	}
+}
@@ -288,6 +288,11 @@ public:
 	/* Other */
 	static Color blend(Color a, Color b,float amount,BlendMethod type=BLEND_COMPOSITE);
 
+	//! Blends \a count colors of \a src onto \a dest
+	/*!	Gives the same result as dest[i]=blend(src[i],dest[i],amount,type)
+	**	for every color, using the vector instructions of the processor */
+	static void blend_span(Color *dest, const Color *src, int count, float amount, BlendMethod type=BLEND_COMPOSITE);
+
 	static bool is_onto(BlendMethod x)
 	{
 		return x==BLEND_BRIGHTEN
@@ -0,0 +1,206 @@
+/* === S Y N F I G ========================================================= */
+/*!	\file colorblendingkernels.h
+**	\brief Blend methods written with generic vector operations
+**
+**	$Id$
+**
+**	\legal
+**	Copyright (c) 2016 Synfig contributors
+**
+**	This package is free software; you can redistribute it and/or
+**	modify it under the terms of the GNU General Public License as
+**	published by the Free Software Foundation; either version 2 of
+**	the License, or (at your option) any later version.
+**
+**	This package is distributed in the hope that it will be useful,
+**	but WITHOUT ANY WARRANTY; without even the implied warranty of
+**	MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE. See the GNU
+**	General Public License for more details.
+**	\endlegal
+*/
+/* ========================================================================= */
+
+/*	This file is included once per instruction set by colorblendingspans.cpp,
+**	so it has no include guard. The including namespace provides:
+**	  vec                    - a vector of PIXELS colors, alpha in the first lane of each
+**	  load(), store()        - unaligned access to PIXELS colors
+**	  splat(), splat_color() - a float or a color repeated in every lane or pixel
+**	  add(), sub(), mul(), div(), vmin(), vmax(), vabs()
+**	  alpha()                - the alpha of every pixel repeated in its four lanes
+**	  with_alpha(c, a)       - the colors of c with the alphas of a
+**	  greater(), equal()     - comparison masks
+**	  select(m, a, b)        - m ? a : b, lane by lane
+**	The kernels follow the scalar versions in colorblendingfunctions.h
+**	operation by operation. */
+
+/* === K E R N E L S ======================================================= */
+
+inline vec invert(vec a)
+	{ return with_alpha(sub(splat(1.0f), a), a); }
+
+inline vec blend_COMPOSITE(vec src, vec dest, vec amount)
+{
+	const vec one = splat(1.0f);
+	const vec a_src = mul(alpha(src), amount);
+	const vec a_dest = alpha(dest);
+	const vec c = add(mul(src, a_src), mul(mul(dest, a_dest), sub(one, a_src)));
+	const vec a_out = add(a_src, mul(a_dest, sub(one, a_src)));
+	return select(
+		greater(vabs(a_out), splat(COLOR_EPSILON)),
+		with_alpha(mul(c, div(one, a_out)), a_out),
+		splat_color(Color::alpha()) );
+}
+
+inline vec blend_STRAIGHT(vec src, vec bg, vec amount)
+{
+	const vec a_src = alpha(src);
+	const vec a_bg = alpha(bg);
+	const vec a_out = add(mul(sub(a_src, a_bg), amount), a_bg);
+	const vec c = add(mul(sub(mul(src, a_src), mul(bg, a_bg)), amount), mul(bg, a_bg));
+	return select(
+		greater(vabs(a_out), splat(COLOR_EPSILON)),
+		with_alpha(mul(c, div(splat(1.0f), a_out)), a_out),
+		splat_color(Color::alpha()) );
+}
+
+inline vec blend_ONTO(vec a, vec b, vec amount)
+	{ return with_alpha(blend_COMPOSITE(a, with_alpha(b, splat(1.0f)), amount), b); }
+
+inline vec blend_STRAIGHT_ONTO(vec a, vec b, vec amount)
+	{ return blend_STRAIGHT(with_alpha(a, mul(alpha(a), alpha(b))), b, amount); }
+
+inline vec blend_BRIGHTEN(vec a, vec b, vec amount)
+	{ return with_alpha(vmax(b, mul(a, mul(alpha(a), amount))), b); }
+
+inline vec blend_DARKEN(vec a, vec b, vec amount)
+{
+	const vec one = splat(1.0f);
+	return with_alpha(vmin(b, add(mul(sub(a, one), mul(alpha(a), amount)), one)), b);
+}
+
+inline vec blend_ADD(vec a, vec b, vec amount)
+	{ return with_alpha(add(b, mul(a, mul(alpha(a), amount))), b); }
+
+inline vec blend_SUBTRACT(vec a, vec b, vec amount)
+	{ return with_alpha(sub(b, mul(a, mul(alpha(a), amount))), b); }
+
+inline vec blend_DIFFERENCE(vec a, vec b, vec amount)
+	{ return with_alpha(vabs(sub(b, mul(a, mul(alpha(a), amount)))), b); }
+
+inline vec blend_MULTIPLY(vec a, vec b, vec amount)
+{
+	const vec k = mul(amount, alpha(a));
+	return with_alpha(add(mul(sub(mul(b, a), b), k), b), b);
+}
+
+inline vec blend_DIVIDE(vec a, vec b, vec amount)
+{
+	const vec k = mul(amount, alpha(a));
+	return with_alpha(add(mul(sub(div(b, add(a, splat(COLOR_EPSILON))), b), k), b), b);
+}
+
+inline vec blend_SCREEN(vec a, vec b, vec amount)
+{
+	const vec one = splat(1.0f);
+	return blend_ONTO(with_alpha(sub(one, mul(sub(one, a), sub(one, b))), a), b, amount);
+}
+
+inline vec blend_OVERLAY(vec a, vec b, vec amount)
+{
+	const vec one = splat(1.0f);
+	const vec rm = mul(b, a);
+	const vec rs = sub(one, mul(sub(one, a), sub(one, b)));
+	return blend_ONTO(with_alpha(add(mul(a, rs), mul(sub(one, a), rm)), a), b, amount);
+}
+
+inline vec blend_HARD_LIGHT(vec a, vec b, vec amount)
+{
+	const vec one = splat(1.0f);
+	const vec two_a = mul(a, splat(2.0f));
+	const vec light = sub(one, mul(sub(one, sub(two_a, one)), sub(one, b)));
+	const vec dark = mul(b, two_a);
+	const vec c = select(greater(a, splat(0.5f)), light, dark);
+	return blend_ONTO(with_alpha(c, a), b, amount);
+}
+
+inline vec blend_ALPHA_OVER(vec a, vec b, vec amount)
+{
+	const vec rm = with_alpha(b, mul(sub(splat(1.0f), alpha(a)), alpha(b)));
+	return blend_STRAIGHT(rm, b, amount);
+}
+
+inline vec blend_BEHIND(vec a, vec b, vec amount)
+{
+	const vec a_a = alpha(a);
+	const vec a_new = select(
+		equal(a_a, splat(0.0f)),
+		mul(splat(COLOR_EPSILON), amount),
+		mul(a_a, amount) );
+	return blend_COMPOSITE(b, with_alpha(a, a_new), splat(1.0f));
+}
+
+inline vec blend_ALPHA_BRIGHTEN(vec a, vec b, vec amount)
+{
+	const vec a_a = alpha(a);
+	return select(greater(mul(alpha(b), amount), a_a), with_alpha(a, mul(a_a, amount)), b);
+}
+
+inline vec blend_ALPHA_DARKEN(vec a, vec b, vec amount)
+{
+	const vec a_a = alpha(a);
+	return select(greater(mul(a_a, amount), alpha(b)), with_alpha(a, mul(a_a, amount)), b);
+}
+
+/* === S P A N S =========================================================== */
+
+//! Blends whole vectors of \a src onto \a dest, leaves the tail to the caller
+template<vec (*func)(vec, vec, vec)>
+int span(Color *dest, const Color *src, int count, float amount)
+{
+	const vec a = splat(amount);
+	int i = 0;
+	for(; i + PIXELS <= count; i += PIXELS)
+		store(dest + i, func(load(src + i), load(dest + i), a));
+	return i;
+}
+
+//! Same as span(), for the methods which invert the colors of \a src
+//! when the amount is negative
+template<vec (*func)(vec, vec, vec)>
+int span_invertible(Color *dest, const Color *src, int count, float amount)
+{
+	if (amount >= 0)
+		return span<func>(dest, src, count, amount);
+
+	const vec a = splat(-amount);
+	int i = 0;
+	for(; i + PIXELS <= count; i += PIXELS)
+		store(dest + i, func(invert(load(src + i)), load(dest + i), a));
+	return i;
+}
+
+void fill_table(blendspanfunc *table)
+{
+	table[Color::BLEND_COMPOSITE]       = span<blend_COMPOSITE>;
+	table[Color::BLEND_STRAIGHT]        = span<blend_STRAIGHT>;
+	table[Color::BLEND_ONTO]            = span<blend_ONTO>;
+	table[Color::BLEND_STRAIGHT_ONTO]   = span<blend_STRAIGHT_ONTO>;
+	table[Color::BLEND_BEHIND]          = span<blend_BEHIND>;
+	table[Color::BLEND_SCREEN]          = span_invertible<blend_SCREEN>;
+	table[Color::BLEND_OVERLAY]         = span_invertible<blend_OVERLAY>;
+	table[Color::BLEND_HARD_LIGHT]      = span_invertible<blend_HARD_LIGHT>;
+	table[Color::BLEND_MULTIPLY]        = span_invertible<blend_MULTIPLY>;
+	table[Color::BLEND_DIVIDE]          = span<blend_DIVIDE>;
+	table[Color::BLEND_ADD]             = span<blend_ADD>;
+	table[Color::BLEND_SUBTRACT]        = span<blend_SUBTRACT>;
+	table[Color::BLEND_DIFFERENCE]      = span<blend_DIFFERENCE>;
+	table[Color::BLEND_BRIGHTEN]        = span<blend_BRIGHTEN>;
+	table[Color::BLEND_DARKEN]          = span<blend_DARKEN>;
+	table[Color::BLEND_ALPHA_OVER]      = span<blend_ALPHA_OVER>;
+	table[Color::BLEND_ALPHA_BRIGHTEN]  = span<blend_ALPHA_BRIGHTEN>;
+	table[Color::BLEND_ALPHA_DARKEN]    = span<blend_ALPHA_DARKEN>;
+	// COLOR, HUE, SATURATION and LUMINANCE go through YUV and HSV
+	// conversions and stay scalar
+}
+
+/* === E N D =============================================================== */
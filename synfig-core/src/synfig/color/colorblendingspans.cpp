@@ -0,0 +1,164 @@
+/* === S Y N F I G ========================================================= */
+/*!	\file colorblendingspans.cpp
+**	\brief Vectorized blending of color spans
+**
+**	$Id$
+**
+**	\legal
+**	Copyright (c) 2016 Synfig contributors
+**
+**	This package is free software; you can redistribute it and/or
+**	modify it under the terms of the GNU General Public License as
+**	published by the Free Software Foundation; either version 2 of
+**	the License, or (at your option) any later version.
+**
+**	This package is distributed in the hope that it will be useful,
+**	but WITHOUT ANY WARRANTY; without even the implied warranty of
+**	MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE. See the GNU
+**	General Public License for more details.
+**	\endlegal
+*/
+/* ========================================================================= */
+
+/* === H E A D E R S ======================================================= */
+
+#ifdef USING_PCH
+#	include "pch.h"
+#else
+#ifdef HAVE_CONFIG_H
+#	include <config.h>
+#endif
+
+#include <cstdlib>
+#include "colorblendingspans.h"
+
+#endif
+
+/* === M A C R O S ========================================================= */
+
+#define COLOR_EPSILON	(0.000001f)
+
+// The kernels rely on Color being four packed floats, alpha first
+#if !defined(USE_HALF_TYPE) && !defined(HAS_VIMAGE) && defined(__SSE2__)
+#define SYNFIG_BLEND_SSE2
+#include <emmintrin.h>
+
+// The AVX kernels are compiled with a target pragma and picked at runtime,
+// so the library still runs on processors without AVX
+#if defined(__GNUC__) && !defined(__clang__) \
+ && (__GNUC__ > 4 || (__GNUC__ == 4 && __GNUC_MINOR__ >= 9))
+#define SYNFIG_BLEND_AVX
+#include <immintrin.h>
+#endif
+#endif
+
+/* === U S I N G =========================================================== */
+
+using namespace synfig;
+
+/* === G L O B A L S ======================================================= */
+
+/* === P R O C E D U R E S ================================================= */
+
+namespace {
+
+#ifdef SYNFIG_BLEND_SSE2
+namespace sse2 {
+
+typedef __m128 vec;
+enum { PIXELS = 1 };
+
+inline vec load(const Color *p) { return _mm_loadu_ps((const float*)p); }
+inline void store(Color *p, vec v) { _mm_storeu_ps((float*)p, v); }
+inline vec splat(float x) { return _mm_set1_ps(x); }
+inline vec splat_color(const Color &c) { return _mm_loadu_ps((const float*)&c); }
+inline vec add(vec a, vec b) { return _mm_add_ps(a, b); }
+inline vec sub(vec a, vec b) { return _mm_sub_ps(a, b); }
+inline vec mul(vec a, vec b) { return _mm_mul_ps(a, b); }
+inline vec div(vec a, vec b) { return _mm_div_ps(a, b); }
+inline vec vmin(vec a, vec b) { return _mm_min_ps(a, b); }
+inline vec vmax(vec a, vec b) { return _mm_max_ps(a, b); }
+inline vec vabs(vec a) { return _mm_andnot_ps(_mm_set1_ps(-0.0f), a); }
+inline vec alpha(vec a) { return _mm_shuffle_ps(a, a, 0); }
+inline vec greater(vec a, vec b) { return _mm_cmpgt_ps(a, b); }
+inline vec equal(vec a, vec b) { return _mm_cmpeq_ps(a, b); }
+inline vec select(vec m, vec a, vec b) { return _mm_or_ps(_mm_and_ps(m, a), _mm_andnot_ps(m, b)); }
+inline vec with_alpha(vec c, vec a) { return select(_mm_castsi128_ps(_mm_set_epi32(0, 0, 0, -1)), a, c); }
+
+#include "colorblendingkernels.h"
+
+} // END of namespace sse2
+#endif
+
+#ifdef SYNFIG_BLEND_AVX
+#pragma GCC push_options
+#pragma GCC target("avx")
+namespace avx {
+
+typedef __m256 vec;
+enum { PIXELS = 2 };
+
+inline vec load(const Color *p) { return _mm256_loadu_ps((const float*)p); }
+inline void store(Color *p, vec v) { _mm256_storeu_ps((float*)p, v); }
+inline vec splat(float x) { return _mm256_set1_ps(x); }
+inline vec splat_color(const Color &c) { return _mm256_broadcast_ps((const __m128*)&c); }
+inline vec add(vec a, vec b) { return _mm256_add_ps(a, b); }
+inline vec sub(vec a, vec b) { return _mm256_sub_ps(a, b); }
+inline vec mul(vec a, vec b) { return _mm256_mul_ps(a, b); }
+inline vec div(vec a, vec b) { return _mm256_div_ps(a, b); }
+inline vec vmin(vec a, vec b) { return _mm256_min_ps(a, b); }
+inline vec vmax(vec a, vec b) { return _mm256_max_ps(a, b); }
+inline vec vabs(vec a) { return _mm256_andnot_ps(_mm256_set1_ps(-0.0f), a); }
+inline vec alpha(vec a) { return _mm256_permute_ps(a, 0); }
+inline vec greater(vec a, vec b) { return _mm256_cmp_ps(a, b, _CMP_GT_OQ); }
+inline vec equal(vec a, vec b) { return _mm256_cmp_ps(a, b, _CMP_EQ_OQ); }
+inline vec select(vec m, vec a, vec b) { return _mm256_blendv_ps(b, a, m); }
+inline vec with_alpha(vec c, vec a) { return _mm256_blend_ps(c, a, 0x11); }
+
+#include "colorblendingkernels.h"
+
+} // END of namespace avx
+#pragma GCC pop_options
+#endif
+
+struct SpanFunctions
+{
+	blendspanfunc table[Color::BLEND_END];
+	const char *isa;
+
+	SpanFunctions(): isa("scalar")
+	{
+		for(int i = 0; i < Color::BLEND_END; ++i)
+			table[i] = NULL;
+		if (getenv("SYNFIG_DISABLE_SIMD"))
+			return;
+
+#ifdef SYNFIG_BLEND_AVX
+		__builtin_cpu_init();
+		if (__builtin_cpu_supports("avx"))
+			{ avx::fill_table(table); isa = "avx"; return; }
+#endif
+#ifdef SYNFIG_BLEND_SSE2
+		sse2::fill_table(table);
+		isa = "sse2";
+#endif
+	}
+
+	static const SpanFunctions& instance()
+	{
+		static SpanFunctions functions;
+		return functions;
+	}
+};
+
+} // END of anonymous namespace
+
+const blendspanfunc*
+synfig::get_blend_span_functions()
+	{ return SpanFunctions::instance().table; }
+
+const char*
+synfig::get_blend_span_isa()
+	{ return SpanFunctions::instance().isa; }
+
+/* === E N D =============================================================== */
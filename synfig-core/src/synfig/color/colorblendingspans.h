@@ -0,0 +1,57 @@
+/* === S Y N F I G ========================================================= */
+/*!	\file colorblendingspans.h
+**	\brief Vectorized blending of color spans
+**
+**	$Id$
+**
+**	\legal
+**	Copyright (c) 2016 Synfig contributors
+**
+**	This package is free software; you can redistribute it and/or
+**	modify it under the terms of the GNU General Public License as
+**	published by the Free Software Foundation; either version 2 of
+**	the License, or (at your option) any later version.
+**
+**	This package is distributed in the hope that it will be useful,
+**	but WITHOUT ANY WARRANTY; without even the implied warranty of
+**	MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE. See the GNU
+**	General Public License for more details.
+**	\endlegal
+*/
+/* ========================================================================= */
+
+/* === S T A R T =========================================================== */
+
+#ifndef __SYNFIG_COLOR_COLORBLENDINGSPANS_H
+#define __SYNFIG_COLOR_COLORBLENDINGSPANS_H
+
+/* === H E A D E R S ======================================================= */
+
+#include <synfig/color.h>
+
+/* === M A C R O S ========================================================= */
+
+/* === T Y P E D E F S ===================================================== */
+
+/* === C L A S S E S & S T R U C T S ======================================= */
+
+namespace synfig {
+
+//! Blends the leading colors of a span, \see Color::blend_span()
+/*!	\return The number of colors processed, the caller blends the rest */
+typedef int (*blendspanfunc)(Color *dest, const Color *src, int count, float amount);
+
+//! Returns the span functions for the instruction set of the processor,
+//! indexed by Color::BlendMethod
+/*!	Blend methods without a vectorized version have null entries.
+**	The SYNFIG_DISABLE_SIMD environment variable disables all of them. */
+const blendspanfunc* get_blend_span_functions();
+
+//! Returns the name of the instruction set used by get_blend_span_functions()
+const char* get_blend_span_isa();
+
+} // synfig namespace
+
+/* === E N D =============================================================== */
+
+#endif
@@ -118,13 +118,28 @@ IndependentContext::set_time(Time time)const
 	//synfig::info("%s: time=%f",(*context)->get_non_empty_description().c_str(),(float)time);
 
 	{
-		Layer::ParamList params;
-		Layer::DynamicParamList::const_iterator iter;
-		// For each parameter of the layer sets the time by the operator()(time)
-		for(iter=(*context)->dynamic_param_list().begin();iter!=(*context)->dynamic_param_list().end();iter++)
-			params[iter->first]=(*iter->second)(time);
-		// Sets the modified parameter list to the current context layer
-		(*context)->set_param_list(params);
+		// The parameters only need to be evaluated again when the layer has been
+		// changed (dirty_time_ is reset then) or the time left the interval
+		// in which all of them are known to be constant
+		if ((*context)->dirty_time_ == Time::end()
+		 || time < (*context)->invariance_begin_
+		 || time > (*context)->invariance_end_)
+		{
+			Time begin = Time::begin(), end = Time::end();
+			// Evaluates the animated parameters and sets the changed ones
+			(*context)->set_dynamic_params(time, begin, end);
+
+			if (begin < end)
+			{
+				(*context)->invariance_begin_=begin;
+				(*context)->invariance_end_=end;
+			}
+			else
+			{
+				(*context)->invariance_begin_=Time::end();
+				(*context)->invariance_end_=Time::begin();
+			}
+		}
 		// Calls the set time for the next layer in the context.
 		(*context)->set_time(context+1,time);
 		// Sets the dirty time the current calling time
@@ -192,6 +207,15 @@ IndependentContext::set_dirty_outlines()
 	}
 }
 
+bool
+IndependentContext::is_thread_safe()const
+{
+	for(IndependentContext context(*this); !(context)->empty(); ++context)
+		if(!(*context)->is_thread_safe())
+			return false;
+	return true;
+}
+
 Color
 Context::get_color(const Point &pos)const
 {
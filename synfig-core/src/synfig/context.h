@@ -78,6 +78,10 @@ public:
 
 	//! Sets dirty (dirty_time_= Time::end()) to all Outline type layers
 	void set_dirty_outlines();
+
+	//! Returns \c true if several threads may render the context at once,
+	//! that is if all its layers are thread safe, see Layer::is_thread_safe()
+	bool is_thread_safe()const;
 };
 
 
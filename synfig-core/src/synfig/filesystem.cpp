@@ -70,6 +70,16 @@ int FileSystem::ReadStream::underflow()
 	return std::streambuf::traits_type::to_int_type(*gptr());
 }
 
+std::streamsize FileSystem::ReadStream::xsgetn(char *s, std::streamsize n)
+{
+	std::streamsize count = 0;
+	if (n > 0 && gptr() < egptr())
+		{ *s = *gptr(); gbump(1); count = 1; }
+	if (count < n)
+		count += internal_read(s + count, n - count);
+	return count;
+}
+
 // WriteStream
 
 FileSystem::WriteStream::WriteStream(Handle file_system):
@@ -84,6 +94,9 @@ FileSystem::WriteStream::overflow(int character)
 	return character != EOF && sizeof(c) == internal_write(&c, sizeof(c)) ? character : EOF;
 }
 
+std::streamsize FileSystem::WriteStream::xsputn(const char *s, std::streamsize n)
+	{ return n > 0 ? internal_write(s, n) : 0; }
+
 // Identifier
 
 FileSystem::ReadStreamHandle FileSystem::Identifier::get_read_stream() const
@@ -103,6 +116,11 @@ bool FileSystem::file_rename(const std::string & /* from_filename */, const std:
 	return false;
 }
 
+std::string FileSystem::get_real_filename(const std::string & /* filename */)
+{
+	return std::string();
+}
+
 bool FileSystem::copy(Handle from_file_system, const std::string &from_filename, Handle to_file_system, const std::string &to_filename)
 {
 	if (from_file_system.empty() || to_file_system.empty()) return false;
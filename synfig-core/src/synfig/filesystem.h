@@ -68,6 +68,8 @@ namespace synfig
 
 			ReadStream(Handle file_system);
 			virtual int underflow();
+			//! Reads blocks straight into \a s, instead of a byte at a time through underflow()
+			virtual std::streamsize xsgetn(char *s, std::streamsize n);
 			virtual size_t internal_read(void *buffer, size_t size) = 0;
 
 		public:
@@ -89,16 +91,13 @@ namespace synfig
 		protected:
 			WriteStream(Handle file_system);
 	        virtual int overflow(int ch);
+			//! Writes blocks straight from \a s, instead of a byte at a time through overflow()
+			virtual std::streamsize xsputn(const char *s, std::streamsize n);
 			virtual size_t internal_write(const void *buffer, size_t size) = 0;
 
 		public:
-			bool write_block(const void *buffer, size_t size)
-			{
-				for(size_t i = 0; i < size; i++)
-					if (!put(((const char*)buffer)[i]).good())
-						return i;
-				return size;
-			}
+			size_t write_block(const void *buffer, size_t size)
+				{ return write((const char*)buffer, size).good() ? size : 0; }
 			bool write_whole_block(const void *buffer, size_t size)
 				{ return size == write_block(buffer, size); }
 			bool write_whole_stream(std::streambuf &streambuf)
@@ -155,6 +154,8 @@ namespace synfig
 		virtual bool file_rename(const std::string &from_filename, const std::string &to_filename);
 		virtual ReadStreamHandle get_read_stream(const std::string &filename) = 0;
 		virtual WriteStreamHandle get_write_stream(const std::string &filename) = 0;
+		//! Name of the file on disk, or an empty string if it is not a plain file of the native file system
+		virtual std::string get_real_filename(const std::string &filename);
 
 		inline bool is_exists(const std::string filename) { return is_file(filename) || is_directory(filename); }
 
@@ -160,6 +160,11 @@ FileSystem::WriteStreamHandle FileSystemNative::get_write_stream(const std::stri
 	     : WriteStreamHandle(new WriteStream(this, f));
 }
 
+std::string FileSystemNative::get_real_filename(const std::string &filename)
+{
+	return fix_slashes(filename);
+}
+
 
 /* === E N T R Y P O I N T ================================================= */
 
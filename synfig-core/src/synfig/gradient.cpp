@@ -49,6 +49,9 @@ using namespace synfig;
 
 /* === G L O B A L S ======================================================= */
 
+//! Upper bound for the cells of the tables of a CompiledGradient, a few hundred KB each
+static const int MAX_CELLS = 4096;
+
 /* === P R O C E D U R E S ================================================= */
 
 /* === M E T H O D S ======================================================= */
@@ -596,3 +599,406 @@ synfig::Gradient::find(const UniqueID &id)const
 
 	throw Exception::NotFound("synfig::Gradient::find()const: Unable to find UniqueID in gradient");
 }
+
+bool
+synfig::Gradient::operator==(const Gradient &rhs)const
+{
+	if(size()!=rhs.size())
+		return false;
+	for(const_iterator a=begin(),b=rhs.begin();a!=end();++a,++b)
+		if(a->pos!=b->pos || a->color!=b->color)
+			return false;
+	return true;
+}
+
+synfig::CompiledGradient::CompiledGradient(const Gradient &gradient, bool loop, bool zigzag, Real resolution, Real supersample):
+	loop(loop),
+	zigzag(zigzag),
+	lo(0.0),
+	hi(1.0),
+	step(1.0),
+	inv_step(1.0),
+	opaque(false),
+	width(0.0),
+	filter_lo(0.0),
+	filter_hi(1.0),
+	filter_step(1.0),
+	filter_inv_step(1.0)
+{
+	for(Gradient::const_iterator iter=gradient.begin();iter!=gradient.end();++iter)
+	{
+		positions.push_back(iter->pos);
+		colors.push_back(iter->color.premult_alpha());
+	}
+	if(colors.empty())
+	{
+		positions.push_back(0.0);
+		colors.push_back(Color(0,0,0,0));
+	}
+
+	// The looped modes read the table over [0,1] even if the cpoints do not cover it
+	lo=min(positions.front(),Real(0.0));
+	hi=max(positions.back(),Real(1.0));
+
+	// Cells narrower than a pixel only cost memory, the lookups are exact anyway
+	int count(MAX_CELLS);
+	if(resolution>0 && (hi-lo)/resolution<MAX_CELLS)
+		count=max(1,(int)ceil((hi-lo)/resolution));
+	step=(hi-lo)/count;
+	inv_step=1.0/step;
+
+	cells.resize(count);
+	int segment(find_segment(-1,lo));
+	Sum sum;
+	for(int k=0;k<count;k++)
+	{
+		const Real a(lo+k*step);
+		const Real b(k+1==count?hi:lo+(k+1)*step);
+		Cell &cell(cells[k]);
+
+		segment=find_segment(segment,a);
+		cell.sum=sum;
+		cell.segment=segment;
+		cell.color=value(segment,a);
+		cell.linear=!(segment+1<(int)positions.size() && positions[segment+1]<b);
+		cell.slope=cell.linear?value(segment,b)-cell.color:Color(0,0,0,0);
+
+		sum+=integrate(a,b,segment);
+	}
+	total=sum;
+	period=integral(1.0)-integral(0.0);
+
+	if(supersample!=0)
+		bake(supersample);
+}
+
+//! Returns the last segment starting at or before \a x, searching forward from \a segment
+int
+synfig::CompiledGradient::find_segment(int segment, Real x)const
+{
+	while(segment+1<(int)positions.size() && positions[segment+1]<=x)
+		segment++;
+	return segment;
+}
+
+//! Premultiplied color of \a segment at \a x, segment -1 being the area before the first cpoint
+Color
+synfig::CompiledGradient::value(int segment, Real x)const
+{
+	if(segment<0)
+		return colors.front();
+	if(segment+1>=(int)positions.size() || positions[segment+1]<=positions[segment])
+		return colors[segment];
+	const float amount((x-positions[segment])/(positions[segment+1]-positions[segment]));
+	return colors[segment]+(colors[segment+1]-colors[segment])*amount;
+}
+
+//! Integral of the premultiplied color from \a a to \a b, where \a a is within \a segment
+CompiledGradient::Sum
+synfig::CompiledGradient::integrate(Real a, Real b, int segment)const
+{
+	Sum sum;
+	while(a<b)
+	{
+		const Real end(segment+1<(int)positions.size() && positions[segment+1]<b ? positions[segment+1] : b);
+		if(end>a)
+			sum+=Sum(value(segment,a)+value(segment,end),0.5*(end-a));
+		a=end;
+		segment++;
+	}
+	return sum;
+}
+
+//! Integral of the premultiplied color from the start of the table to \a x
+CompiledGradient::Sum
+synfig::CompiledGradient::integral(Real x)const
+{
+	if(x<=lo)
+		return Sum(colors.front(),x-lo);
+	if(x>=hi)
+		return total+Sum(colors.back(),x-hi);
+
+	int k((int)((x-lo)*inv_step));
+	if(k>=(int)cells.size())
+		k=cells.size()-1;
+	const Cell &cell(cells[k]);
+	const Real a(lo+k*step);
+	if(!cell.linear)
+		return cell.sum+integrate(a,x,cell.segment);
+
+	const float t((x-a)*inv_step);
+	return cell.sum+Sum(cell.color+cell.slope*(t*0.5f),t*step);
+}
+
+//! Integral over the zigzag mirrored gradient, which repeats every 2 units
+CompiledGradient::Sum
+synfig::CompiledGradient::zigzag_integral(Real x)const
+{
+	const Real n(floor(x*0.5));
+	const Real f(x-2*n);
+	const Sum base(period*(2*n));
+	if(f<=1.0)
+		return base+(integral(f)-integral(0.0));
+	return base+period+(integral(1.0)-integral(2.0-f));
+}
+
+//! Premultiplied color at \a x without any filtering
+Color
+synfig::CompiledGradient::sample(Real x)const
+{
+	if(x<lo)
+		return colors.front();
+	if(x>=hi)
+		return colors.back();
+
+	int k((int)((x-lo)*inv_step));
+	if(k>=(int)cells.size())
+		k=cells.size()-1;
+	const Cell &cell(cells[k]);
+	if(!cell.linear)
+		return value(find_segment(cell.segment,x),x);
+	return cell.color+cell.slope*(float)((x-lo-k*step)*inv_step);
+}
+
+//! Premultiplied color averaged from \a begin to \a end, in the units of the table
+Color
+synfig::CompiledGradient::average(Real begin, Real end)const
+{
+	const Real width(end-begin);
+
+	if(loop && zigzag)
+		return ((zigzag_integral(end)-zigzag_integral(begin))*(1.0/width)).get();
+	if(loop)
+	{
+		const Real nb(floor(begin)), ne(floor(end));
+		return ((period*(ne-nb)+integral(end-ne)-integral(begin-nb))*(1.0/width)).get();
+	}
+	return ((integral(end)-integral(begin))*(1.0/width)).get();
+}
+
+//! Maps \a x and \a supersample of the layer into the units of the table
+Real
+synfig::CompiledGradient::map(Real x, Real &supersample)const
+{
+	supersample=fabs(supersample);
+	if(zigzag)
+	{
+		x*=2.0;
+		supersample*=2.0;
+		// Without looping the far side of the mirror is left to the clamping
+		if(!loop && x>1.0)
+			x=2.0-x;
+	}
+	if(supersample>2.0)
+		supersample=2.0;
+	return x;
+}
+
+//! Quadratic through the averaged colors from \a t0 to \a t1 of the cell starting at \a a
+CompiledGradient::Quadratic
+synfig::CompiledGradient::fit(Real a, float t0, float t1)const
+{
+	const float tm((t0+t1)*0.5f), d(t1-t0);
+	const Color v0(average(a+t0*filter_step-width*0.5,a+t0*filter_step+width*0.5));
+	const Color vm(average(a+tm*filter_step-width*0.5,a+tm*filter_step+width*0.5));
+	const Color v1(average(a+t1*filter_step-width*0.5,a+t1*filter_step+width*0.5));
+
+	// in terms of u=(t-t0)/d first, then expanded for t
+	const Color e2((v1-vm*2+v0)*2);
+	const Color e1(v1-v0-e2);
+	Quadratic q;
+	q.c2=e2*(1/(d*d));
+	q.c1=e1*(1/d)-q.c2*(2*t0);
+	q.c0=v0-e1*(t0/d)+e2*(t0*t0/(d*d));
+	return q;
+}
+
+//! Bakes the colors averaged over \a supersample, as piecewise quadratics
+void
+synfig::CompiledGradient::bake(Real supersample)
+{
+	map(0.0,supersample);
+	width=supersample;
+
+	if(loop)
+	{
+		filter_lo=0.0;
+		filter_hi=zigzag?2.0:1.0;
+	}
+	else
+	{
+		filter_lo=lo-width*0.5;
+		filter_hi=hi+width*0.5;
+	}
+
+	int count(MAX_CELLS);
+	if((filter_hi-filter_lo)/(width*0.5)<MAX_CELLS)
+		count=max(1,(int)ceil((filter_hi-filter_lo)/(width*0.5)));
+	filter_step=(filter_hi-filter_lo)/count;
+	filter_inv_step=1.0/filter_step;
+
+	// The average has a kink wherever a side of the filter crosses a cpoint,
+	// or the point where a looped gradient wraps or mirrors
+	std::vector<Real> points(positions);
+	if(loop)
+	{
+		points.push_back(0.0);
+		points.push_back(1.0);
+		if(zigzag)
+			for(size_t i=0;i<positions.size();i++)
+				points.push_back(2.0-positions[i]);
+	}
+	std::vector<Real> kinks;
+	for(size_t i=0;i<points.size();i++)
+		for(int side=-1;side<=1;side+=2)
+		{
+			Real kink(points[i]+side*width*0.5);
+			if(loop)
+				kink-=floor((kink-filter_lo)/(filter_hi-filter_lo))*(filter_hi-filter_lo);
+			kinks.push_back((kink-filter_lo)*filter_inv_step);
+		}
+	std::sort(kinks.begin(),kinks.end());
+
+	filtered.resize(count);
+	std::vector<Real>::const_iterator iter(kinks.begin());
+	for(int k=0;k<count;k++)
+	{
+		const Real a(filter_lo+k*filter_step);
+		Filtered &cell(filtered[k]);
+
+		// kinks on the borders of the cell do no harm
+		std::vector<float> inside;
+		for(;iter!=kinks.end() && *iter<k+1;++iter)
+			if(*iter-k>1e-6 && k+1-*iter>1e-6 && (inside.empty() || *iter-k-inside.back()>1e-6))
+				inside.push_back(*iter-k);
+
+		cell.exact=inside.size()>1;
+		cell.split=inside.size()==1?inside.front():2.0f;
+		cell.left=fit(a,0.0f,inside.size()==1?cell.split:1.0f);
+		if(inside.size()==1)
+			cell.right=fit(a,cell.split,1.0f);
+		else
+			cell.right=cell.left;
+	}
+
+	opaque=true;
+	for(size_t i=0;i<colors.size();i++)
+		if(colors[i].get_a()!=1.0f)
+			opaque=false;
+}
+
+Color
+synfig::CompiledGradient::operator()(Real x, Real supersample)const
+{
+	if(isnan(x))
+		return colors.front().demult_alpha();
+
+	x=map(x,supersample);
+
+	// Too narrow to be told apart from a single sample
+	if(supersample<step*0.001)
+	{
+		if(loop && zigzag)
+		{
+			x-=2.0*floor(x*0.5);
+			if(x>1.0)
+				x=2.0-x;
+		}
+		else if(loop)
+			x-=floor(x);
+		return sample(x).demult_alpha();
+	}
+
+	return average(x-supersample*0.5,x+supersample*0.5).demult_alpha();
+}
+
+Color
+synfig::CompiledGradient::operator()(Real x)const
+{
+	Color color;
+	fill(&color,1,x,1.0);
+	return color;
+}
+
+void
+synfig::CompiledGradient::fill(Color *dest, int count, Real x, Real dx)const
+{
+	if(filtered.empty())
+	{
+		for(int i=0;i<count;i++)
+			dest[i]=(*this)(x+i*dx,0.0);
+		return;
+	}
+
+	// a gradient running across the span
+	if(dx==0 && count>1)
+	{
+		std::fill(dest,dest+count,(*this)(x));
+		return;
+	}
+
+	const int cell_count(filtered.size());
+	const Real scale(zigzag?2.0:1.0);
+	const Color front(colors.front().demult_alpha()), back(colors.back().demult_alpha());
+	for(int i=0;i<count;i++)
+	{
+		Real f((x+i*dx)*scale);
+		if(zigzag && !loop && f>1.0)
+			f=2.0-f;
+		f=(f-filter_lo)*filter_inv_step;
+
+		// NaN falls to the front color, as in Gradient::operator()
+		if(loop)
+		{
+			if(!(f>=0 && f<cell_count))
+			{
+				f-=floor(f/cell_count)*cell_count;
+				if(!(f>=0))
+					{ dest[i]=front; continue; }
+			}
+		}
+		else if(!(f>0))
+			{ dest[i]=front; continue; }
+		else if(f>=cell_count)
+			{ dest[i]=back; continue; }
+
+		int k((int)f);
+		if(k>=cell_count)
+			k=cell_count-1;
+		const Filtered &cell(filtered[k]);
+		if(cell.exact)
+		{
+			const Real y(filter_lo+f*filter_step);
+			dest[i]=average(y-width*0.5,y+width*0.5).demult_alpha();
+			continue;
+		}
+
+		const float t(f-k);
+		dest[i]=t<cell.split?cell.left(t):cell.right(t);
+		if(opaque)
+			dest[i].set_a(1.0);
+		else
+			dest[i]=dest[i].demult_alpha();
+	}
+}
+
+etl::handle<const CompiledGradient>
+synfig::CompiledGradientCache::get(const Gradient &gradient, bool loop, bool zigzag, Real resolution, Real supersample)
+{
+	Mutex::Lock lock(mutex);
+	if(!compiled
+	|| this->gradient!=gradient
+	|| this->loop!=loop
+	|| this->zigzag!=zigzag
+	|| this->resolution!=resolution
+	|| this->supersample!=supersample)
+	{
+		compiled=new CompiledGradient(gradient,loop,zigzag,resolution,supersample);
+		this->gradient=gradient;
+		this->loop=loop;
+		this->zigzag=zigzag;
+		this->resolution=resolution;
+		this->supersample=supersample;
+	}
+	return compiled;
+}
@@ -33,6 +33,8 @@
 #include <vector>
 #include <utility>
 #include "uniqueid.h"
+#include "mutex.h"
+#include <ETL/handle>
 
 /* === M A C R O S ========================================================= */
 
@@ -112,6 +114,10 @@ public:
 	Gradient operator*(const float    &rhs)const { return Gradient(*this)*=rhs; }
 	Gradient operator/(const float    &rhs)const { return Gradient(*this)/=rhs; }
 
+	//! True if both have cpoints of the same positions and colors
+	bool operator==(const Gradient &rhs)const;
+	bool operator!=(const Gradient &rhs)const { return !(*this==rhs); }
+
 	Color operator()(const Real &x, float supersample=0)const;
 
 	Real mag()const;
@@ -129,6 +135,121 @@ public:
 	const_iterator find(const UniqueID &id)const;
 }; // END of class Gradient
 
+/*! \class CompiledGradient
+**	\brief Gradient baked into a table for rendering
+**
+**	Keeps the premultiplied colors of a Gradient together with their running
+**	integral, sampled in cells about as wide as the smallest supersample it
+**	will be asked for. A box filtered color then costs two table reads
+**	instead of the searches and the integration of Gradient::operator().
+**	The loop and zigzag modes of the gradient layers are built in, so the
+**	wrapped ends of a looped gradient are filtered like any other place.
+*/
+class CompiledGradient : public etl::shared_object
+{
+public:
+	//! Bakes \a gradient into cells not wider than \a resolution
+	/*!	If \a supersample is given, the colors averaged over that width are
+	**	baked as well, for operator()(Real) and fill() */
+	CompiledGradient(const Gradient &gradient, bool loop=false, bool zigzag=false, Real resolution=0, Real supersample=0);
+
+	//! Color at \a x averaged over \a supersample, as the gradient layers compute it
+	Color operator()(Real x, Real supersample)const;
+
+	//! Color at \a x averaged over the supersample given to the constructor
+	Color operator()(Real x)const;
+
+	//! Writes the colors at \a x, \a x+\a dx, \a x+2*\a dx... into \a count items of \a dest
+	void fill(Color *dest, int count, Real x, Real dx)const;
+
+private:
+	//! Integral of premultiplied colors, kept in double precision since only differences of it are used
+	struct Sum
+	{
+		double r, g, b, a;
+
+		Sum(): r(), g(), b(), a() { }
+		Sum(const Color &c, double k):
+			r(c.get_r()*k), g(c.get_g()*k), b(c.get_b()*k), a(c.get_a()*k) { }
+
+		Sum &operator+=(const Sum &x) { r+=x.r; g+=x.g; b+=x.b; a+=x.a; return *this; }
+		Sum operator+(const Sum &x)const { return Sum(*this)+=x; }
+		Sum operator-(const Sum &x)const { Sum s(*this); s.r-=x.r; s.g-=x.g; s.b-=x.b; s.a-=x.a; return s; }
+		Sum operator*(double k)const { Sum s(*this); s.r*=k; s.g*=k; s.b*=k; s.a*=k; return s; }
+		Color get()const { return Color(r, g, b, a); }
+	};
+
+	struct Cell
+	{
+		Sum sum;		//!< Integral of the premultiplied color up to the start of the cell
+		Color color;	//!< Premultiplied color at the start of the cell
+		Color slope;	//!< Change of the premultiplied color across the cell
+		int segment;	//!< Segment of the cpoints at the start of the cell
+		bool linear;	//!< True if no cpoint falls inside the cell
+	};
+
+	//! Averaged color within a cell, as \a c0 + \a c1*t + \a c2*t*t for t from 0 to 1
+	struct Quadratic
+	{
+		Color c0, c1, c2;
+		Color operator()(float t)const { return c0+(c1+c2*t)*t; }
+	};
+
+	//! Averaged color over a cell, smooth on either side of \a split
+	struct Filtered
+	{
+		Quadratic left, right;
+		float split;	//!< Where the average has a kink, past 1 if it has none
+		bool exact;		//!< True if there is more than one kink
+	};
+
+	bool loop, zigzag;
+	std::vector<Real> positions;
+	std::vector<Color> colors;
+	std::vector<Cell> cells;
+	Real lo, hi, step, inv_step;
+	Sum total, period;
+
+	std::vector<Filtered> filtered;
+	bool opaque;
+	Real width, filter_lo, filter_hi, filter_step, filter_inv_step;
+
+	int find_segment(int segment, Real x)const;
+	Color value(int segment, Real x)const;
+	Sum integrate(Real a, Real b, int segment)const;
+	Sum integral(Real x)const;
+	Sum zigzag_integral(Real x)const;
+	Color sample(Real x)const;
+	Color average(Real begin, Real end)const;
+	Real map(Real x, Real &supersample)const;
+	Quadratic fit(Real a, float t0, float t1)const;
+	void bake(Real supersample);
+}; // END of class CompiledGradient
+
+/*! \class CompiledGradientCache
+**	\brief The CompiledGradient a layer rendered with last time
+**
+**	The table is baked again only when the gradient or the other arguments
+**	of CompiledGradient differ from the last call of get(). A thread keeps
+**	the table it got while another one replaces it. Copies start empty.
+*/
+class CompiledGradientCache
+{
+	Mutex mutex;
+	etl::handle<CompiledGradient> compiled;
+	Gradient gradient;
+	bool loop, zigzag;
+	Real resolution, supersample;
+
+public:
+	CompiledGradientCache(): loop(), zigzag(), resolution(), supersample() { }
+	CompiledGradientCache(const CompiledGradientCache &): loop(), zigzag(), resolution(), supersample() { }
+	CompiledGradientCache& operator=(const CompiledGradientCache &) { return *this; }
+
+	//! Returns the gradient baked with these arguments, see CompiledGradient::CompiledGradient()
+	etl::handle<const CompiledGradient> get(const Gradient &gradient, bool loop=false, bool zigzag=false, Real resolution=0, Real supersample=0);
+}; // END of class CompiledGradientCache
+
 }; // END of namespace synfig
 
 /* === E N D =============================================================== */
@@ -33,9 +33,12 @@
 #include "canvas.h"
 #include "importer.h"
 #include "surface.h"
+#include "mipmap.h"
+#include "mutex.h"
 #include <algorithm>
 #include "string.h"
 #include <map>
+#include <set>
 #include <ctype.h>
 #include <functional>
 #include <glibmm.h>
@@ -53,6 +56,11 @@ using namespace synfig;
 Importer::Book* synfig::Importer::book_;
 
 map<FileSystem::Identifier,Importer::LooseHandle> *__open_importers;
+//! Files whose importers are being created, outside of open_mutex
+static set<FileSystem::Identifier> *opening_importers;
+static Glib::Mutex *open_mutex;
+static Glib::Cond *open_cond;
+static Mutex mipmap_mutex;
 
 /* === P R O C E D U R E S ================================================= */
 
@@ -63,6 +71,9 @@ Importer::subsys_init()
 {
 	book_=new Book();
 	__open_importers=new map<FileSystem::Identifier,Importer::LooseHandle>();
+	opening_importers=new set<FileSystem::Identifier>();
+	open_mutex=new Glib::Mutex();
+	open_cond=new Glib::Cond();
 	return true;
 }
 
@@ -71,6 +82,9 @@ Importer::subsys_stop()
 {
 	delete book_;
 	delete __open_importers;
+	delete opening_importers;
+	delete open_mutex;
+	delete open_cond;
 	return true;
 }
 
@@ -89,12 +103,29 @@ Importer::open(const FileSystem::Identifier &identifier)
 		return 0;
 	}
 
+	Glib::Mutex::Lock lock(*open_mutex);
+
+	// If another thread is opening the same file, wait for its importer
+	while(opening_importers->count(identifier))
+		open_cond->wait(*open_mutex);
+
 	// If we already have an importer open under that filename,
 	// then use it instead.
-	if(__open_importers->count(identifier))
+	map<FileSystem::Identifier,Importer::LooseHandle>::iterator iter=__open_importers->find(identifier);
+	if(iter!=__open_importers->end())
 	{
-		//synfig::info("Found importer already open, using it...");
-		return (*__open_importers)[identifier];
+		// An importer whose last handle is gone is being deleted by
+		// another thread, which waits for open_mutex to unregister it.
+		// It is replaced by a new one, its destructor won't find itself.
+		Importer *existing=iter->second.get();
+		if(existing->ref_if_alive())
+		{
+			//synfig::info("Found importer already open, using it...");
+			Importer::Handle importer(existing);
+			existing->unref();
+			return importer;
+		}
+		__open_importers->erase(iter);
 	}
 
 	if(filename_extension(identifier.filename) == "")
@@ -114,17 +145,33 @@ Importer::open(const FileSystem::Identifier &identifier)
 		return 0;
 	}
 
+	// The file is read without the lock, so other files can be opened meanwhile
+	Factory factory = Importer::book()[ext].factory;
+	opening_importers->insert(identifier);
+	lock.release();
+
+	Importer::Handle importer;
 	try {
-		Importer::Handle importer;
-		importer=Importer::book()[ext].factory(identifier);
-		(*__open_importers)[identifier]=importer;
-		return importer;
+		importer=factory(identifier);
 	}
 	catch (String str)
 	{
 		synfig::error(str);
 	}
-	return 0;
+	catch (...)
+	{
+		lock.acquire();
+		opening_importers->erase(identifier);
+		open_cond->broadcast();
+		throw;
+	}
+
+	lock.acquire();
+	opening_importers->erase(identifier);
+	if(importer)
+		(*__open_importers)[identifier]=importer;
+	open_cond->broadcast();
+	return importer;
 }
 
 Importer::Importer(const FileSystem::Identifier &identifier):
@@ -137,10 +184,21 @@ Importer::Importer(const FileSystem::Identifier &identifier):
 Importer::~Importer()
 {
 	// Remove ourselves from the open importer list
+	Glib::Mutex::Lock lock(*open_mutex);
 	map<FileSystem::Identifier,Importer::LooseHandle>::iterator iter;
 	for(iter=__open_importers->begin();iter!=__open_importers->end();++iter)
 		if(iter->second==this)
 		{
 			__open_importers->erase(iter);
+			break;
 		}
 }
+
+etl::handle<Mipmap>
+Importer::get_mipmap()
+{
+	Mutex::Lock lock(mipmap_mutex);
+	if(!mipmap_)
+		mipmap_=new Mipmap();
+	return mipmap_;
+}
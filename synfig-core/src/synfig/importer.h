@@ -94,6 +94,7 @@ namespace synfig {
 
 class Surface;
 class ProgressCallback;
+class Mipmap;
 
 /*!	\class Importer
 **	\brief Used for importing bitmaps of various formats, including animations.
@@ -146,6 +147,9 @@ private:
 	//! \todo Do not hardcode the gamma to 2.2
 	Gamma gamma_;
 
+	//! Downscaled copies of the image, shared by the layers showing it
+	etl::handle<Mipmap> mipmap_;
+
 protected:
 
 	Importer(const FileSystem::Identifier &identifier);
@@ -181,7 +185,13 @@ public:
 	//! Returns \c true if the importer pays attention to the \a time parameter of get_frame()
 	virtual bool is_animated() { return false; }
 
+	//! Returns the Mipmap shared by every layer showing the image of a static importer
+	/*!	It is empty until one of the layers builds it, see Mipmap::build() */
+	etl::handle<Mipmap> get_mipmap();
+
 	//! Attempts to open \a filename, and returns a handle to the associated Importer
+	/*!	May be called from several threads at once. A file being opened by
+	**	another thread is waited for, rather than read twice. */
 	static Handle open(const FileSystem::Identifier &identifier);
 };
 
@@ -56,7 +56,10 @@
 #include "transform.h"
 #include "rect.h"
 #include "guid.h"
+#include "mutex.h"
 
+#include <typeinfo>
+#include <algorithm>
 #include <sigc++/adaptors/bind.h>
 #endif
 
@@ -82,6 +85,10 @@ struct _LayerCounter
 
 int _LayerCounter::counter(0);
 
+//! Parameter names of each layer class, see Layer::get_param_slots()
+static Mutex param_slots_mutex;
+static std::map<String, Layer::ParamSlots> param_slots;
+
 /* === P R O C E D U R E S ================================================= */
 
 Layer::Book&
@@ -154,7 +161,10 @@ Layer::Layer():
 	optimized_(false),
 	exclude_from_rendering_(false),
 	param_z_depth(Real(0.0f)),
-	dirty_time_(Time::end())
+	dirty_time_(Time::end()),
+	invariance_begin_(Time::end()),
+	invariance_end_(Time::begin()),
+	revision_(0)
 {
 	_LayerCounter::counter++;
 	SET_INTERPOLATION_DEFAULTS();
@@ -176,6 +186,7 @@ synfig::Layer::create(const String &name)
 synfig::Layer::~Layer()
 {
 	_LayerCounter::counter--;
+	dynamic_param_slots_.clear();
 	while(!dynamic_param_list_.empty())
 	{
 		remove_child(dynamic_param_list_.begin()->second.get());
@@ -278,6 +289,7 @@ Layer::connect_dynamic_param(const String& param, etl::loose_handle<ValueNode> v
 		remove_child(previous.get());
 
 	add_child(value_node.get());
+	update_dynamic_param_slots();
 
 	if(!value_node->is_exported() && get_canvas())
 	{
@@ -296,6 +308,7 @@ Layer::disconnect_dynamic_param(const String& param)
 	if(previous)
 	{
 		dynamic_param_list_.erase(param);
+		update_dynamic_param_slots();
 
 		// fix 2353284: if two parameters in the same layer are
 		// connected to the same valuenode and we disconnect one of
@@ -321,9 +334,53 @@ Layer::on_changed()
 		printf("%s:%d Layer::on_changed()\n", __FILE__, __LINE__);
 
 	dirty_time_=Time::end();
+	++revision_;
+	for(std::vector<DynamicParamSlot>::iterator i = dynamic_param_slots_.begin(); i != dynamic_param_slots_.end(); ++i)
+		i->applied = false;
 	Node::on_changed();
 }
 
+void
+Layer::update_dynamic_param_slots()
+{
+	dynamic_param_slots_.clear();
+	dynamic_param_slots_.reserve(dynamic_param_list_.size());
+	for(DynamicParamList::const_iterator iter = dynamic_param_list_.begin(); iter != dynamic_param_list_.end(); ++iter)
+	{
+		if (!iter->second)
+			continue;
+		DynamicParamSlot slot;
+		slot.name = &iter->first;
+		slot.value_node = &iter->second;
+		slot.applied = false;
+		dynamic_param_slots_.push_back(slot);
+	}
+}
+
+void
+Layer::set_dynamic_params(Time time, Time &begin, Time &end)
+{
+	bool changed = false;
+	for(std::vector<DynamicParamSlot>::iterator i = dynamic_param_slots_.begin(); i != dynamic_param_slots_.end(); ++i)
+	{
+		const ValueNode &value_node = **i->value_node;
+		ValueBase value = value_node(time);
+		if (begin < end)
+			value_node.get_invariance(time, begin, end);
+
+		// Layers may do some work in set_param(), so a parameter
+		// is only set again when its value really changed
+		if (i->applied && i->value == value)
+			continue;
+		set_param(*i->name, value);
+		i->value = value;
+		i->applied = true;
+		changed = true;
+	}
+	if (changed)
+		++revision_;
+}
+
 bool
 Layer::set_param(const String &param, const ValueBase &value)
 {
@@ -470,6 +527,9 @@ Layer::set_param_list(const ParamList &list)
 	bool ret=true;
 	if(!list.size())
 		return false;
+	++revision_;
+	for(std::vector<DynamicParamSlot>::iterator i = dynamic_param_slots_.begin(); i != dynamic_param_slots_.end(); ++i)
+		i->applied = false;
 	ParamList::const_iterator iter(list.begin());
 	for(;iter!=list.end();++iter)
 	{
@@ -483,6 +543,13 @@ Layer::get_param_list()const
 {
 	ParamList ret;
 
+	if (const ParamSlots *slots = get_param_slots())
+	{
+		for(std::vector<String>::const_iterator i = slots->names.begin(); i != slots->names.end(); ++i)
+			ret[*i]=get_param(*i);
+		return ret;
+	}
+
 	Vocab vocab(get_param_vocab());
 
 	Vocab::const_iterator iter=vocab.begin();
@@ -493,6 +560,29 @@ Layer::get_param_list()const
 	return ret;
 }
 
+const Layer::ParamSlots*
+Layer::get_param_slots()const
+{
+	// the vocab of a Layer_Mime is made of whatever it was given
+	if (dynamic_cast<const Layer_Mime*>(this))
+		return NULL;
+
+	Mutex::Lock lock(param_slots_mutex);
+	const String key = typeid(*this).name();
+	std::map<String, ParamSlots>::iterator i = param_slots.find(key);
+	if (i != param_slots.end())
+		return &i->second;
+
+	ParamSlots &slots = param_slots[key];
+	Vocab vocab(get_param_vocab());
+	for(Vocab::const_iterator iter = vocab.begin(); iter != vocab.end(); ++iter)
+	{
+		if (std::find(slots.names.begin(), slots.names.end(), iter->get_name()) == slots.names.end())
+			slots.names.push_back(iter->get_name());
+	}
+	return &slots;
+}
+
 ValueBase
 Layer::get_param(const String & param)const
 {
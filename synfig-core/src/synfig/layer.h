@@ -30,6 +30,7 @@
 /* === H E A D E R S ======================================================= */
 
 #include <map>
+#include <vector>
 #include <ETL/handle>
 #include "real.h"
 #include "string.h"
@@ -88,7 +89,7 @@
 
 //! Imports a parameter if it is of the same type as param
 #define IMPORT_VALUE(x)                                                         \
-	if (#x=="param_"+param && x.get_type()==value.get_type())                   \
+	if (synfig::Layer::is_param_member(param, #x) && x.get_type()==value.get_type()) \
 	{                                                                           \
 		x=value;                                                                \
 		return true;                                                            \
@@ -97,7 +98,7 @@
 //! Imports a parameter 'x' and perform an action usually based on
 //! some condition 'y'
 #define IMPORT_VALUE_PLUS_BEGIN(x)                                              \
-	if (#x=="param_"+param && x.get_type()==value.get_type())                   \
+	if (synfig::Layer::is_param_member(param, #x) && x.get_type()==value.get_type()) \
 	{                                                                           \
 		x=value;                                                                \
 		{
@@ -112,7 +113,7 @@
 
 //! Exports a parameter if it is the same type as value
 #define EXPORT_VALUE(x)                                                         \
-	if (#x=="param_"+param)                                                     \
+	if (synfig::Layer::is_param_member(param, #x))                              \
 	{                                                                           \
 		synfig::ValueBase ret;					\
 		ret.copy(x);							\
@@ -271,6 +272,13 @@ public:
 	/*! \see get_param_vocab() */
 	typedef ParamVocab Vocab;
 
+	//! Names of the parameters of a layer class, in the order of its vocab
+	/*! Built once per class, \see get_param_slots() */
+	struct ParamSlots
+	{
+		std::vector<String> names;
+	};
+
 	/*
  --	** -- D A T A -------------------------------------------------------------
 	*/
@@ -297,6 +305,19 @@ private:
 	//! Map of parameter with animated value nodes
 	DynamicParamList dynamic_param_list_;
 
+	//! A connected parameter together with the value last passed to set_param()
+	struct DynamicParamSlot
+	{
+		const String *name;						//!< Key of the entry in dynamic_param_list_
+		const etl::rhandle<ValueNode> *value_node;	//!< Value of that entry, follows replace()
+		ValueBase value;
+		bool applied;
+	};
+
+	//! The entries of dynamic_param_list_, in a form cheap to walk for every frame.
+	//! Rebuilt whenever a parameter is connected or disconnected.
+	std::vector<DynamicParamSlot> dynamic_param_slots_;
+
 	//! A description of what this layer does
 	String description_;
 
@@ -306,6 +327,15 @@ private:
 	//! \writeme
 	mutable Time dirty_time_;
 
+	//! Interval around dirty_time_ in which the dynamic parameters keep their
+	//! values, so IndependentContext::set_time() need not evaluate them again.
+	//! Empty (begin > end) when they may change at any time.
+	mutable Time invariance_begin_;
+	mutable Time invariance_end_;
+
+	//! Changed whenever the parameters may have changed, \see get_revision()
+	unsigned long revision_;
+
 	//! Contains the name of the group that this layer belongs to
 	String group_;
 
@@ -424,6 +454,27 @@ public:
 	//! Returns that status of the 'exclude_from_rendering' flag
 	bool get_exclude_from_rendering()const { return exclude_from_rendering_; }
 
+	//! Returns a number which changes whenever the parameters of the layer may have changed
+	/*!	Used together with the GUID to tell whether a rendered result is still valid.
+	**	\see SurfaceCache */
+	unsigned long get_revision()const { return revision_; }
+
+protected:
+	//! Changes the revision for contents which are not parameters, like the pixels of a bitmap
+	void new_revision() { ++revision_; }
+
+public:
+	//! Returns \c true when the rendered result depends on the time
+	//! by other means than the parameters (e.g. noise or an animated import)
+	virtual bool is_time_dependent()const { return false; }
+
+	//! Returns \c true when several threads may render the layer at once
+	/*!	The strips and the tile groups of a frame all render the same layers
+	**	on the threads of a ThreadPool. A layer which shares its state with
+	**	other layers while it renders returns \c false, and the frame is then
+	**	rendered by one thread. \see IndependentContext::is_thread_safe() */
+	virtual bool is_thread_safe()const { return true; }
+
 	//! Returns the position of the layer in the canvas.
 	/*! Returns negative on error */
 	int get_depth()const;
@@ -528,6 +579,21 @@ public:
 	//! Get a list of all of the parameters and their values
 	virtual ParamList get_param_list()const;
 
+	//! Names of the parameters of this layer's class, taken from get_param_vocab() on first use
+	/*!	\return The table shared by all layers of the class, or NULL if the
+	**	vocab differs from layer to layer (see Layer_Mime) */
+	const ParamSlots* get_param_slots()const;
+
+	//! Returns \c true if \a member, the name of a parameter member, is \a prefix followed by \a param
+	/*!	Used by IMPORT_VALUE() and EXPORT_VALUE(), this does not build any string */
+	static bool is_param_member(const String &param, const char *member, const char *prefix = "param_")
+	{
+		while(*prefix)
+			if (*member++ != *prefix++)
+				return false;
+		return param.compare(member) == 0;
+	}
+
 	//! Sets the \a time for the Layer and those under it
 	/*!	\param context		Context iterator referring to next Layer.
 	**	\param time			writeme
@@ -598,6 +664,17 @@ public:
 	//! Disconnects the parameter from any Value Node
 	virtual bool disconnect_dynamic_param(const String& param);
 
+private:
+	//! Refills dynamic_param_slots_ from dynamic_param_list_
+	void update_dynamic_param_slots();
+
+	//! Evaluates the connected parameters at \a time and sets those which changed
+	/*!	Narrows [\a begin, \a end] to the interval in which none of them changes.
+	**	Used by IndependentContext::set_time() */
+	void set_dynamic_params(Time time, Time &begin, Time &end);
+
+public:
+
 	//! Retrieves the grow value from its parent canvas
 	Real get_parent_canvas_grow_value()const;
 
@@ -45,8 +45,11 @@
 
 #include <synfig/general.h>
 #include <synfig/paramdesc.h>
+#include <synfig/threadpool.h>
 #include <ETL/misc>
 
+#include <vector>
+
 #endif
 
 /* === U S I N G =========================================================== */
@@ -57,8 +60,112 @@ using namespace etl;
 
 /* === G L O B A L S ======================================================= */
 
+//! Output columns sampled before moving on to the next row, so that the
+//! bitmap rows read for a tile stay in the cache
+static const int TILE_WIDTH = 64;
+
 /* === P R O C E D U R E S ================================================= */
 
+struct BitmapNearest
+{
+	const Surface &surface;
+	explicit BitmapNearest(const Surface &surface): surface(surface) { }
+	Color operator() (float x, float y) const
+	{
+		int xclamp = min(surface.get_w()-1, max(0, round_to_int(x)));
+		int yclamp = min(surface.get_h()-1, max(0, round_to_int(y)));
+		return surface[yclamp][xclamp];
+	}
+};
+
+struct BitmapLinear
+{
+	const Surface &surface;
+	explicit BitmapLinear(const Surface &surface): surface(surface) { }
+	Color operator() (float x, float y) const { return surface.linear_sample(x, y); }
+};
+
+struct BitmapCosine
+{
+	const Surface &surface;
+	explicit BitmapCosine(const Surface &surface): surface(surface) { }
+	Color operator() (float x, float y) const { return surface.cosine_sample(x, y); }
+};
+
+struct BitmapCubic
+{
+	const Surface &surface;
+	explicit BitmapCubic(const Surface &surface): surface(surface) { }
+	Color operator() (float x, float y) const { return surface.cubic_sample(x, y); }
+};
+
+//! Averages the area of the bitmap covered by an output pixel
+struct BitmapMipmap
+{
+	Mipmap::Sampler sampler;
+	float dx, dy;
+	BitmapMipmap(const Mipmap::Sampler &sampler, float indx, float indy):
+		sampler(sampler), dx(0.5f*indx - 0.5f), dy(0.5f*indy - 0.5f) { }
+	//! (\a x, \a y) is the corner of the pixel, as for the other samplers
+	Color operator() (float x, float y) const { return sampler(x + dx, y + dy); }
+};
+
+//! Samples a band of output rows in tiles and blends them onto the target
+template<typename Sample>
+struct BitmapRows
+{
+	Surface &target;
+	const Sample &sample;
+	int x_start, x_end, y_start;
+	float inx_start, iny_start, indx, indy;
+	float gamma_adjust, amount;
+	Color::BlendMethod blend_method;
+
+	BitmapRows(Surface &target, const Sample &sample, int x_start, int x_end, int y_start,
+			float inx_start, float iny_start, float indx, float indy,
+			float gamma_adjust, float amount, Color::BlendMethod blend_method):
+		target(target), sample(sample), x_start(x_start), x_end(x_end), y_start(y_start),
+		inx_start(inx_start), iny_start(iny_start), indx(indx), indy(indy),
+		gamma_adjust(gamma_adjust), amount(amount), blend_method(blend_method) { }
+
+	void operator() (int begin, int end) const
+	{
+		std::vector<Color> row(TILE_WIDTH);
+		for(int tile = x_start; tile < x_end; tile += TILE_WIDTH)
+		{
+			const int count = min(TILE_WIDTH, x_end - tile);
+			const float inx = inx_start + (tile - x_start)*indx;
+			for(int y = begin; y < end; ++y)
+			{
+				const float iny = iny_start + y*indy;
+				for(int i = 0; i < count; ++i)
+					row[i] = sample(inx + i*indx, iny);
+				if(gamma_adjust != 1.0f)
+					for(int i = 0; i < count; ++i)
+					{
+						row[i].set_r(powf((float)row[i].get_r(), gamma_adjust));
+						row[i].set_g(powf((float)row[i].get_g(), gamma_adjust));
+						row[i].set_b(powf((float)row[i].get_b(), gamma_adjust));
+					}
+				Color::blend_span(&target[y_start + y][tile], &row[0], count, amount, blend_method);
+			}
+		}
+	}
+};
+
+template<typename Sample>
+static void
+render_rows(Surface &target, const Sample &sample, int x_start, int x_end, int y_start, int y_end,
+	float inx_start, float iny_start, float indx, float indy,
+	float gamma_adjust, float amount, Color::BlendMethod blend_method)
+{
+	ThreadPool &pool(ThreadPool::instance());
+	const int rows = y_end - y_start;
+	pool.run_bands(
+		BitmapRows<Sample>(target, sample, x_start, x_end, y_start, inx_start, iny_start, indx, indy, gamma_adjust, amount, blend_method),
+		rows, (x_end - x_start)*rows < 128*128 ? 1 : pool.get_threads()*4);
+}
+
 /* === M E T H O D S ======================================================= */
 
 synfig::Layer_Bitmap::Layer_Bitmap():
@@ -525,148 +632,38 @@ Layer_Bitmap::accelerated_render(Context context,Surface *surface,int quality, c
 
 	//synfig::info("xstart:%d ystart:%d xend:%d yend:%d",x_start,y_start,x_end,y_end);
 
-	//start drawing at the start of the bitmap (either origin or corner of input...)
-	//and get other info
-	Surface::alpha_pen pen(surface->get_pen(x_start,y_start));
-	pen.set_alpha(get_amount());
-	pen.set_blend_method(get_blend_method());
+	if(x_start >= x_end || y_start >= y_end)
+		return true;
 
-	//check if we should use the downscale filtering
-	if(quality <= 7)
+	//when the bitmap is drawn smaller, sample its prefiltered levels
+	//instead of skipping pixels
+	if(quality < 10 && (fabs(indx) > 1 || fabs(indy) > 1))
 	{
-		//the stride of the value should be inverted because we want to downsample
-		//when the stride is small, not big
-		//int multw = (int)ceil(indx);
-		//int multh = (int)ceil(indy);
-
-		if(indx > 1.7 || indy > 1.7)
+		if(!mipmap || !mipmap->build(this->surface))
 		{
-			/*synfig::info("Decided to downsample? ratios - (%f,%f) -> (%d,%d)",
-						indx, indy, multw, multh);	*/
-
-			//use sample rect here...
-
-			float iny, inx;
-			int x,y;
-
-			//Point sample - truncate
-			iny = iny_start;//+0.5f;
-			for(y = y_start; y < y_end; ++y, pen.inc_y(), iny += indy)
-			{
-				inx = inx_start;//+0.5f;
-				for(x = x_start; x < x_end; x++, pen.inc_x(), inx += indx)
-				{
-					Color rc = this->surface.sample_rect_clip(inx,iny,inx+indx,iny+indy);
-					pen.put_value(filter(rc));
-				}
-				pen.dec_x(x_end-x_start);
-			}
-
-			//Color c = (*surface)[0][0];
-			//synfig::info("ValueBase of first pixel = (%f,%f,%f,%f)",c.get_r(),c.get_g(),c.get_b(),c.get_a());
-
-			return true;
+			mipmap = new Mipmap();
+			mipmap->build(this->surface);
 		}
+		BitmapMipmap sample(Mipmap::Sampler(*mipmap, this->surface, indx, indy), indx, indy);
+		render_rows(*surface, sample, x_start, x_end, y_start, y_end, inx_start, iny_start, indx, indy, gamma_adjust, get_amount(), get_blend_method());
+		return true;
 	}
 
 	//perform normal interpolation
-	if(interp==0)
+	switch(interp)
 	{
-		//synfig::info("Decided to do nearest neighbor");
-		float iny, inx;
-		int x,y;
-
-		//Point sample - truncate
-		iny = iny_start;//+0.5f;
-		for(y = y_start; y < y_end; y++, pen.inc_y(), iny += indy)
-		{
-			inx = inx_start;//+0.5f;
-			int yclamp = min(inh-1, max(0, round_to_int(iny)));
-			for(x = x_start; x < x_end; x++, pen.inc_x(), inx += indx)
-			{
-				int xclamp = min(inw-1, max(0, round_to_int(inx)));
-				Color c = filter(this->surface[yclamp][xclamp]);
-				pen.put_value(c); //must get rid of the clip
-			}
-			pen.dec_x(x_end-x_start);
-		}
-	}
-	else
-	if(interp==1)
-	{
-		//bilinear filtering
-
-		//float 	xmf,xpf,ymf,ypf;
-		//int		xm,xp,ym,yp;
-		float 	inx,iny;
-		int		x,y;
-
-		//can probably buffer for x values...
-
-		//loop and based on inx,iny sample input image
-		iny = iny_start;
-		for(y = y_start; y < y_end; y++, pen.inc_y(), iny += indy)
-		{
-			inx = inx_start;
-			for(x = x_start; x < x_end; x++, pen.inc_x(), inx += indx)
-			{
-				Color col(this->surface.linear_sample(inx,iny));
-				pen.put_value(filter(col));
-			}
-			pen.dec_x(x_end-x_start);
-
-		}
-	}
-	else
-	if(interp==2)
-	{
-		//cosine filtering
-
-		//float 	xmf,xpf,ymf,ypf;
-		//int		xm,xp,ym,yp;
-		float 	inx,iny;
-		int		x,y;
-
-		//can probably buffer for x values...
-
-		//loop and based on inx,iny sample input image
-		iny = iny_start;
-		for(y = y_start; y < y_end; y++, pen.inc_y(), iny += indy)
-		{
-			inx = inx_start;
-			for(x = x_start; x < x_end; x++, pen.inc_x(), inx += indx)
-			{
-				Color col(this->surface.cosine_sample(inx,iny));
-				pen.put_value(filter(col));
-			}
-			pen.dec_x(x_end-x_start);
-
-		}
-	}
-	else
-	{
-		//cubic filtering
-
-		//float 	xmf,xpf,ymf,ypf;
-		//int		xm,xp,ym,yp;
-		float 	inx,iny;
-		int		x,y;
-
-		//can probably buffer for x values...
-
-		//loop and based on inx,iny sample input image
-		iny = iny_start;
-		for(y = y_start; y < y_end; y++, pen.inc_y(), iny += indy)
-		{
-			inx = inx_start;
-			for(x = x_start; x < x_end; x++, pen.inc_x(), inx += indx)
-			{
-				Color col(this->surface.cubic_sample(inx,iny));
-				pen.put_value(filter(col));
-			}
-			pen.dec_x(x_end-x_start);
-
-		}
+	case 0:
+		render_rows(*surface, BitmapNearest(this->surface), x_start, x_end, y_start, y_end, inx_start, iny_start, indx, indy, gamma_adjust, get_amount(), get_blend_method());
+		break;
+	case 1:
+		render_rows(*surface, BitmapLinear(this->surface), x_start, x_end, y_start, y_end, inx_start, iny_start, indx, indy, gamma_adjust, get_amount(), get_blend_method());
+		break;
+	case 2:
+		render_rows(*surface, BitmapCosine(this->surface), x_start, x_end, y_start, y_end, inx_start, iny_start, indx, indy, gamma_adjust, get_amount(), get_blend_method());
+		break;
+	default:
+		render_rows(*surface, BitmapCubic(this->surface), x_start, x_end, y_start, y_end, inx_start, iny_start, indx, indy, gamma_adjust, get_amount(), get_blend_method());
+		break;
 	}
 
 	return true;
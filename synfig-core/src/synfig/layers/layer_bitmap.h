@@ -30,6 +30,7 @@
 
 #include "layer_composite.h"
 #include <synfig/surface.h>
+#include <synfig/mipmap.h>
 #include <synfig/target.h> // for RenderMethod
 
 /* === M A C R O S ========================================================= */
@@ -61,6 +62,13 @@ public:
 	mutable CairoSurface csurface;
 	mutable bool trimmed;
 	mutable unsigned int width, height, top, left;
+	//! Downscaled copies of \c surface, built when it is first drawn smaller.
+	//! Whoever changes \c surface must clear it, see surface_changed().
+	mutable Mipmap::Handle mipmap;
+
+	//! To be called under \c mutex after changing \c surface.
+	//! Drops the mipmap and changes the revision, so no cached render of the old pixels is used.
+	void surface_changed()const { mipmap=NULL; const_cast<Layer_Bitmap*>(this)->new_revision(); }
 
 
 	Layer_Bitmap();
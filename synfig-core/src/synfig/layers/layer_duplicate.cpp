@@ -40,6 +40,15 @@
 #include <synfig/value.h>
 #include <synfig/valuenode.h>
 #include <synfig/canvas.h>
+#include <synfig/mutex.h>
+#include <synfig/surfacecache.h>
+#include <synfig/threadpool.h>
+#include "layer_pastecanvas.h"
+
+#include <list>
+#include <set>
+#include <map>
+#include <algorithm>
 
 #endif
 
@@ -58,10 +67,387 @@ SYNFIG_LAYER_SET_CATEGORY(Layer_Duplicate,N_("Other"));
 SYNFIG_LAYER_SET_VERSION(Layer_Duplicate,"0.1");
 SYNFIG_LAYER_SET_CVS_ID(Layer_Duplicate,"$Id$");
 
+//! Number of sets of copies kept by a layer
+static const size_t COPY_CACHE_SIZE = 2;
+//! Deepest nesting of groups which is searched for the index
+static const int MAX_COPY_DEPTH = 32;
+
+/* === P R O C E D U R E S ================================================= */
+
+//! Layer with parameters depending on the index of a duplicate layer
+struct IndexDependent
+{
+	Layer::Handle layer;
+	//! Time of the canvas of the layer
+	Time time;
+	//! Names of the parameters depending on the index
+	std::vector<String> params;
+};
+
+//! Renders one copy of the context, for one value of the index
+struct RenderCopy: public ThreadPool::Task
+{
+	Context context;
+	RendDesc desc;
+	int quality;
+	//! The alpha of the copy is multiplied by it
+	float amount;
+	Surface surface;
+	bool success;
+
+	RenderCopy(): quality(), amount(1), success() { }
+
+	virtual void run()
+	{
+		try { success = context.accelerated_render(&surface, quality, desc, NULL); }
+		catch(...) { success = false; }
+		if (!success || amount == 1)
+			return;
+		for(int j = 0; j < surface.get_h(); j++)
+		{
+			Color *row = surface[j];
+			for(int i = 0; i < surface.get_w(); i++)
+				row[i].set_a(row[i].get_a()*amount);
+		}
+	}
+};
+
+//! Composites a copy onto the copy before it
+struct MergeCopies: public ThreadPool::Task
+{
+	Surface *upper;
+	Surface *lower;
+
+	MergeCopies(Surface &upper, Surface &lower): upper(&upper), lower(&lower) { }
+
+	virtual void run()
+	{
+		Surface::alpha_pen apen(lower->begin());
+		apen.set_alpha(1);
+		apen.set_blend_method(Color::BLEND_COMPOSITE);
+		upper->blit_to(apen);
+	}
+};
+
+//! Adds \a node and all the value nodes using it to \a nodes
+static void
+add_users(const Node *node, std::set<const Node*> &nodes)
+{
+	if (!nodes.insert(node).second)
+		return;
+	for(std::set<Node*>::const_iterator iter = node->parent_set.begin(); iter != node->parent_set.end(); ++iter)
+		if (dynamic_cast<const ValueNode*>(*iter))
+			add_users(*iter, nodes);
+}
+
+//! Finds the layers of \a context with parameters linked to some of \a nodes
+/*!	The groups are searched too. The dependent layers and the groups containing
+**	them are added to \a affected, those are the layers to copy for each index.
+**	\return \c false if the copies can't render at once */
+static bool
+find_dependents(IndependentContext context, Time time, const std::set<const Node*> &nodes,
+	std::vector<IndexDependent> &dependents, std::set<const Layer*> &affected, int depth)
+{
+	if (depth >= MAX_COPY_DEPTH)
+		return false;
+
+	bool copyable = true;
+	for(; !context->empty(); ++context)
+	{
+		const Layer::Handle &layer(*context);
+		const Layer_PasteCanvas *paste = dynamic_cast<const Layer_PasteCanvas*>(layer.get());
+
+		IndexDependent dependent;
+		for(Layer::DynamicParamList::const_iterator iter = layer->dynamic_param_list().begin(); iter != layer->dynamic_param_list().end(); ++iter)
+			if (nodes.count(iter->second.get()))
+				dependent.params.push_back(iter->first);
+
+		const size_t inner = dependents.size();
+		if (paste && paste->get_sub_canvas()
+		 && !find_dependents(paste->get_sub_canvas()->get_independent_context(), time + paste->get_time_offset(), nodes, dependents, affected, depth + 1))
+			copyable = false;
+
+		if (dependent.params.empty() && inner == dependents.size())
+			continue;
+		affected.insert(layer.get());
+
+		// These share their state with their copies, which then can't
+		// render at once: the index of the duplicates, the importer of an
+		// image sequence, the fonts and the sub canvas chosen by the index
+		const String &name = layer->get_name();
+		if (name == "duplicate" || name == "import" || name == "text" || !Layer::book().count(name)
+		 || std::find(dependent.params.begin(), dependent.params.end(), "canvas") != dependent.params.end())
+			copyable = false;
+		if (paste)
+		{
+			// the z range uses the positions of the layers in their canvas,
+			// and the copies share the layers at those positions
+			ContextParams params;
+			paste->apply_z_range_to_params(params);
+			if (params.z_range)
+				copyable = false;
+		}
+
+		if (!dependent.params.empty())
+		{
+			dependent.layer = layer;
+			dependent.time = time;
+			dependents.push_back(dependent);
+		}
+	}
+	return copyable;
+}
+
+//! Finds the layers the copies of \a context would share and can't render at once
+/*!	A group sets the time and the grow value of its canvas while it renders,
+**	so the shared groups are added to \a affected and each copy gets its own.
+**	The layers which render or set the layers under them at other times or
+**	indexes can't be shared.
+**	\return \c false if the copies can't render at once */
+static bool
+find_shared_state(IndependentContext context, std::set<const Layer*> &affected, int depth)
+{
+	if (depth >= MAX_COPY_DEPTH)
+		return false;
+
+	for(; !context->empty(); ++context)
+	{
+		const Layer::Handle &layer(*context);
+		const Layer_PasteCanvas *paste = dynamic_cast<const Layer_PasteCanvas*>(layer.get());
+		if (!affected.count(layer.get()))
+		{
+			const String &name = layer->get_name();
+			if (name == "duplicate" || name == "MotionBlur" || name == "stroboscope" || name == "timeloop")
+				return false;
+			if (!paste || !paste->get_sub_canvas())
+			{
+				if (!layer->is_thread_safe())
+					return false;
+				continue;
+			}
+
+			ContextParams params;
+			paste->apply_z_range_to_params(params);
+			if (params.z_range || !Layer::book().count(name))
+				return false;
+			affected.insert(layer.get());
+		}
+
+		if (paste && paste->get_sub_canvas()
+		 && !find_shared_state(paste->get_sub_canvas()->get_independent_context(), affected, depth + 1))
+			return false;
+	}
+	return true;
+}
+
+//! Finds the layers of \a context with parameters depending on \a index
+static bool
+find_dependents(IndependentContext context, const ValueNode_Duplicate::Handle &index, Time time,
+	std::vector<IndexDependent> &dependents, std::set<const Layer*> &affected)
+{
+	std::set<const Node*> nodes;
+	add_users(index.get(), nodes);
+	return find_dependents(context, time, nodes, dependents, affected, 0);
+}
+
+//! Evaluates the parameters of \a dependent which depend on the index
+static Layer::ParamList
+evaluate(const IndexDependent &dependent)
+{
+	Layer::ParamList params;
+	const Layer::DynamicParamList &dynamic_params = dependent.layer->dynamic_param_list();
+	for(std::vector<String>::const_iterator iter = dependent.params.begin(); iter != dependent.params.end(); ++iter)
+	{
+		Layer::DynamicParamList::const_iterator param = dynamic_params.find(*iter);
+		if (param != dynamic_params.end())
+			params[*iter] = (*param->second)(dependent.time);
+	}
+	return params;
+}
+
+//! Copies the affected layers of \a context into \a canvas, the others are shared
+/*!	The copies are clones linked to the same value nodes as the originals,
+**	but the parameters depending on the index are set to \a values instead.
+**	So the originals are never changed for an index, and the copies don't
+**	change when the index steps on. */
+static void
+copy_affected(IndependentContext context, Canvas::Handle canvas, const std::set<const Layer*> &affected,
+	const std::map<const Layer*, Layer::ParamList> &values)
+{
+	for(; !context->empty(); ++context)
+	{
+		const Layer::Handle &layer(*context);
+		if (!affected.count(layer.get()))
+		{
+			canvas->push_back_simple(layer);
+			continue;
+		}
+		const Layer_PasteCanvas *paste = dynamic_cast<const Layer_PasteCanvas*>(layer.get());
+
+		// a new GUID, so the copies for other indexes and frames never share cached surfaces
+		Layer::Handle copy(layer->clone(layer->get_canvas(), GUID()));
+		if (!copy)
+		{
+			synfig::warning("Duplicate: can't copy layer \"%s\", it is shared by the copies", layer->get_name().c_str());
+			canvas->push_back_simple(layer);
+			continue;
+		}
+
+		// clone() links the copy to clones of the value nodes. The originals
+		// keep their cached values, and the layers under an inner duplicate
+		// follow the index it steps.
+		const Layer::DynamicParamList &dynamic_params = layer->dynamic_param_list();
+		for(Layer::DynamicParamList::const_iterator iter = dynamic_params.begin(); iter != dynamic_params.end(); ++iter)
+			if (!paste || iter->first != "canvas")
+				copy->connect_dynamic_param(iter->first, iter->second);
+
+		bool own_canvas = true;
+		std::map<const Layer*, Layer::ParamList>::const_iterator value = values.find(layer.get());
+		if (value != values.end())
+			for(Layer::ParamList::const_iterator iter = value->second.begin(); iter != value->second.end(); ++iter)
+			{
+				copy->disconnect_dynamic_param(iter->first);
+				copy->set_param(iter->first, iter->second);
+				if (paste && iter->first == "canvas")
+					own_canvas = false;
+			}
+
+		if (paste && paste->get_sub_canvas() && own_canvas)
+		{
+			// inline, so it belongs to the copy alone. The shared layers are
+			// only added to it, they stay in the groups of their own canvas.
+			Canvas::Handle sub_canvas(Canvas::create_inline(canvas));
+			sub_canvas->set_grow_value(paste->get_sub_canvas()->get_grow_value());
+			copy_affected(paste->get_sub_canvas()->get_independent_context(), sub_canvas, affected, values);
+			copy->disconnect_dynamic_param("canvas");
+			etl::handle<Layer_PasteCanvas>::cast_static(copy)->set_sub_canvas(sub_canvas);
+		}
+
+		canvas->push_back_simple(copy);
+		// the copy takes the position of the original for the z range. A group
+		// showing the canvas of the index keeps it where it is, it isn't ours.
+		if (own_canvas)
+			copy->set_canvas(canvas);
+	}
+}
+
+//! Adds the layers of \a context to \a key
+static bool
+add_layers_to_key(SurfaceCache::KeyBuilder &key, IndependentContext context, int depth)
+{
+	if (depth >= MAX_COPY_DEPTH)
+		return false;
+
+	for(; !context->empty(); ++context)
+	{
+		const Layer &layer(**context);
+		key.add(layer.get_guid().get_hi());
+		key.add(layer.get_guid().get_lo());
+		key.add(layer.get_revision());
+		key.add(layer.active());
+		key.add(layer.get_exclude_from_rendering());
+
+		const Layer_PasteCanvas *paste = dynamic_cast<const Layer_PasteCanvas*>(&layer);
+		if (paste && paste->get_sub_canvas()
+		 && !add_layers_to_key(key, paste->get_sub_canvas()->get_independent_context(), depth + 1))
+			return false;
+	}
+
+	// marks the end of the canvas, so nesting can't be confused with a flat list
+	key.add(depth);
+	return true;
+}
+
+/* === C L A S S E S ======================================================= */
+
+//! The context for every value of the index of one frame
+struct Layer_Duplicate::Copies
+{
+	SurfaceCache::Key key;
+
+	std::vector<IndexDependent> dependents;
+	//! The copies can render at once, otherwise they are rendered in turn
+	bool parallel;
+	//! Number of values of the index
+	int count;
+	//! A copy of the context for each index, the layers but the groups which
+	//! don't depend on the index are shared.
+	//! Empty if nothing depends on the index: every copy is the context itself.
+	std::vector<Canvas::Handle> canvases;
+
+	//! Renders using the copies right now, the entry is kept until they finish
+	int users;
+
+	Copies(): key(), parallel(), count(), users() { }
+
+	//! Finds the dependent layers and copies them for each index
+	void build(const Context &context, const ValueNode_Duplicate::Handle &index, Time time)
+	{
+		std::set<const Layer*> affected;
+		parallel = find_dependents(context, index, time, dependents, affected)
+		        && !context.get_params().z_range;
+		// the copies render at once, so they only share layers which don't change meanwhile
+		if (parallel && !dependents.empty())
+			parallel = find_shared_state(context, affected, 0);
+
+		index->reset_index(time);
+		do
+		{
+			count++;
+			if (dependents.empty())
+				continue;
+
+			std::map<const Layer*, Layer::ParamList> values;
+			for(std::vector<IndexDependent>::const_iterator iter = dependents.begin(); iter != dependents.end(); ++iter)
+				values[iter->layer.get()] = evaluate(*iter);
+
+			Canvas::Handle canvas(Canvas::create());
+			copy_affected(context, canvas, affected, values);
+			canvas->get_independent_context().set_time(time);
+			canvases.push_back(canvas);
+		} while (index->step(time));
+	}
+};
+
+//! The last sets of copies of one layer, guarded by its mutex
+struct Layer_Duplicate::CopyCache
+{
+	typedef std::list<Copies> EntryList;
+
+	//! Most recently used first
+	EntryList entries;
+
+	//! Forgets the least recently used entries nobody is rendering
+	void trim()
+	{
+		EntryList::iterator i = entries.end();
+		while(entries.size() > COPY_CACHE_SIZE && i != entries.begin())
+			if ((--i)->users == 0)
+				i = entries.erase(i);
+	}
+
+	//! Releases an entry, even if the rendering throws
+	class User
+	{
+		CopyCache &cache;
+		Copies &copies;
+		Mutex &mutex;
+	public:
+		User(CopyCache &cache, Copies &copies, Mutex &mutex): cache(cache), copies(copies), mutex(mutex) { }
+		~User()
+		{
+			Mutex::Lock lock(mutex);
+			--copies.users;
+			cache.trim();
+		}
+	};
+};
+
 /* === M E M B E R S ======================================================= */
 
 Layer_Duplicate::Layer_Duplicate():
-	Layer_Composite(1.0,Color::BLEND_COMPOSITE)
+	Layer_Composite(1.0,Color::BLEND_COMPOSITE),
+	copy_cache(new CopyCache)
 {
 	LinkableValueNode* index_value_node = ValueNode_Duplicate::create(Real(3));
 	connect_dynamic_param("index", index_value_node);
@@ -70,6 +456,12 @@ Layer_Duplicate::Layer_Duplicate():
 	SET_STATIC_DEFAULTS();
 }
 
+Layer_Duplicate::~Layer_Duplicate()
+{
+	Mutex::Lock lock(mutex);
+	delete copy_cache;
+}
+
 Layer::Handle
 Layer_Duplicate::clone(Canvas::LooseHandle canvas, const GUID& deriv_guid)const
 {
@@ -129,14 +521,14 @@ Layer_Duplicate::get_color(Context context, const Point &pos)const
 	float amount(get_amount());
 	Color color;
 
+	Copies &copies = get_copies(context, duplicate_param);
+	CopyCache::User user(*copy_cache, copies, mutex);
 	Mutex::Lock lock(mutex);
-	duplicate_param->reset_index(time_cur);
-	do
+	for(int i = 0; i < copies.count; i++)
 	{
-		context.set_time(time_cur+1);
-		context.set_time(time_cur);
-		color = Color::blend(context.get_color(pos),color,amount,blend_method);
-	} while (duplicate_param->step(time_cur));
+		Context copy(copies.canvases.empty() ? context : copies.canvases[i]->get_context(context));
+		color = Color::blend(copy.get_color(pos),color,amount,blend_method);
+	}
 
 	return color;
 }
@@ -180,36 +572,160 @@ Layer_Duplicate::accelerated_render(Context context,Surface *surface,int quality
 		return true;
 	}
 
-	SuperCallback subimagecb;
-	Surface tmp;
-	int i = 0;
-
 	handle<ValueNode_Duplicate> duplicate_param = get_duplicate_param();
 	if (!duplicate_param) return context.accelerated_render(surface,quality,renddesc,cb);
 
+	Copies &copies = get_copies(context, duplicate_param);
+	CopyCache::User user(*copy_cache, copies, mutex);
+	if (!copies.parallel)
+		return render_in_turn(context,surface,quality,renddesc,cb,copies);
+	return render_copies(context,surface,quality,renddesc,cb,copies);
+}
+
+//! Finds the copies of the context for the current time, or makes them
+/*!	The caller uses them until it destroys a CopyCache::User for them */
+Layer_Duplicate::Copies &
+Layer_Duplicate::get_copies(Context context, const ValueNode_Duplicate::Handle &index)const
+{
+	SurfaceCache::KeyBuilder key;
+	key.add((double)time_cur);
+	key.add(get_revision());
+	const bool keyed = add_layers_to_key(key, context, 0);
+
+	Mutex::Lock lock(mutex);
+	CopyCache::EntryList &entries = copy_cache->entries;
+	CopyCache::EntryList::iterator entry;
+	for(entry = entries.begin(); keyed && entry != entries.end(); ++entry)
+		if (entry->key == key.get())
+			break;
+	if (!keyed || entry == entries.end())
+	{
+		entries.push_front(Copies());
+		entry = entries.begin();
+		entry->key = key.get();
+		entry->build(context, index, time_cur);
+	}
+	else
+		entries.splice(entries.begin(), entries, entry);
+
+	++entry->users;
+	return *entry;
+}
+
+//! Renders the copies of the context in parallel, a batch at a time
+/*!	The copies are made once per frame and shared by all the tiles. When the
+**	copies are composited, each batch is merged in pairs, and the pairs of
+**	pairs and so on, before it goes onto the surface. */
+bool
+Layer_Duplicate::render_copies(Context context,Surface *surface,int quality,const RendDesc &renddesc,ProgressCallback *cb,const Copies &copies)const
+{
+	surface->set_wh(renddesc.get_w(),renddesc.get_h());
+	surface->clear();
+
+	Color::BlendMethod blend_method(get_blend_method());
+	const float amount = get_amount();
+
+	// Nothing depends on the index, every copy is the same
+	if (copies.canvases.empty())
+	{
+		Surface tmp;
+		if(!context.accelerated_render(&tmp,quality,renddesc,cb)) return false;
+		for(int i = 0; i < copies.count; i++)
+		{
+			Surface::alpha_pen apen(surface->begin());
+			apen.set_alpha(amount);
+			apen.set_blend_method(i ? blend_method : Color::BLEND_COMPOSITE);
+			tmp.blit_to(apen);
+		}
+		return true;
+	}
+
+	// Compositing is associative, when the alpha of each copy is scaled by the amount
+	const bool merge = blend_method == Color::BLEND_COMPOSITE && amount >= 0 && amount <= 1;
+
+	ThreadPool &pool = ThreadPool::instance();
+	const int batch = std::max(2, pool.get_threads()*2);
+	const int count = copies.canvases.size();
+	for(int first = 0; first < count; first += batch)
+	{
+		const int last = std::min(first + batch, count);
+		std::vector<RenderCopy> tasks(last - first);
+		std::vector<ThreadPool::Task*> list;
+		for(int i = first; i < last; i++)
+		{
+			RenderCopy &task = tasks[i - first];
+			task.context = copies.canvases[i]->get_context(context);
+			task.desc = renddesc;
+			task.quality = quality;
+			task.amount = merge ? amount : 1;
+			list.push_back(&task);
+		}
+		pool.run(list);
+		for(size_t i = 0; i < tasks.size(); i++)
+			if (!tasks[i].success)
+				return false;
+
+		if (merge)
+		{
+			// the later copies go over the earlier ones
+			for(size_t stride = 1; stride < tasks.size(); stride *= 2)
+			{
+				std::vector<MergeCopies> merges;
+				for(size_t i = 0; i + stride < tasks.size(); i += 2*stride)
+					merges.push_back(MergeCopies(tasks[i + stride].surface, tasks[i].surface));
+				list.clear();
+				for(size_t i = 0; i < merges.size(); i++)
+					list.push_back(&merges[i]);
+				pool.run(list);
+			}
+			Surface::alpha_pen apen(surface->begin());
+			apen.set_alpha(1);
+			apen.set_blend_method(Color::BLEND_COMPOSITE);
+			tasks[0].surface.blit_to(apen);
+		}
+		else
+			for(int i = first; i < last; i++)
+			{
+				Surface::alpha_pen apen(surface->begin());
+				apen.set_alpha(amount);
+				apen.set_blend_method(i ? blend_method : Color::BLEND_COMPOSITE);
+				tasks[i - first].surface.blit_to(apen);
+			}
+
+		if (cb && !cb->amount_complete(last, count))
+			return false;
+	}
+	return true;
+}
+
+//! Renders the copies of the context in turn
+/*!	Some of the copies share layers which can't render at once, so nobody
+**	else may render them meanwhile */
+bool
+Layer_Duplicate::render_in_turn(Context context,Surface *surface,int quality,const RendDesc &renddesc,ProgressCallback *cb,const Copies &copies)const
+{
+	SuperCallback subimagecb;
+	Surface tmp;
+
 	surface->set_wh(renddesc.get_w(),renddesc.get_h());
 	surface->clear();
 
 	Color::BlendMethod blend_method(get_blend_method());
-	int steps = duplicate_param->count_steps(time_cur);
+	int steps = copies.count;
 
 	Mutex::Lock lock(mutex);
-	duplicate_param->reset_index(time_cur);
-	do
+	for(int i = 0; i < steps; i++)
 	{
 		subimagecb=SuperCallback(cb,i*(5000/steps),(i+1)*(5000/steps),5000);
-		// \todo can we force a re-evaluation of all the variables without changing the time twice?
-		context.set_time(time_cur+1);
-		context.set_time(time_cur);
-		if(!context.accelerated_render(&tmp,quality,renddesc,&subimagecb)) return false;
+		Context copy(copies.canvases.empty() ? context : copies.canvases[i]->get_context(context));
+		if(!copy.accelerated_render(&tmp,quality,renddesc,&subimagecb)) return false;
 
 		Surface::alpha_pen apen(surface->begin());
 		apen.set_alpha(get_amount());
 		// \todo have a checkbox allowing use of 'behind' to reverse the order?
 		apen.set_blend_method(i ? blend_method : Color::BLEND_COMPOSITE);
 		tmp.blit_to(apen);
-		i++;
-	} while (duplicate_param->step(time_cur));
+	}
 
 	return true;
 }
@@ -232,25 +748,23 @@ Layer_Duplicate::accelerated_cairorender(Context context, cairo_t *cr, int quali
 	
 	SuperCallback subimagecb;
 	
-	int i = 0;
-	
 	handle<ValueNode_Duplicate> duplicate_param = get_duplicate_param();
 	if (!duplicate_param) return context.accelerated_cairorender(cr,quality,renddesc,cb);
 	
 	Color::BlendMethod blend_method(get_blend_method());
-	int steps = duplicate_param->count_steps(time_cur);
+	
+	Copies &copies = get_copies(context, duplicate_param);
+	CopyCache::User user(*copy_cache, copies, mutex);
+	int steps = copies.count;
 	
 	Mutex::Lock lock(mutex);
-	duplicate_param->reset_index(time_cur);
 	cairo_save(cr);
-	do
+	for(int i = 0; i < steps; i++)
 	{
 		subimagecb=SuperCallback(cb,i*(5000/steps),(i+1)*(5000/steps),5000);
-		// \todo can we force a re-evaluation of all the variables without changing the time twice?
-		context.set_time(time_cur+1);
-		context.set_time(time_cur);
+		Context copy(copies.canvases.empty() ? context : copies.canvases[i]->get_context(context));
 		cairo_push_group(cr);
-		if(!context.accelerated_cairorender(cr,quality,renddesc,&subimagecb))
+		if(!copy.accelerated_cairorender(cr,quality,renddesc,&subimagecb))
 		{
 			cairo_pop_group(cr);
 			return false;
@@ -258,8 +772,7 @@ Layer_Duplicate::accelerated_cairorender(Context context, cairo_t *cr, int quali
 		cairo_pop_group_to_source(cr);;
 		// \todo have a checkbox allowing use of 'behind' to reverse the order?
 		cairo_paint_with_alpha_operator(cr, get_amount(), i ? blend_method : Color::BLEND_COMPOSITE);
-		i++;
-	} while (duplicate_param->step(time_cur));
+	}
 	cairo_restore(cr);
 	return true;
 }
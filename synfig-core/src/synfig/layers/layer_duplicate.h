@@ -43,11 +43,23 @@ class Layer_Duplicate : public synfig::Layer_Composite
 private:
 	mutable ValueBase param_index;
 	mutable Time time_cur;
-	mutable synfig::Mutex mutex;
+	//! Recursive, the copies of an outer layer may render this one on the
+	//! same thread while it is rendering in turn
+	mutable synfig::RecMutex mutex;
+
+	struct Copies;
+	struct CopyCache;
+	//! The last sets of copies of the context, one copy for each index
+	CopyCache *copy_cache;
+
+	Copies &get_copies(Context context, const ValueNode_Duplicate::Handle &index)const;
+	bool render_copies(Context context,Surface *surface,int quality,const RendDesc &renddesc,ProgressCallback *cb,const Copies &copies)const;
+	bool render_in_turn(Context context,Surface *surface,int quality,const RendDesc &renddesc,ProgressCallback *cb,const Copies &copies)const;
 
 public:
 
 	Layer_Duplicate();
+	virtual ~Layer_Duplicate();
 
 	//! Duplicates the Layer
 	virtual Layer::Handle clone(etl::loose_handle<Canvas> canvas, const GUID& deriv_guid=GUID())const;
@@ -98,6 +98,9 @@ Layer_MeshTransform::update_mesh_and_mask()
 {
 	// TODO: check mask to calculate bounds
 
+	// the lookup grids are built again on demand
+	mesh.changed();
+
 	texture_scale_dependency_from_x = Vector::zero();
 	texture_scale_dependency_from_y = Vector::zero();
 
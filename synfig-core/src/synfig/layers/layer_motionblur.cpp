@@ -40,7 +40,22 @@
 #include <synfig/value.h>
 #include <synfig/valuenode.h>
 #include <synfig/canvas.h>
+#include <synfig/general.h>
+#include <synfig/mutex.h>
+#include <synfig/surfacecache.h>
+#include <synfig/threadpool.h>
+#include "layer_pastecanvas.h"
 
+#include <cmath>
+#include <list>
+#include <algorithm>
+
+#endif
+
+// The colors are summed as vectors, they must be four packed floats
+#if !defined(USE_HALF_TYPE) && !defined(HAS_VIMAGE) && defined(__SSE2__)
+#define SYNFIG_MOTIONBLUR_SSE2
+#include <emmintrin.h>
 #endif
 
 /* === U S I N G =========================================================== */
@@ -58,6 +73,479 @@ SYNFIG_LAYER_SET_CATEGORY(Layer_MotionBlur,N_("Blurs"));
 SYNFIG_LAYER_SET_VERSION(Layer_MotionBlur,"0.1");
 SYNFIG_LAYER_SET_CVS_ID(Layer_MotionBlur,"$Id$");
 
+//! Number of sets of copies kept by a layer
+static const size_t SAMPLE_CACHE_SIZE = 2;
+//! Deepest nesting of groups which is copied
+static const int MAX_COPY_DEPTH = 32;
+//! Pixels around a moving layer which are blurred as well, for antialiasing
+static const int DAMAGE_MARGIN = 2;
+
+/* === P R O C E D U R E S ================================================= */
+
+//! Guards the copies of all the motion blur layers
+/*!	Creating and destroying layers and value nodes updates global tables,
+**	so it must not happen on several threads at once. The mutex is recursive
+**	because destroying copies of a motion blur destroys its copies too. */
+static RecMutex&
+copies_mutex()
+{
+	static RecMutex mutex;
+	return mutex;
+}
+
+//! Adds \a weight times the premultiplied colors of \a src to \a dest
+static void
+add_premultiplied(Color *dest, const Color *src, int count, float weight)
+{
+	int i = 0;
+#ifdef SYNFIG_MOTIONBLUR_SSE2
+	// alpha is the first lane
+	const __m128 w = _mm_set1_ps(weight);
+	const __m128 alpha_lane = _mm_castsi128_ps(_mm_set_epi32(0, 0, 0, -1));
+	for(; i < count; i++)
+	{
+		const __m128 c = _mm_loadu_ps((const float*)(src + i));
+		const __m128 a = _mm_mul_ps(_mm_shuffle_ps(c, c, 0), w);
+		// colors times alpha and weight, alpha times weight
+		const __m128 k = _mm_or_ps(_mm_and_ps(alpha_lane, w), _mm_andnot_ps(alpha_lane, a));
+		_mm_storeu_ps((float*)(dest + i), _mm_add_ps(_mm_loadu_ps((const float*)(dest + i)), _mm_mul_ps(c, k)));
+	}
+#endif
+	for(; i < count; i++)
+		dest[i] += src[i].premult_alpha()*weight;
+}
+
+//! Adds a weighted subsample to a band of rows of the sum
+struct AddRows
+{
+	Surface &sum;
+	const Surface &src;
+	//! Position of the sum in \a src
+	int x, y;
+	float weight;
+
+	AddRows(Surface &sum, const Surface &src, int x, int y, float weight):
+		sum(sum), src(src), x(x), y(y), weight(weight) { }
+
+	void operator()(int begin, int end)const
+	{
+		for(int j = begin; j < end; j++)
+			add_premultiplied(sum[j], src[j + y] + x, sum.get_w(), weight);
+	}
+};
+
+//! Divides a band of rows of the sum by the total weight and puts them into \a dest
+struct ResolveRows
+{
+	const Surface &sum;
+	Surface &dest;
+	//! Position of the sum in \a dest
+	int x, y;
+	float divisor;
+
+	ResolveRows(const Surface &sum, Surface &dest, int x, int y, float divisor):
+		sum(sum), dest(dest), x(x), y(y), divisor(divisor) { }
+
+	void operator()(int begin, int end)const
+	{
+		const float k = 1.0f/divisor;
+		for(int j = begin; j < end; j++)
+		{
+			const Color *in = sum[j];
+			Color *out = dest[j + y] + x;
+			for(int i = 0; i < sum.get_w(); i++)
+				out[i] = (in[i]*k).demult_alpha();
+		}
+	}
+};
+
+//! Renders the copies of the context at the times of some subsamples
+struct RenderTask: public ThreadPool::Task
+{
+	Context context;
+	RendDesc desc;
+	int quality;
+	Surface surface;
+	bool success;
+
+	RenderTask(): quality(), success() { }
+
+	virtual void run()
+	{
+		try { success = context.accelerated_render(&surface, quality, desc, NULL); }
+		catch(...) { success = false; }
+	}
+};
+
+//! Returns \c true if nothing in \a context changes between \a begin and \a end
+/*!	Checks the invariance of the animated parameters, the same way
+**	IndependentContext::set_time() does, so no layer has to be set to
+**	another time. */
+static bool
+is_static(IndependentContext context, Time begin, Time end, int depth)
+{
+	if (depth >= MAX_COPY_DEPTH)
+		return false;
+
+	for(; !context->empty(); ++context)
+	{
+		const Layer &layer(**context);
+		// these use the time by themselves
+		if (layer.is_time_dependent() || layer.get_name() == "timeloop")
+			return false;
+
+		for(Layer::DynamicParamList::const_iterator iter = layer.dynamic_param_list().begin(); iter != layer.dynamic_param_list().end(); ++iter)
+		{
+			Time b = Time::begin(), e = Time::end();
+			iter->second->get_invariance(end, b, e);
+			if (b > begin || e < end)
+				return false;
+		}
+
+		const Layer_PasteCanvas *paste = dynamic_cast<const Layer_PasteCanvas*>(&layer);
+		if (paste && paste->get_sub_canvas())
+		{
+			const Time offset = paste->get_time_offset();
+			if (!is_static(paste->get_sub_canvas()->get_independent_context(), begin + offset, end + offset, depth + 1))
+				return false;
+		}
+	}
+	return true;
+}
+
+//! Adds the layers of \a context to \a key
+/*!	\return \c false if some layer can't be copied by copy_layers() */
+static bool
+add_layers_to_key(SurfaceCache::KeyBuilder &key, IndependentContext context, int depth)
+{
+	if (depth >= MAX_COPY_DEPTH)
+		return false;
+
+	for(; !context->empty(); ++context)
+	{
+		const Layer &layer(**context);
+
+		// These share their state with their copies: the index of the
+		// duplicates, the importer of an image sequence and the fonts
+		const String &name = layer.get_name();
+		if (name == "duplicate" || name == "import" || name == "text" || !Layer::book().count(name))
+			return false;
+
+		key.add(layer.get_guid().get_hi());
+		key.add(layer.get_guid().get_lo());
+		key.add(layer.get_revision());
+		key.add(layer.active());
+		key.add(layer.get_exclude_from_rendering());
+
+		const Layer_PasteCanvas *paste = dynamic_cast<const Layer_PasteCanvas*>(&layer);
+		if (paste)
+		{
+			// the z range uses the positions of the layers in their canvas,
+			// which the copies don't have
+			ContextParams params;
+			paste->apply_z_range_to_params(params);
+			if (params.z_range)
+				return false;
+			if (paste->get_sub_canvas()
+			 && !add_layers_to_key(key, paste->get_sub_canvas()->get_independent_context(), depth + 1))
+				return false;
+		}
+	}
+
+	// marks the end of the canvas, so nesting can't be confused with a flat list
+	key.add(depth);
+	return true;
+}
+
+//! Copies the layers of \a context into \a canvas
+/*!	The copies share the value nodes of the originals and the sub canvases
+**	of the groups are copied as well, so the copies can be set to another
+**	time while the originals are being rendered. */
+static void
+copy_layers(IndependentContext context, Canvas::Handle canvas)
+{
+	for(; !context->empty(); ++context)
+	{
+		const Layer &layer(**context);
+		const Layer_PasteCanvas *paste = dynamic_cast<const Layer_PasteCanvas*>(&layer);
+
+		Layer::Handle copy(Layer::create(layer.get_name()));
+		copy->set_description(layer.get_description());
+		copy->set_active(layer.active());
+		copy->set_optimized(layer.optimized());
+		copy->set_exclude_from_rendering(layer.get_exclude_from_rendering());
+
+		Layer::ParamList params(layer.get_param_list());
+		if (paste)
+			params.erase("canvas");
+		copy->set_param_list(params);
+		for(Layer::DynamicParamList::const_iterator iter = layer.dynamic_param_list().begin(); iter != layer.dynamic_param_list().end(); ++iter)
+			if (!paste || iter->first != "canvas")
+				copy->connect_dynamic_param(iter->first, iter->second);
+
+		if (paste && paste->get_sub_canvas())
+		{
+			Canvas::Handle sub_canvas(Canvas::create_inline(canvas));
+			sub_canvas->set_grow_value(paste->get_sub_canvas()->get_grow_value());
+			copy_layers(paste->get_sub_canvas()->get_independent_context(), sub_canvas);
+			etl::handle<Layer_PasteCanvas>::cast_static(copy)->set_sub_canvas(sub_canvas);
+		}
+
+		canvas->push_back_simple(copy);
+	}
+}
+
+//! Returns \c true if both layers and their groups have the same parameters
+static bool
+same_layer(const Layer &a, const Layer &b, int depth)
+{
+	if (a.get_name() != b.get_name() || a.active() != b.active())
+		return false;
+
+	Layer::ParamList params_a(a.get_param_list()), params_b(b.get_param_list());
+	const Layer_PasteCanvas *paste_a = dynamic_cast<const Layer_PasteCanvas*>(&a);
+	const Layer_PasteCanvas *paste_b = dynamic_cast<const Layer_PasteCanvas*>(&b);
+	if (!paste_a || !paste_b)
+		return params_a == params_b;
+
+	// the copies have copies of the sub canvas, compare their layers instead
+	params_a.erase("canvas");
+	params_b.erase("canvas");
+	if (params_a != params_b)
+		return false;
+
+	Canvas::Handle canvas_a(paste_a->get_sub_canvas()), canvas_b(paste_b->get_sub_canvas());
+	if (!canvas_a || !canvas_b)
+		return !canvas_a && !canvas_b;
+	if (depth >= MAX_COPY_DEPTH)
+		return false;
+
+	IndependentContext iter_a(canvas_a->get_independent_context());
+	IndependentContext iter_b(canvas_b->get_independent_context());
+	for(; !iter_a->empty() && !iter_b->empty(); ++iter_a, ++iter_b)
+		if (!same_layer(**iter_a, **iter_b, depth + 1))
+			return false;
+	return iter_a->empty() && iter_b->empty();
+}
+
+//! Area of its context the layer may change
+/*!	\return \c true if the layer only draws over its context inside
+**	\a bounds. Otherwise (filters, distortions, transformations)
+**	it may change every pixel of its context and move the changes of the
+**	layers below it. */
+static bool
+get_bounds(Context context, Rect &bounds)
+{
+	const Layer &layer(**context);
+	const Layer_Composite *composite = dynamic_cast<const Layer_Composite*>(&layer);
+	if (composite && !Color::is_straight(composite->get_blend_method()))
+	{
+		const Layer_PasteCanvas *paste = dynamic_cast<const Layer_PasteCanvas*>(&layer);
+		bounds = paste
+		       ? paste->get_bounding_rect_context_dependent(context.get_params())
+		       : layer.get_bounding_rect();
+		if (bounds.is_valid()
+		 && bounds.minx > -INFINITY && bounds.maxx < INFINITY
+		 && bounds.miny > -INFINITY && bounds.maxy < INFINITY)
+			return true;
+	}
+	bounds = layer.get_full_bounding_rect(context.get_next());
+	return false;
+}
+
+//! Adds the pixels of \a desc covered by \a rect to the rectangle [x0, x1) x [y0, y1)
+static void
+add_pixels(const RendDesc &desc, const Rect &rect, int &x0, int &y0, int &x1, int &y1)
+{
+	if (!rect.is_valid())
+		return;
+
+	const Point &tl = desc.get_tl();
+	Real ax = (rect.minx - tl[0])/desc.get_pw(), bx = (rect.maxx - tl[0])/desc.get_pw();
+	Real ay = (rect.miny - tl[1])/desc.get_ph(), by = (rect.maxy - tl[1])/desc.get_ph();
+	if (ax > bx) std::swap(ax, bx);
+	if (ay > by) std::swap(ay, by);
+
+	// infinite or undefined bounds cover the whole surface
+	const Real w = desc.get_w(), h = desc.get_h();
+	ax = ax == ax ? std::max(ax, Real(0)) : 0;
+	ay = ay == ay ? std::max(ay, Real(0)) : 0;
+	bx = bx == bx ? std::min(bx, w) : w;
+	by = by == by ? std::min(by, h) : h;
+	if (ax >= bx || ay >= by)
+		return;
+
+	const int px0 = std::max((int)floor(ax) - DAMAGE_MARGIN, 0);
+	const int py0 = std::max((int)floor(ay) - DAMAGE_MARGIN, 0);
+	const int px1 = std::min((int)ceil(bx) + DAMAGE_MARGIN, (int)w);
+	const int py1 = std::min((int)ceil(by) + DAMAGE_MARGIN, (int)h);
+	if (x0 >= x1 || y0 >= y1)
+		{ x0 = px0; y0 = py0; x1 = px1; y1 = py1; return; }
+	x0 = std::min(x0, px0);
+	y0 = std::min(y0, py0);
+	x1 = std::max(x1, px1);
+	y1 = std::max(y1, py1);
+}
+
+//! Renders the subsamples one after another, setting the time of \a context
+/*!	Used when some layer of the context can't be copied. Leaves the
+**	context at \a time. The caller has to keep every other thread away
+**	from the context until it returns. */
+static bool
+render_in_turn(Context context, Surface *surface, int quality, const RendDesc &renddesc, ProgressCallback *cb,
+	const std::vector<std::pair<Time, float> > &subsamples, Time time)
+{
+	const int w = renddesc.get_w(), h = renddesc.get_h();
+	ThreadPool &pool = ThreadPool::instance();
+	const int bands = pool.get_threads()*4;
+
+	Surface tmp, sum(w, h);
+	sum.clear();
+	float divisor = 0;
+	const int count = subsamples.size();
+	for(int i = 0; i < count; i++)
+	{
+		SuperCallback subimagecb(cb, i*(5000/count), (i + 1)*(5000/count), 5000);
+		context.set_time(subsamples[i].first);
+		if(!context.accelerated_render(&tmp,quality,renddesc,&subimagecb))
+		{
+			context.set_time(time);
+			return false;
+		}
+		pool.run_bands(AddRows(sum, tmp, 0, 0, subsamples[i].second), h, bands);
+		divisor += subsamples[i].second;
+	}
+	context.set_time(time);
+
+	surface->set_wh(w, h);
+	pool.run_bands(ResolveRows(sum, *surface, 0, 0, divisor), h, bands);
+	return true;
+}
+
+/* === C L A S S E S ======================================================= */
+
+//! Subsamples of one frame
+struct Layer_MotionBlur::Samples
+{
+	struct Sample
+	{
+		Time time;
+		float weight;
+		//! Copy of the context set to the time of the subsample,
+		//! null for the subsample at the current time: that one is the context itself
+		Canvas::Handle canvas;
+
+		Sample(): weight() { }
+	};
+
+	SurfaceCache::Key key;
+	std::vector<Sample> samples;
+
+	//! Every pixel may change during the exposure
+	bool full_damage;
+	//! Otherwise, the areas which may change. The subsamples are the same
+	//! as the context everywhere else.
+	std::vector<Rect> damage;
+
+	//! Renders using the copies right now, the entry is kept until they finish
+	int users;
+
+	Samples(): key(), full_damage(), users() { }
+
+	//! Copies \a context and sets the copies to the times of \a subsamples
+	void build(Context context, const std::vector<std::pair<Time, float> > &subsamples, Time time, Canvas::Handle parent)
+	{
+		// what the layers look like at the current time
+		std::vector<bool> plain;
+		std::vector<Rect> bounds;
+		for(Context iter = context; !iter->empty(); ++iter)
+		{
+			Rect rect;
+			plain.push_back(iter.active() && get_bounds(iter, rect));
+			bounds.push_back(rect);
+		}
+
+		for(size_t i = 0; i < subsamples.size(); i++)
+		{
+			Sample sample;
+			sample.time = subsamples[i].first;
+			sample.weight = subsamples[i].second;
+			if (sample.time != time)
+			{
+				sample.canvas = parent ? Canvas::create_inline(parent) : Canvas::create();
+				copy_layers(context, sample.canvas);
+				sample.canvas->get_independent_context().set_time(sample.time);
+				if (!full_damage)
+					add_damage(sample.canvas->get_context(context), context, plain, bounds);
+			}
+			samples.push_back(sample);
+		}
+	}
+
+	//! Adds the areas where the copies in \a sample differ from \a context
+	void add_damage(Context sample, Context context, const std::vector<bool> &plain, const std::vector<Rect> &bounds)
+	{
+		// All the visible layers above only draw over their context,
+		// so the pixels changed by this layer stay where they are
+		bool exposed = true;
+		for(int i = 0; !context->empty() && !sample->empty(); ++context, ++sample, ++i)
+		{
+			if (!context.active())
+				continue;
+			if (!same_layer(**sample, **context, 0))
+			{
+				Rect rect;
+				const bool sample_plain = get_bounds(sample, rect);
+				if (!exposed)
+					{ full_damage = true; return; }
+				damage.push_back(rect);
+				damage.push_back(bounds[i]);
+				if (!sample_plain)
+					exposed = false;
+			}
+			if (!plain[i])
+				exposed = false;
+		}
+	}
+};
+
+//! The last sets of copies of one layer
+struct Layer_MotionBlur::SampleCache
+{
+	typedef std::list<Samples> EntryList;
+
+	//! Most recently used first, guarded by copies_mutex()
+	EntryList entries;
+
+	//! Held by render_in_turn() while it changes the time of the context,
+	//! since the other tiles render the same layers through this one
+	Mutex in_turn_mutex;
+
+	//! Forgets the least recently used entries nobody is rendering
+	void trim()
+	{
+		EntryList::iterator i = entries.end();
+		while(entries.size() > SAMPLE_CACHE_SIZE && i != entries.begin())
+			if ((--i)->users == 0)
+				i = entries.erase(i);
+	}
+
+	//! Releases an entry, even if the rendering throws
+	class User
+	{
+		SampleCache &cache;
+		EntryList::iterator entry;
+	public:
+		User(SampleCache &cache, EntryList::iterator entry): cache(cache), entry(entry) { }
+		~User()
+		{
+			Mutex::Lock lock(copies_mutex());
+			--entry->users;
+			cache.trim();
+		}
+	};
+};
+
 /* === M E M B E R S ======================================================= */
 
 Layer_MotionBlur::Layer_MotionBlur():
@@ -66,11 +554,18 @@ Layer_MotionBlur::Layer_MotionBlur():
 	param_subsamples_factor (ValueBase(Real(1.0))),
 	param_subsampling_type  (ValueBase(int(SUBSAMPLING_HYPERBOLIC))),
 	param_subsample_start   (ValueBase(Real(0.0))),
-	param_subsample_end     (ValueBase(Real(1.0)))
+	param_subsample_end     (ValueBase(Real(1.0))),
+	sample_cache            (new SampleCache)
 {
 
 }
 
+Layer_MotionBlur::~Layer_MotionBlur()
+{
+	Mutex::Lock lock(copies_mutex());
+	delete sample_cache;
+}
+
 bool
 Layer_MotionBlur::set_param(const String &param, const ValueBase &value)
 {
@@ -227,16 +722,11 @@ Layer_MotionBlur::accelerated_render(Context context,Surface *surface,int qualit
 			if(subsample_end == 0) samples++;
 		}
 
-		Surface tmp;
-		int i;
-		float scale, divisor = 0;
-
-		surface->set_wh(renddesc.get_w(),renddesc.get_h());
-		surface->clear();
-
-		// Render subsamples from time_cur-aperture to time_cur
-		for(i=0;i<samples;i++)
+		// Times and weights of the subsamples from time_cur-aperture to time_cur
+		std::vector<std::pair<Time, float> > subsamples;
+		for(int i=0;i<samples;i++)
 		{
+			float scale;
 			float pos = i/(samples-1.0);
 			float ipos = 1.0-pos;
 			switch(subsampling_type)
@@ -255,18 +745,16 @@ Layer_MotionBlur::accelerated_render(Context context,Surface *surface,int qualit
 			// Don't bother rendering if scale is zero
 			if(scale==0)
 				continue;
-			divisor += scale;
-			subimagecb=SuperCallback(cb,i*(5000/samples),(i+1)*(5000/samples),5000);
-			context.set_time(time_cur-aperture*ipos);
-			if(!context.accelerated_render(&tmp,quality,renddesc,&subimagecb))
-				return false;
-			for(int y=0;y<renddesc.get_h();y++)
-				for(int x=0;x<renddesc.get_w();x++)
-					(*surface)[y][x]+=tmp[y][x].premult_alpha()*scale;
+			subsamples.push_back(std::make_pair(time_cur-aperture*ipos, scale));
 		}
-		for(int y=0;y<renddesc.get_h();y++)
-			for(int x=0;x<renddesc.get_w();x++)
-				(*surface)[y][x]=((*surface)[y][x]/divisor).demult_alpha();
+		if (subsamples.empty())
+			return context.accelerated_render(surface,quality,renddesc,cb);
+
+		// Nothing below moves during the exposure, every subsample would be the same
+		if (is_static(context, std::min(time_cur-aperture, time_cur), std::max(time_cur-aperture, time_cur), 0))
+			return context.accelerated_render(surface,quality,renddesc,cb);
+
+		return render_subsamples(context,surface,quality,renddesc,cb,subsamples);
 	}
 	else
 		return context.accelerated_render(surface,quality,renddesc,cb);
@@ -275,6 +763,116 @@ Layer_MotionBlur::accelerated_render(Context context,Surface *surface,int qualit
 }
 
 
+//! Renders the subsamples in parallel, each from its own copy of the context
+/*!	The copies are made once per frame and shared by all the tiles. Wherever
+**	no layer moves during the exposure, the subsamples are all the same as the
+**	context at the current time, so only the damaged part of the surface is
+**	rendered again for the other subsamples. */
+bool
+Layer_MotionBlur::render_subsamples(Context context,Surface *surface,int quality,const RendDesc &renddesc,ProgressCallback *cb,const std::vector<std::pair<Time,float> > &subsamples)const
+{
+	SurfaceCache::KeyBuilder key;
+	key.add((double)time_cur);
+	for(size_t i = 0; i < subsamples.size(); i++)
+	{
+		key.add((double)subsamples[i].first);
+		key.add(subsamples[i].second);
+	}
+	if (!add_layers_to_key(key, context, 0))
+	{
+		Mutex::Lock lock(sample_cache->in_turn_mutex);
+		return render_in_turn(context, surface, quality, renddesc, cb, subsamples, time_cur);
+	}
+
+	SampleCache::EntryList::iterator entry;
+	{
+		Mutex::Lock lock(copies_mutex());
+		SampleCache::EntryList &entries = sample_cache->entries;
+		for(entry = entries.begin(); entry != entries.end(); ++entry)
+			if (entry->key == key.get())
+				break;
+		if (entry == entries.end())
+		{
+			entries.push_front(Samples());
+			entry = entries.begin();
+			entry->key = key.get();
+			entry->build(context, subsamples, time_cur, Canvas::Handle(get_canvas()));
+		}
+		else
+			entries.splice(entries.begin(), entries, entry);
+		++entry->users;
+	}
+	SampleCache::User user(*sample_cache, entry);
+	const Samples &samples = *entry;
+
+	// The context itself is the subsample at the current time, and the
+	// result wherever nothing moves
+	const int count = samples.samples.size();
+	SuperCallback subimagecb(cb, 0, 1000, 1000*count);
+	if(!context.accelerated_render(surface,quality,renddesc,&subimagecb))
+		return false;
+
+	int x0 = 0, y0 = 0, x1 = 0, y1 = 0;
+	if (samples.full_damage)
+		{ x1 = renddesc.get_w(); y1 = renddesc.get_h(); }
+	else
+		for(size_t i = 0; i < samples.damage.size(); i++)
+			add_pixels(renddesc, samples.damage[i], x0, y0, x1, y1);
+	if (x0 >= x1 || y0 >= y1)
+		return true;
+
+	const int w = x1 - x0, h = y1 - y0;
+	RendDesc desc(renddesc);
+	desc.set_subwindow(x0, y0, w, h);
+
+	ThreadPool &pool = ThreadPool::instance();
+	const int bands = pool.get_threads()*4;
+
+	Surface sum(w, h);
+	sum.clear();
+	float divisor = 0;
+	std::vector<const Samples::Sample*> copies;
+	for(int i = 0; i < count; i++)
+	{
+		const Samples::Sample &sample = samples.samples[i];
+		divisor += sample.weight;
+		if (sample.canvas)
+			copies.push_back(&sample);
+		else
+			pool.run_bands(AddRows(sum, *surface, x0, y0, sample.weight), h, bands);
+	}
+
+	// A few copies at a time, so only a few surfaces are alive at once
+	const int batch = pool.get_threads();
+	for(int first = 0; first < (int)copies.size(); first += batch)
+	{
+		const int last = std::min(first + batch, (int)copies.size());
+		std::vector<RenderTask> tasks(last - first);
+		std::vector<ThreadPool::Task*> list;
+		for(int i = first; i < last; i++)
+		{
+			RenderTask &task = tasks[i - first];
+			task.context = copies[i]->canvas->get_context(context);
+			task.desc = desc;
+			task.quality = quality;
+			list.push_back(&task);
+		}
+		pool.run(list);
+
+		for(int i = first; i < last; i++)
+		{
+			if (!tasks[i - first].success)
+				return false;
+			pool.run_bands(AddRows(sum, tasks[i - first].surface, 0, 0, copies[i]->weight), h, bands);
+		}
+		if (cb && !cb->amount_complete(1000*(last + 1), 1000*count))
+			return false;
+	}
+
+	pool.run_bands(ResolveRows(sum, *surface, x0, y0, divisor), h, bands);
+	return true;
+}
+
 bool
 Layer_MotionBlur::accelerated_cairorender(Context context, cairo_t *cr ,int quality, const RendDesc &renddesc, ProgressCallback *cb)const
 {
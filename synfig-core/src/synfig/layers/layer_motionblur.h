@@ -30,6 +30,8 @@
 
 #include "layer_composite.h"
 #include <synfig/time.h>
+#include <vector>
+#include <utility>
 
 /* === S T R U C T S & C L A S S E S ======================================= */
 
@@ -56,13 +58,22 @@ private:
 	ValueBase param_subsample_end;
 	mutable Time time_cur;
 
+	struct Samples;
+	struct SampleCache;
+	//! Copies of the context set to the times of the last subsamples
+	SampleCache *sample_cache;
+
+	bool render_subsamples(Context context,Surface *surface,int quality,const RendDesc &renddesc,ProgressCallback *cb,const std::vector<std::pair<Time,float> > &samples)const;
+
 public:
 	Layer_MotionBlur();
+	virtual ~Layer_MotionBlur();
 	virtual bool set_param(const String & param, const synfig::ValueBase &value);
 	virtual ValueBase get_param(const String & param)const;
 	virtual Color get_color(Context context, const Point &pos)const;
 	virtual void set_time(IndependentContext context, Time time)const;
 	virtual void set_time(IndependentContext context, Time time, const Point &point)const;
+	virtual bool is_time_dependent()const { return true; }
 	virtual bool accelerated_render(Context context,Surface *surface,int quality, const RendDesc &renddesc, ProgressCallback *cb)const;
 	virtual bool accelerated_cairorender(Context context, cairo_t *cr, int quality, const RendDesc &renddesc, ProgressCallback *cb)const;
 	virtual Vocab get_param_vocab()const;
@@ -43,6 +43,8 @@
 #include "../valuenode.h"
 #include "../canvas.h"
 #include "../cairo_renddesc.h"
+#include "../surfacecache.h"
+#include "../mutex.h"
 
 
 #endif
@@ -66,16 +68,31 @@ using namespace synfig;
 
 /* === C L A S S E S ======================================================= */
 
-class depth_counter	// Makes our recursive depth counter exception-safe
+//! Counts the nesting of a layer while it uses its canvas
+/*!	Only an exported or external canvas can contain the layer pasting it.
+**	Such a canvas may also be pasted by several layers, each setting its own
+**	time and grow value, so its lock is held meanwhile and the nesting is
+**	counted under it. An inline canvas belongs to its layer alone, the
+**	threads rendering it at once don't count. */
+class depth_counter
 {
+	Mutex *mutex;
 	int *depth;
 public:
-	depth_counter(int &x):depth(&x) { (*depth)++; }
-	~depth_counter() { (*depth)--; }
+	depth_counter(const Canvas::Handle &canvas, int &x):
+		mutex(canvas && !canvas->is_inline() ? &canvas->get_render_mutex() : NULL),
+		depth(mutex ? &x : NULL)
+		{ if (mutex) { mutex->lock(); (*depth)++; } }
+	~depth_counter()
+		{ if (mutex) { (*depth)--; mutex->unlock(); } }
+	//! The layer is nested deeper than MAX_DEPTH in its own canvas
+	bool too_deep()const { return depth && *depth > MAX_DEPTH; }
 };
 
 /* === G L O B A L S ======================================================= */
 
+/* === P R O C E D U R E S ================================================= */
+
 /* === M E T H O D S ======================================================= */
 
 Layer_PasteCanvas::Layer_PasteCanvas():
@@ -110,6 +127,35 @@ Layer_PasteCanvas::~Layer_PasteCanvas()
 	//	canvas->unref();
 }
 
+bool
+Layer_PasteCanvas::add_canvas_to_cache_key(SurfaceCache::KeyBuilder &key, const Canvas &canvas, int depth)
+{
+	if (depth >= MAX_DEPTH)
+		return false;
+
+	for(Canvas::const_iterator iter = canvas.begin(); iter != canvas.end(); ++iter)
+	{
+		const Layer &layer(**iter);
+		if (layer.is_time_dependent())
+			return false;
+
+		key.add(layer.get_guid().get_hi());
+		key.add(layer.get_guid().get_lo());
+		key.add(layer.get_revision());
+		key.add(layer.active());
+		key.add(layer.get_exclude_from_rendering());
+
+		const Layer_PasteCanvas *paste = dynamic_cast<const Layer_PasteCanvas*>(&layer);
+		if (paste && paste->get_sub_canvas()
+		 && !add_canvas_to_cache_key(key, *paste->get_sub_canvas(), depth + 1))
+			return false;
+	}
+
+	// marks the end of the canvas, so nesting can't be confused with a flat list
+	key.add(canvas.size());
+	return true;
+}
+
 String
 Layer_PasteCanvas::get_local_name()const
 {
@@ -304,7 +350,8 @@ Layer_PasteCanvas::set_time(IndependentContext context, Time time)const
 {
 	Time time_offset=param_time_offset.get(Time());
 
-	if(depth==MAX_DEPTH)return;depth_counter counter(depth);
+	depth_counter counter(canvas, depth);
+	if(counter.too_deep())return;
 	param_curr_time.set(time);
 
 	context.set_time(time);
@@ -312,6 +359,19 @@ Layer_PasteCanvas::set_time(IndependentContext context, Time time)const
 		canvas->set_time(time+time_offset);
 }
 
+void
+Layer_PasteCanvas::update_canvas(Real outline_grow, Time curr_time, Time time_offset)const
+{
+	// The strips and tiles of a frame render this layer at the same time
+	// and all set the same values. The first one changes them, the others
+	// find them set, and the lock keeps every one of them from reading the
+	// canvas before the change is complete.
+	Mutex::Lock lock(canvas->get_render_mutex());
+	canvas->set_grow_value(outline_grow+get_parent_canvas_grow_value());
+	if(muck_with_time_ && curr_time!=Time::begin())
+		canvas->set_time(curr_time+time_offset);
+}
+
 void
 Layer_PasteCanvas::apply_z_range_to_params(ContextParams &/*cp*/)const
 {
@@ -320,7 +380,8 @@ Layer_PasteCanvas::apply_z_range_to_params(ContextParams &/*cp*/)const
 synfig::Layer::Handle
 Layer_PasteCanvas::hit_check(synfig::Context context, const synfig::Point &pos)const
 {
-	if(depth==MAX_DEPTH)return 0;depth_counter counter(depth);
+	depth_counter counter(canvas, depth);
+	if(counter.too_deep())return 0;
 
 	Transformation transformation(get_summary_transformation());
 
@@ -352,7 +413,8 @@ Layer_PasteCanvas::get_color(Context context, const Point &pos)const
 	if(!canvas || !get_amount())
 		return context.get_color(pos);
 
-	if(depth==MAX_DEPTH)return Color::alpha();depth_counter counter(depth);
+	depth_counter counter(canvas, depth);
+	if(counter.too_deep())return Color::alpha();
 
 	Point target_pos = transformation.back_transform(pos);
 
@@ -383,6 +445,13 @@ Layer_PasteCanvas::get_full_bounding_rect(Context context)const
 	return context.get_full_bounding_rect()|get_bounding_rect_context_dependent(context.get_params());
 }
 
+bool
+Layer_PasteCanvas::is_thread_safe()const
+{
+	if(!canvas) return true;
+	return canvas->is_inline() && canvas->get_independent_context().is_thread_safe();
+}
+
 bool
 Layer_PasteCanvas::accelerated_render(Context context,Surface *surface,int quality, const RendDesc &renddesc, ProgressCallback *cb)const
 {
@@ -396,13 +465,12 @@ Layer_PasteCanvas::accelerated_render(Context context,Surface *surface,int quali
 
 	if(cb && !cb->amount_complete(0,10000)) return false;
 
-	if(depth==MAX_DEPTH)
+	depth_counter counter(canvas, depth);
+	if(counter.too_deep())
 		// if we are at the extent of our depth,
 		// then we should just return whatever is under us.
 		return context.accelerated_render(surface,quality,renddesc,cb);
 
-	depth_counter counter(depth);
-
 	if(!canvas || !get_amount())
 		return context.accelerated_render(surface,quality,renddesc,cb);
 
@@ -423,11 +491,7 @@ Layer_PasteCanvas::accelerated_render(Context context,Surface *surface,int quali
 	if (!context.accelerated_render(surface,quality,renddesc,&stageone))
 		return false;
 
-	Real grow_value(get_parent_canvas_grow_value());
-	canvas->set_grow_value(outline_grow+grow_value);
-
-	if(muck_with_time_ && curr_time!=Time::begin() /*&& canvas->get_time()!=curr_time+time_offset*/)
-		canvas->set_time(curr_time+time_offset);
+	update_canvas(outline_grow, curr_time, time_offset);
 
 	Color::BlendMethod blend_method(get_blend_method());
 	const Rect full_bounding_rect(canvasContext.get_full_bounding_rect());
@@ -523,8 +587,40 @@ Layer_PasteCanvas::accelerated_render(Context context,Surface *surface,int quali
 		intermediate_desc.set_tl(pixel_aligned_tl);
 		intermediate_desc.set_br(pixel_aligned_br);
 		Surface intermediate_surface;
-		if(!canvasContext.accelerated_render(&intermediate_surface,quality,intermediate_desc,&stagetwo))
-			return false;
+
+		// the pasted canvas usually renders the same pixels every frame
+		// (static backgrounds, groups), so look for a cached result first
+		SurfaceCache &cache(SurfaceCache::instance());
+		SurfaceCache::KeyBuilder key;
+		bool cacheable = cache.get_budget() && add_canvas_to_cache_key(key, *canvas, depth);
+		if (cacheable)
+		{
+			const ContextParams &params(canvasContext.get_params());
+			key.add(get_guid().get_hi());
+			key.add(get_guid().get_lo());
+			key.add(get_revision());
+			// set by update_canvas(), includes the grow of the outer canvases
+			key.add(canvas->get_grow_value());
+			key.add(params.render_excluded_contexts);
+			key.add(params.z_range);
+			key.add(params.z_range_position);
+			key.add(params.z_range_depth);
+			key.add(params.z_range_blur);
+			key.add(intermediate_desc.get_w());
+			key.add(intermediate_desc.get_h());
+			key.add(intermediate_desc.get_tl());
+			key.add(intermediate_desc.get_br());
+			key.add(intermediate_desc.get_transformation_matrix());
+			key.add(quality);
+		}
+
+		if (!cacheable || !cache.get(key.get(), intermediate_surface))
+		{
+			if(!canvasContext.accelerated_render(&intermediate_surface,quality,intermediate_desc,&stagetwo))
+				return false;
+			if (cacheable)
+				cache.put(key.get(), intermediate_surface);
+		}
 		Surface::alpha_pen apen(surface->get_pen(x0, y0));
 		apen.set_alpha(get_amount());
 		apen.set_blend_method(blend_using_straight ? Color::BLEND_STRAIGHT : blend_method);
@@ -548,13 +644,12 @@ Layer_PasteCanvas::accelerated_cairorender(Context context,cairo_t *cr, int qual
 
 	if(cb && !cb->amount_complete(0,10000)) return false;
 
-	if(depth==MAX_DEPTH)
+	depth_counter counter(canvas, depth);
+	if(counter.too_deep())
 		// if we are at the extent of our depth,
 		// then we should just return whatever is under us.
 		return context.accelerated_cairorender(cr,quality,renddesc,cb);
 
-	depth_counter counter(depth);
-
 	if(!canvas || !get_amount())
 		return context.accelerated_cairorender(cr,quality,renddesc,cb);
 
@@ -563,11 +658,7 @@ Layer_PasteCanvas::accelerated_cairorender(Context context,cairo_t *cr, int qual
 	SuperCallback stagethree(cb,9000,9999,10000);
 
 
-	Real grow_value(get_parent_canvas_grow_value());
-	canvas->set_grow_value(outline_grow+grow_value);
-
-	if(muck_with_time_ && curr_time!=Time::begin() /*&& canvas->get_time()!=curr_time+time_offset*/)
-		canvas->set_time(curr_time+time_offset);
+	update_canvas(outline_grow, curr_time, time_offset);
 
 	bool ret;
 	RendDesc workdesc(renddesc);
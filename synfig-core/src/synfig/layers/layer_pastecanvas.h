@@ -38,6 +38,7 @@
 #include <synfig/canvas.h>
 #include <synfig/rect.h>
 #include <synfig/transformation.h>
+#include <synfig/surfacecache.h>
 
 /* === M A C R O S ========================================================= */
 
@@ -174,6 +175,9 @@ public:
 	//! See Layer::accelerated_render
 	virtual bool accelerated_render(Context context,Surface *surface,int quality, const RendDesc &renddesc, ProgressCallback *cb)const;
 	virtual bool accelerated_cairorender(Context context, cairo_t *cr, int quality, const RendDesc &renddesc, ProgressCallback *cb)const;
+	//! Adds the state of every layer of \a canvas and of its pasted canvases to \a key
+	/*!	\return \c false if the rendered canvas must not be cached */
+	static bool add_canvas_to_cache_key(SurfaceCache::KeyBuilder &key, const Canvas &canvas, int depth = 0);
 	//! Bounding rect for this layer depends from context_params
 	Rect get_bounding_rect_context_dependent(const ContextParams &context_params)const;
 	//!Returns the rectangle that includes the context of the layer and
@@ -184,10 +188,15 @@ public:
 	//! Checks to see if a part of the Paste Canvas Layer is directly under \a point
 	virtual synfig::Layer::Handle hit_check(synfig::Context context, const synfig::Point &point)const;
 	virtual void set_render_method(Context context, RenderMethod x);
+	//! The layers pasting an exported or external canvas render it one at a time
+	virtual bool is_thread_safe()const;
 
 	virtual void fill_sound_processor(SoundProcessor &soundProcessor) const;
 
 protected:
+	//! Sets the grow value and the time of the pasted canvas before it is rendered
+	void update_canvas(Real outline_grow, Time curr_time, Time time_offset)const;
+
 	//!	Function to be overloaded that fills the Time Point Set with
 	//! all the children Time Points. In this case the children Time Points
 	//! are the canvas parameter children layers Time points and the Paste Canvas
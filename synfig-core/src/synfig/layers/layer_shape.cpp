@@ -46,8 +46,13 @@
 
 
 #include <synfig/curve_helper.h>
+#include <synfig/threadpool.h>
+#include <synfig/surfacecache.h>
+#include <synfig/mutex.h>
 
 #include <vector>
+#include <list>
+#include <algorithm>
 
 #include <deque>
 
@@ -965,8 +970,6 @@ class Layer_Shape::PolySpan
 public:
 	typedef	vector<PenMark> 	cover_array;
 
-	Point			arc[3*MAX_SUBDIVISION_SIZE + 1];
-
 	cover_array		covers;
 	PenMark			current;
 
@@ -1067,7 +1070,7 @@ public:
 			addcurrent();
 			current.setcover(0,0);
 
-			sort(covers.begin() + open_index,covers.end());
+			bin_marks(open_index);
 			flags &= ~NotSorted;
 		}
 	}
@@ -1099,7 +1102,13 @@ public:
 	void draw_scanline(int y, Real x1, Real y1, Real x2, Real y2);
 	void draw_line(Real x1, Real y1, Real x2, Real y2);
 
-	Real ExtractAlpha(Real area, WindingStyle winding_style)
+	//sorts the marks from first on by rows, then by x within every row
+	void bin_marks(int first);
+
+	//draws bands of rows onto a surface
+	struct Renderer;
+
+	Real ExtractAlpha(Real area, WindingStyle winding_style)const
 	{
 		if (area < 0)
 			area = -area;
@@ -1125,11 +1134,239 @@ public:
 	}
 };
 
+//******************** FLATTENED EDGES ****************************
+// The shape subdivided into lines, in pixels but without the offset of the
+// tile. So one list serves all the tiles of a frame, and all the frames
+// while neither the shape nor its transformation change.
+
+//edge lists kept per layer, a few for the renderers working on other frames
+const size_t	EDGE_CACHE_SIZE = 4;
+//larger shapes are only subdivided inside of the tile, and not cached
+const Real		MAX_CACHED_EXTENT = 16384;
+//cached edges are subdivided everywhere, within this window
+const int		MAX_CACHED_WINDOW = 1 << 30;
+//lines checked against the window at once
+const int		RUN_SIZE = 32;
+
+class Layer_Shape::EdgeList
+{
+public:
+	enum Operation
+	{
+		MOVE,
+		LINE,
+		CLOSE
+	};
+
+	//a move, a close, or up to RUN_SIZE consecutive lines
+	struct Run
+	{
+		int		operation;
+		int		begin;
+		int		end;
+		//bounds of the lines and of the point they start from
+		Rect	bounds;
+	};
+
+	vector<Point>	points;
+	//runs of points, and groups of up to RUN_SIZE runs of lines
+	vector<Run>		runs;
+	vector<Run>		groups;
+
+	//the same pen state as in PolySpan, for the curves and the tangents
+	Real			cur_x;
+	Real			cur_y;
+	Real			close_x;
+	Real			close_y;
+	bool			open;
+
+	//curves outside of the window are not subdivided
+	ContextRect		window;
+
+	EdgeList(): cur_x(), cur_y(), close_x(), close_y(), open(false) { }
+
+	bool notclosed() const
+	{
+		return open || (cur_x != close_x) || (cur_y != close_y);
+	}
+
+	static void add_run(vector<Run> &runs, int operation, int begin)
+	{
+		Run run;
+		run.operation = operation;
+		run.begin = run.end = begin;
+		runs.push_back(run);
+	}
+
+	void add_run(int operation)
+	{
+		add_run(runs, operation, points.size());
+		add_run(groups, operation, runs.size() - 1);
+		groups.back().end++;
+	}
+
+	void move_to(Real x, Real y)
+	{
+		if(isnan(x))x=0;
+		if(isnan(y))y=0;
+		add_run(MOVE);
+		points.push_back(Point(x,y));
+		runs.back().end++;
+		close_x = cur_x = x;
+		close_y = cur_y = y;
+		open = false;
+	}
+
+	void line_to(Real x, Real y)
+	{
+		if(runs.empty() || runs.back().operation != LINE
+		|| runs.back().end - runs.back().begin >= RUN_SIZE)
+		{
+			add_run(runs, LINE, points.size());
+			runs.back().bounds = Rect(cur_x,cur_y);
+			if(groups.empty() || groups.back().operation != LINE
+			|| groups.back().end - groups.back().begin >= RUN_SIZE)
+			{
+				add_run(groups, LINE, runs.size() - 1);
+				groups.back().bounds = Rect(cur_x,cur_y);
+			}
+			groups.back().end++;
+		}
+		runs.back().bounds.expand(x,y);
+		groups.back().bounds.expand(x,y);
+		points.push_back(Point(x,y));
+		runs.back().end++;
+		cur_x = x;
+		cur_y = y;
+		open = true;
+	}
+
+	void close()
+	{
+		if(open)
+		{
+			add_run(CLOSE);
+			cur_x = close_x;
+			cur_y = close_y;
+			open = false;
+		}
+	}
+
+	void conic_to(Real x1, Real y1, Real x, Real y);
+	void cubic_to(Real x1, Real y1, Real x2, Real y2, Real x, Real y);
+
+	//lines outside of the window only add their cover to its sides,
+	//and a single line to the same end adds the same
+	static bool outside(const Run &run, const ContextRect &w, Real dx, Real dy)
+	{
+		return run.operation == LINE
+			&& (run.bounds.maxx + dx < w.minx || run.bounds.minx + dx > w.maxx
+			 || run.bounds.maxy + dy < w.miny || run.bounds.miny + dy > w.maxy);
+	}
+
+	//draws the edges into the span, moved by dx,dy
+	void draw(PolySpan &span, Real dx, Real dy) const
+	{
+		for(vector<Run>::const_iterator g = groups.begin(); g != groups.end(); ++g)
+		{
+			if(outside(*g, span.window, dx, dy))
+			{
+				const Point &p = points[runs[g->end - 1].end - 1];
+				span.line_to(p[0] + dx, p[1] + dy);
+				continue;
+			}
+
+			for(int i = g->begin; i < g->end; i++)
+			{
+				const Run &run = runs[i];
+				switch(run.operation)
+				{
+					case MOVE:
+						span.move_to(points[run.begin][0] + dx, points[run.begin][1] + dy);
+						break;
+					case LINE:
+						if(outside(run, span.window, dx, dy))
+						{
+							const Point &p = points[run.end - 1];
+							span.line_to(p[0] + dx, p[1] + dy);
+							break;
+						}
+						for(int j = run.begin; j < run.end; j++)
+							span.line_to(points[j][0] + dx, points[j][1] + dy);
+						break;
+					default:
+						span.close();
+						break;
+				}
+			}
+		}
+	}
+};
+
+//the flattened edges of the last renders of one layer
+struct Layer_Shape::EdgeCache
+{
+	struct Entry
+	{
+		SurfaceCache::Key	key;
+		EdgeList			edges;
+		//renders drawing the edges right now, the entry is kept until they finish
+		int					users;
+
+		Entry(): key(), users() { }
+	};
+	typedef list<Entry> EntryList;
+
+	Mutex		mutex;
+	//most recently used first
+	EntryList	entries;
+
+	//hash of the bytestream, valid while the revision matches
+	int					revision;
+	SurfaceCache::Key	content;
+
+	EdgeCache(): revision(-1), content() { }
+
+	//forgets the least recently used entries nobody is drawing
+	void trim()
+	{
+		EntryList::iterator i = entries.end();
+		while(entries.size() > EDGE_CACHE_SIZE && i != entries.begin())
+			if ((--i)->users == 0)
+				i = entries.erase(i);
+	}
+
+	//releases an entry found by draw_edges(), even if the drawing throws
+	class User
+	{
+		EdgeCache &cache;
+		EntryList::iterator entry;
+	public:
+		User(EdgeCache &cache, EntryList::iterator entry): cache(cache), entry(entry) { }
+		~User()
+		{
+			Mutex::Lock lock(cache.mutex);
+			--entry->users;
+			cache.trim();
+		}
+	};
+};
+
+static Layer_Shape::EdgeCacheStats edge_cache_stats;
+
+static Mutex&
+edge_cache_stats_mutex()
+{
+	static Mutex mutex;
+	return mutex;
+}
+
 /* === M E T H O D S ======================================================= */
 
 Layer_Shape::Layer_Shape(const Real &a, const Color::BlendMethod m):
 	Layer_Composite      (a,m),
 	edge_table	         (new Intersector),
+	edge_cache	         (new EdgeCache),
 	param_color          (Color::black()),
 	param_origin         (Vector(0,0)),
 	param_invert         (bool(false)),
@@ -1139,13 +1376,15 @@ Layer_Shape::Layer_Shape(const Real &a, const Color::BlendMethod m):
 	param_winding_style	 (int(WINDING_NON_ZERO)),
 	bytestream           (0),
 	lastbyteop           (Primitive::NONE),
-	lastoppos            (-1)
+	lastoppos            (-1),
+	bytestream_revision  (0)
 {
 }
 
 Layer_Shape::~Layer_Shape()
 {
 	delete edge_table;
+	delete edge_cache;
 }
 
 void
@@ -1153,6 +1392,7 @@ Layer_Shape::clear()
 {
 	edge_table->clear();
 	bytestream.clear();
+	bytestream_revision++;
 }
 
 bool
@@ -1574,8 +1814,12 @@ static inline Real max_edges_conic(const Point *const p)
 	return max(d1,d2);
 }
 
-void Layer_Shape::PolySpan::conic_to(Real x1, Real y1, Real x, Real y)
+//! Subdivides a conic from the current point of \a span into lines,
+//! the parts outside of the window of \a span are drawn straight
+template<typename Span>
+static void subdivide_conic(Span &span, Real x1, Real y1, Real x, Real y)
 {
+	Point	arc[3*MAX_SUBDIVISION_SIZE + 1];
 	Point *current = arc;
 	int		level = 0;
 	int 	num = 0;
@@ -1583,12 +1827,12 @@ void Layer_Shape::PolySpan::conic_to(Real x1, Real y1, Real x, Real y)
 
 	arc[0] = Point(x,y);
 	arc[1] = Point(x1,y1);
-	arc[2] = Point(cur_x,cur_y);
+	arc[2] = Point(span.cur_x,span.cur_y);
 
 	//just draw the line if it's outside
-	if(clip_conic(arc,window))
+	if(clip_conic(arc,span.window))
 	{
-		line_to(x,y);
+		span.line_to(x,y);
 		return;
 	}
 
@@ -1604,9 +1848,9 @@ void Layer_Shape::PolySpan::conic_to(Real x1, Real y1, Real x, Real y)
 			return;
 		}else
 		//if the curve is clipping then draw degenerate
-		if(clip_conic(current,window))
+		if(clip_conic(current,span.window))
 		{
-			line_to(current[0][0],current[0][1]); //backwards so front is destination
+			span.line_to(current[0][0],current[0][1]); //backwards so front is destination
 			current -= 2;
 			if(onsecond) level--;
 			onsecond = true;
@@ -1635,8 +1879,8 @@ void Layer_Shape::PolySpan::conic_to(Real x1, Real y1, Real x, Real y)
 		else	//NOT TOO BIG? RENDER!!!
 		{
 			//cur_x,cur_y = current[2], so we need to go 1,0
-			line_to(current[1][0],current[1][1]);
-			line_to(current[0][0],current[0][1]);
+			span.line_to(current[1][0],current[1][1]);
+			span.line_to(current[0][0],current[0][1]);
 
 			current -= 2;
 			if(onsecond) level--;
@@ -1646,8 +1890,11 @@ void Layer_Shape::PolySpan::conic_to(Real x1, Real y1, Real x, Real y)
 	}
 }
 
-void Layer_Shape::PolySpan::cubic_to(Real x1, Real y1, Real x2, Real y2, Real x, Real y)
+//! Same as subdivide_conic(), for a cubic
+template<typename Span>
+static void subdivide_cubic(Span &span, Real x1, Real y1, Real x2, Real y2, Real x, Real y)
 {
+	Point	arc[4*MAX_SUBDIVISION_SIZE + 1];
 	Point *current = arc;
 	int		num = 0;
 	int		level = 0;
@@ -1656,12 +1903,12 @@ void Layer_Shape::PolySpan::cubic_to(Real x1, Real y1, Real x2, Real y2, Real x,
 	arc[0] = Point(x,y);
 	arc[1] = Point(x2,y2);
 	arc[2] = Point(x1,y1);
-	arc[3] = Point(cur_x,cur_y);
+	arc[3] = Point(span.cur_x,span.cur_y);
 
 	//just draw the line if it's outside
-	if(clip_cubic(arc,window))
+	if(clip_cubic(arc,span.window))
 	{
-		line_to(x,y);
+		span.line_to(x,y);
 		return;
 	}
 
@@ -1688,9 +1935,9 @@ void Layer_Shape::PolySpan::cubic_to(Real x1, Real y1, Real x2, Real y2, Real x,
 			continue;
 		}else
 		//if the curve is clipping then draw degenerate
-		if(clip_cubic(current,window))
+		if(clip_cubic(current,span.window))
 		{
-			line_to(current[0][0],current[0][1]); //backwards so front is destination
+			span.line_to(current[0][0],current[0][1]); //backwards so front is destination
 			current -= 3;
 			if(onsecond) level--;
 			onsecond = true;
@@ -1710,9 +1957,9 @@ void Layer_Shape::PolySpan::cubic_to(Real x1, Real y1, Real x2, Real y2, Real x,
 		else //NOT TOO BIG? RENDER!!!
 		{
 			//cur_x,cur_y = current[3], so we need to go 2,1,0
-			line_to(current[2][0],current[2][1]);
-			line_to(current[1][0],current[1][1]);
-			line_to(current[0][0],current[0][1]);
+			span.line_to(current[2][0],current[2][1]);
+			span.line_to(current[1][0],current[1][1]);
+			span.line_to(current[0][0],current[0][1]);
 
 			current -= 3;
 			if(onsecond) level--;
@@ -1722,6 +1969,18 @@ void Layer_Shape::PolySpan::cubic_to(Real x1, Real y1, Real x2, Real y2, Real x,
 	}
 }
 
+void Layer_Shape::PolySpan::conic_to(Real x1, Real y1, Real x, Real y)
+	{ subdivide_conic(*this, x1, y1, x, y); }
+
+void Layer_Shape::PolySpan::cubic_to(Real x1, Real y1, Real x2, Real y2, Real x, Real y)
+	{ subdivide_cubic(*this, x1, y1, x2, y2, x, y); }
+
+void Layer_Shape::EdgeList::conic_to(Real x1, Real y1, Real x, Real y)
+	{ subdivide_conic(*this, x1, y1, x, y); }
+
+void Layer_Shape::EdgeList::cubic_to(Real x1, Real y1, Real x2, Real y2, Real x, Real y)
+	{ subdivide_cubic(*this, x1, y1, x2, y2, x, y); }
+
 //******************** LINE ALGORITHMS ****************************
 // THESE CALCULATE THE AREA AND THE COVER FOR THE MARKS, TO THEN SCAN CONVERT
 // - BROKEN UP INTO SCANLINES (draw_line - y intersections),
@@ -2004,6 +2263,7 @@ void Layer_Shape::move_to(Real x, Real y)
 		bytestream.insert(bytestream.end(),(char*)&p,(char*)(&p+1));	//insert the bytes for data
 	}
 
+	bytestream_revision++;
 	edge_table->move_to(x,y);
 }
 
@@ -2024,6 +2284,7 @@ void Layer_Shape::close()
 		bytestream.insert(bytestream.end(),(char*)&op,(char*)(&op+1)); //insert header
 	}
 
+	bytestream_revision++;
 	edge_table->close();
 	//should not affect the bounding box since it would just be returning to old point...
 }
@@ -2042,6 +2303,7 @@ void Layer_Shape::endpath()
 		bytestream.insert(bytestream.end(),(char*)&op,(char*)(&op+1));
 	}
 	//should not affect the bounding box since it would just be returning to old point... if at all
+	bytestream_revision++;
 }
 
 void Layer_Shape::line_to(Real x, Real y)
@@ -2072,6 +2334,7 @@ void Layer_Shape::line_to(Real x, Real y)
 		bytestream.insert(bytestream.end(),(char*)&p,(char*)(&p+1));	//insert the bytes for data
 	}
 
+	bytestream_revision++;
 	edge_table->line_to(x,y);
 }
 
@@ -2103,6 +2366,7 @@ void Layer_Shape::conic_to(Real x1, Real y1, Real x, Real y)
 		bytestream.insert(bytestream.end(),(char*)&p,(char*)(&p+1));	//insert the bytes for data
 	}
 
+	bytestream_revision++;
 	edge_table->conic_to(x1,y1,x,y);
 }
 
@@ -2131,6 +2395,7 @@ void Layer_Shape::conic_to_smooth(Real x, Real y)				//x1,y1 derived from curren
 		bytestream.insert(bytestream.end(),(char*)&p,(char*)(&p+1));	//insert the bytes for data
 	}
 
+	bytestream_revision++;
 	edge_table->conic_to_smooth(x,y);
 }
 
@@ -2165,6 +2430,7 @@ void Layer_Shape::curve_to(Real x1, Real y1, Real x2, Real y2, Real x, Real y)
 		bytestream.insert(bytestream.end(),(char*)&p,(char*)(&p+1));	//insert the bytes for data
 	}
 
+	bytestream_revision++;
 	edge_table->curve_to(x1,y1,x2,y2,x,y);
 }
 
@@ -2195,139 +2461,207 @@ void Layer_Shape::curve_to_smooth(Real x2, Real y2, Real x, Real y)		//x1,y1 der
 		bytestream.insert(bytestream.end(),(char*)&p2,(char*)(&p2+1));	//insert the bytes for data
 		bytestream.insert(bytestream.end(),(char*)&p,(char*)(&p+1));	//insert the bytes for data
 	}
+	bytestream_revision++;
 }
 
 // ACCELERATED RENDER FUNCTION - TRANSLATE BYTE CODE INTO FUNCTION CALLS
 
-bool Layer_Shape::render_polyspan(
-	Surface *surface,
-	PolySpan &polyspan,
-	Color::value_type amount,
-	Color::BlendMethod blend_method,
-	const Color &color,
-	bool invert,
-	bool antialias,
-	WindingStyle winding_style ) const
+//sorts the marks of a band of rows by x
+struct SortRows
 {
-	Surface::alpha_pen p(surface->begin(), amount, blend_method);
-	PolySpan::cover_array::iterator cur_mark = polyspan.covers.begin();
-	PolySpan::cover_array::iterator end_mark = polyspan.covers.end();
+	vector<PenMark> &marks;
+	//index of the first mark of every row, plus the end
+	const vector<int> &rows;
 
-	Real cover,area,alpha;
+	SortRows(vector<PenMark> &marks, const vector<int> &rows): marks(marks), rows(rows) { }
 
-	int	y,x;
+	void operator()(int begin, int end)const
+	{
+		for(int r = begin; r < end; r++)
+			sort(marks.begin() + rows[r], marks.begin() + rows[r + 1]);
+	}
+};
 
-	p.set_value(color);
-	cover = 0;
+void Layer_Shape::PolySpan::bin_marks(int first)
+{
+	const int count = (int)covers.size() - first;
+	if(count < 2) return;
 
-	if(cur_mark == end_mark)
+	cover_array::iterator begin = covers.begin() + first;
+	int miny = begin->y, maxy = begin->y;
+	for(cover_array::iterator i = begin; i != covers.end(); ++i)
 	{
-		//no marks at all
-		if(invert)
-		{
-			p.move_to(polyspan.window.minx,polyspan.window.miny);
-			p.put_block(polyspan.window.maxy - polyspan.window.miny,polyspan.window.maxx - polyspan.window.minx);
-		}
-		return true;
+		miny = min(miny, i->y);
+		maxy = max(maxy, i->y);
 	}
 
-	//fill initial rect / line
-	if(invert)
+	//small or very sparse lists are sorted right away
+	if(count < 4096 || maxy - miny > count)
 	{
-		//fill all the area above the first vertex
-		p.move_to(polyspan.window.minx,polyspan.window.miny);
-		y = polyspan.window.miny;
-		int l = polyspan.window.maxx - polyspan.window.minx;
+		sort(begin, covers.end());
+		return;
+	}
 
-		p.put_block(cur_mark->y - polyspan.window.miny,l);
+	//count the marks of every row, then place them in their row keeping their order
+	vector<int> rows(maxy - miny + 2, 0);
+	for(cover_array::iterator i = begin; i != covers.end(); ++i)
+		rows[i->y - miny + 1]++;
+	for(size_t r = 1; r < rows.size(); r++)
+		rows[r] += rows[r - 1];
 
-		//fill the area to the left of the first vertex on that line
-		l = cur_mark->x - polyspan.window.minx;
-		p.move_to(polyspan.window.minx,cur_mark->y);
-		if(l) p.put_hline(l);
-	}
+	vector<int> next(rows.begin(), rows.end() - 1);
+	cover_array binned(count);
+	for(cover_array::iterator i = begin; i != covers.end(); ++i)
+		binned[next[i->y - miny]++] = *i;
 
-	for(;;)
-	{
-		y = cur_mark->y;
-		x = cur_mark->x;
+	//the rows are independent, sort them in parallel
+	ThreadPool &pool = ThreadPool::instance();
+	pool.run_bands(SortRows(binned, rows), (int)rows.size() - 1, pool.get_threads()*4);
 
-		p.move_to(x,y);
+	copy(binned.begin(), binned.end(), begin);
+}
 
-		area = cur_mark->area;
-		cover += cur_mark->cover;
+//orders marks by row only
+struct MarkRowLess
+{
+	bool operator()(const PenMark &mark, int y)const { return mark.y < y; }
+};
 
-		//accumulate for the current pixel
-		while(++cur_mark != polyspan.covers.end())
+struct Layer_Shape::PolySpan::Renderer
+{
+	const PolySpan &polyspan;
+	Surface &surface;
+	Color::value_type amount;
+	Color::BlendMethod blend_method;
+	Color color;
+	bool invert;
+	bool antialias;
+	WindingStyle winding_style;
+
+	Renderer(const PolySpan &polyspan, Surface &surface, Color::value_type amount,
+			 Color::BlendMethod blend_method, const Color &color,
+			 bool invert, bool antialias, WindingStyle winding_style):
+		polyspan(polyspan), surface(surface), amount(amount), blend_method(blend_method),
+		color(color), invert(invert), antialias(antialias), winding_style(winding_style) { }
+
+	//blends a single pixel with the given coverage
+	void put(Color *row, int x, Real alpha)const
+	{
+		if(!antialias)
 		{
-			if(y != cur_mark->y || x != cur_mark->x)
-				break;
-
-			area += cur_mark->area;
-			cover += cur_mark->cover;
+			if(alpha < .5) return;
+			alpha = 1;
 		}
+		else if(!alpha) return;
+
+		row[x] = Color::blend(color, row[x], amount*alpha, blend_method);
+	}
 
-		//draw pixel - based on covered area
-		if(area)	//if we're ok, draw the current pixel
+	//blends the pixels x0 to x1 (excluded) with the same coverage
+	void fill(Color *row, const Color *colors, int x0, int x1, Real alpha)const
+	{
+		if(!antialias)
 		{
-			alpha = polyspan.ExtractAlpha(cover - area, winding_style);
-			if(invert) alpha = 1 - alpha;
+			if(alpha < .5) return;
+			alpha = 1;
+		}
+		else if(!alpha) return;
 
-			if(!antialias)
-			{
-				if(alpha >= .5) p.put_value();
-			}
-			else if(alpha) p.put_value_alpha(alpha);
+		x0 = max(x0, polyspan.window.minx);
+		x1 = min(x1, polyspan.window.maxx);
+		if(x0 < x1)
+			Color::blend_span(row + x0, colors + x0 - polyspan.window.minx, x1 - x0, amount*alpha, blend_method);
+	}
 
-			p.inc_x();
-			x++;
-		}
+	//draws the row y from the marks begin to end (excluded)
+	void draw_row(int y, const PenMark *mark, const PenMark *end, const Color *colors)const
+	{
+		Color *row = surface[y];
+		Real cover = 0, area, alpha;
+		int x = polyspan.window.minx;
 
-		//if we're done, don't use iterator and exit
-		if(cur_mark == end_mark) break;
+		//fill the area to the left of the first vertex on that line
+		if(invert && mark != end)
+			fill(row, colors, x, mark->x, 1);
 
-		//if there is no more live pixels on this line, goto next
-		if(y != cur_mark->y)
+		while(mark != end)
 		{
-			if(invert)
-			{
-				//fill the area at the end of the line
-				p.put_hline(polyspan.window.maxx - x);
+			x = mark->x;
+			area = mark->area;
+			cover += mark->cover;
 
-				//fill area at the beginning of the next line
-				p.move_to(polyspan.window.minx,cur_mark->y);
-				p.put_hline(cur_mark->x - polyspan.window.minx);
+			//accumulate for the current pixel
+			while(++mark != end && mark->x == x)
+			{
+				area += mark->area;
+				cover += mark->cover;
 			}
 
-			cover = 0;
-
-			continue;
-		}
-
-		//draw span to next pixel - based on total amount of pixel cover
-		if(x < cur_mark->x)
-		{
-			alpha = polyspan.ExtractAlpha(cover, winding_style);
-			if(invert) alpha = 1 - alpha;
+			//draw pixel - based on covered area
+			if(area)
+			{
+				alpha = polyspan.ExtractAlpha(cover - area, winding_style);
+				put(row, x, invert ? 1 - alpha : alpha);
+				x++;
+			}
 
-			if(!antialias)
+			//draw span to next pixel - based on total amount of pixel cover
+			if(mark != end && x < mark->x)
 			{
-				if(alpha >= .5) p.put_hline(cur_mark->x - x);
+				alpha = polyspan.ExtractAlpha(cover, winding_style);
+				fill(row, colors, x, mark->x, invert ? 1 - alpha : alpha);
 			}
-			else if(alpha) p.put_hline(cur_mark->x - x,alpha);
 		}
+
+		//fill the area at the end of the line
+		if(invert)
+			fill(row, colors, x, polyspan.window.maxx, 1);
 	}
 
-	//fill the after stuff
-	if(invert)
+	//draws the rows begin to end (excluded) of the window
+	void operator()(int begin, int end)const
 	{
-		//fill the area at the end of the line
-		p.put_hline(polyspan.window.maxx - x);
+		const int y0 = polyspan.window.miny + begin;
+		const int y1 = polyspan.window.miny + end;
 
-		//fill area at the beginning of the next line
-		p.move_to(polyspan.window.minx,y+1);
-		p.put_block(polyspan.window.maxy - y - 1,polyspan.window.maxx - polyspan.window.minx);
+		//the source of the span blends, one color per pixel of the window
+		vector<Color> colors(polyspan.window.maxx - polyspan.window.minx, color);
+
+		const PenMark *first = polyspan.covers.empty() ? NULL : &polyspan.covers[0];
+		const PenMark *last = first + polyspan.covers.size();
+		const PenMark *mark = lower_bound(first, last, y0, MarkRowLess());
+
+		for(int y = y0; y < y1; y++)
+		{
+			const PenMark *row_end = mark;
+			while(row_end != last && row_end->y == y)
+				row_end++;
+			draw_row(y, mark, row_end, colors.empty() ? NULL : &colors[0]);
+			mark = row_end;
+		}
 	}
+};
+
+bool Layer_Shape::render_polyspan(
+	Surface *surface,
+	PolySpan &polyspan,
+	Color::value_type amount,
+	Color::BlendMethod blend_method,
+	const Color &color,
+	bool invert,
+	bool antialias,
+	WindingStyle winding_style ) const
+{
+	const ContextRect &window = polyspan.window;
+	const int rows = window.maxy - window.miny;
+	if(rows <= 0 || window.maxx <= window.minx)
+		return true;
+
+	//the marks are sorted by rows, so bands of rows can be drawn at the same time
+	PolySpan::Renderer renderer(polyspan, *surface, amount, blend_method, color, invert, antialias, winding_style);
+	ThreadPool &pool = ThreadPool::instance();
+	bool few = rows*(window.maxx - window.minx) < 128*128 && polyspan.covers.size() < 4096;
+	pool.run_bands(renderer, rows, few ? 1 : pool.get_threads()*4);
 
 	return true;
 }
@@ -3093,47 +3427,12 @@ Layer_Shape::feather_cairo_surface(cairo_surface_t* surface, RendDesc renddesc,
 
 
 bool
-Layer_Shape::render_shape(Surface *surface,bool useblend,int /*quality*/,
-							const RendDesc &renddesc, ProgressCallback *cb)const
+Layer_Shape::flatten(EdgeList &edges, const Matrix &matrix)const
 {
-	// If our amount is set to zero, no need to render anything
-	if(!get_amount())
-		return true;
-
-	const Real pw = renddesc.get_w()/(renddesc.get_br()[0]-renddesc.get_tl()[0]);
-	const Real ph = renddesc.get_h()/(renddesc.get_br()[1]-renddesc.get_tl()[1]);
-
-	// if the pixels are zero sized then we're too zoomed out to see anything
-	if (pw == 0 || ph == 0)
-		return true;
-
-	Matrix matrix(
-		Matrix().set_translate(param_origin.get(Point()))
-	  * renddesc.get_transformation_matrix()
-	  * Matrix().set_translate(-renddesc.get_tl())
-	  * Matrix().set_scale(pw, ph)
-	);
-
 	int tmp(0);
 
-	SuperCallback	progress(cb,0,renddesc.get_h(),renddesc.get_h());
-
-	//test new polygon renderer
-	// Build edge table
-	// Width and Height of a pixel
-	const int w = renddesc.get_w();
-	const int h = renddesc.get_h();
-
 	Vector tangent (0,0);
 
-	PolySpan	span;
-
-	//optimization for tessellating only inside tiles
-	span.window.minx = 0;
-	span.window.miny = 0;
-	span.window.maxx = w;
-	span.window.maxy = h;
-
 	//pointers for processing the bytestream
 	const char *current 	= &bytestream[0];
 	const char *end			= &bytestream[bytestream.size()];
@@ -3161,7 +3460,7 @@ Layer_Shape::render_shape(Surface *surface,bool useblend,int /*quality*/,
 		current += sizeof(Primitive);
 		if(current > end)
 		{
-			warning("Layer_Shape::accelerated_render - Error in the byte stream, not enough space for next declaration");
+			warning("Layer_Shape::flatten - Error in the byte stream, not enough space for next declaration");
 			return false;
 		}
 
@@ -3174,11 +3473,11 @@ Layer_Shape::render_shape(Surface *surface,bool useblend,int /*quality*/,
 
 		if(operation == Primitive::CLOSE)
 		{
-			if(span.notclosed())
+			if(edges.notclosed())
 			{
-				tangent[0] = span.close_x - span.cur_x;
-				tangent[1] = span.close_y - span.cur_y;
-				span.close();
+				tangent[0] = edges.close_x - edges.cur_x;
+				tangent[1] = edges.close_y - edges.cur_y;
+				edges.close();
 			}
 			continue;
 		}
@@ -3189,11 +3488,11 @@ Layer_Shape::render_shape(Surface *surface,bool useblend,int /*quality*/,
 		//check data positioning
 		if(current > end)
 		{
-			warning("Layer_Shape::accelerated_render - Error in the byte stream, in sufficient data space for declared number of points");
+			warning("Layer_Shape::flatten - Error in the byte stream, in sufficient data space for declared number of points");
 			return false;
 		}
 
-		} catch(...) { synfig::error("Layer_Shape::render_shape()1: Caught an exception after %d loops, rethrowing...", tmp); throw; }
+		} catch(...) { synfig::error("Layer_Shape::flatten(): Caught an exception after %d loops, rethrowing...", tmp); throw; }
 
 		//transfer all the data - RLE optimized
 		for(curnum=0; curnum < number;)
@@ -3206,17 +3505,17 @@ Layer_Shape::render_shape(Surface *surface,bool useblend,int /*quality*/,
 
 					if(curnum == 0)
 					{
-						span.move_to(x,y);
+						edges.move_to(x,y);
 
 						tangent[0] = 0;
 						tangent[1] = 0;
 					}
 					else
 					{
-						tangent[0] = x - span.cur_x;
-						tangent[1] = y - span.cur_y;
+						tangent[0] = x - edges.cur_x;
+						tangent[1] = y - edges.cur_y;
 
-						span.line_to(x,y);
+						edges.line_to(x,y);
 					}
 
 					curnum++; //only advance one point
@@ -3228,10 +3527,10 @@ Layer_Shape::render_shape(Surface *surface,bool useblend,int /*quality*/,
 				{
 					matrix.get_transformed(x, y, data[curnum][0], data[curnum][1]);
 
-					tangent[0] = x - span.cur_x;
-					tangent[1] = y - span.cur_y;
+					tangent[0] = x - edges.cur_x;
+					tangent[1] = y - edges.cur_y;
 
-					span.line_to(x,y);
+					edges.line_to(x,y);
 					curnum++;
 					break;
 				}
@@ -3244,7 +3543,7 @@ Layer_Shape::render_shape(Surface *surface,bool useblend,int /*quality*/,
 					tangent[0] = 2*(x - x1);
 					tangent[1] = 2*(y - y1);
 
-					span.conic_to(x1,y1,x,y);
+					edges.conic_to(x1,y1,x,y);
 					curnum += 2;
 					break;
 				}
@@ -3253,13 +3552,13 @@ Layer_Shape::render_shape(Surface *surface,bool useblend,int /*quality*/,
 				{
 					matrix.get_transformed(x, y, data[curnum][0], data[curnum][1]);
 
-					x1 = span.cur_x + tangent[0]/2;
-					y1 = span.cur_y + tangent[1]/2;
+					x1 = edges.cur_x + tangent[0]/2;
+					y1 = edges.cur_y + tangent[1]/2;
 
 					tangent[0] = 2*(x - x1);
 					tangent[1] = 2*(y - y1);
 
-					span.conic_to(x1,y1,x,y);
+					edges.conic_to(x1,y1,x,y);
 					curnum ++;
 
 					break;
@@ -3274,7 +3573,7 @@ Layer_Shape::render_shape(Surface *surface,bool useblend,int /*quality*/,
 					tangent[0] = 2*(x - x2);
 					tangent[1] = 2*(y - y2);
 
-					span.cubic_to(x1,y1,x2,y2,x,y);
+					edges.cubic_to(x1,y1,x2,y2,x,y);
 					curnum += 3;
 
 					break;
@@ -3285,13 +3584,13 @@ Layer_Shape::render_shape(Surface *surface,bool useblend,int /*quality*/,
 					matrix.get_transformed(x, y, data[curnum+1][0], data[curnum+1][1]);
 					matrix.get_transformed(x1, y1, data[curnum][0], data[curnum][1]);
 
-					x1 = span.cur_x + tangent[0]/3.0;
-					y1 = span.cur_y + tangent[1]/3.0;
+					x1 = edges.cur_x + tangent[0]/3.0;
+					y1 = edges.cur_y + tangent[1]/3.0;
 
 					tangent[0] = 2*(x - x2);
 					tangent[1] = 2*(y - y2);
 
-					span.cubic_to(x1,y1,x2,y2,x,y);
+					edges.cubic_to(x1,y1,x2,y2,x,y);
 					curnum += 2;
 
 					break;
@@ -3300,6 +3599,188 @@ Layer_Shape::render_shape(Surface *surface,bool useblend,int /*quality*/,
 		}
 	}
 
+	return true;
+}
+
+static void
+count_edge_cache(bool hit)
+{
+	Mutex::Lock lock(edge_cache_stats_mutex());
+	if (hit)
+		++edge_cache_stats.hits;
+	else
+		++edge_cache_stats.misses;
+}
+
+// The tiles of a frame get pixel sizes which differ in the last bits,
+// so the key only takes 32 significant bits of the matrix
+static void
+add_rounded(SurfaceCache::KeyBuilder &builder, Real x)
+{
+	int exponent;
+	const Real mantissa = frexp(x, &exponent);
+	builder.add((long long)floor(mantissa*4294967296.0 + 0.5));
+	builder.add(exponent);
+}
+
+Layer_Shape::EdgeCacheStats
+Layer_Shape::get_edge_cache_stats()
+{
+	Mutex::Lock lock(edge_cache_stats_mutex());
+	return edge_cache_stats;
+}
+
+void
+Layer_Shape::reset_edge_cache_stats()
+{
+	Mutex::Lock lock(edge_cache_stats_mutex());
+	edge_cache_stats = EdgeCacheStats();
+}
+
+bool
+Layer_Shape::draw_edges(PolySpan &span, const RendDesc &renddesc, Real pw, Real ph)const
+{
+	// The transformation to pixels without the offset of the tile,
+	// the offset is added while drawing the edges
+	const Matrix matrix(
+		Matrix().set_translate(param_origin.get(Point()))
+	  * renddesc.get_transformation_matrix()
+	  * Matrix().set_scale(pw, ph)
+	);
+	const Real dx = -renddesc.get_tl()[0]*pw;
+	const Real dy = -renddesc.get_tl()[1]*ph;
+
+	// Huge (zoomed in) shapes are only worth subdividing inside of the tile
+	bool cached = true;
+	if (!edge_table->initaabb)
+	{
+		const Rect &aabb = edge_table->aabb;
+		Point p = matrix.get_transformed(Point(aabb.minx, aabb.miny));
+		Rect bounds(p[0], p[1]);
+		p = matrix.get_transformed(Point(aabb.maxx, aabb.miny));
+		bounds.expand(p[0], p[1]);
+		p = matrix.get_transformed(Point(aabb.minx, aabb.maxy));
+		bounds.expand(p[0], p[1]);
+		p = matrix.get_transformed(Point(aabb.maxx, aabb.maxy));
+		bounds.expand(p[0], p[1]);
+
+		cached = bounds.maxx - bounds.minx <= MAX_CACHED_EXTENT
+		      && bounds.maxy - bounds.miny <= MAX_CACHED_EXTENT
+		      && bounds.minx > -MAX_CACHED_WINDOW && bounds.maxx < MAX_CACHED_WINDOW
+		      && bounds.miny > -MAX_CACHED_WINDOW && bounds.maxy < MAX_CACHED_WINDOW;
+	}
+
+	if (!cached)
+	{
+		count_edge_cache(false);
+
+		EdgeList edges;
+		edges.window = span.window;
+		if (!flatten(edges, matrix*Matrix().set_translate(dx, dy)))
+			return false;
+		edges.draw(span, 0, 0);
+		return true;
+	}
+
+	SurfaceCache::Key key;
+	EdgeCache::EntryList &entries = edge_cache->entries;
+	EdgeCache::EntryList::iterator entry;
+	bool found;
+	{
+		Mutex::Lock lock(edge_cache->mutex);
+
+		if (edge_cache->revision != bytestream_revision)
+		{
+			SurfaceCache::KeyBuilder content;
+			if (!bytestream.empty())
+				content.add(&bytestream[0], bytestream.size());
+			edge_cache->content = content.get();
+			edge_cache->revision = bytestream_revision;
+		}
+
+		SurfaceCache::KeyBuilder builder;
+		builder.add(edge_cache->content);
+		add_rounded(builder, matrix.m00);
+		add_rounded(builder, matrix.m01);
+		add_rounded(builder, matrix.m10);
+		add_rounded(builder, matrix.m11);
+		add_rounded(builder, matrix.m20);
+		add_rounded(builder, matrix.m21);
+		key = builder.get();
+
+		for(entry = entries.begin(); entry != entries.end(); ++entry)
+			if (entry->key == key)
+				break;
+		found = entry != entries.end();
+		if (found)
+		{
+			entries.splice(entries.begin(), entries, entry);
+			++entry->users;
+		}
+	}
+
+	if (found)
+	{
+		count_edge_cache(true);
+
+		EdgeCache::User user(*edge_cache, entry);
+		entry->edges.draw(span, dx, dy);
+		return true;
+	}
+
+	count_edge_cache(false);
+
+	// flatten without holding the lock, the other tiles may be drawing
+	EdgeCache::EntryList fresh(1);
+	fresh.front().key = key;
+	EdgeList &edges = fresh.front().edges;
+	edges.window.minx = edges.window.miny = -MAX_CACHED_WINDOW;
+	edges.window.maxx = edges.window.maxy = MAX_CACHED_WINDOW;
+	if (!flatten(edges, matrix))
+		return false;
+	edges.draw(span, dx, dy);
+
+	Mutex::Lock lock(edge_cache->mutex);
+	for(entry = entries.begin(); entry != entries.end(); ++entry)
+		if (entry->key == key)
+			return true;
+	entries.splice(entries.begin(), fresh);
+	edge_cache->trim();
+	return true;
+}
+
+bool
+Layer_Shape::render_shape(Surface *surface,bool useblend,int /*quality*/,
+							const RendDesc &renddesc, ProgressCallback *cb)const
+{
+	// If our amount is set to zero, no need to render anything
+	if(!get_amount())
+		return true;
+
+	const Real pw = renddesc.get_w()/(renddesc.get_br()[0]-renddesc.get_tl()[0]);
+	const Real ph = renddesc.get_h()/(renddesc.get_br()[1]-renddesc.get_tl()[1]);
+
+	// if the pixels are zero sized then we're too zoomed out to see anything
+	if (pw == 0 || ph == 0)
+		return true;
+
+	//test new polygon renderer
+	// Build edge table
+	// Width and Height of a pixel
+	const int w = renddesc.get_w();
+	const int h = renddesc.get_h();
+
+	PolySpan	span;
+
+	//optimization for tessellating only inside tiles
+	span.window.minx = 0;
+	span.window.miny = 0;
+	span.window.maxx = w;
+	span.window.maxy = h;
+
+	if (!draw_edges(span, renddesc, pw, ph))
+		return false;
+
 	//sort the bastards so we can render everything
 	span.sort_marks();
 
@@ -3357,21 +3838,12 @@ Layer_Shape::render_shape(etl::surface<float> *surface,int /*quality*/,
 	if (pw == 0 || ph == 0)
 		return true;
 
-	Matrix matrix(
-		Matrix().set_translate(param_origin.get(Point()))
-	  * renddesc.get_transformation_matrix()
-	  * Matrix().set_translate(-renddesc.get_tl())
-	  * Matrix().set_scale(pw, ph)
-	);
-
 	//test new polygon renderer
 	// Build edge table
 	// Width and Height of a pixel
 	const int 	w = renddesc.get_w();
 	const int	h = renddesc.get_h();
 
-	Vector tangent (0,0);
-
 	PolySpan	span;
 
 	//optimization for tessellating only inside tiles
@@ -3380,164 +3852,8 @@ Layer_Shape::render_shape(etl::surface<float> *surface,int /*quality*/,
 	span.window.maxx = w;
 	span.window.maxy = h;
 
-	//pointers for processing the bytestream
-	const char *current 	= &bytestream[0];
-	const char *end			= &bytestream[bytestream.size()];
-
-	int	operation 	= Primitive::NONE;
-	int number		= 0;
-	int curnum;
-
-	Primitive 	*curprim;
-	Point		*data;
-
-	Real x,y,x1,y1,x2,y2;
-
-	while(current < end)
-	{
-		//get the op code safely
-		curprim = (Primitive *)current;
-
-		//advance past indices
-		current += sizeof(Primitive);
-		if(current > end)
-		{
-			warning("Layer_Shape::accelerated_render - Error in the byte stream, not enough space for next declaration");
-			return false;
-		}
-
-		//get the relevant data
-		operation 	= curprim->operation;
-		number 		= curprim->number;
-
-		if(operation == Primitive::END)
-			break;
-
-		if(operation == Primitive::CLOSE)
-		{
-			if(span.notclosed())
-			{
-				tangent[0] = span.close_x - span.cur_x;
-				tangent[1] = span.close_y - span.cur_y;
-				span.close();
-			}
-			continue;
-		}
-
-		data = (Point*)current;
-		current += sizeof(Point)*number;
-
-		//check data positioning
-		if(current > end)
-		{
-			warning("Layer_Shape::accelerated_render - Error in the byte stream, in sufficient data space for declared number of points");
-			return false;
-		}
-
-		//transfer all the data
-		for(curnum=0; curnum < number;)
-		{
-			switch(operation)
-			{
-				case Primitive::MOVE_TO:
-				{
-					matrix.get_transformed(x, y, data[curnum][0], data[curnum][1]);
-
-					if(curnum == 0)
-					{
-						span.move_to(x,y);
-
-						tangent[0] = 0;
-						tangent[1] = 0;
-					}
-					else
-					{
-						tangent[0] = x - span.cur_x;
-						tangent[1] = y - span.cur_y;
-
-						span.line_to(x,y);
-					}
-
-					curnum++; //only advance one point
-
-					break;
-				}
-
-				case Primitive::LINE_TO:
-				{
-					matrix.get_transformed(x, y, data[curnum][0], data[curnum][1]);
-
-					tangent[0] = x - span.cur_x;
-					tangent[1] = y - span.cur_y;
-
-					span.line_to(x,y);
-					curnum++;
-					break;
-				}
-
-				case Primitive::CONIC_TO:
-				{
-					matrix.get_transformed(x, y, data[curnum+1][0], data[curnum+1][1]);
-					matrix.get_transformed(x1, y1, data[curnum][0], data[curnum][1]);
-
-					tangent[0] = 2*(x - x1);
-					tangent[1] = 2*(y - y1);
-
-					span.conic_to(x1,y1,x,y);
-					curnum += 2;
-					break;
-				}
-
-				case Primitive::CONIC_TO_SMOOTH:
-				{
-					matrix.get_transformed(x, y, data[curnum][0], data[curnum][1]);
-
-					x1 = span.cur_x + tangent[0]/2;
-					y1 = span.cur_y + tangent[1]/2;
-
-					tangent[0] = 2*(x - x1);
-					tangent[1] = 2*(y - y1);
-
-					span.conic_to(x1,y1,x,y);
-					curnum ++;
-
-					break;
-				}
-
-				case Primitive::CUBIC_TO:
-				{
-					matrix.get_transformed(x, y, data[curnum+2][0], data[curnum+2][1]);
-					matrix.get_transformed(x2, y2, data[curnum+1][0], data[curnum+1][1]);
-					matrix.get_transformed(x1, y1, data[curnum][0], data[curnum][1]);
-
-					tangent[0] = 2*(x - x2);
-					tangent[1] = 2*(y - y2);
-
-					span.cubic_to(x1,y1,x2,y2,x,y);
-					curnum += 3;
-
-					break;
-				}
-
-				case Primitive::CUBIC_TO_SMOOTH:
-				{
-					matrix.get_transformed(x, y, data[curnum+1][0], data[curnum+1][1]);
-					matrix.get_transformed(x1, y1, data[curnum][0], data[curnum][1]);
-
-					x1 = span.cur_x + tangent[0]/3.0;
-					y1 = span.cur_y + tangent[1]/3.0;
-
-					tangent[0] = 2*(x - x2);
-					tangent[1] = 2*(y - y2);
-
-					span.cubic_to(x1,y1,x2,y2,x,y);
-					curnum += 2;
-
-					break;
-				}
-			}
-		}
-	}
+	if (!draw_edges(span, renddesc, pw, ph))
+		return false;
 
 	//sort the bastards so we can render everything
 	span.sort_marks();
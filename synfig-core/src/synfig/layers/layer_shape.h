@@ -32,6 +32,7 @@
 #include "layer_composite.h"
 #include <synfig/color.h>
 #include <synfig/vector.h>
+#include <synfig/matrix.h>
 #include <synfig/blur.h>
 
 #include <vector>
@@ -63,6 +64,9 @@ private:
 	//internal caching
 	struct Intersector;
 	Intersector	*edge_table;
+	class EdgeList;
+	struct EdgeCache;
+	EdgeCache	*edge_cache;
 protected:
 	//!Parameter: (Color) Color of the shape
 	ValueBase   param_color;
@@ -85,12 +89,23 @@ private:
 	int						lastbyteop;
 	int						lastoppos;
 
+	//bumped on every change of the bytestream, tells the edge cache to rehash it
+	int						bytestream_revision;
+
 protected:
 
 	Layer_Shape(const Real &a = 1.0, const Color::BlendMethod m = Color::BLEND_COMPOSITE);
 
 public:
 
+	//! Counters of the flattened edge lists reused between renders
+	struct EdgeCacheStats
+	{
+		long long hits;
+		long long misses;
+		EdgeCacheStats(): hits(), misses() { }
+	};
+
 	~Layer_Shape();
 
 	//! Clears out any data
@@ -122,8 +137,14 @@ public:
 	bool shape_to_cairo(cairo_t* cr)const;
 	bool feather_cairo_surface(cairo_surface_t* surface, RendDesc renddesc, int quality)const;
 
+	//! Returns the edge cache counters summed over all the shape layers
+	static EdgeCacheStats get_edge_cache_stats();
+	static void reset_edge_cache_stats();
+
 private:
 	class 		PolySpan;
+	bool flatten(EdgeList &edges, const Matrix &matrix)const;
+	bool draw_edges(PolySpan &span, const RendDesc &renddesc, Real pw, Real ph)const;
 	bool render_polyspan(
 		Surface *surface,
 		PolySpan &polyspan,
@@ -80,6 +80,9 @@
 #include "importer.h"
 
 #include "zstreambuf.h"
+#include "xmlreader.h"
+#include "xmlcache.h"
+#include "loadqueue.h"
 
 #include <map>
 #include <sigc++/bind.h>
@@ -114,6 +117,16 @@ std::set<FileSystem::Identifier> CanvasParser::loading_;
 
 /* === P R O C E D U R E S ================================================= */
 
+//! Reads the number at \a s and moves \a s past it, without copying the string
+static inline Real
+read_number(const char *&s)
+{
+	char *end;
+	Real x = strtod(s, &end);
+	s = end;
+	return x;
+}
+
 static std::map<String, Canvas::LooseHandle>* open_canvas_map_(0);
 
 std::map<synfig::String, etl::loose_handle<Canvas> >& synfig::get_open_canvas_map()
@@ -184,22 +197,42 @@ synfig::open_canvas_as(const FileSystem::Identifier &identifier,const String &as
 	return canvas;
 }
 
+Canvas::Handle
+synfig::open_canvas_from_string_as(const String &data,const FileSystem::Identifier &identifier,const String &as,String &errors,String &warnings)
+{
+	Canvas::Handle canvas;
+	CanvasParser parser;
+	parser.set_allow_errors(true);
+
+	canvas=parser.parse_from_string_as(data,identifier,as,errors);
+
+	warnings = parser.get_warnings_text();
+
+	if(parser.error_count())
+	{
+		errors = parser.get_errors_text();
+		return Canvas::Handle();
+	}
+
+	return canvas;
+}
+
 /* === M E T H O D S ======================================================= */
 
 void
-CanvasParser::error_unexpected_element(xmlpp::Node *element,const String &got, const String &expected)
+CanvasParser::error_unexpected_element(XMLElement *element,const String &got, const String &expected)
 {
 	error(element,strprintf(_("Unexpected element <%s>, Expected <%s>"),got.c_str(),expected.c_str()));
 }
 
 void
-CanvasParser::error_unexpected_element(xmlpp::Node *element,const String &got)
+CanvasParser::error_unexpected_element(XMLElement *element,const String &got)
 {
 	error(element,strprintf(_("Unexpected element <%s>"),got.c_str()));
 }
 
 void
-CanvasParser::warning(xmlpp::Node *element, const String &text)
+CanvasParser::warning(XMLElement *element, const String &text)
 {
 	string str=strprintf("%s:<%s>:%d: ",filename.c_str(),element->get_name().c_str(),element->get_line())+text;
 
@@ -213,7 +246,7 @@ CanvasParser::warning(xmlpp::Node *element, const String &text)
 }
 
 void
-CanvasParser::error(xmlpp::Node *element, const String &text)
+CanvasParser::error(XMLElement *element, const String &text)
 {
 	string str=strprintf("%s:<%s>:%d: error: ",filename.c_str(),element->get_name().c_str(),element->get_line())+text;
 	total_errors_++;
@@ -225,7 +258,7 @@ CanvasParser::error(xmlpp::Node *element, const String &text)
 }
 
 void
-CanvasParser::fatal_error(xmlpp::Node *element, const String &text)
+CanvasParser::fatal_error(XMLElement *element, const String &text)
 {
 	string str=strprintf("%s:<%s>:%d:",filename.c_str(),element->get_name().c_str(),element->get_line())+text;
 	throw runtime_error(str);
@@ -234,7 +267,7 @@ CanvasParser::fatal_error(xmlpp::Node *element, const String &text)
 
 
 Keyframe
-CanvasParser::parse_keyframe(xmlpp::Element *element,Canvas::Handle canvas)
+CanvasParser::parse_keyframe(XMLElement *element,Canvas::Handle canvas)
 {
 	assert(element->get_name()=="keyframe");
 
@@ -247,14 +280,14 @@ CanvasParser::parse_keyframe(xmlpp::Element *element,Canvas::Handle canvas)
 	Keyframe ret(Time(element->get_attribute("time")->get_value(),canvas->rend_desc().get_frame_rate()));
 
 
-	if(!element->get_children().empty())
-		if(!element->get_child_text()->get_content().empty())
-			ret.set_description(element->get_child_text()->get_content());
+	if(element->has_children())
+		if(!element->get_child_text().empty())
+			ret.set_description(element->get_child_text());
 	
 	bool active=true;
 	if(element->get_attribute("active")) 
 	{
-		string val=element->get_attribute("active")->get_value();
+		const String &val=element->get_attribute("active")->get_value();
 		if(val=="false" || val=="0")
 			active=false;
 	}
@@ -265,11 +298,11 @@ CanvasParser::parse_keyframe(xmlpp::Element *element,Canvas::Handle canvas)
 
 
 Real
-CanvasParser::parse_real(xmlpp::Element *element)
+CanvasParser::parse_real(XMLElement *element)
 {
 	assert(element->get_name()=="real");
 
-	if(!element->get_children().empty())
+	if(element->has_children())
 		warning(element, strprintf(_("<%s> should not contain anything"),"real"));
 
 	if(!element->get_attribute("value"))
@@ -278,17 +311,17 @@ CanvasParser::parse_real(xmlpp::Element *element)
 		return false;
 	}
 
-	string val=element->get_attribute("value")->get_value();
+	const String &val=element->get_attribute("value")->get_value();
 
 	return atof(val.c_str());
 }
 
 Time
-CanvasParser::parse_time(xmlpp::Element *element,Canvas::Handle canvas)
+CanvasParser::parse_time(XMLElement *element,Canvas::Handle canvas)
 {
 	assert(element->get_name()=="time");
 
-	if(!element->get_children().empty())
+	if(element->has_children())
 		warning(element, strprintf(_("<%s> should not contain anything"),"time"));
 
 	if(!element->get_attribute("value"))
@@ -297,17 +330,17 @@ CanvasParser::parse_time(xmlpp::Element *element,Canvas::Handle canvas)
 		return false;
 	}
 
-	string val=element->get_attribute("value")->get_value();
+	const String &val=element->get_attribute("value")->get_value();
 
 	return Time(val,canvas->rend_desc().get_frame_rate());
 }
 
 int
-CanvasParser::parse_integer(xmlpp::Element *element)
+CanvasParser::parse_integer(XMLElement *element)
 {
 	assert(element->get_name()=="integer");
 
-	if(!element->get_children().empty())
+	if(element->has_children())
 		warning(element, strprintf(_("<%s> should not contain anything"),"integer"));
 
 	if(!element->get_attribute("value"))
@@ -316,17 +349,17 @@ CanvasParser::parse_integer(xmlpp::Element *element)
 		return false;
 	}
 
-	string val=element->get_attribute("value")->get_value();
+	const String &val=element->get_attribute("value")->get_value();
 
 	return atoi(val.c_str());
 }
 
 GUID
-CanvasParser::parse_guid(xmlpp::Element *element)
+CanvasParser::parse_guid(XMLElement *element)
 {
 	assert(element->get_name()=="guid");
 
-	if(!element->get_children().empty())
+	if(element->has_children())
 		warning(element, strprintf(_("<%s> should not contain anything"),"guid"));
 
 	if(!element->get_attribute("value"))
@@ -335,7 +368,7 @@ CanvasParser::parse_guid(xmlpp::Element *element)
 		return false;
 	}
 
-	string val=element->get_attribute("value")->get_value();
+	const String &val=element->get_attribute("value")->get_value();
 
 	return GUID(val);
 }
@@ -350,11 +383,11 @@ Vector &canvas_parser_vector_id(Vector &vector)
 }
 
 Vector
-CanvasParser::parse_vector(xmlpp::Element *element)
+CanvasParser::parse_vector(XMLElement *element)
 {
 	assert(element->get_name()=="vector");
 
-	if(element->get_children().empty())
+	if(!element->has_children())
 	{
 		error(element, "Undefined value in <vector>");
 		return Vector();
@@ -362,31 +395,27 @@ CanvasParser::parse_vector(xmlpp::Element *element)
 
 	Vector vect;
 
-	xmlpp::Element::NodeList list = element->get_children();
-	for(xmlpp::Element::NodeList::iterator iter = list.begin(); iter != list.end(); ++iter)
+	for(XMLElement iter(element); iter.next(); )
 	{
-		xmlpp::Element *child=dynamic_cast<xmlpp::Element*>((xmlpp::Node*)*iter);
-		if(!child)
-			continue;
-		else
+		XMLElement *child(&iter);
 		if(child->get_name()=="x")
 		{
-			if(child->get_children().empty())
+			if(!child->has_children())
 			{
 				error(element, "Undefined value in <x>");
 				return Vector();
 			}
-			vect[0]=atof(child->get_child_text()->get_content().c_str());
+			vect[0]=atof(child->get_child_text().c_str());
 		}
 		else
 		if(child->get_name()=="y")
 		{
-			if(child->get_children().empty())
+			if(!child->has_children())
 			{
 				error(element, "Undefined value in <y>");
 				return Vector();
 			}
-			vect[1]=atof(child->get_child_text()->get_content().c_str());
+			vect[1]=atof(child->get_child_text().c_str());
 		}
 		else
 		{
@@ -403,11 +432,11 @@ CanvasParser::parse_vector(xmlpp::Element *element)
 }
 
 Color
-CanvasParser::parse_color(xmlpp::Element *element)
+CanvasParser::parse_color(XMLElement *element)
 {
 	assert(element->get_name()=="color");
 
-	if(element->get_children().empty())
+	if(!element->has_children())
 	{
 		error(element, "Undefined value in <color>");
 		return Color();
@@ -415,51 +444,47 @@ CanvasParser::parse_color(xmlpp::Element *element)
 
 	Color color(0);
 
-	xmlpp::Element::NodeList list = element->get_children();
-	for(xmlpp::Element::NodeList::iterator iter = list.begin(); iter != list.end(); ++iter)
+	for(XMLElement iter(element); iter.next(); )
 	{
-		xmlpp::Element *child(dynamic_cast<xmlpp::Element*>(*iter));
-		if(!child)
-			continue;
-		else
+		XMLElement *child(&iter);
 		if(child->get_name()=="r")
 		{
-			if(child->get_children().empty())
+			if(!child->has_children())
 			{
 				error(element, "Undefined value in <r>");
 				return Color();
 			}
-			color.set_r(atof(child->get_child_text()->get_content().c_str()));
+			color.set_r(atof(child->get_child_text().c_str()));
 		}
 		else
 		if(child->get_name()=="g")
 		{
-			if(child->get_children().empty())
+			if(!child->has_children())
 			{
 				error(element, "Undefined value in <g>");
 				return Color();
 			}
-			color.set_g(atof(child->get_child_text()->get_content().c_str()));
+			color.set_g(atof(child->get_child_text().c_str()));
 		}
 		else
 		if(child->get_name()=="b")
 		{
-			if(child->get_children().empty())
+			if(!child->has_children())
 			{
 				error(element, "Undefined value in <b>");
 				return Color();
 			}
-			color.set_b(atof(child->get_child_text()->get_content().c_str()));
+			color.set_b(atof(child->get_child_text().c_str()));
 		}
 		else
 		if(child->get_name()=="a")
 		{
-			if(child->get_children().empty())
+			if(!child->has_children())
 			{
 				error(element, "Undefined value in <a>");
 				return Color();
 			}
-			color.set_a(atof(child->get_child_text()->get_content().c_str()));
+			color.set_a(atof(child->get_child_text().c_str()));
 		}
 		else
 		{
@@ -472,31 +497,31 @@ CanvasParser::parse_color(xmlpp::Element *element)
 }
 
 synfig::String
-CanvasParser::parse_string(xmlpp::Element *element)
+CanvasParser::parse_string(XMLElement *element)
 {
 	assert(element->get_name()=="string");
 
-	if(element->get_children().empty())
+	if(!element->has_children())
 	{
 		warning(element, "Undefined value in <string>");
 		return synfig::String();
 	}
 
-	if(element->get_child_text()->get_content().empty())
+	if(element->get_child_text().empty())
 	{
 		warning(element, "Content element of <string> appears to be empty");
 		return synfig::String();
 	}
 
-	return element->get_child_text()->get_content();
+	return element->get_child_text();
 }
 
 bool
-CanvasParser::parse_bool(xmlpp::Element *element)
+CanvasParser::parse_bool(XMLElement *element)
 {
 	assert(element->get_name()=="bool");
 
-	if(!element->get_children().empty())
+	if(element->has_children())
 		warning(element, strprintf(_("<%s> should not contain anything"),"bool"));
 
 	if(!element->get_attribute("value"))
@@ -505,7 +530,7 @@ CanvasParser::parse_bool(xmlpp::Element *element)
 		return false;
 	}
 
-	string val=element->get_attribute("value")->get_value();
+	const String &val=element->get_attribute("value")->get_value();
 
 	if(val=="true" || val=="1")
 		return true;
@@ -518,18 +543,14 @@ CanvasParser::parse_bool(xmlpp::Element *element)
 }
 
 Gradient
-CanvasParser::parse_gradient(xmlpp::Element *node)
+CanvasParser::parse_gradient(XMLElement *node)
 {
 	assert(node->get_name()=="gradient");
 	Gradient ret;
 
-	xmlpp::Element::NodeList list = node->get_children();
-	for(xmlpp::Element::NodeList::iterator iter = list.begin(); iter != list.end(); ++iter)
+	for(XMLElement iter(node); iter.next(); )
 	{
-		xmlpp::Element *child(dynamic_cast<xmlpp::Element*>(*iter));
-		if(!child)
-			continue;
-		else
+		XMLElement *child(&iter);
 		{
 			Gradient::CPoint cpoint;
 			cpoint.color=parse_color(child);
@@ -550,17 +571,13 @@ CanvasParser::parse_gradient(xmlpp::Element *node)
 }
 
 ValueBase
-CanvasParser::parse_list(xmlpp::Element *element,Canvas::Handle canvas)
+CanvasParser::parse_list(XMLElement *element,Canvas::Handle canvas)
 {
 	vector<ValueBase> value_list;
 
-	xmlpp::Element::NodeList list = element->get_children();
-	for(xmlpp::Element::NodeList::iterator iter = list.begin(); iter != list.end(); ++iter)
+	for(XMLElement iter(element); iter.next(); )
 	{
-		xmlpp::Element *child(dynamic_cast<xmlpp::Element*>(*iter));
-		if(!child)
-			continue;
-		else
+		XMLElement *child(&iter);
 		{
 			value_list.push_back(parse_value(child,canvas));
 			if(!value_list.back().is_valid())
@@ -575,11 +592,11 @@ CanvasParser::parse_list(xmlpp::Element *element,Canvas::Handle canvas)
 }
 
 Segment
-CanvasParser::parse_segment(xmlpp::Element *element)
+CanvasParser::parse_segment(XMLElement *element)
 {
 	assert(element->get_name()=="segment");
 
-	if(element->get_children().empty())
+	if(!element->has_children())
 	{
 		error(element, "Undefined value in <segment>");
 		return Segment();
@@ -587,107 +604,87 @@ CanvasParser::parse_segment(xmlpp::Element *element)
 
 	Segment seg;
 
-	xmlpp::Element::NodeList list = element->get_children();
-	for(xmlpp::Element::NodeList::iterator iter = list.begin(); iter != list.end(); ++iter)
+	for(XMLElement iter(element); iter.next(); )
 	{
-		xmlpp::Element *child(dynamic_cast<xmlpp::Element*>(*iter));
-		if(!child)
-			continue;
-		else
+		XMLElement *child(&iter);
 		if(child->get_name()=="p1")
 		{
-			xmlpp::Element::NodeList list = child->get_children();
-			xmlpp::Element::NodeList::iterator iter;
+			XMLElement contents(child);
 
 			// Search for the first non-text XML element
-			for(iter = list.begin(); iter != list.end(); ++iter)
-				if(dynamic_cast<xmlpp::Element*>(*iter)) break;
-
-			if(iter==list.end())
+			if(!contents.next())
 			{
 				error(element, "Undefined value in <p1>");
 				continue;
 			}
 
-			if((*iter)->get_name()!="vector")
+			if(contents.get_name()!="vector")
 			{
-				error_unexpected_element((*iter),(*iter)->get_name(),"vector");
+				error_unexpected_element(&contents,contents.get_name(),"vector");
 				continue;
 			}
 
-			seg.p1=parse_vector(dynamic_cast<xmlpp::Element*>(*iter));
+			seg.p1=parse_vector(&contents);
 		}
 		else
 		if(child->get_name()=="t1")
 		{
-			xmlpp::Element::NodeList list = child->get_children();
-			xmlpp::Element::NodeList::iterator iter;
+			XMLElement contents(child);
 
 			// Search for the first non-text XML element
-			for(iter = list.begin(); iter != list.end(); ++iter)
-				if(dynamic_cast<xmlpp::Element*>(*iter)) break;
-
-			if(iter==list.end())
+			if(!contents.next())
 			{
 				error(element, "Undefined value in <t1>");
 				continue;
 			}
 
-			if((*iter)->get_name()!="vector")
+			if(contents.get_name()!="vector")
 			{
-				error_unexpected_element((*iter),(*iter)->get_name(),"vector");
+				error_unexpected_element(&contents,contents.get_name(),"vector");
 				continue;
 			}
 
-			seg.t1=parse_vector(dynamic_cast<xmlpp::Element*>(*iter));
+			seg.t1=parse_vector(&contents);
 		}
 		else
 		if(child->get_name()=="p2")
 		{
-			xmlpp::Element::NodeList list = child->get_children();
-			xmlpp::Element::NodeList::iterator iter;
+			XMLElement contents(child);
 
 			// Search for the first non-text XML element
-			for(iter = list.begin(); iter != list.end(); ++iter)
-				if(dynamic_cast<xmlpp::Element*>(*iter)) break;
-
-			if(iter==list.end())
+			if(!contents.next())
 			{
 				error(element, "Undefined value in <p2>");
 				continue;
 			}
 
-			if((*iter)->get_name()!="vector")
+			if(contents.get_name()!="vector")
 			{
-				error_unexpected_element((*iter),(*iter)->get_name(),"vector");
+				error_unexpected_element(&contents,contents.get_name(),"vector");
 				continue;
 			}
 
-			seg.p2=parse_vector(dynamic_cast<xmlpp::Element*>(*iter));
+			seg.p2=parse_vector(&contents);
 		}
 		else
 		if(child->get_name()=="t2")
 		{
-			xmlpp::Element::NodeList list = child->get_children();
-			xmlpp::Element::NodeList::iterator iter;
+			XMLElement contents(child);
 
 			// Search for the first non-text XML element
-			for(iter = list.begin(); iter != list.end(); ++iter)
-				if(dynamic_cast<xmlpp::Element*>(*iter)) break;
-
-			if(iter==list.end())
+			if(!contents.next())
 			{
 				error(element, "Undefined value in <t2>");
 				continue;
 			}
 
-			if((*iter)->get_name()!="vector")
+			if(contents.get_name()!="vector")
 			{
-				error_unexpected_element((*iter),(*iter)->get_name(),"vector");
+				error_unexpected_element(&contents,contents.get_name(),"vector");
 				continue;
 			}
 
-			seg.t2=parse_vector(dynamic_cast<xmlpp::Element*>(*iter));
+			seg.t2=parse_vector(&contents);
 		}
 		else
 		{
@@ -699,10 +696,10 @@ CanvasParser::parse_segment(xmlpp::Element *element)
 }
 
 BLinePoint
-CanvasParser::parse_bline_point(xmlpp::Element *element)
+CanvasParser::parse_bline_point(XMLElement *element)
 {
 	assert(element->get_name()=="bline_point");
-	if(element->get_children().empty())
+	if(!element->has_children())
 	{
 		error(element, "Undefined value in <bline_point>");
 		return BLinePoint();
@@ -711,137 +708,113 @@ CanvasParser::parse_bline_point(xmlpp::Element *element)
 	BLinePoint ret;
 	ret.set_split_tangent_both(false);
 
-	xmlpp::Element::NodeList list = element->get_children();
-	for(xmlpp::Element::NodeList::iterator iter = list.begin(); iter != list.end(); ++iter)
+	for(XMLElement iter(element); iter.next(); )
 	{
-		xmlpp::Element *child(dynamic_cast<xmlpp::Element*>(*iter));
-		if(!child)
-			continue;
-		else
+		XMLElement *child(&iter);
 		// Vertex
 		if(child->get_name()[0]=='v' || child->get_name()=="p1")
 		{
-			xmlpp::Element::NodeList list = child->get_children();
-			xmlpp::Element::NodeList::iterator iter;
+			XMLElement contents(child);
 
 			// Search for the first non-text XML element
-			for(iter = list.begin(); iter != list.end(); ++iter)
-				if(dynamic_cast<xmlpp::Element*>(*iter)) break;
-
-			if(iter==list.end())
+			if(!contents.next())
 			{
 				error(element, "Undefined value in <vertex>");
 				continue;
 			}
 
-			if((*iter)->get_name()!="vector")
+			if(contents.get_name()!="vector")
 			{
-				error_unexpected_element((*iter),(*iter)->get_name(),"vector");
+				error_unexpected_element(&contents,contents.get_name(),"vector");
 				continue;
 			}
 
-			ret.set_vertex(parse_vector(dynamic_cast<xmlpp::Element*>(*iter)));
+			ret.set_vertex(parse_vector(&contents));
 		}
 		else
 		// Tangent 1
 		if(child->get_name()=="t1" || child->get_name()=="tangent")
 		{
-			xmlpp::Element::NodeList list = child->get_children();
-			xmlpp::Element::NodeList::iterator iter;
+			XMLElement contents(child);
 
 			// Search for the first non-text XML element
-			for(iter = list.begin(); iter != list.end(); ++iter)
-				if(dynamic_cast<xmlpp::Element*>(*iter)) break;
-
-			if(iter==list.end())
+			if(!contents.next())
 			{
 				error(element, "Undefined value in <t1>");
 				continue;
 			}
 
-			if((*iter)->get_name()!="vector")
+			if(contents.get_name()!="vector")
 			{
-				error_unexpected_element((*iter),(*iter)->get_name(),"vector");
+				error_unexpected_element(&contents,contents.get_name(),"vector");
 				continue;
 			}
 
-			ret.set_tangent1(parse_vector(dynamic_cast<xmlpp::Element*>(*iter)));
+			ret.set_tangent1(parse_vector(&contents));
 		}
 		else
 		// Tangent 2
 		if(child->get_name()=="t2")
 		{
-			xmlpp::Element::NodeList list = child->get_children();
-			xmlpp::Element::NodeList::iterator iter;
+			XMLElement contents(child);
 
 			// Search for the first non-text XML element
-			for(iter = list.begin(); iter != list.end(); ++iter)
-				if(dynamic_cast<xmlpp::Element*>(*iter)) break;
-
-			if(iter==list.end())
+			if(!contents.next())
 			{
 				error(element, "Undefined value in <t2>");
 				continue;
 			}
 
-			if((*iter)->get_name()!="vector")
+			if(contents.get_name()!="vector")
 			{
-				error_unexpected_element((*iter),(*iter)->get_name(),"vector");
+				error_unexpected_element(&contents,contents.get_name(),"vector");
 				continue;
 			}
 
-			ret.set_tangent2(parse_vector(dynamic_cast<xmlpp::Element*>(*iter)));
+			ret.set_tangent2(parse_vector(&contents));
 			ret.set_split_tangent_both(true);
 		}
 		else
 		// width
 		if(child->get_name()=="width")
 		{
-			xmlpp::Element::NodeList list = child->get_children();
-			xmlpp::Element::NodeList::iterator iter;
+			XMLElement contents(child);
 
 			// Search for the first non-text XML element
-			for(iter = list.begin(); iter != list.end(); ++iter)
-				if(dynamic_cast<xmlpp::Element*>(*iter)) break;
-
-			if(iter==list.end())
+			if(!contents.next())
 			{
 				error(element, "Undefined value in <width>");
 				continue;
 			}
 
-			if((*iter)->get_name()!="real")
+			if(contents.get_name()!="real")
 			{
-				error_unexpected_element((*iter),(*iter)->get_name(),"real");
+				error_unexpected_element(&contents,contents.get_name(),"real");
 				continue;
 			}
 
-			ret.set_width(parse_real(dynamic_cast<xmlpp::Element*>(*iter)));
+			ret.set_width(parse_real(&contents));
 		}
 		else
 		// origin
 		if(child->get_name()=="origin")
 		{
-			xmlpp::Element::NodeList list = child->get_children();
-			xmlpp::Element::NodeList::iterator iter;
+			XMLElement contents(child);
 
 			// Search for the first non-text XML element
-			for(iter = list.begin(); iter != list.end(); ++iter)
-				if(dynamic_cast<xmlpp::Element*>(*iter)) break;
-
-			if(iter==list.end())
+			if(!contents.next())
 			{
 				error(element, "Undefined value in <origin>");
 				continue;
 			}
 
-			if((*iter)->get_name()!="real")
+			if(contents.get_name()!="real")
 			{
-				error_unexpected_element((*iter),(*iter)->get_name(),"real");
+				error_unexpected_element(&contents,contents.get_name(),"real");
 				continue;
 			}
 
-			ret.set_origin(parse_real(dynamic_cast<xmlpp::Element*>(*iter)));
+			ret.set_origin(parse_real(&contents));
 		}
 		else
 		{
@@ -853,11 +826,11 @@ CanvasParser::parse_bline_point(xmlpp::Element *element)
 }
 
 Transformation
-CanvasParser::parse_transformation(xmlpp::Element *element)
+CanvasParser::parse_transformation(XMLElement *element)
 {
 	assert(element->get_name()=="transformation");
 
-	if(element->get_children().empty())
+	if(!element->has_children())
 	{
 		error(element, "Undefined value in <transformation>");
 		return Transformation();
@@ -865,107 +838,87 @@ CanvasParser::parse_transformation(xmlpp::Element *element)
 
 	Transformation transformation;
 
-	xmlpp::Element::NodeList list = element->get_children();
-	for(xmlpp::Element::NodeList::iterator iter = list.begin(); iter != list.end(); ++iter)
+	for(XMLElement iter(element); iter.next(); )
 	{
-		xmlpp::Element *child(dynamic_cast<xmlpp::Element*>(*iter));
-		if(!child)
-			continue;
-		else
+		XMLElement *child(&iter);
 		if(child->get_name()=="offset")
 		{
-			xmlpp::Element::NodeList list = child->get_children();
-			xmlpp::Element::NodeList::iterator iter;
+			XMLElement contents(child);
 
 			// Search for the first non-text XML element
-			for(iter = list.begin(); iter != list.end(); ++iter)
-				if(dynamic_cast<xmlpp::Element*>(*iter)) break;
-
-			if(iter==list.end())
+			if(!contents.next())
 			{
 				error(element, "Undefined value in <offset>");
 				continue;
 			}
 
-			if((*iter)->get_name()!="vector")
+			if(contents.get_name()!="vector")
 			{
-				error_unexpected_element((*iter),(*iter)->get_name(),"vector");
+				error_unexpected_element(&contents,contents.get_name(),"vector");
 				continue;
 			}
 
-			transformation.offset=parse_vector(dynamic_cast<xmlpp::Element*>(*iter));
+			transformation.offset=parse_vector(&contents);
 		}
 		else
 		if(child->get_name()=="angle")
 		{
-			xmlpp::Element::NodeList list = child->get_children();
-			xmlpp::Element::NodeList::iterator iter;
+			XMLElement contents(child);
 
 			// Search for the first non-text XML element
-			for(iter = list.begin(); iter != list.end(); ++iter)
-				if(dynamic_cast<xmlpp::Element*>(*iter)) break;
-
-			if(iter==list.end())
+			if(!contents.next())
 			{
 				error(element, "Undefined value in <angle>");
 				continue;
 			}
 
-			if((*iter)->get_name()!="angle")
+			if(contents.get_name()!="angle")
 			{
-				error_unexpected_element((*iter),(*iter)->get_name(),"angle");
+				error_unexpected_element(&contents,contents.get_name(),"angle");
 				continue;
 			}
 
-			transformation.angle=parse_angle(dynamic_cast<xmlpp::Element*>(*iter));
+			transformation.angle=parse_angle(&contents);
 		}
 		else
 		if(child->get_name()=="skew_angle")
 		{
-			xmlpp::Element::NodeList list = child->get_children();
-			xmlpp::Element::NodeList::iterator iter;
+			XMLElement contents(child);
 
 			// Search for the first non-text XML element
-			for(iter = list.begin(); iter != list.end(); ++iter)
-				if(dynamic_cast<xmlpp::Element*>(*iter)) break;
-
-			if(iter==list.end())
+			if(!contents.next())
 			{
 				error(element, "Undefined value in <angle>");
 				continue;
 			}
 
-			if((*iter)->get_name()!="angle")
+			if(contents.get_name()!="angle")
 			{
-				error_unexpected_element((*iter),(*iter)->get_name(),"angle");
+				error_unexpected_element(&contents,contents.get_name(),"angle");
 				continue;
 			}
 
-			transformation.skew_angle=parse_angle(dynamic_cast<xmlpp::Element*>(*iter));
+			transformation.skew_angle=parse_angle(&contents);
 		}
 		else
 		if(child->get_name()=="scale")
 		{
-			xmlpp::Element::NodeList list = child->get_children();
-			xmlpp::Element::NodeList::iterator iter;
+			XMLElement contents(child);
 
 			// Search for the first non-text XML element
-			for(iter = list.begin(); iter != list.end(); ++iter)
-				if(dynamic_cast<xmlpp::Element*>(*iter)) break;
-
-			if(iter==list.end())
+			if(!contents.next())
 			{
 				error(element, "Undefined value in <scale>");
 				continue;
 			}
 
-			if((*iter)->get_name()!="vector")
+			if(contents.get_name()!="vector")
 			{
-				error_unexpected_element((*iter),(*iter)->get_name(),"vector");
+				error_unexpected_element(&contents,contents.get_name(),"vector");
 				continue;
 			}
 
-			transformation.scale=parse_vector(dynamic_cast<xmlpp::Element*>(*iter));
+			transformation.scale=parse_vector(&contents);
 		}
 		else
 		{
@@ -977,10 +930,10 @@ CanvasParser::parse_transformation(xmlpp::Element *element)
 }
 
 WidthPoint
-CanvasParser::parse_width_point(xmlpp::Element *element)
+CanvasParser::parse_width_point(XMLElement *element)
 {
 	assert(element->get_name()=="width_point");
-	if(element->get_children().empty())
+	if(!element->has_children())
 	{
 		error(element, "Undefined value in <width_point>");
 		return WidthPoint();
@@ -988,157 +941,129 @@ CanvasParser::parse_width_point(xmlpp::Element *element)
 
 	WidthPoint ret;
 
-	xmlpp::Element::NodeList list = element->get_children();
-	for(xmlpp::Element::NodeList::iterator iter = list.begin(); iter != list.end(); ++iter)
+	for(XMLElement iter(element); iter.next(); )
 	{
-		xmlpp::Element *child(dynamic_cast<xmlpp::Element*>(*iter));
-		if(!child)
-			continue;
-		else
+		XMLElement *child(&iter);
 		// Position
 		if(child->get_name()=="position")
 		{
-			xmlpp::Element::NodeList list = child->get_children();
-			xmlpp::Element::NodeList::iterator iter;
+			XMLElement contents(child);
 
 			// Search for the first non-text XML element
-			for(iter = list.begin(); iter != list.end(); ++iter)
-				if(dynamic_cast<xmlpp::Element*>(*iter)) break;
-
-			if(iter==list.end())
+			if(!contents.next())
 			{
 				error(element, "Undefined value in <position>");
 				continue;
 			}
 
-			if((*iter)->get_name()!="real")
+			if(contents.get_name()!="real")
 			{
-				error_unexpected_element((*iter),(*iter)->get_name(),"real");
+				error_unexpected_element(&contents,contents.get_name(),"real");
 				continue;
 			}
 
-			ret.set_position(parse_real(dynamic_cast<xmlpp::Element*>(*iter)));
+			ret.set_position(parse_real(&contents));
 		}
 		else
 		// Width
 		if(child->get_name()=="width")
 		{
-			xmlpp::Element::NodeList list = child->get_children();
-			xmlpp::Element::NodeList::iterator iter;
+			XMLElement contents(child);
 
 			// Search for the first non-text XML element
-			for(iter = list.begin(); iter != list.end(); ++iter)
-				if(dynamic_cast<xmlpp::Element*>(*iter)) break;
-
-			if(iter==list.end())
+			if(!contents.next())
 			{
 				error(element, "Undefined value in <width>");
 				continue;
 			}
 
-			if((*iter)->get_name()!="real")
+			if(contents.get_name()!="real")
 			{
-				error_unexpected_element((*iter),(*iter)->get_name(),"real");
+				error_unexpected_element(&contents,contents.get_name(),"real");
 				continue;
 			}
 
-			ret.set_width(parse_real(dynamic_cast<xmlpp::Element*>(*iter)));
+			ret.set_width(parse_real(&contents));
 		}
 		else
 		// Side type before
 		if(child->get_name()=="side_before")
 		{
-			xmlpp::Element::NodeList list = child->get_children();
-			xmlpp::Element::NodeList::iterator iter;
+			XMLElement contents(child);
 
 			// Search for the first non-text XML element
-			for(iter = list.begin(); iter != list.end(); ++iter)
-				if(dynamic_cast<xmlpp::Element*>(*iter)) break;
-
-			if(iter==list.end())
+			if(!contents.next())
 			{
 				error(element, "Undefined value in <side_before>");
 				continue;
 			}
 
-			if((*iter)->get_name()!="integer")
+			if(contents.get_name()!="integer")
 			{
-				error_unexpected_element((*iter),(*iter)->get_name(),"integer");
+				error_unexpected_element(&contents,contents.get_name(),"integer");
 				continue;
 			}
 
-			ret.set_side_type_before(parse_integer(dynamic_cast<xmlpp::Element*>(*iter)));
+			ret.set_side_type_before(parse_integer(&contents));
 		}
 		else
 		// Side type after
 		if(child->get_name()=="side_after")
 		{
-			xmlpp::Element::NodeList list = child->get_children();
-			xmlpp::Element::NodeList::iterator iter;
+			XMLElement contents(child);
 
 			// Search for the first non-text XML element
-			for(iter = list.begin(); iter != list.end(); ++iter)
-				if(dynamic_cast<xmlpp::Element*>(*iter)) break;
-
-			if(iter==list.end())
+			if(!contents.next())
 			{
 				error(element, "Undefined value in <side_after>");
 				continue;
 			}
-			if((*iter)->get_name()!="integer")
+			if(contents.get_name()!="integer")
 			{
-				error_unexpected_element((*iter),(*iter)->get_name(),"integer");
+				error_unexpected_element(&contents,contents.get_name(),"integer");
 				continue;
 			}
-			ret.set_side_type_after(parse_integer(dynamic_cast<xmlpp::Element*>(*iter)));
+			ret.set_side_type_after(parse_integer(&contents));
 		}
 		// Lower Boundary
 		if(child->get_name()=="lower_bound")
 		{
-			xmlpp::Element::NodeList list = child->get_children();
-			xmlpp::Element::NodeList::iterator iter;
+			XMLElement contents(child);
 
 			// Search for the first non-text XML element
-			for(iter = list.begin(); iter != list.end(); ++iter)
-				if(dynamic_cast<xmlpp::Element*>(*iter)) break;
-
-			if(iter==list.end())
+			if(!contents.next())
 			{
 				error(element, "Undefined value in <lower_bound>");
 				continue;
 			}
 
-			if((*iter)->get_name()!="real")
+			if(contents.get_name()!="real")
 			{
-				error_unexpected_element((*iter),(*iter)->get_name(),"real");
+				error_unexpected_element(&contents,contents.get_name(),"real");
 				continue;
 			}
 
-			ret.set_lower_bound(parse_real(dynamic_cast<xmlpp::Element*>(*iter)));
+			ret.set_lower_bound(parse_real(&contents));
 		}
 		// Upper Boundary
 		if(child->get_name()=="upper_bound")
 		{
-			xmlpp::Element::NodeList list = child->get_children();
-			xmlpp::Element::NodeList::iterator iter;
+			XMLElement contents(child);
 
 			// Search for the first non-text XML element
-			for(iter = list.begin(); iter != list.end(); ++iter)
-				if(dynamic_cast<xmlpp::Element*>(*iter)) break;
-
-			if(iter==list.end())
+			if(!contents.next())
 			{
 				error(element, "Undefined value in <upper_bound>");
 				continue;
 			}
 
-			if((*iter)->get_name()!="real")
+			if(contents.get_name()!="real")
 			{
-				error_unexpected_element((*iter),(*iter)->get_name(),"real");
+				error_unexpected_element(&contents,contents.get_name(),"real");
 				continue;
 			}
 
-			ret.set_upper_bound(parse_real(dynamic_cast<xmlpp::Element*>(*iter)));
+			ret.set_upper_bound(parse_real(&contents));
 		}
 		else
 			error_unexpected_element(child,child->get_name());
@@ -1147,10 +1072,10 @@ CanvasParser::parse_width_point(xmlpp::Element *element)
 }
 
 DashItem
-CanvasParser::parse_dash_item(xmlpp::Element *element)
+CanvasParser::parse_dash_item(XMLElement *element)
 {
 	assert(element->get_name()=="dash_item");
-	if(element->get_children().empty())
+	if(!element->has_children())
 	{
 		error(element, "Undefined value in <dash_item>");
 		return DashItem();
@@ -1158,109 +1083,89 @@ CanvasParser::parse_dash_item(xmlpp::Element *element)
 
 	DashItem ret;
 
-	xmlpp::Element::NodeList list = element->get_children();
-	for(xmlpp::Element::NodeList::iterator iter = list.begin(); iter != list.end(); ++iter)
+	for(XMLElement iter(element); iter.next(); )
 	{
-		xmlpp::Element *child(dynamic_cast<xmlpp::Element*>(*iter));
-		if(!child)
-			continue;
-		else
+		XMLElement *child(&iter);
 		// Offset
 		if(child->get_name()=="offset")
 		{
-			xmlpp::Element::NodeList list = child->get_children();
-			xmlpp::Element::NodeList::iterator iter;
+			XMLElement contents(child);
 
 			// Search for the first non-text XML element
-			for(iter = list.begin(); iter != list.end(); ++iter)
-				if(dynamic_cast<xmlpp::Element*>(*iter)) break;
-
-			if(iter==list.end())
+			if(!contents.next())
 			{
 				error(element, "Undefined value in <offset>");
 				continue;
 			}
 
-			if((*iter)->get_name()!="real")
+			if(contents.get_name()!="real")
 			{
-				error_unexpected_element((*iter),(*iter)->get_name(),"real");
+				error_unexpected_element(&contents,contents.get_name(),"real");
 				continue;
 			}
 
-			ret.set_offset(parse_real(dynamic_cast<xmlpp::Element*>(*iter)));
+			ret.set_offset(parse_real(&contents));
 		}
 		else
 		// Length
 		if(child->get_name()=="length")
 		{
-			xmlpp::Element::NodeList list = child->get_children();
-			xmlpp::Element::NodeList::iterator iter;
+			XMLElement contents(child);
 
 			// Search for the first non-text XML element
-			for(iter = list.begin(); iter != list.end(); ++iter)
-				if(dynamic_cast<xmlpp::Element*>(*iter)) break;
-
-			if(iter==list.end())
+			if(!contents.next())
 			{
 				error(element, "Undefined value in <length>");
 				continue;
 			}
 
-			if((*iter)->get_name()!="real")
+			if(contents.get_name()!="real")
 			{
-				error_unexpected_element((*iter),(*iter)->get_name(),"real");
+				error_unexpected_element(&contents,contents.get_name(),"real");
 				continue;
 			}
 
-			ret.set_length(parse_real(dynamic_cast<xmlpp::Element*>(*iter)));
+			ret.set_length(parse_real(&contents));
 		}
 		else
 		// Side type before
 		if(child->get_name()=="side_before")
 		{
-			xmlpp::Element::NodeList list = child->get_children();
-			xmlpp::Element::NodeList::iterator iter;
+			XMLElement contents(child);
 
 			// Search for the first non-text XML element
-			for(iter = list.begin(); iter != list.end(); ++iter)
-				if(dynamic_cast<xmlpp::Element*>(*iter)) break;
-
-			if(iter==list.end())
+			if(!contents.next())
 			{
 				error(element, "Undefined value in <side_before>");
 				continue;
 			}
 
-			if((*iter)->get_name()!="integer")
+			if(contents.get_name()!="integer")
 			{
-				error_unexpected_element((*iter),(*iter)->get_name(),"integer");
+				error_unexpected_element(&contents,contents.get_name(),"integer");
 				continue;
 			}
 
-			ret.set_side_type_before(parse_integer(dynamic_cast<xmlpp::Element*>(*iter)));
+			ret.set_side_type_before(parse_integer(&contents));
 		}
 		else
 		// Side type after
 		if(child->get_name()=="side_after")
 		{
-			xmlpp::Element::NodeList list = child->get_children();
-			xmlpp::Element::NodeList::iterator iter;
+			XMLElement contents(child);
 
 			// Search for the first non-text XML element
-			for(iter = list.begin(); iter != list.end(); ++iter)
-				if(dynamic_cast<xmlpp::Element*>(*iter)) break;
-
-			if(iter==list.end())
+			if(!contents.next())
 			{
 				error(element, "Undefined value in <side_after>");
 				continue;
 			}
-			if((*iter)->get_name()!="integer")
+			if(contents.get_name()!="integer")
 			{
-				error_unexpected_element((*iter),(*iter)->get_name(),"integer");
+				error_unexpected_element(&contents,contents.get_name(),"integer");
 				continue;
 			}
-			ret.set_side_type_after(parse_integer(dynamic_cast<xmlpp::Element*>(*iter)));
+			ret.set_side_type_after(parse_integer(&contents));
 		}
 		else
 			error_unexpected_element(child,child->get_name());
@@ -1271,11 +1176,11 @@ CanvasParser::parse_dash_item(xmlpp::Element *element)
 
 
 Angle
-CanvasParser::parse_angle(xmlpp::Element *element)
+CanvasParser::parse_angle(XMLElement *element)
 {
 	assert(element->get_name()=="angle");
 
-	if(!element->get_children().empty())
+	if(element->has_children())
 		warning(element, strprintf(_("<%s> should not contain anything"),"angle"));
 
 	if(!element->get_attribute("value"))
@@ -1284,17 +1189,17 @@ CanvasParser::parse_angle(xmlpp::Element *element)
 		return Angle();
 	}
 
-	string val=element->get_attribute("value")->get_value();
+	const String &val=element->get_attribute("value")->get_value();
 
 	return Angle::deg(atof(val.c_str()));
 }
 
 ValueBase
-CanvasParser::parse_weighted_value(xmlpp::Element *element, types_namespace::TypeWeightedValueBase &type, Canvas::Handle canvas)
+CanvasParser::parse_weighted_value(XMLElement *element, types_namespace::TypeWeightedValueBase &type, Canvas::Handle canvas)
 {
 	assert(element->get_name()==type.description.name);
 
-	if(element->get_children().empty())
+	if(!element->has_children())
 	{
 		error(element, "Undefined value in <" + type.description.name + ">");
 		return ValueBase();
@@ -1303,59 +1208,47 @@ CanvasParser::parse_weighted_value(xmlpp::Element *element, types_namespace::Typ
 	Real weight = 0.0;
 	ValueBase value;
 
-	xmlpp::Element::NodeList list = element->get_children();
-	for(xmlpp::Element::NodeList::iterator iter = list.begin(); iter != list.end(); ++iter)
+	for(XMLElement iter(element); iter.next(); )
 	{
-		xmlpp::Element *child(dynamic_cast<xmlpp::Element*>(*iter));
-		if(!child)
-			continue;
-		else
+		XMLElement *child(&iter);
 		if(child->get_name()=="weight")
 		{
-			xmlpp::Element::NodeList list = child->get_children();
-			xmlpp::Element::NodeList::iterator iter;
+			XMLElement contents(child);
 
 			// Search for the first non-text XML element
-			for(iter = list.begin(); iter != list.end(); ++iter)
-				if(dynamic_cast<xmlpp::Element*>(*iter)) break;
-
-			if(iter==list.end())
+			if(!contents.next())
 			{
 				error(element, "Undefined value in <weight>");
 				continue;
 			}
 
-			if((*iter)->get_name()!="real")
+			if(contents.get_name()!="real")
 			{
-				error_unexpected_element((*iter),(*iter)->get_name(),"real");
+				error_unexpected_element(&contents,contents.get_name(),"real");
 				continue;
 			}
 
-			weight = parse_real(dynamic_cast<xmlpp::Element*>(*iter));
+			weight = parse_real(&contents);
 		}
 		else
 		if(child->get_name()=="value")
 		{
-			xmlpp::Element::NodeList list = child->get_children();
-			xmlpp::Element::NodeList::iterator iter;
+			XMLElement contents(child);
 
 			// Search for the first non-text XML element
-			for(iter = list.begin(); iter != list.end(); ++iter)
-				if(dynamic_cast<xmlpp::Element*>(*iter)) break;
-
-			if(iter==list.end())
+			if(!contents.next())
 			{
 				error(element, "Undefined value in <value>");
 				continue;
 			}
 
-			if((*iter)->get_name()!=type.get_contained_type().description.name)
+			if(contents.get_name()!=type.get_contained_type().description.name)
 			{
-				error_unexpected_element((*iter),(*iter)->get_name(),type.get_contained_type().description.name);
+				error_unexpected_element(&contents,contents.get_name(),type.get_contained_type().description.name);
 				continue;
 			}
 
-			value = parse_value(dynamic_cast<xmlpp::Element*>(*iter),canvas);
+			value = parse_value(&contents,canvas);
 		}
 		else
 		{
@@ -1368,11 +1261,11 @@ CanvasParser::parse_weighted_value(xmlpp::Element *element, types_namespace::Typ
 }
 
 ValueBase
-CanvasParser::parse_pair(xmlpp::Element *element, types_namespace::TypePairBase &type, Canvas::Handle canvas)
+CanvasParser::parse_pair(XMLElement *element, types_namespace::TypePairBase &type, Canvas::Handle canvas)
 {
 	assert(element->get_name()==type.description.name);
 
-	if(element->get_children().empty())
+	if(!element->has_children())
 	{
 		error(element, "Undefined value in <" + type.description.name + ">");
 		return ValueBase();
@@ -1381,59 +1274,47 @@ CanvasParser::parse_pair(xmlpp::Element *element, types_namespace::TypePairBase
 	ValueBase first;
 	ValueBase second;
 
-	xmlpp::Element::NodeList list = element->get_children();
-	for(xmlpp::Element::NodeList::iterator iter = list.begin(); iter != list.end(); ++iter)
+	for(XMLElement iter(element); iter.next(); )
 	{
-		xmlpp::Element *child(dynamic_cast<xmlpp::Element*>(*iter));
-		if(!child)
-			continue;
-		else
+		XMLElement *child(&iter);
 		if(child->get_name()=="first")
 		{
-			xmlpp::Element::NodeList list = child->get_children();
-			xmlpp::Element::NodeList::iterator iter;
+			XMLElement contents(child);
 
 			// Search for the first non-text XML element
-			for(iter = list.begin(); iter != list.end(); ++iter)
-				if(dynamic_cast<xmlpp::Element*>(*iter)) break;
-
-			if(iter==list.end())
+			if(!contents.next())
 			{
 				error(element, "Undefined value in <first>");
 				continue;
 			}
 
-			if((*iter)->get_name()!=type.get_first_type().description.name)
+			if(contents.get_name()!=type.get_first_type().description.name)
 			{
-				error_unexpected_element((*iter),(*iter)->get_name(),type.get_first_type().description.name);
+				error_unexpected_element(&contents,contents.get_name(),type.get_first_type().description.name);
 				continue;
 			}
 
-			first = parse_value(dynamic_cast<xmlpp::Element*>(*iter),canvas);
+			first = parse_value(&contents,canvas);
 		}
 		else
 		if(child->get_name()=="second")
 		{
-			xmlpp::Element::NodeList list = child->get_children();
-			xmlpp::Element::NodeList::iterator iter;
+			XMLElement contents(child);
 
 			// Search for the first non-text XML element
-			for(iter = list.begin(); iter != list.end(); ++iter)
-				if(dynamic_cast<xmlpp::Element*>(*iter)) break;
-
-			if(iter==list.end())
+			if(!contents.next())
 			{
 				error(element, "Undefined value in <second>");
 				continue;
 			}
 
-			if((*iter)->get_name()!=type.get_second_type().description.name)
+			if(contents.get_name()!=type.get_second_type().description.name)
 			{
-				error_unexpected_element((*iter),(*iter)->get_name(),type.get_second_type().description.name);
+				error_unexpected_element(&contents,contents.get_name(),type.get_second_type().description.name);
 				continue;
 			}
 
-			second = parse_value(dynamic_cast<xmlpp::Element*>(*iter),canvas);
+			second = parse_value(&contents,canvas);
 		}
 		else
 		{
@@ -1446,12 +1327,12 @@ CanvasParser::parse_pair(xmlpp::Element *element, types_namespace::TypePairBase
 }
 
 Interpolation
-CanvasParser::parse_interpolation(xmlpp::Element *element,String attribute)
+CanvasParser::parse_interpolation(XMLElement *element,String attribute)
 {
 	if(!element->get_attribute(attribute))
 		return INTERPOLATION_UNDEFINED;
 	
-	string val=element->get_attribute(attribute)->get_value();
+	const String &val=element->get_attribute(attribute)->get_value();
 	if(val=="halt")
 		return INTERPOLATION_HALT;
 	else if(val=="constant")
@@ -1471,12 +1352,12 @@ CanvasParser::parse_interpolation(xmlpp::Element *element,String attribute)
 }
 
 bool
-CanvasParser::parse_static(xmlpp::Element *element)
+CanvasParser::parse_static(XMLElement *element)
 {
 	if(!element->get_attribute("static"))
 		return false;
 
-	string val=element->get_attribute("static")->get_value();
+	const String &val=element->get_attribute("static")->get_value();
 
 	if(val=="true" || val=="1")
 		return true;
@@ -1490,7 +1371,7 @@ CanvasParser::parse_static(xmlpp::Element *element)
 
 
 ValueBase
-CanvasParser::parse_value(xmlpp::Element *element,Canvas::Handle canvas)
+CanvasParser::parse_value(XMLElement *element,Canvas::Handle canvas)
 {
 	if(element->get_name()=="real")
 	{
@@ -1654,7 +1535,7 @@ CanvasParser::parse_value(xmlpp::Element *element,Canvas::Handle canvas)
 
 
 ValueNode_Animated::Handle
-CanvasParser::parse_animated(xmlpp::Element *element,Canvas::Handle canvas)
+CanvasParser::parse_animated(XMLElement *element,Canvas::Handle canvas)
 {
 	assert(element->get_name()=="hermite" || element->get_name()=="animated");
 
@@ -1687,13 +1568,9 @@ CanvasParser::parse_animated(xmlpp::Element *element,Canvas::Handle canvas)
 		value_node->set_interpolation(parse_interpolation(element, "interpolation"));
 	}
 
-	xmlpp::Element::NodeList list = element->get_children();
-	for(xmlpp::Element::NodeList::iterator iter = list.begin(); iter != list.end(); ++iter)
+	for(XMLElement iter(element); iter.next(); )
 	{
-		xmlpp::Element *child(dynamic_cast<xmlpp::Element*>(*iter));
-		if(!child)
-			continue;
-		else
+		XMLElement *child(&iter);
 		if(child->get_name()=="waypoint")
 		{
 			if(!child->get_attribute("time"))
@@ -1706,11 +1583,11 @@ CanvasParser::parse_animated(xmlpp::Element *element,Canvas::Handle canvas)
 
 
 			ValueNode::Handle waypoint_value_node;
-			xmlpp::Element::NodeList list = child->get_children();
+			XMLElement contents(child);
 
 			if(child->get_attribute("use"))
 			{
-				if(!list.empty())
+				if(child->has_children())
 					warning(child,_("Found \"use\" attribute for <waypoint>, but it wasn't empty. Ignoring contents..."));
 
 				// the waypoint might look like this, in which case we won't find "mycanvas" in the list of valuenodes, 'cos it's a canvas
@@ -1731,28 +1608,23 @@ CanvasParser::parse_animated(xmlpp::Element *element,Canvas::Handle canvas)
 			}
 			else
 			{
-				if(child->get_children().empty())
+				if(!child->has_children())
 				{
 					error(child, strprintf(_("<%s> is missing its data"),"waypoint"));
 					continue;
 				}
 
-				xmlpp::Element::NodeList::iterator iter;
-
 				// Search for the first non-text XML element
-				for(iter = list.begin(); iter != list.end(); ++iter)
-					if(dynamic_cast<xmlpp::Element*>(*iter)) break;
-
-				if(iter==list.end())
+				if(!contents.next())
 				{
 					error(child, strprintf(_("<%s> is missing its data"),"waypoint"));
 					continue;
 				}
 
-				waypoint_value_node=parse_value_node(dynamic_cast<xmlpp::Element*>(*iter),canvas);
+				waypoint_value_node=parse_value_node(&contents,canvas);
 
 				/*
-				ValueBase data=parse_value(dynamic_cast<xmlpp::Element*>(*iter),canvas);
+				ValueBase data=parse_value(&contents,canvas);
 
 				if(!data.is_valid())
 				{
@@ -1776,9 +1648,8 @@ CanvasParser::parse_animated(xmlpp::Element *element,Canvas::Handle canvas)
 				//note: commented out as part of bones branch merge
 
 				// Warn if there is trash after the param value
-				for(iter++; iter != list.end(); ++iter)
-					if(dynamic_cast<xmlpp::Element*>(*iter))
-						warning((*iter),strprintf(_("Unexpected element <%s> after <waypoint> data, ignoring..."),(*iter)->get_name().c_str()));
+				while(contents.next())
+					warning(&contents,strprintf(_("Unexpected element <%s> after <waypoint> data, ignoring..."),contents.get_name().c_str()));
 			}
 
 
@@ -1787,23 +1658,19 @@ CanvasParser::parse_animated(xmlpp::Element *element,Canvas::Handle canvas)
 
 			if(child->get_attribute("tension"))
 			{
-				synfig::String str(child->get_attribute("tension")->get_value());
-				waypoint->set_tension(atof(str.c_str()));
+				waypoint->set_tension(atof(child->get_attribute("tension")->get_value().c_str()));
 			}
 			if(child->get_attribute("temporal-tension"))
 			{
-				synfig::String str(child->get_attribute("temporal-tension")->get_value());
-				waypoint->set_temporal_tension(atof(str.c_str()));
+				waypoint->set_temporal_tension(atof(child->get_attribute("temporal-tension")->get_value().c_str()));
 			}
 			if(child->get_attribute("continuity"))
 			{
-				synfig::String str(child->get_attribute("continuity")->get_value());
-				waypoint->set_continuity(atof(str.c_str()));
+				waypoint->set_continuity(atof(child->get_attribute("continuity")->get_value().c_str()));
 			}
 			if(child->get_attribute("bias"))
 			{
-				synfig::String str(child->get_attribute("bias")->get_value());
-				waypoint->set_bias(atof(str.c_str()));
+				waypoint->set_bias(atof(child->get_attribute("bias")->get_value().c_str()));
 			}
 
 			if(child->get_attribute("before"))
@@ -1872,7 +1739,7 @@ CanvasParser::parse_animated(xmlpp::Element *element,Canvas::Handle canvas)
 }
 
 etl::handle<LinkableValueNode>
-CanvasParser::parse_linkable_value_node(xmlpp::Element *element,Canvas::Handle canvas)
+CanvasParser::parse_linkable_value_node(XMLElement *element,Canvas::Handle canvas)
 {
 	if (getenv("SYNFIG_DEBUG_LOAD_CANVAS")) printf("%s:%d parse_linkable_value_node\n", __FILE__, __LINE__);
 
@@ -1921,11 +1788,10 @@ CanvasParser::parse_linkable_value_node(xmlpp::Element *element,Canvas::Handle c
 	{
 		int index;
 		String id, name;
-		xmlpp::Element::AttributeList attrib_list(element->get_attributes());
-		for(xmlpp::Element::AttributeList::iterator iter = attrib_list.begin(); iter != attrib_list.end(); iter++)
+		for(int i = 0; i < element->get_attribute_count(); i++)
 		{
-			name = (*iter)->get_name();
-			id = (*iter)->get_value();
+			name = element->get_attribute_at(i).get_name();
+			id = element->get_attribute_at(i).get_value();
 
 			if (name == "guid" || name == "id" || name == "type")
 				continue;
@@ -2007,15 +1873,11 @@ CanvasParser::parse_linkable_value_node(xmlpp::Element *element,Canvas::Handle c
 	{
 		int index;
 		String child_name;
-		xmlpp::Element::NodeList list = element->get_children();
-		for(xmlpp::Element::NodeList::iterator iter = list.begin(); iter != list.end(); ++iter)
+		for(XMLElement iter(element); iter.next(); )
 		{
-			xmlpp::Element *child(dynamic_cast<xmlpp::Element*>(*iter));
+			XMLElement *child(&iter);
 			try
 			{
-				if(!child)
-					continue;
-
 				child_name = child->get_name();
 
 				bool load_old_weighted_bonelink = false;
@@ -2035,25 +1897,21 @@ CanvasParser::parse_linkable_value_node(xmlpp::Element *element,Canvas::Handle c
 					break;
 				}
 
-				xmlpp::Element::NodeList list = child->get_children();
-				xmlpp::Element::NodeList::iterator iter;
+				XMLElement contents(child);
 
 				// Search for the first non-text XML element
-				for(iter = list.begin(); iter != list.end(); ++iter)
-					if(dynamic_cast<xmlpp::Element*>(*iter)) break;
-
-				if(iter==list.end())
+				if(!contents.next())
 				{
 					error(child,strprintf(_("element <%s> is missing its contents"),
 										  child_name.c_str()));
 					continue;
 				}
 
-				c[index]=parse_value_node(dynamic_cast<xmlpp::Element*>(*iter),canvas);
+				c[index]=parse_value_node(&contents,canvas);
 
 				if(!c[index])
 				{
-					error((*iter),strprintf(_("Parse of '%s' failed"),
+					error(&contents,strprintf(_("Parse of '%s' failed"),
 											child_name.c_str()));
 					continue;
 				}
@@ -2214,7 +2072,7 @@ CanvasParser::parse_linkable_value_node(xmlpp::Element *element,Canvas::Handle c
 }
 
 handle<ValueNode_StaticList>
-CanvasParser::parse_static_list(xmlpp::Element *element,Canvas::Handle canvas)
+CanvasParser::parse_static_list(XMLElement *element,Canvas::Handle canvas)
 {
 	assert(element->get_name()=="static_list");
 
@@ -2244,13 +2102,9 @@ CanvasParser::parse_static_list(xmlpp::Element *element,Canvas::Handle canvas)
 
 	value_node->set_root_canvas(canvas->get_root());
 
-	xmlpp::Element::NodeList list = element->get_children();
-	for(xmlpp::Element::NodeList::iterator iter = list.begin(); iter != list.end(); ++iter)
+	for(XMLElement iter(element); iter.next(); )
 	{
-		xmlpp::Element *child(dynamic_cast<xmlpp::Element*>(*iter));
-		if(!child)
-			continue;
-		else
+		XMLElement *child(&iter);
 		if(child->get_name()=="entry")
 		{
 			ValueNode::Handle list_entry;
@@ -2271,23 +2125,19 @@ CanvasParser::parse_static_list(xmlpp::Element *element,Canvas::Handle canvas)
 			}
 			else
 			{
-				xmlpp::Element::NodeList list = child->get_children();
-				xmlpp::Element::NodeList::iterator iter;
+				XMLElement contents(child);
 
 				// Search for the first non-text XML element
-				for(iter = list.begin(); iter != list.end(); ++iter)
-					if(dynamic_cast<xmlpp::Element*>(*iter)) break;
-
-				if(iter==list.end())
+				if(!contents.next())
 				{
 					error(child,strprintf(_("<entry> is missing its contents or missing \"use\" element")));
 					continue;
 				}
 
-				list_entry=parse_value_node(dynamic_cast<xmlpp::Element*>(*iter),canvas);
+				list_entry=parse_value_node(&contents,canvas);
 
 				if(!list_entry)
-					error((*iter),"Parse of ValueNode failed");
+					error(&contents,"Parse of ValueNode failed");
 
 				// \todo do a search for more elements and warn if they are found
 
@@ -2306,7 +2156,7 @@ CanvasParser::parse_static_list(xmlpp::Element *element,Canvas::Handle canvas)
 
 // This will also parse a bline
 handle<ValueNode_DynamicList>
-CanvasParser::parse_dynamic_list(xmlpp::Element *element,Canvas::Handle canvas)
+CanvasParser::parse_dynamic_list(XMLElement *element,Canvas::Handle canvas)
 {
 	assert(element->get_name()=="dynamic_list" ||
 		element->get_name()=="bline" ||
@@ -2397,13 +2247,9 @@ CanvasParser::parse_dynamic_list(xmlpp::Element *element,Canvas::Handle canvas)
 
 	value_node->set_root_canvas(canvas->get_root());
 
-	xmlpp::Element::NodeList list = element->get_children();
-	for(xmlpp::Element::NodeList::iterator iter = list.begin(); iter != list.end(); ++iter)
+	for(XMLElement iter(element); iter.next(); )
 	{
-		xmlpp::Element *child(dynamic_cast<xmlpp::Element*>(*iter));
-		if(!child)
-			continue;
-		else
+		XMLElement *child(&iter);
 		if(child->get_name()=="entry")
 		{
 			ValueNode_DynamicList::ListEntry list_entry;
@@ -2534,23 +2380,19 @@ CanvasParser::parse_dynamic_list(xmlpp::Element *element,Canvas::Handle canvas)
 			}
 			else
 			{
-				xmlpp::Element::NodeList list = child->get_children();
-				xmlpp::Element::NodeList::iterator iter;
+				XMLElement contents(child);
 
 				// Search for the first non-text XML element
-				for(iter = list.begin(); iter != list.end(); ++iter)
-					if(dynamic_cast<xmlpp::Element*>(*iter)) break;
-
-				if(iter==list.end())
+				if(!contents.next())
 				{
 					error(child,strprintf(_("<entry> is missing its contents or missing \"use\" element")));
 					continue;
 				}
 
-				list_entry.value_node=parse_value_node(dynamic_cast<xmlpp::Element*>(*iter),canvas);
+				list_entry.value_node=parse_value_node(&contents,canvas);
 
 				if(!list_entry.value_node)
-					error((*iter),"Parse of ValueNode failed");
+					error(&contents,"Parse of ValueNode failed");
 
 				// \todo do a search for more elements and warn if they are found
 
@@ -2569,7 +2411,7 @@ CanvasParser::parse_dynamic_list(xmlpp::Element *element,Canvas::Handle canvas)
 }
 
 handle<ValueNode>
-CanvasParser::parse_value_node(xmlpp::Element *element,Canvas::Handle canvas)
+CanvasParser::parse_value_node(XMLElement *element,Canvas::Handle canvas)
 {
 	if (getenv("SYNFIG_DEBUG_LOAD_CANVAS")) printf("%s:%d parse_value_node\n", __FILE__, __LINE__);
 	handle<ValueNode> value_node;
@@ -2722,17 +2564,13 @@ CanvasParser::parse_value_node(xmlpp::Element *element,Canvas::Handle canvas)
 }
 
 void
-CanvasParser::parse_canvas_defs(xmlpp::Element *element,Canvas::Handle canvas)
+CanvasParser::parse_canvas_defs(XMLElement *element,Canvas::Handle canvas)
 {
 	if (getenv("SYNFIG_DEBUG_LOAD_CANVAS")) printf("%s:%d parse_canvas_defs\n", __FILE__, __LINE__);
 	assert(element->get_name()=="defs");
-	xmlpp::Element::NodeList list = element->get_children();
-	for(xmlpp::Element::NodeList::iterator iter = list.begin(); iter != list.end(); ++iter)
+	for(XMLElement iter(element); iter.next(); )
 	{
-		xmlpp::Element *child(dynamic_cast<xmlpp::Element*>(*iter));
-		if(!child)
-			continue;
-		else
+		XMLElement *child(&iter);
 		if(child->get_name()=="canvas")
 			parse_canvas(child, canvas);
 		else
@@ -2742,26 +2580,22 @@ CanvasParser::parse_canvas_defs(xmlpp::Element *element,Canvas::Handle canvas)
 }
 
 std::list<ValueNode::Handle>
-CanvasParser::parse_canvas_bones(xmlpp::Element *element,Canvas::Handle canvas)
+CanvasParser::parse_canvas_bones(XMLElement *element,Canvas::Handle canvas)
 {
 	if (getenv("SYNFIG_DEBUG_LOAD_CANVAS")) printf("%s:%d parse_canvas_bones\n", __FILE__, __LINE__);
 	assert(element->get_name()=="bones");
-	xmlpp::Element::NodeList list = element->get_children();
 	std::list<ValueNode::Handle> bone_list;
-	for(xmlpp::Element::NodeList::iterator iter = list.begin(); iter != list.end(); ++iter)
+	for(XMLElement iter(element); iter.next(); )
 	{
-		xmlpp::Element *child(dynamic_cast<xmlpp::Element*>(*iter));
-		if(!child)
-			continue;
-		else
-			bone_list.push_back(parse_value_node(child,canvas));
+		XMLElement *child(&iter);
+		bone_list.push_back(parse_value_node(child,canvas));
 	}
 	if (getenv("SYNFIG_DEBUG_LOAD_CANVAS")) printf("%s:%d parse_canvas_bones done\n", __FILE__, __LINE__);
 	return bone_list;
 }
 
 Layer::Handle
-CanvasParser::parse_layer(xmlpp::Element *element,Canvas::Handle canvas)
+CanvasParser::parse_layer(XMLElement *element,Canvas::Handle canvas)
 {
 
 	assert(element->get_name()=="layer");
@@ -2830,13 +2664,9 @@ CanvasParser::parse_layer(xmlpp::Element *element,Canvas::Handle canvas)
 		scale_scalar_node->set_link("scalar", scale_node);
 	}
 
-	xmlpp::Element::NodeList list = element->get_children();
-	for(xmlpp::Element::NodeList::iterator iter = list.begin(); iter != list.end(); ++iter)
+	for(XMLElement iter(element); iter.next(); )
 	{
-		xmlpp::Element *child(dynamic_cast<xmlpp::Element*>(*iter));
-		if(!child)
-			continue;
-		else
+		XMLElement *child(&iter);
 		if(child->get_name()=="name")
 			warning(child,_("<name> entry for <layer> is not yet supported. Ignoring..."));
 		else
@@ -2845,7 +2675,7 @@ CanvasParser::parse_layer(xmlpp::Element *element,Canvas::Handle canvas)
 		else
 		if(child->get_name()=="param")
 		{
-			xmlpp::Element::NodeList list = child->get_children();
+			XMLElement contents(child);
 
 			if(!child->get_attribute("name"))
 			{
@@ -2865,7 +2695,7 @@ CanvasParser::parse_layer(xmlpp::Element *element,Canvas::Handle canvas)
 				// If the "use" attribute is used, then the
 				// element should be empty. Warn the user if
 				// we find otherwise.
-				if(!list.empty())
+				if(child->has_children())
 					warning(child,_("Found \"use\" attribute for <param>, but it wasn't empty. Ignoring contents..."));
 
 				String str=	child->get_attribute("use")->get_value();
@@ -2877,9 +2707,9 @@ CanvasParser::parse_layer(xmlpp::Element *element,Canvas::Handle canvas)
 					String warnings;
 					Canvas::Handle c(canvas->surefind_canvas(str, warnings));
 					warnings_text += warnings;
-					if(!c) error((*iter),strprintf(_("Failed to load subcanvas '%s'"), str.c_str()));
+					if(!c) error(child,strprintf(_("Failed to load subcanvas '%s'"), str.c_str()));
 					if(!layer->set_param(param_name,c))
-						error((*iter),_("Layer rejected canvas link"));
+						error(child,_("Layer rejected canvas link"));
 					//Parse the static option and sets it to the canvas ValueBase
 					ValueBase v=layer->get_param(param_name);
 					v.set_static(parse_static(child));
@@ -2938,15 +2768,8 @@ CanvasParser::parse_layer(xmlpp::Element *element,Canvas::Handle canvas)
 				continue;
 			}
 
-			xmlpp::Element::NodeList::iterator iter;
-
 			// Search for the first non-text XML element
-			for(iter = list.begin(); iter != list.end(); ++iter)
-				if(dynamic_cast<xmlpp::Element*>(*iter))
-					break;
-				//if(!(!dynamic_cast<xmlpp::Element*>(*iter) && (*iter)->get_name()=="text"||(*iter)->get_name()=="comment"   )) break;
-
-			if(iter==list.end())
+			if(!contents.next())
 			{
 				error(child,_("<param> is either missing its contents, or missing a \"use\" attribute."));
 				continue;
@@ -2957,23 +2780,23 @@ CanvasParser::parse_layer(xmlpp::Element *element,Canvas::Handle canvas)
 
 			// If we recognize the element name as a
 			// ValueBase, then treat is at one
-			if(/*(*iter)->get_name()!="canvas" && */ValueBase::ident_type((*iter)->get_name()) != type_nil && !dynamic_cast<xmlpp::Element*>(*iter)->get_attribute("guid"))
+			if(/*contents.get_name()!="canvas" && */ValueBase::ident_type(contents.get_name()) != type_nil && !contents.get_attribute("guid"))
 			{
-				data=parse_value(dynamic_cast<xmlpp::Element*>(*iter),canvas);
+				data=parse_value(&contents,canvas);
 
 				if(!data.is_valid())
 				{
-					error((*iter),_("Bad data for <param>"));
+					error(&contents,_("Bad data for <param>"));
 					continue;
 				}
 			}
 			else	// ... otherwise, we assume that it is a ValueNode
 			{
-				value_node=parse_value_node(dynamic_cast<xmlpp::Element*>(*iter),canvas);
+				value_node=parse_value_node(&contents,canvas);
 
 				if(!value_node)
 				{
-					error((*iter),_("Bad data for <param>"));
+					error(&contents,_("Bad data for <param>"));
 					continue;
 				}
 			}
@@ -3018,7 +2841,7 @@ CanvasParser::parse_layer(xmlpp::Element *element,Canvas::Handle canvas)
 					// the layer liked it
 					if(!layer->set_param(param_name,data))
 					{
-						warning((*iter),strprintf(_("Layer '%s' rejected value for parameter '%s'"),
+						warning(&contents,strprintf(_("Layer '%s' rejected value for parameter '%s'"),
 												  element->get_attribute("type")->get_value().c_str(),
 												  param_name.c_str()));
 						continue;
@@ -3027,9 +2850,8 @@ CanvasParser::parse_layer(xmlpp::Element *element,Canvas::Handle canvas)
 			}
 
 			// Warn if there is trash after the param value
-			for(iter++; iter != list.end(); ++iter)
-				if(dynamic_cast<xmlpp::Element*>(*iter))
-					warning((*iter),strprintf(_("Unexpected element <%s> after <param> data, ignoring..."),(*iter)->get_name().c_str()));
+			while(contents.next())
+				warning(&contents,strprintf(_("Unexpected element <%s> after <param> data, ignoring..."),contents.get_name().c_str()));
 			continue;
 		}
 		else
@@ -3084,7 +2906,7 @@ CanvasParser::parse_layer(xmlpp::Element *element,Canvas::Handle canvas)
 }
 
 Canvas::Handle
-CanvasParser::parse_canvas(xmlpp::Element *element,Canvas::Handle parent,bool inline_,const FileSystem::Identifier &identifier,String filename)
+CanvasParser::parse_canvas(XMLElement *element,Canvas::Handle parent,bool inline_,const FileSystem::Identifier &identifier,String filename)
 {
 
 	if(element->get_name()!="canvas")
@@ -3182,17 +3004,14 @@ CanvasParser::parse_canvas(xmlpp::Element *element,Canvas::Handle parent,bool in
 
 	if(element->get_attribute("view-box"))
 	{
-		string values=element->get_attribute("view-box")->get_value();
+		const char *values=element->get_attribute("view-box")->get_value().c_str();
 		Vector
 			tl,
 			br;
-		tl[0]=atof(string(values.data(),values.find(' ')).c_str());
-		values=string(values.begin()+values.find(' ')+1,values.end());
-		tl[1]=atof(string(values.data(),values.find(' ')).c_str());
-		values=string(values.begin()+values.find(' ')+1,values.end());
-		br[0]=atof(string(values.data(),values.find(' ')).c_str());
-		values=string(values.begin()+values.find(' ')+1,values.end());
-		br[1]=atof(values.c_str());
+		tl[0]=read_number(values);
+		tl[1]=read_number(values);
+		br[0]=read_number(values);
+		br[1]=read_number(values);
 
 		canvas->rend_desc().set_tl(tl);
 		canvas->rend_desc().set_br(br);
@@ -3200,31 +3019,24 @@ CanvasParser::parse_canvas(xmlpp::Element *element,Canvas::Handle parent,bool in
 
 	if(element->get_attribute("bgcolor"))
 	{
-		string values=element->get_attribute("bgcolor")->get_value();
+		const char *values=element->get_attribute("bgcolor")->get_value().c_str();
 		Color bg;
 
-		bg.set_r(atof(string(values.data(),values.find(' ')).c_str()));
-		values=string(values.begin()+values.find(' ')+1,values.end());
-
-		bg.set_g(atof(string(values.data(),values.find(' ')).c_str()));
-		values=string(values.begin()+values.find(' ')+1,values.end());
-
-		bg.set_b(atof(string(values.data(),values.find(' ')).c_str()));
-		values=string(values.begin()+values.find(' ')+1,values.end());
-
-		bg.set_a(atof(values.c_str()));
+		bg.set_r(read_number(values));
+		bg.set_g(read_number(values));
+		bg.set_b(read_number(values));
+		bg.set_a(read_number(values));
 
 		canvas->rend_desc().set_bg_color(bg);
 	}
 
 	if(element->get_attribute("focus"))
 	{
-		string values=element->get_attribute("focus")->get_value();
+		const char *values=element->get_attribute("focus")->get_value().c_str();
 		Vector focus;
 
-		focus[0]=atof(string(values.data(),values.find(' ')).c_str());
-		values=string(values.begin()+values.find(' ')+1,values.end());
-		focus[1]=atof(values.c_str());
+		focus[0]=read_number(values);
+		focus[1]=read_number(values);
 
 		canvas->rend_desc().set_focus(focus);
 	}
@@ -3232,148 +3044,126 @@ CanvasParser::parse_canvas(xmlpp::Element *element,Canvas::Handle parent,bool in
 	canvas->rend_desc().set_flags(RendDesc::PX_ASPECT|RendDesc::IM_SPAN);
 
 	list<ValueNode::Handle> bone_list;
-	xmlpp::Element::NodeList list = element->get_children();
-	for(xmlpp::Element::NodeList::iterator iter = list.begin(); iter != list.end(); ++iter)
+	for(XMLElement iter(element); iter.next(); )
 	{
-		xmlpp::Element *child(dynamic_cast<xmlpp::Element*>(*iter));
-		if(child)
+		XMLElement *child(&iter);
+		if(child->get_name()=="defs")
 		{
-			if(child->get_name()=="defs")
+			if(canvas->is_inline())
+				error(child,_("Group canvases cannot have a <defs> section"));
+			parse_canvas_defs(child, canvas);
+		}
+		else
+		if(child->get_name()=="bones")
+		{
+			if(canvas->is_inline())
+				error(child,_("Inline canvas cannot have a <bones> section"));
+			bone_list = parse_canvas_bones(child, canvas);
+		}
+		else
+		if(child->get_name()=="keyframe")
+		{
+			if(canvas->is_inline())
 			{
-				if(canvas->is_inline())
-					error(child,_("Group canvases cannot have a <defs> section"));
-				parse_canvas_defs(child, canvas);
+				warning(child,_("Group canvases cannot have keyframes"));
+				continue;
 			}
-			else
-			if(child->get_name()=="bones")
+
+			canvas->keyframe_list().add(parse_keyframe(child,canvas));
+			canvas->keyframe_list().sync();
+		}
+		else
+		if(child->get_name()=="meta")
+		{
+			if(canvas->is_inline())
 			{
-				if(canvas->is_inline())
-					error(child,_("Inline canvas cannot have a <bones> section"));
-				bone_list = parse_canvas_bones(child, canvas);
+				warning(child,_("Group canvases cannot have metadata"));
+				continue;
 			}
-			else
-			if(child->get_name()=="keyframe")
+
+			if(!child->get_attribute("name"))
 			{
-				if(canvas->is_inline())
-				{
-					warning(child,_("Group canvases cannot have keyframes"));
-					continue;
-				}
+				warning(child,_("<meta> must have a name"));
+				continue;
+			}
 
-				canvas->keyframe_list().add(parse_keyframe(child,canvas));
-				canvas->keyframe_list().sync();
+			if(!child->get_attribute("content"))
+			{
+				warning(child,_("<meta> must have content"));
+				continue;
 			}
-			else
-			if(child->get_name()=="meta")
+			
+			// In Synfig prior to version 1.0 we have messed decimal separator:
+			// some files use ".", but other ones use ","/
+			// Let's try to put a workaround for that.
+			std::vector<String> replacelist;
+			replacelist.push_back("background_first_color");
+			replacelist.push_back("background_second_color");
+			replacelist.push_back("background_size");
+			replacelist.push_back("grid_color");
+			replacelist.push_back("grid_size");
+			replacelist.push_back("jack_offset");
+			String content;
+			content=child->get_attribute("content")->get_value();
+			if(std::find(replacelist.begin(), replacelist.end(), child->get_attribute("name")->get_value()) != replacelist.end()) 
 			{
-				if(canvas->is_inline())
-				{
-					warning(child,_("Group canvases cannot have metadata"));
-					continue;
-				}
+				size_t index = 0;
+				while (true) {
+				     /* Locate the substring to replace. */
+				     index = content.find(",", index);
+				     if (index == string::npos) break;
 
-				if(!child->get_attribute("name"))
-				{
-					warning(child,_("<meta> must have a name"));
-					continue;
-				}
+				     /* Make the replacement. */
+				     content.replace(index, 1, ".");
 
-				if(!child->get_attribute("content"))
-				{
-					warning(child,_("<meta> must have content"));
-					continue;
+				     /* Advance index forward so the next iteration doesn't pick it up as well. */
+				     index += 1;
 				}
 				
-				// In Synfig prior to version 1.0 we have messed decimal separator:
-				// some files use ".", but other ones use ","/
-				// Let's try to put a workaround for that.
-				std::vector<String> replacelist;
-				replacelist.push_back("background_first_color");
-				replacelist.push_back("background_second_color");
-				replacelist.push_back("background_size");
-				replacelist.push_back("grid_color");
-				replacelist.push_back("grid_size");
-				replacelist.push_back("jack_offset");
-				String content;
-				content=child->get_attribute("content")->get_value();
-				if(std::find(replacelist.begin(), replacelist.end(), child->get_attribute("name")->get_value()) != replacelist.end()) 
-				{
-					size_t index = 0;
-					while (true) {
-					     /* Locate the substring to replace. */
-					     index = content.find(",", index);
-					     if (index == string::npos) break;
-
-					     /* Make the replacement. */
-					     content.replace(index, 1, ".");
-
-					     /* Advance index forward so the next iteration doesn't pick it up as well. */
-					     index += 1;
-					}
-					
-				}
-				canvas->set_meta_data(child->get_attribute("name")->get_value(),content);
 			}
-			else if(child->get_name()=="name")
-			{
-				xmlpp::Element::NodeList list = child->get_children();
-
-				// If we don't have any name, warn
-				if(list.empty())
-					warning(child,_("blank \"name\" entity"));
-
-				string tmp;
-				for(xmlpp::Element::NodeList::iterator iter = list.begin(); iter != list.end(); ++iter)
-					if(dynamic_cast<xmlpp::TextNode*>(*iter))tmp+=dynamic_cast<xmlpp::TextNode*>(*iter)->get_content();
-				canvas->set_name(tmp);
-			}
-			else
-			if(child->get_name()=="desc")
-			{
-
-				xmlpp::Element::NodeList list = child->get_children();
+			canvas->set_meta_data(child->get_attribute("name")->get_value(),content);
+		}
+		else if(child->get_name()=="name")
+		{
+			// If we don't have any name, warn
+			if(!child->has_children())
+				warning(child,_("blank \"name\" entity"));
 
-				// If we don't have any description, warn
-				if(list.empty())
-					warning(child,_("blank \"desc\" entity"));
+			canvas->set_name(child->get_child_text());
+		}
+		else
+		if(child->get_name()=="desc")
+		{
 
-				string tmp;
-				for(xmlpp::Element::NodeList::iterator iter = list.begin(); iter != list.end(); ++iter)
-					if(dynamic_cast<xmlpp::TextNode*>(*iter))tmp+=dynamic_cast<xmlpp::TextNode*>(*iter)->get_content();
-				canvas->set_description(tmp);
-			}
-			else
-			if(child->get_name()=="author")
-			{
+			// If we don't have any description, warn
+			if(!child->has_children())
+				warning(child,_("blank \"desc\" entity"));
 
-				xmlpp::Element::NodeList list = child->get_children();
+			canvas->set_description(child->get_child_text());
+		}
+		else
+		if(child->get_name()=="author")
+		{
 
-				// If we don't have any description, warn
-				if(list.empty())
-					warning(child,_("blank \"author\" entity"));
+			// If we don't have any description, warn
+			if(!child->has_children())
+				warning(child,_("blank \"author\" entity"));
 
-				string tmp;
-				for(xmlpp::Element::NodeList::iterator iter = list.begin(); iter != list.end(); ++iter)
-					if(dynamic_cast<xmlpp::TextNode*>(*iter))tmp+=dynamic_cast<xmlpp::TextNode*>(*iter)->get_content();
-				canvas->set_author(tmp);
-			}
-			else
-			if(child->get_name()=="layer")
-			{
-				//if(canvas->is_inline())
-				//	canvas->push_front(parse_layer(child,canvas->parent()));
-				//else
-					canvas->push_front(parse_layer(child,canvas));
-			}
-			else
-			{
-				printf("%s:%d\n", __FILE__, __LINE__);
-				error_unexpected_element(child,child->get_name());
-			}
+			canvas->set_author(child->get_child_text());
+		}
+		else
+		if(child->get_name()=="layer")
+		{
+			//if(canvas->is_inline())
+			//	canvas->push_front(parse_layer(child,canvas->parent()));
+			//else
+				canvas->push_front(parse_layer(child,canvas));
+		}
+		else
+		{
+			printf("%s:%d\n", __FILE__, __LINE__);
+			error_unexpected_element(child,child->get_name());
 		}
-//		else
-//		if((child->get_name()=="text"||child->get_name()=="comment") && child->has_child_text())
-//			continue;
 	}
 
 	if(canvas->value_node_list().placeholder_count())
@@ -3423,51 +3213,86 @@ CanvasParser::show_canvas_map(String file, int line, String text)
 
 Canvas::Handle
 CanvasParser::parse_from_file_as(const FileSystem::Identifier &identifier,const String &as,String &errors)
+{
+	if(get_open_canvas_map().count(etl::absolute_path(as)))
+		return get_open_canvas_map()[etl::absolute_path(as)];
+	return parse_document(identifier,as,NULL,errors);
+}
+
+Canvas::Handle
+CanvasParser::parse_from_string_as(const String &data,const FileSystem::Identifier &identifier,const String &as,String &errors)
+{
+	return parse_document(identifier,as,&data,errors);
+}
+
+Canvas::Handle
+CanvasParser::parse_document(const FileSystem::Identifier &identifier,const String &as,const String *data,String &errors)
 {
 	ChangeLocale change_locale(LC_NUMERIC, "C");
 
 	try
 	{
-		if(get_open_canvas_map().count(etl::absolute_path(as)))
-			return get_open_canvas_map()[etl::absolute_path(as)];
-
 		filename=as;
 		total_warnings_=0;
-		
-		synfig::info(String("Loading file: ") + filename);
-		FileSystem::ReadStreamHandle stream = identifier.get_read_stream();
-		if (stream)
+
+		// The files read by the layers (images, fonts) are loaded together on
+		// the thread pool when the queue goes out of scope, before the canvas
+		// is returned. External canvases are parsed at once since their
+		// exported values are needed here, but their files join this queue.
+		LoadQueue load_queue;
+
+		// The document is parsed while it is read, so the stream or the
+		// cache are needed until the whole canvas is built
+		FileSystem::ReadStreamHandle stream;
+		XMLCache cache;
+		XMLReader reader;
+		if (data)
+			reader.open_memory(*data, as);
+		else
 		{
-			if (filename_extension(identifier.filename) == ".sifz")
-				stream = FileSystem::ReadStreamHandle(new ZReadStream(stream));
+			synfig::info(String("Loading file: ") + filename);
 
-			xmlpp::DomParser parser;
-			parser.parse_stream(*stream);
-			stream.reset();
-			if(parser)
+			if (cache.open(identifier))
+			{
+				synfig::info(String("Loading from cache: ") + XMLCache::get_filename(identifier.filename));
+				reader.open_cache(cache);
+			}
+			else
+			if ((stream = identifier.get_read_stream()))
 			{
-				Canvas::Handle canvas(parse_canvas(parser.get_document()->get_root_node(),0,false,identifier,as));
-				if (!canvas) return canvas;
+				if (filename_extension(identifier.filename) == ".sifz")
+					stream = FileSystem::ReadStreamHandle(new ZReadStream(stream));
+				reader.open_stream(*stream, identifier.filename);
+				if(!reader.is_open())
+					throw runtime_error(String("  * ") + _("Can't open file") + " \"" + identifier.filename + "\"");
+			}
+			else
+				throw runtime_error(String("  * ") + _("Can't find linked file") + " \"" + identifier.filename + "\"");
+		}
+
+		XMLElement root(reader);
+		if(root.next())
+		{
+			Canvas::Handle canvas(parse_canvas(&root,0,false,identifier,as));
+			if (!canvas) return canvas;
+			if (!data)
 				register_canvas_in_map(canvas, as);
 
-				const ValueNodeList& value_node_list(canvas->value_node_list());
+			const ValueNodeList& value_node_list(canvas->value_node_list());
 
-				again:
-				ValueNodeList::const_iterator iter;
-				for(iter=value_node_list.begin();iter!=value_node_list.end();++iter)
+			again:
+			ValueNodeList::const_iterator iter;
+			for(iter=value_node_list.begin();iter!=value_node_list.end();++iter)
+			{
+				ValueNode::Handle value_node(*iter);
+				if(value_node->is_exported() && value_node->get_id().find("Unnamed")==0)
 				{
-					ValueNode::Handle value_node(*iter);
-					if(value_node->is_exported() && value_node->get_id().find("Unnamed")==0)
-					{
-						canvas->remove_value_node(value_node, true);
-						goto again;
-					}
+					canvas->remove_value_node(value_node, true);
+					goto again;
 				}
-
-				return canvas;
 			}
-		} else {
-			throw runtime_error(String("  * ") + _("Can't find linked file") + " \"" + identifier.filename + "\"");
+
+			return canvas;
 		}
 	}
 	catch(Exception::BadLinkName) { synfig::error("BadLinkName Thrown"); }
@@ -3475,12 +3300,6 @@ CanvasParser::parse_from_file_as(const FileSystem::Identifier &identifier,const
 	catch(Exception::FileNotFound) { synfig::error("FileNotFound Thrown"); }
 	catch(Exception::IDNotFound) { synfig::error("IDNotFound Thrown"); }
 	catch(Exception::IDAlreadyExists) { synfig::error("IDAlreadyExists Thrown"); }
-	catch(xmlpp::internal_error x)
-	{
-		if (!strcmp(x.what(), "Couldn't create parsing context"))
-			throw runtime_error(String("  * ") + _("Can't open file") + " \"" + identifier.filename + "\"");
-		throw;
-	}
 	catch(const std::exception& ex)
 	{
 		synfig::error("Standard Exception: "+String(ex.what()));
@@ -3504,9 +3323,17 @@ CanvasParser::parse_as(xmlpp::Element* node,String &errors)
 	try
 	{
 		total_warnings_=0;
+		LoadQueue load_queue;
 		if(node)
 		{
-			Canvas::Handle canvas(parse_canvas(node,0,false,FileSystemNative::instance()->get_identifier(std::string()),""));
+			// The tree is walked in document order, as if it was being read from a file
+			XMLReader reader;
+			reader.open_document(node->cobj()->doc);
+			XMLElement root(reader);
+			if(!root.next())
+				return Canvas::Handle();
+
+			Canvas::Handle canvas(parse_canvas(&root,0,false,FileSystemNative::instance()->get_identifier(std::string()),""));
 			if (!canvas) return canvas;
 
 			const ValueNodeList& value_node_list(canvas->value_node_list());
@@ -3531,12 +3358,6 @@ CanvasParser::parse_as(xmlpp::Element* node,String &errors)
 	catch(Exception::FileNotFound) { synfig::error("FileNotFound Thrown"); }
 	catch(Exception::IDNotFound) { synfig::error("IDNotFound Thrown"); }
 	catch(Exception::IDAlreadyExists) { synfig::error("IDAlreadyExists Thrown"); }
-	catch(xmlpp::internal_error x)
-	{
-		if (!strcmp(x.what(), "Couldn't create parsing context"))
-			throw runtime_error(String("  * ") + _("Can't open file") + " \"" + "\"");
-		throw;
-	}
 	catch(const std::exception& ex)
 	{
 		synfig::error("Standard Exception: "+String(ex.what()));
@@ -51,13 +51,19 @@
 
 /* === C L A S S E S & S T R U C T S ======================================= */
 
-namespace xmlpp { class Node; class Element; };
+namespace xmlpp { class Element; };
 
 namespace synfig {
 
+class XMLElement;
+
 /*!	\class CanvasParser
-**	\brief Class that handles xmlpp elements from a sif file and converts
+**	\brief Class that reads the elements of a sif file and converts
 * them into Synfig objects
+*
+* The file is read only once from start to end (see XMLReader), so the
+* objects are built while the elements go by and no tree of the whole
+* document is kept in memory.
 */
 class CanvasParser
 {
@@ -144,6 +150,11 @@ public:
 	Canvas::Handle parse_from_file_as(const FileSystem::Identifier &identifier,const String &as,String &errors);
 	//! Parse a Canvas from a xmlpp root node
 	Canvas::Handle parse_as(xmlpp::Element* node,String &errors);
+	//! Parse a Canvas from the contents of a file with absolute path.
+	/*! Unlike parse_from_file_as() the canvas is neither looked up in
+	**	nor registered in the open canvas map, so every call returns a
+	**	new, independent canvas. */
+	Canvas::Handle parse_from_string_as(const String &data,const FileSystem::Identifier &identifier,const String &as,String &errors);
 
 	//! Set of absolute file names of the canvases currently being parsed
 	static std::set<FileSystem::Identifier> loading_;
@@ -151,86 +162,89 @@ public:
 private:
 
 	//! Error handling function
-	void error(xmlpp::Node *node,const String &text);
+	void error(XMLElement *node,const String &text);
 	//! Fatal Error handling function
-	void fatal_error(xmlpp::Node *node,const String &text);
+	void fatal_error(XMLElement *node,const String &text);
 	//! Warning handling function
-	void warning(xmlpp::Node *node,const String &text);
+	void warning(XMLElement *node,const String &text);
 	//! Unexpected element error handling function
-	void error_unexpected_element(xmlpp::Node *node,const String &got, const String &expected);
+	void error_unexpected_element(XMLElement *node,const String &got, const String &expected);
 	//! Unexpected element error handling function
-	void error_unexpected_element(xmlpp::Node *node,const String &got);
+	void error_unexpected_element(XMLElement *node,const String &got);
+
+	//! Parses \a data, or the file of \a identifier if \a data is \c NULL, and registers the canvas of the file
+	Canvas::Handle parse_document(const FileSystem::Identifier &identifier,const String &as,const String *data,String &errors);
 
 	//! Canvas Parsing Function
-	Canvas::Handle parse_canvas(xmlpp::Element *node,Canvas::Handle parent=0,bool inline_=false,const FileSystem::Identifier &identifier = FileSystemNative::instance()->get_identifier(std::string()),String path=".");
+	Canvas::Handle parse_canvas(XMLElement *node,Canvas::Handle parent=0,bool inline_=false,const FileSystem::Identifier &identifier = FileSystemNative::instance()->get_identifier(std::string()),String path=".");
 	//! Canvas definitions Parsing Function (exported value nodes and exported canvases)
-	void parse_canvas_defs(xmlpp::Element *node,Canvas::Handle canvas);
+	void parse_canvas_defs(XMLElement *node,Canvas::Handle canvas);
 
-	std::list<ValueNode::Handle> parse_canvas_bones(xmlpp::Element *node,Canvas::Handle canvas);
+	std::list<ValueNode::Handle> parse_canvas_bones(XMLElement *node,Canvas::Handle canvas);
 
 	//! Layer Parsing Function
-	etl::handle<Layer> parse_layer(xmlpp::Element *node,Canvas::Handle canvas);
+	etl::handle<Layer> parse_layer(XMLElement *node,Canvas::Handle canvas);
 	//! Generic Value Base Parsing Function
-	ValueBase parse_value(xmlpp::Element *node,Canvas::Handle canvas);
+	ValueBase parse_value(XMLElement *node,Canvas::Handle canvas);
 	//! Generic Value Node Parsing Function
-	etl::handle<ValueNode> parse_value_node(xmlpp::Element *node,Canvas::Handle canvas);
+	etl::handle<ValueNode> parse_value_node(XMLElement *node,Canvas::Handle canvas);
 
 	//! Real Value Base Parsing Function
-	Real parse_real(xmlpp::Element *node);
+	Real parse_real(XMLElement *node);
 	//! Time Value Base Parsing Function
-	Time parse_time(xmlpp::Element *node,Canvas::Handle canvas);
+	Time parse_time(XMLElement *node,Canvas::Handle canvas);
 	//! Integer Value Base Parsing Function
-	int parse_integer(xmlpp::Element *node);
+	int parse_integer(XMLElement *node);
 	//! Vector Value Base Parsing Function
-	Vector parse_vector(xmlpp::Element *node);
+	Vector parse_vector(XMLElement *node);
 	//! Color Value Base Parsing Function
-	Color parse_color(xmlpp::Element *node);
+	Color parse_color(XMLElement *node);
 	//! Angle Value Base Parsing Function
-	Angle parse_angle(xmlpp::Element *node);
+	Angle parse_angle(XMLElement *node);
 	//! String Value Base Parsing Function
-	String parse_string(xmlpp::Element *node);
+	String parse_string(XMLElement *node);
 	//! Bool Value Base Parsing Function
-	bool parse_bool(xmlpp::Element *node);
+	bool parse_bool(XMLElement *node);
 	//! Segment Value Base Parsing Function
-	Segment parse_segment(xmlpp::Element *node);
+	Segment parse_segment(XMLElement *node);
 	//! List Value Base Parsing Function
-	ValueBase parse_list(xmlpp::Element *node,Canvas::Handle canvas);
+	ValueBase parse_list(XMLElement *node,Canvas::Handle canvas);
 	//! Weighted Value Base Parsing Function
-	ValueBase parse_weighted_value(xmlpp::Element *node, types_namespace::TypeWeightedValueBase &type, Canvas::Handle canvas);
+	ValueBase parse_weighted_value(XMLElement *node, types_namespace::TypeWeightedValueBase &type, Canvas::Handle canvas);
 	//! Pair Value Base Parsing Function
-	ValueBase parse_pair(xmlpp::Element *node, types_namespace::TypePairBase &type, Canvas::Handle canvas);
+	ValueBase parse_pair(XMLElement *node, types_namespace::TypePairBase &type, Canvas::Handle canvas);
 	//! Gradient Value Base Parsing Function
-	Gradient parse_gradient(xmlpp::Element *node);
+	Gradient parse_gradient(XMLElement *node);
 	//! Bline Point Value Base Parsing Function
-	BLinePoint parse_bline_point(xmlpp::Element *node);
+	BLinePoint parse_bline_point(XMLElement *node);
 	//! Transformation Value Base Parsing Function
-	Transformation parse_transformation(xmlpp::Element *node);
+	Transformation parse_transformation(XMLElement *node);
 
-	GUID parse_guid(xmlpp::Element *node);
+	GUID parse_guid(XMLElement *node);
 
 	//! Width Point Value Base Parsing Function
-	WidthPoint parse_width_point(xmlpp::Element *node);
+	WidthPoint parse_width_point(XMLElement *node);
 	//! Dash Item Value Base Parsing Function
-	DashItem parse_dash_item(xmlpp::Element *node);
+	DashItem parse_dash_item(XMLElement *node);
 
 	//! Keyframe Parsing Function
-	Keyframe parse_keyframe(xmlpp::Element *node,Canvas::Handle canvas);
+	Keyframe parse_keyframe(XMLElement *node,Canvas::Handle canvas);
 
 	//! ValueNode Animated Parsing Function
-	etl::handle<ValueNode_Animated> parse_animated(xmlpp::Element *node,Canvas::Handle canvas);
+	etl::handle<ValueNode_Animated> parse_animated(XMLElement *node,Canvas::Handle canvas);
 	//! Linkable ValueNode Parsing Function
-	etl::handle<LinkableValueNode> parse_linkable_value_node(xmlpp::Element *node,Canvas::Handle canvas);
+	etl::handle<LinkableValueNode> parse_linkable_value_node(XMLElement *node,Canvas::Handle canvas);
 
 	//! Static List Parsnig Function
-	etl::handle<ValueNode_StaticList> parse_static_list(xmlpp::Element *node,Canvas::Handle canvas);
+	etl::handle<ValueNode_StaticList> parse_static_list(XMLElement *node,Canvas::Handle canvas);
 
 	//! Dynamic List Parsnig Function
-	etl::handle<ValueNode_DynamicList> parse_dynamic_list(xmlpp::Element *node,Canvas::Handle canvas);
+	etl::handle<ValueNode_DynamicList> parse_dynamic_list(XMLElement *node,Canvas::Handle canvas);
 
 	//! Interpolation option for ValueBase parsing function
-	Interpolation parse_interpolation(xmlpp::Element *node, String attribute);
+	Interpolation parse_interpolation(XMLElement *node, String attribute);
 	//! Static option for ValueBase parsing function
-	bool parse_static(xmlpp::Element *node);
+	bool parse_static(XMLElement *node);
 
 }; // END of CanvasParser
 
@@ -243,6 +257,10 @@ extern Canvas::Handle open_canvas(xmlpp::Element* node,String &errors,String &wa
 /*!	\return	The Canvas's handle on success, an empty handle on failure */
 extern Canvas::Handle open_canvas_as(const FileSystem::Identifier &identifier,const String &as,String &errors,String &warnings);
 
+//!	Loads an independent copy of a canvas from \a data, as if it was read from \a as
+/*!	\return	The Canvas's handle on success, an empty handle on failure */
+extern Canvas::Handle open_canvas_from_string_as(const String &data,const FileSystem::Identifier &identifier,const String &as,String &errors,String &warnings);
+
 //! Returns the Open Canvases Map.
 //! \see open_canvas_map_
 std::map<String, etl::loose_handle<Canvas> >& get_open_canvas_map();
@@ -0,0 +1,121 @@
+/* === S Y N F I G ========================================================= */
+/*!	\file synfig/loadqueue.cpp
+**	\brief Files read by layers while a document is opened, loaded together on the thread pool
+**
+**	$Id$
+**
+**	\legal
+**	Copyright (c) 2016 Synfig contributors
+**
+**	This package is free software; you can redistribute it and/or
+**	modify it under the terms of the GNU General Public License as
+**	published by the Free Software Foundation; either version 2 of
+**	the License, or (at your option) any later version.
+**
+**	This package is distributed in the hope that it will be useful,
+**	but WITHOUT ANY WARRANTY; without even the implied warranty of
+**	MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE. See the GNU
+**	General Public License for more details.
+**	\endlegal
+*/
+/* ========================================================================= */
+
+/* === H E A D E R S ======================================================= */
+
+#ifdef USING_PCH
+#	include "pch.h"
+#else
+#ifdef HAVE_CONFIG_H
+#	include <config.h>
+#endif
+
+#include <algorithm>
+#include <glibmm/thread.h>
+
+#include "loadqueue.h"
+#include "mutex.h"
+
+#endif
+
+/* === U S I N G =========================================================== */
+
+using namespace std;
+using namespace synfig;
+
+/* === M A C R O S ========================================================= */
+
+/* === G L O B A L S ======================================================= */
+
+//! Outermost queue of every thread which has one
+static vector<LoadQueue*> queues;
+static Mutex queues_mutex;
+
+/* === P R O C E D U R E S ================================================= */
+
+/* === M E T H O D S ======================================================= */
+
+LoadQueue::LoadQueue():
+	outer_(current()),
+	thread_(Glib::Thread::self())
+{
+	if (!outer_)
+	{
+		Mutex::Lock lock(queues_mutex);
+		queues.push_back(this);
+	}
+}
+
+LoadQueue::~LoadQueue()
+{
+	if (outer_) return;
+	run();
+	Mutex::Lock lock(queues_mutex);
+	queues.erase(std::find(queues.begin(), queues.end(), this));
+}
+
+void
+LoadQueue::push(Task *task)
+{
+	if (outer_)
+		outer_->push(task);
+	else
+		tasks_.push_back(task);
+}
+
+void
+LoadQueue::run()
+{
+	if (outer_) return;
+
+	vector<Task*> tasks;
+	tasks.swap(tasks_);
+	ThreadPool::instance().run(vector<ThreadPool::Task*>(tasks.begin(), tasks.end()));
+	for(vector<Task*>::iterator i = tasks.begin(); i != tasks.end(); ++i)
+		{ (*i)->finish(); delete *i; }
+}
+
+LoadQueue*
+LoadQueue::current()
+{
+	Glib::Thread *self = Glib::Thread::self();
+	Mutex::Lock lock(queues_mutex);
+	for(vector<LoadQueue*>::iterator i = queues.begin(); i != queues.end(); ++i)
+		if ((*i)->thread_ == self)
+			return *i;
+	return NULL;
+}
+
+void
+LoadQueue::load(Task *task)
+{
+	if (LoadQueue *queue = current())
+	{
+		queue->push(task);
+		return;
+	}
+	task->run();
+	task->finish();
+	delete task;
+}
+
+/* === E N D =============================================================== */
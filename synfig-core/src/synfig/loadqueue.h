@@ -0,0 +1,100 @@
+/* === S Y N F I G ========================================================= */
+/*!	\file synfig/loadqueue.h
+**	\brief Files read by layers while a document is opened, loaded together on the thread pool
+**
+**	$Id$
+**
+**	\legal
+**	Copyright (c) 2016 Synfig contributors
+**
+**	This package is free software; you can redistribute it and/or
+**	modify it under the terms of the GNU General Public License as
+**	published by the Free Software Foundation; either version 2 of
+**	the License, or (at your option) any later version.
+**
+**	This package is distributed in the hope that it will be useful,
+**	but WITHOUT ANY WARRANTY; without even the implied warranty of
+**	MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE. See the GNU
+**	General Public License for more details.
+**	\endlegal
+*/
+/* ========================================================================= */
+
+/* === S T A R T =========================================================== */
+
+#ifndef __SYNFIG_LOADQUEUE_H
+#define __SYNFIG_LOADQUEUE_H
+
+/* === H E A D E R S ======================================================= */
+
+#include <vector>
+#include "threadpool.h"
+
+/* === M A C R O S ========================================================= */
+
+/* === T Y P E D E F S ===================================================== */
+
+namespace Glib { class Thread; }
+
+/* === C L A S S E S & S T R U C T S ======================================= */
+
+namespace synfig {
+
+/*!	\class LoadQueue
+**	\brief Loads queued by layers while a document is parsed, run on ThreadPool::instance() when it is done
+**
+**	While a LoadQueue exists, layers created on the same thread push a
+**	Task instead of reading their files (imported images, font faces)
+**	on the spot. The tasks run in parallel when the queue is destroyed,
+**	so the document is complete before anything can render it.
+**
+**	A queue created while another one exists on the same thread (an
+**	external canvas opened by the document) adds its tasks to the outer
+**	one, so they all run together.
+*/
+class LoadQueue
+{
+public:
+	//! Load of the files of one layer
+	class Task: public ThreadPool::Task
+	{
+	public:
+		//! Reads the files. Runs on any thread at the same time as the other tasks.
+		virtual void run()=0;
+		//! Hands the result to the layer. Runs on the thread of the queue, after every run().
+		virtual void finish() { }
+	};
+
+private:
+	LoadQueue *outer_;
+	Glib::Thread *thread_;
+	std::vector<Task*> tasks_;
+
+	//! Non-copyable
+	LoadQueue(const LoadQueue&);
+	//! Non-assignable
+	void operator=(const LoadQueue&);
+
+public:
+	LoadQueue();
+	//! Runs whatever is queued, unless an outer queue will
+	~LoadQueue();
+
+	//! Queues \a task, which is deleted once done
+	void push(Task *task);
+
+	//! Runs the queued tasks now and waits for them
+	void run();
+
+	//! The queue of the calling thread, or NULL if loads have to be done at once
+	static LoadQueue* current();
+
+	//! Queues \a task on the queue of the calling thread, or does it at once if there is none
+	static void load(Task *task);
+}; // END of class LoadQueue
+
+}; // END of namespace synfig
+
+/* === E N D =============================================================== */
+
+#endif
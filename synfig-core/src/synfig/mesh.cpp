@@ -32,6 +32,9 @@
 #include "mesh.h"
 #include "matrix.h"
 
+#include <cmath>
+#include <algorithm>
+
 #endif
 
 /* === U S I N G =========================================================== */
@@ -44,8 +47,181 @@ using namespace synfig;
 
 /* === G L O B A L S ======================================================= */
 
+//! Smaller meshes are just scanned
+static const size_t MIN_INDEXED_TRIANGLES = 16;
+//! Widest side of a grid, in cells
+static const int MAX_GRID_SIDE = 1024;
+
+/* === C L A S S E S ======================================================= */
+
+//! Uniform grid over the bounds of the triangles in one space
+/*!	Each cell lists the triangles whose bounds overlap it, the last ones
+**	first, so the first one containing a point is the same triangle the
+**	backward scan of the whole mesh finds. */
+class Mesh::Index
+{
+public:
+	Vector origin, max_point;
+	//! Cells per unit
+	Vector scale;
+	int w, h;
+	//! Triangles of cell \c i are cell_triangles[cell_offsets[i]..cell_offsets[i+1]]
+	std::vector<int> cell_offsets;
+	std::vector<int> cell_triangles;
+
+	Index(): w(), h() { }
+
+	const Vector& get_vertex(const Mesh &mesh, int vertex, bool world)const
+		{ return world ? mesh.vertices[vertex].position : mesh.vertices[vertex].tex_coords; }
+
+	//! Cells overlapped by a rectangle, clamped to the grid
+	void get_cells(const Vector &min, const Vector &max, int &x0, int &y0, int &x1, int &y1)const
+	{
+		x0 = std::max(0, std::min(w - 1, (int)floor((min[0] - origin[0])*scale[0])));
+		y0 = std::max(0, std::min(h - 1, (int)floor((min[1] - origin[1])*scale[1])));
+		x1 = std::max(0, std::min(w - 1, (int)floor((max[0] - origin[0])*scale[0])));
+		y1 = std::max(0, std::min(h - 1, (int)floor((max[1] - origin[1])*scale[1])));
+	}
+
+	void build(const Mesh &mesh, bool world)
+	{
+		const int count = mesh.triangles.size();
+		std::vector<Vector> mins(count), maxs(count);
+		Vector min(INFINITY, INFINITY), max(-INFINITY, -INFINITY);
+		for(int i = 0; i < count; i++)
+		{
+			mins[i] = maxs[i] = get_vertex(mesh, mesh.triangles[i].vertices[0], world);
+			for(int j = 1; j < 3; j++)
+			{
+				const Vector &v = get_vertex(mesh, mesh.triangles[i].vertices[j], world);
+				mins[i][0] = std::min(mins[i][0], v[0]); mins[i][1] = std::min(mins[i][1], v[1]);
+				maxs[i][0] = std::max(maxs[i][0], v[0]); maxs[i][1] = std::max(maxs[i][1], v[1]);
+			}
+			min[0] = std::min(min[0], mins[i][0]); min[1] = std::min(min[1], mins[i][1]);
+			max[0] = std::max(max[0], maxs[i][0]); max[1] = std::max(max[1], maxs[i][1]);
+		}
+
+		// points on the edges may be found a bit outside by the rounding
+		const Vector size = max - min;
+		const Real margin = 1e-9*(fabs(size[0]) + fabs(size[1]) + fabs(min[0]) + fabs(min[1])) + 1e-12;
+		origin = min - Vector(margin, margin);
+		max_point = max + Vector(margin, margin);
+
+		// about one cell per triangle, following the shape of the bounds
+		const Real cells = (Real)count;
+		if (size[0] <= 0.0 && size[1] <= 0.0) { w = 1; h = 1; }
+		else if (size[1] <= 0.0 || size[0] > size[1]*cells) { w = (int)cells; h = 1; }
+		else if (size[0] <= 0.0 || size[1] > size[0]*cells) { w = 1; h = (int)cells; }
+		else
+		{
+			w = (int)ceil(sqrt(cells*size[0]/size[1]));
+			h = (int)ceil(cells/w);
+		}
+		w = std::max(1, std::min(MAX_GRID_SIDE, w));
+		h = std::max(1, std::min(MAX_GRID_SIDE, h));
+		scale[0] = size[0] > 0.0 ? w/(size[0] + 2.0*margin) : 0.0;
+		scale[1] = size[1] > 0.0 ? h/(size[1] + 2.0*margin) : 0.0;
+
+		// count, then fill, backward
+		const Vector margins(margin, margin);
+		cell_offsets.assign(w*h + 1, 0);
+		for(int i = count - 1; i >= 0; i--)
+		{
+			int x0, y0, x1, y1;
+			get_cells(mins[i] - margins, maxs[i] + margins, x0, y0, x1, y1);
+			for(int y = y0; y <= y1; y++)
+				for(int x = x0; x <= x1; x++)
+					cell_offsets[y*w + x + 1]++;
+		}
+		for(int i = 0; i < w*h; i++)
+			cell_offsets[i + 1] += cell_offsets[i];
+		cell_triangles.resize(cell_offsets[w*h]);
+		std::vector<int> fill(cell_offsets.begin(), cell_offsets.end() - 1);
+		for(int i = count - 1; i >= 0; i--)
+		{
+			int x0, y0, x1, y1;
+			get_cells(mins[i] - margins, maxs[i] + margins, x0, y0, x1, y1);
+			for(int y = y0; y <= y1; y++)
+				for(int x = x0; x <= x1; x++)
+					cell_triangles[fill[y*w + x]++] = i;
+		}
+	}
+
+	//! Triangles which may contain \a point, in the order to try them
+	bool find(const Vector &point, const int *&begin, const int *&end)const
+	{
+		if (!(point[0] >= origin[0] && point[1] >= origin[1]
+		   && point[0] <= max_point[0] && point[1] <= max_point[1]))
+			return false;
+		const int x = std::min(w - 1, (int)((point[0] - origin[0])*scale[0]));
+		const int y = std::min(h - 1, (int)((point[1] - origin[1])*scale[1]));
+		const int cell = y*w + x;
+		if (cell_offsets[cell] == cell_offsets[cell + 1])
+			return false;
+		begin = &cell_triangles[cell_offsets[cell]];
+		end = begin + (cell_offsets[cell + 1] - cell_offsets[cell]);
+		return true;
+	}
+};
+
 /* === M E T H O D S ======================================================= */
 
+Mesh::Mesh():
+	world_index(NULL),
+	texture_index(NULL)
+{ }
+
+Mesh::Mesh(const Mesh &other):
+	vertices(other.vertices),
+	triangles(other.triangles),
+	world_index(NULL),
+	texture_index(NULL)
+{ }
+
+Mesh::~Mesh()
+	{ changed(); }
+
+Mesh&
+Mesh::operator=(const Mesh &other)
+{
+	if (&other != this)
+	{
+		vertices = other.vertices;
+		triangles = other.triangles;
+		changed();
+	}
+	return *this;
+}
+
+void
+Mesh::changed()
+{
+	Mutex::Lock lock(index_mutex);
+	delete world_index.get();
+	delete texture_index.get();
+	world_index.set(NULL);
+	texture_index.set(NULL);
+}
+
+const Mesh::Index&
+Mesh::get_index(bool world) const
+{
+	// several render threads look up the same mesh,
+	// only the first lookup builds the index under the lock
+	etl::atomic_pointer<Index> &index = world ? world_index : texture_index;
+	if (Index *built = index.get())
+		return *built;
+
+	Mutex::Lock lock(index_mutex);
+	if (!index.get())
+	{
+		Index *built = new Index();
+		built->build(*this, world);
+		index.set(built);
+	}
+	return *index.get();
+}
+
 bool
 Mesh::transform_coord_world_to_texture(
 	const Vector &src,
@@ -82,6 +258,29 @@ Mesh::transform_coord_world_to_texture(
 bool
 Mesh::transform_coord_world_to_texture(const Vector &src, Vector &dest) const
 {
+	if (triangles.size() >= MIN_INDEXED_TRIANGLES)
+	{
+		const int *begin, *end;
+		if (!get_index(true).find(src, begin, end))
+			return false;
+		for(const int *i = begin; i != end; ++i)
+		{
+			const Triangle &t = triangles[*i];
+			if (transform_coord_world_to_texture(
+				src,
+				dest,
+				vertices[t.vertices[0]].position,
+				vertices[t.vertices[0]].tex_coords,
+				vertices[t.vertices[1]].position,
+				vertices[t.vertices[1]].tex_coords,
+				vertices[t.vertices[2]].position,
+				vertices[t.vertices[2]].tex_coords
+			))
+				return true;
+		}
+		return false;
+	}
+
 	// process triangles backward
 	for(TriangleList::const_reverse_iterator ri = triangles.rbegin(); ri != triangles.rend(); ++ri)
 		if (transform_coord_world_to_texture(
@@ -101,6 +300,29 @@ Mesh::transform_coord_world_to_texture(const Vector &src, Vector &dest) const
 bool
 Mesh::transform_coord_texture_to_world(const Vector &src, Vector &dest) const
 {
+	if (triangles.size() >= MIN_INDEXED_TRIANGLES)
+	{
+		const int *begin, *end;
+		if (!get_index(false).find(src, begin, end))
+			return false;
+		for(const int *i = begin; i != end; ++i)
+		{
+			const Triangle &t = triangles[*i];
+			if (transform_coord_texture_to_world(
+				src,
+				dest,
+				vertices[t.vertices[0]].position,
+				vertices[t.vertices[0]].tex_coords,
+				vertices[t.vertices[1]].position,
+				vertices[t.vertices[1]].tex_coords,
+				vertices[t.vertices[2]].position,
+				vertices[t.vertices[2]].tex_coords
+			))
+				return true;
+		}
+		return false;
+	}
+
 	// process triangles backward
 	for(TriangleList::const_reverse_iterator ri = triangles.rbegin(); ri != triangles.rend(); ++ri)
 		if (transform_coord_texture_to_world(
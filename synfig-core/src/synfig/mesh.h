@@ -28,7 +28,9 @@
 /* === H E A D E R S ======================================================= */
 
 #include <vector>
+#include <ETL/handle>
 #include "vector.h"
+#include "mutex.h"
 
 /* === M A C R O S ========================================================= */
 
@@ -63,7 +65,27 @@ public:
 	VertexList vertices;
 	TriangleList triangles;
 
-	void clear() { vertices.clear(); triangles.clear(); }
+private:
+	class Index;
+
+	//! Grids of the triangles for the lookups, built on the first lookup
+	//! and read without the lock once they are published
+	mutable etl::atomic_pointer<Index> world_index;
+	mutable etl::atomic_pointer<Index> texture_index;
+	mutable Mutex index_mutex;
+
+	const Index& get_index(bool world) const;
+
+public:
+	Mesh();
+	Mesh(const Mesh &other);
+	~Mesh();
+	Mesh& operator=(const Mesh &other);
+
+	void clear() { vertices.clear(); triangles.clear(); changed(); }
+	//! Must be called after changing the vertices or the triangles
+	void changed();
+
 	bool transform_coord_world_to_texture(const Vector &src, Vector &dest) const;
 	bool transform_coord_texture_to_world(const Vector &src, Vector &dest) const;
 
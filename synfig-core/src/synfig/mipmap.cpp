@@ -0,0 +1,202 @@
+/* === S Y N F I G ========================================================= */
+/*!	\file synfig/mipmap.cpp
+**	\brief Prefiltered downscaled copies of a bitmap
+**
+**	$Id$
+**
+**	\legal
+**	Copyright (c) 2016 Synfig contributors
+**
+**	This package is free software; you can redistribute it and/or
+**	modify it under the terms of the GNU General Public License as
+**	published by the Free Software Foundation; either version 2 of
+**	the License, or (at your option) any later version.
+**
+**	This package is distributed in the hope that it will be useful,
+**	but WITHOUT ANY WARRANTY; without even the implied warranty of
+**	MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE. See the GNU
+**	General Public License for more details.
+**	\endlegal
+*/
+/* ========================================================================= */
+
+/* === H E A D E R S ======================================================= */
+
+#ifdef USING_PCH
+#	include "pch.h"
+#else
+#ifdef HAVE_CONFIG_H
+#	include <config.h>
+#endif
+
+#include "mipmap.h"
+#include "threadpool.h"
+
+#include <cmath>
+#include <algorithm>
+
+#endif
+
+/* === U S I N G =========================================================== */
+
+using namespace std;
+using namespace synfig;
+
+/* === M A C R O S ========================================================= */
+
+/* === G L O B A L S ======================================================= */
+
+/* === P R O C E D U R E S ================================================= */
+
+//! Averages 2x2 texels of \a src into each texel of \a dest, premultiplying \a src unless it is \a cooked
+struct HalveRows
+{
+	const Surface &src;
+	Surface &dest;
+	bool cooked;
+
+	HalveRows(const Surface &src, Surface &dest, bool cooked):
+		src(src), dest(dest), cooked(cooked) { }
+
+	void operator() (int begin, int end) const
+	{
+		const ColorPrep cooker;
+		const int w = src.get_w(), h = src.get_h();
+		for(int y = begin; y < end; ++y)
+		{
+			const Color *row0 = src[2*y];
+			const Color *row1 = src[min(2*y + 1, h - 1)];
+			Color *out = dest[y];
+			for(int x = 0; x < dest.get_w(); ++x)
+			{
+				const int x0 = 2*x, x1 = min(2*x + 1, w - 1);
+				if (cooked)
+					out[x] = (row0[x0] + row0[x1] + row1[x0] + row1[x1])*0.25f;
+				else
+					out[x] = (cooker.cook(row0[x0]) + cooker.cook(row0[x1])
+					        + cooker.cook(row1[x0]) + cooker.cook(row1[x1]))*0.25f;
+			}
+		}
+	}
+};
+
+/* === M E T H O D S ======================================================= */
+
+const int Mipmap::MAX_ANISOTROPY;
+
+Mipmap::Mipmap():
+	width(0), height(0), built(false)
+{ }
+
+bool
+Mipmap::build(const Surface &base)
+{
+	Mutex::Lock lock(mutex);
+
+	if (built)
+		return width == base.get_w() && height == base.get_h();
+
+	width = base.get_w();
+	height = base.get_h();
+	built = true;
+
+	int count = 0;
+	for(int w = width, h = height; w > 1 || h > 1; w = (w + 1)/2, h = (h + 1)/2)
+		++count;
+	if (!base.is_valid())
+		count = 0;
+
+	levels.resize(count);
+	ThreadPool &pool = ThreadPool::instance();
+	const Surface *src = &base;
+	for(int i = 0; i < count; ++i)
+	{
+		const int w = (src->get_w() + 1)/2, h = (src->get_h() + 1)/2;
+		levels[i].set_wh(w, h);
+		pool.run_bands(HalveRows(*src, levels[i], i > 0), h, w*h < 128*128 ? 1 : pool.get_threads()*4);
+		src = &levels[i];
+	}
+	return true;
+}
+
+Mipmap::Sampler::Sampler(const Mipmap &mipmap, const Surface &base, Real dx, Real dy):
+	weight(0), taps(1), tap_dx(0), tap_dy(0)
+{
+	dx = fabs(dx);
+	dy = fabs(dy);
+
+	// The level is chosen by the shorter side of the footprint, the longer
+	// side is covered by several lookups into that level
+	Real major = max(dx, dy), minor = min(dx, dy);
+	if (minor*MAX_ANISOTROPY < major)
+		minor = major/MAX_ANISOTROPY;
+	if (major > 1)
+	{
+		taps = min(MAX_ANISOTROPY, (int)ceil(major/max(minor, Real(1)) - 1e-6));
+		taps = max(taps, 1);
+		(dx >= dy ? tap_dx : tap_dy) = major/taps;
+	}
+
+	const Real lod = minor > 1 ? log(minor)/log(2.0) : 0;
+	int first = (int)floor(lod);
+	weight = lod - first;
+	if (first >= mipmap.get_levels() - 1)
+	{
+		first = mipmap.get_levels() - 1;
+		weight = 0;
+	}
+
+	for(int i = 0; i < 2; ++i)
+	{
+		const int index = min(first + i, mipmap.get_levels() - 1);
+		level[i].surface = index ? &mipmap.get_level(index) : &base;
+		level[i].cooked = index != 0;
+		level[i].scale = 1.0f/(1 << index);
+		level[i].offset = 0.5f*level[i].scale - 0.5f;
+	}
+}
+
+Color
+Mipmap::Sampler::bilinear(const Level &level, float x, float y)
+{
+	const Surface &s = *level.surface;
+	const int w = s.get_w(), h = s.get_h();
+
+	x = x*level.scale + level.offset;
+	y = y*level.scale + level.offset;
+	x = max(0.0f, min(x, float(w - 1)));
+	y = max(0.0f, min(y, float(h - 1)));
+
+	const int u0 = min((int)x, w - 1), v0 = min((int)y, h - 1);
+	const int u1 = min(u0 + 1, w - 1), v1 = min(v0 + 1, h - 1);
+	const float a = x - u0, b = y - v0;
+
+	const Color *row0 = s[v0], *row1 = s[v1];
+	if (level.cooked)
+		return (row0[u0]*(1 - a) + row0[u1]*a)*(1 - b)
+		     + (row1[u0]*(1 - a) + row1[u1]*a)*b;
+
+	const ColorPrep cooker;
+	return (cooker.cook(row0[u0])*(1 - a) + cooker.cook(row0[u1])*a)*(1 - b)
+	     + (cooker.cook(row1[u0])*(1 - a) + cooker.cook(row1[u1])*a)*b;
+}
+
+Color
+Mipmap::Sampler::operator()(float x, float y)const
+{
+	x -= tap_dx*(taps - 1)*0.5f;
+	y -= tap_dy*(taps - 1)*0.5f;
+
+	Color sum(0, 0, 0, 0);
+	for(int i = 0; i < taps; ++i, x += tap_dx, y += tap_dy)
+	{
+		Color c = bilinear(level[0], x, y);
+		if (weight > 0)
+			c = c*(1 - weight) + bilinear(level[1], x, y)*weight;
+		sum += c;
+	}
+	if (taps > 1)
+		sum *= 1.0f/taps;
+
+	return ColorPrep().uncook(sum);
+}
@@ -0,0 +1,119 @@
+/* === S Y N F I G ========================================================= */
+/*!	\file synfig/mipmap.h
+**	\brief Prefiltered downscaled copies of a bitmap
+**
+**	$Id$
+**
+**	\legal
+**	Copyright (c) 2016 Synfig contributors
+**
+**	This package is free software; you can redistribute it and/or
+**	modify it under the terms of the GNU General Public License as
+**	published by the Free Software Foundation; either version 2 of
+**	the License, or (at your option) any later version.
+**
+**	This package is distributed in the hope that it will be useful,
+**	but WITHOUT ANY WARRANTY; without even the implied warranty of
+**	MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE. See the GNU
+**	General Public License for more details.
+**	\endlegal
+*/
+/* ========================================================================= */
+
+/* === S T A R T =========================================================== */
+
+#ifndef __SYNFIG_MIPMAP_H
+#define __SYNFIG_MIPMAP_H
+
+/* === H E A D E R S ======================================================= */
+
+#include <vector>
+#include <ETL/handle>
+#include "real.h"
+#include "color.h"
+#include "surface.h"
+#include "mutex.h"
+
+/* === M A C R O S ========================================================= */
+
+/* === T Y P E D E F S ===================================================== */
+
+/* === C L A S S E S & S T R U C T S ======================================= */
+
+namespace synfig {
+
+/*!	\class Mipmap
+**	\brief Pyramid of a bitmap, each level half the size of the one before
+**
+**	The levels hold premultiplied colors, each texel being the average of
+**	2x2 texels of the level above. The bitmap itself is level 0 and is not
+**	copied, so it has to be passed to every call. Once built, the levels
+**	never change: a Mipmap may be shared by all the layers showing the same
+**	image (see Importer::get_mipmap()) and sampled from several threads.
+**	Whoever changes the pixels of the bitmap must drop its handle instead.
+*/
+class Mipmap : public etl::shared_object
+{
+public:
+	typedef etl::handle<Mipmap> Handle;
+
+	//! Number of taps along the major axis of a footprint, at most
+	static const int MAX_ANISOTROPY = 16;
+
+	//! Lookups of one footprint size, trilinear across levels and anisotropic along the longer side
+	class Sampler
+	{
+		struct Level
+		{
+			const Surface *surface;
+			bool cooked;	//!< False for level 0, which has straight colors
+			float scale, offset;
+		};
+
+		Level level[2];
+		float weight;	//!< Share of the smaller level
+		int taps;
+		float tap_dx, tap_dy;
+
+		static Color bilinear(const Level &level, float x, float y);
+
+	public:
+		//! Prepares lookups over \a dx by \a dy texels of \a base
+		Sampler(const Mipmap &mipmap, const Surface &base, Real dx, Real dy);
+
+		//! Straight color averaged over the footprint centered at \a x, \a y
+		/*!	The coordinates are in texels of the bitmap, texel centers being at integers */
+		Color operator()(float x, float y)const;
+	};
+
+private:
+	mutable Mutex mutex;
+	std::vector<Surface> levels;
+	int width, height;
+	bool built;
+
+	//! Non-copyable
+	Mipmap(const Mipmap&);
+	//! Non-assignable
+	void operator=(const Mipmap&);
+
+public:
+	Mipmap();
+
+	//! Builds the levels of \a base unless they are built already
+	/*!	\return \c false if the levels were built for a bitmap of another size,
+	**	in which case the caller needs a Mipmap of its own */
+	bool build(const Surface &base);
+
+	//! Number of levels, including the bitmap itself
+	int get_levels()const { return levels.size() + 1; }
+
+	//! Level \a i, with premultiplied colors. Level 0 is the bitmap and is not stored.
+	const Surface& get_level(int i)const { return levels[i - 1]; }
+}; // END of class Mipmap
+
+}; // END of namespace synfig
+
+/* === E N D =============================================================== */
+
+#endif
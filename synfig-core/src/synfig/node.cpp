@@ -33,6 +33,7 @@
 #include <cstdlib>
 #include <cstdio>
 #include "node.h"
+#include "mutex.h"
 // #include "nodebase.h"		// this defines a bunch of sigc::slots that are never used
 
 #ifdef HASH_MAP_H
@@ -91,6 +92,13 @@ typedef map<synfig::GUID,Node*> GlobalNodeMap;
 //! A map to store all the GUIDs with a pointer to the Node.
 static GlobalNodeMap* global_node_map_;
 
+//! Guards the map, nodes may be created and destroyed by several render threads
+static Mutex& global_node_map_mutex()
+{
+	static Mutex mutex;
+	return mutex;
+}
+
 static GlobalNodeMap& global_node_map()
 {
 	if(!global_node_map_)
@@ -103,6 +111,7 @@ static GlobalNodeMap& global_node_map()
 synfig::Node*
 synfig::find_node(const synfig::GUID& guid)
 {
+	Mutex::Lock lock(global_node_map_mutex());
 	if(global_node_map().count(guid)==0)
 		return 0;
 	return global_node_map()[guid];
@@ -111,6 +120,7 @@ synfig::find_node(const synfig::GUID& guid)
 static void
 refresh_node(synfig::Node* node, synfig::GUID old_guid)
 {
+	Mutex::Lock lock(global_node_map_mutex());
 	assert(global_node_map().count(old_guid));
 	global_node_map().erase(old_guid);
 	assert(!global_node_map().count(old_guid));
@@ -175,6 +185,7 @@ Node::Node():
 	deleting_(false)
 {
 #ifndef BE_FRUGAL_WITH_GUIDS
+	Mutex::Lock lock(global_node_map_mutex());
 	guid_.make_unique();
 	assert(guid_);
 	assert(!global_node_map().count(guid_));
@@ -188,6 +199,7 @@ Node::~Node()
 
 	if(guid_)
 	{
+		Mutex::Lock lock(global_node_map_mutex());
 		assert(global_node_map().count(guid_));
 		global_node_map().erase(guid_);
 		assert(!global_node_map().count(guid_));
@@ -209,6 +221,7 @@ Node::get_guid()const
 #ifdef BE_FRUGAL_WITH_GUIDS
 	if(!guid_)
 	{
+		Mutex::Lock lock(global_node_map_mutex());
 		const_cast<synfig::GUID&>(guid_).make_unique();
 		assert(guid_);
 		assert(!global_node_map().count(guid_));
@@ -228,6 +241,7 @@ Node::set_guid(const synfig::GUID& x)
 #ifdef BE_FRUGAL_WITH_GUIDS
 	if(!guid_)
 	{
+		Mutex::Lock lock(global_node_map_mutex());
 		guid_=x;
 		assert(!global_node_map().count(guid_));
 		global_node_map()[guid_]=this;
@@ -44,6 +44,10 @@
 #include "context.h"
 #include "surface.h"
 #include "cairo_renddesc.h"
+#include "threadpool.h"
+#include <vector>
+#include <algorithm>
+#include <cstring>
 
 
 #endif
@@ -468,49 +472,108 @@ synfig::cairorender(Context context,
 
 
 
-bool
-synfig::render_threaded(
-	Context context,
-	Target_Scanline::Handle target,
-	const RendDesc &desc,
-	ProgressCallback *callback,
-	int threads)
+namespace {
+
+//! Renders one scanline of \a surface through Context::get_color()
+class ParametricScanlineTask: public ThreadPool::Task
 {
-#ifndef WIN32
-    struct _render_thread
-    {
-		int
-			pipe_read,
-			pipe_write,
-			pid;
-		_render_thread():
-			pipe_read(), pipe_write(), pid()
+public:
+	Context context;
+	Color *colordata;
+	int w, a;
+	bool no_clamp;
+	Point::value_type su, v, du, dsu, dsv;
+
+	ParametricScanlineTask():
+		colordata(), w(), a(), no_clamp(), su(), v(), du(), dsu(), dsv() { }
+
+	virtual void run()
+	{
+		Point::value_type u;
+		int x, x2, y2;
+		Color::value_type pool;
+
+		for(x=0,u=su;x<w;x++,u+=du)
 		{
-			pipe(&pipe_read);
-			pid=0;
+			Color &c(colordata[x]);
+			c=Color::alpha();
+
+			// Loop through all subpixels
+			for(y2=0,pool=0;y2<a;y2++)
+				for(x2=0;x2<a;x2++)
+				{
+					Color color=context.get_color(
+						Point(
+							u+(Point::value_type)(x2)*dsu,
+							v+(Point::value_type)(y2)*dsv
+							)
+						);
+					if(!no_clamp)
+						color=color.clamped();
+					c+=color*color.get_a();
+					pool+=color.get_a();
+				}
+			if(pool)
+				c/=pool;
 		}
-		~_render_thread()
+	}
+};
+
+//! Renders a horizontal strip of the frame with the accelerated renderer
+class AcceleratedStripTask: public ThreadPool::Task
+{
+public:
+	Context context;
+	Surface *surface;
+	RendDesc desc;
+	int quality;
+	int y0, h;
+	bool success;
+
+	AcceleratedStripTask():
+		surface(), quality(), y0(), h(), success() { }
+
+	virtual void run()
+	{
+		success=false;
+		try
 		{
-			close(pipe_read);
-			close(pipe_write);
-			if(pid)
-			{
-				kill(pid,9);
-			}
+			RendDesc strip_desc(desc);
+			strip_desc.set_subwindow(0,y0,desc.get_w(),h);
+
+			Surface strip;
+			if(!context.accelerated_render(&strip,quality,strip_desc,0) || !strip)
+				return;
+
+			// strips never overlap, so writing into the shared
+			// surface needs no locking
+			Surface::pen pen(surface->get_pen(0,y0));
+			strip.blit_to(pen,0,0,strip.get_w(),strip.get_h());
+			success=true;
 		}
-    } *render_thread;
+		catch(...)
+		{
+			synfig::error("accelerated_render_threaded(): strip %d-%d failed",y0,y0+h);
+		}
+	}
+};
 
-    int i, mythread=-1;
+} // END of anonymous namespace
 
+bool
+synfig::render_threaded(
+	Context context,
+	Target_Scanline::Handle target,
+	const RendDesc &desc,
+	ProgressCallback *callback,
+	ThreadPool &thread_pool)
+{
 	Point::value_type
-		u,v,		// Current location in image
+		v,			// Current location in image
 		su,sv,		// Starting locations
 		du, dv,		// Distance between pixels
 		dsu,dsv;	// Distance between subpixels
 
-	bool
-		no_clamp=!desc.get_clamp();
-
 	int
 		w(desc.get_w()),
 		h(desc.get_h()),
@@ -520,13 +583,6 @@ synfig::render_threaded(
 		tl(desc.get_tl()),
 		br(desc.get_br());
 
-	int
-		x,y,		// Current location on output bitmap
-		x2,y2;		// Subpixel counters
-
-	Color::value_type
-		pool;		// Alpha pool (for correct alpha antialiasing)
-
 	assert(target);
 
 	// If we do not have a target then bail
@@ -545,64 +601,81 @@ synfig::render_threaded(
 	su=tl[0]+(du-dsu)/(Point::value_type)2.0;
 	sv=tl[1]-(dv-dsv)/(Point::value_type)2.0;
 
-    render_thread=new _render_thread[threads];
+	// Scanlines are rendered in bands, so the target receives them
+	// in order and the callback can abort between bands.
+	int band=thread_pool.get_threads()*8;
+	const bool parallel=context.is_thread_safe();
+	Surface buffer(w,band);
 
-	// Start the forks
-    for(i=0;i<threads;i++)
-    {
-		int pid=fork();
-		if(pid==0)
-		{
-	    	mythread=i;
-	    	goto renderthread;
-		}
-		render_thread[i].pid=pid;
-    }
+	std::vector<ParametricScanlineTask> scanline_tasks(band);
+	std::vector<ThreadPool::Task*> tasks;
 
 	// Mark the start of a new frame.
 	if(!target->start_frame(callback))
 		return false;
 
-    for(y=0;y<h;y++)
-    {
-		// Set the current pixel pointer
-		// to the start of the line
-		Color *colordata(target->start_scanline(y));
-
-		if(!colordata)
-		{
-			if(callback)callback->error(_("Target panic"));
-			else throw(string(_("Target panic")));
-			return false;
-		}
-
+	for(int y0=0;y0<h;y0+=band)
+	{
 		// If we have a callback that we need
 		// to report to, do so now.
 		if(callback)
-			if( callback->amount_complete(y,h) == false )
+			if( callback->amount_complete(y0,h) == false )
 			{
 				// If the callback returns false,
 				// then the render has been aborted.
 				// Exit gracefully.
-
-				target->end_scanline();
 				target->end_frame();
-				delete [] render_thread;
 				return false;
 			}
 
-		read(render_thread[y%threads].pipe_read,colordata,w*sizeof(Color));
+		int rows=std::min(band,h-y0);
+		tasks.clear();
+		for(int i=0;i<rows;i++)
+		{
+			ParametricScanlineTask &task(scanline_tasks[i]);
+			task.context=context;
+			task.colordata=buffer[i];
+			task.w=w;
+			task.a=a;
+			task.no_clamp=!desc.get_clamp();
+			task.su=su;
+			task.v=sv+dv*(Point::value_type)(y0+i);
+			task.du=du;
+			task.dsu=dsu;
+			task.dsv=dsv;
+			tasks.push_back(&task);
+		}
+		if(parallel)
+			thread_pool.run(tasks);
+		else
+			for(int i=0;i<rows;i++)
+				tasks[i]->run();
 
-		// Send the buffer to the render target.
-		// If anything goes wrong, cleanup and bail.
-		if(!target->end_scanline())
+		for(int i=0;i<rows;i++)
 		{
-			delete [] render_thread;
-			if(callback)callback->error(_("Target panic"));
-			else throw(string(_("Target panic")));
-			return false;
+			// Set the current pixel pointer
+			// to the start of the line
+			Color *colordata(target->start_scanline(y0+i));
+
+			if(!colordata)
+			{
+				if(callback)callback->error(_("Target panic"));
+				else throw(string(_("Target panic")));
+				return false;
+			}
+
+			memcpy(colordata,buffer[i],w*sizeof(Color));
+
+			// Send the buffer to the render target.
+			// If anything goes wrong, cleanup and bail.
+			if(!target->end_scanline())
+			{
+				if(callback)callback->error(_("Target panic"));
+				else throw(string(_("Target panic")));
+				return false;
+			}
 		}
-    }
+	}
 
 	// Finish up the target's frame
 	target->end_frame();
@@ -613,65 +686,69 @@ synfig::render_threaded(
 	if(callback)
 		callback->amount_complete(h,h);
 
-    delete [] render_thread;
-    return true;
+	return true;
+}
 
-renderthread:
+bool
+synfig::render_threaded(
+	Context context,
+	Target_Scanline::Handle target,
+	const RendDesc &desc,
+	ProgressCallback *callback,
+	int threads)
+{
+	ThreadPool thread_pool(threads);
+	return render_threaded(context, target, desc, callback, thread_pool);
+}
 
-	// Change the random seed, so that each thread has a different one
-	srand(mythread*20+threads+time(0));
+bool
+synfig::accelerated_render_threaded(
+	Context context,
+	Surface *surface,
+	int quality,
+	const RendDesc &desc,
+	ProgressCallback *callback,
+	ThreadPool &thread_pool)
+{
+	assert(surface);
 
-	Color *buffer(new Color[w]);
+	int
+		w(desc.get_w()),
+		h(desc.get_h());
 
-	// Loop through all horizontal lines
-	for(y=mythread,v=sv+dv*(Real)mythread;y<h;y+=threads,v+=dv*(Real)threads)
-	{
-		// Set the current pixel pointer
-		// to the start of the line
-		Color* colordata(buffer);
+	// Nothing to share between threads, or layers which can't be shared
+	if(thread_pool.get_threads()<=1 || h<2 || !context.is_thread_safe())
+		return context.accelerated_render(surface,quality,desc,callback);
 
-		// Loop through every pixel in row
-		for(x=0,u=su;x<w;x++,u+=du)
-		{
-			Color &c(*(colordata++));
-			c=Color::alpha();
+	if(callback && !callback->amount_complete(0,h))
+		return false;
 
-			// Loop through all subpixels
-			for(y2=0,pool=0;y2<a;y2++)
-				for(x2=0;x2<a;x2++)
-				{
-					Color color=context.get_color(
-						Point(
-							u+(Point::value_type)(x2)*dsu,
-							v+(Point::value_type)(y2)*dsv
-							)
-						);
-					if(!no_clamp)
-					{
-						color=color.clamped();
-						c+=color*color.get_a();
-						pool+=color.get_a();
-					}
-					else
-					{
-						c+=color*color.get_a();
-						pool+=color.get_a();
-					}
-				}
-			if(pool)
-				c/=pool;
-		}
+	// Use several strips per thread, so the work stealing
+	// can balance strips of different complexity
+	int strips=std::min(h,thread_pool.get_threads()*4);
+	surface->set_wh(w,h);
 
-		// Send the buffer to the primary thread.
-		write(render_thread[mythread].pipe_write,buffer,w*sizeof(Color));
+	std::vector<AcceleratedStripTask> strip_tasks(strips);
+	std::vector<ThreadPool::Task*> tasks;
+	for(int i=0;i<strips;i++)
+	{
+		AcceleratedStripTask &task(strip_tasks[i]);
+		task.context=context;
+		task.surface=surface;
+		task.desc=desc;
+		task.quality=quality;
+		task.y0=h*i/strips;
+		task.h=h*(i+1)/strips-task.y0;
+		tasks.push_back(&task);
 	}
+	thread_pool.run(tasks);
 
-	delete [] buffer;
+	for(int i=0;i<strips;i++)
+		if(!strip_tasks[i].success)
+			return false;
 
-    _exit(0);
-	return false;
-#else
-	return render(context, target, desc, callback);
+	if(callback && !callback->amount_complete(h,h))
+		return false;
 
-#endif
+	return true;
 }
@@ -48,6 +48,8 @@
 
 namespace synfig {
 
+class ThreadPool;
+
 //! Renders starting at \a context to \a target
 /*! \warning \a Target::set_rend_desc() must have
 **		already been called on \a target before
@@ -59,12 +61,32 @@ extern bool cairorender(Context context, cairo_t* cr, const RendDesc &desc, Prog
 
 extern bool parametric_render(Context context, Surface &surface, const RendDesc &desc,ProgressCallback *);
 
+//! Renders starting at \a context to \a target using \a threads threads
+/*! Scanlines are distributed over a ThreadPool created for this call. */
 extern bool render_threaded(	Context context,
 	Target_Scanline::Handle target,
 	const RendDesc &desc,
 	ProgressCallback *callback,
 	int threads);
 
+//! Renders starting at \a context to \a target using the threads of \a thread_pool,
+//! or only the calling one if the context isn't thread safe
+extern bool render_threaded(	Context context,
+	Target_Scanline::Handle target,
+	const RendDesc &desc,
+	ProgressCallback *callback,
+	ThreadPool &thread_pool);
+
+//! Accelerated render of \a context split in horizontal strips over \a thread_pool
+/*! Falls back to Context::accelerated_render() for a single thread, and for
+**	a context which isn't thread safe, see IndependentContext::is_thread_safe(). */
+extern bool accelerated_render_threaded(	Context context,
+	Surface *surface,
+	int quality,
+	const RendDesc &desc,
+	ProgressCallback *callback,
+	ThreadPool &thread_pool);
+
 }; /* end namespace synfig */
 
 /* -- E N D ----------------------------------------------------------------- */
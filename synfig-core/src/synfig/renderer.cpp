@@ -215,25 +215,25 @@ Renderer::Result Renderer::render(const Params &params, const PrimitiveBase &pri
 	{
 		const Primitive<PrimitiveTypeSurface>* p =
 			dynamic_cast<const Primitive<PrimitiveTypeSurface>*>(&primitive);
-		return p == NULL ? ResultFail : Renderer::render_surface(params, *p);
+		return p == NULL ? ResultFail : render_surface(params, *p);
 	}
 	case PrimitiveTypePolygon:
 	{
 		const Primitive<PrimitiveTypePolygon>* p =
 			dynamic_cast<const Primitive<PrimitiveTypePolygon>*>(&primitive);
-		return p == NULL ? ResultFail : Renderer::render_polygon(params, *p);
+		return p == NULL ? ResultFail : render_polygon(params, *p);
 	}
 	case PrimitiveTypeColoredPolygon:
 	{
 		const Primitive<PrimitiveTypeColoredPolygon>* p =
 			dynamic_cast<const Primitive<PrimitiveTypeColoredPolygon>*>(&primitive);
-		return p == NULL ? ResultFail : Renderer::render_colored_polygon(params, *p);
+		return p == NULL ? ResultFail : render_colored_polygon(params, *p);
 	}
 	case PrimitiveTypeMesh:
 	{
 		const Primitive<PrimitiveTypeMesh>* p =
 			dynamic_cast<const Primitive<PrimitiveTypeMesh>*>(&primitive);
-		return p == NULL ? ResultFail : Renderer::render_mesh(params, *p);
+		return p == NULL ? ResultFail : render_mesh(params, *p);
 	}
 	default:
 		break;
@@ -30,6 +30,8 @@
 #include <ETL/handle>
 #include <map>
 #include <limits>
+#include "real.h"
+#include "color.h"
 
 /* === M A C R O S ========================================================= */
 
@@ -186,7 +188,7 @@ public:
 		Primitive(): PrimitiveBase(primitive_type) { }
 
 		template<typename RendererType>
-		const typename TypesTemplate<RendererType, primitive_type>::Data* get()
+		const typename TypesTemplate<RendererType, primitive_type>::Data* get() const
 		{
 			typedef PrimitiveData<typename TypesTemplate<RendererType, primitive_type>::Data> PrimitiveData;
 			typedef typename PrimitiveData::ConstHandle ConstHandle;
@@ -220,6 +222,7 @@ public:
 
 	template<typename T>
 	class TypesTemplateBase {
+	public:
 		typedef T Data;
 		typedef PrimitiveData<Data> Primitive;
 	};
@@ -242,11 +245,18 @@ public:
 
 	class Params {
 	public:
-		// TODO: blend method, color
+		// TODO: color
 		PrimitiveBase *out_surface;
 		const PrimitiveBase *back_surface;
 		const PrimitiveBase *mesh_texture_surface;
-		inline Params(): out_surface(NULL), back_surface(NULL), mesh_texture_surface(NULL) { }
+		Color::BlendMethod blend_method;
+		Real alpha;
+		inline Params():
+			out_surface(NULL),
+			back_surface(NULL),
+			mesh_texture_surface(NULL),
+			blend_method(Color::BLEND_COMPOSITE),
+			alpha(1.0) { }
 	};
 
 	enum Result {
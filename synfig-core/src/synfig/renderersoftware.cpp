@@ -36,6 +36,10 @@
 #endif
 
 #include "renderersoftware.h"
+#include "threadpool.h"
+
+#include <vector>
+#include <algorithm>
 
 #endif
 
@@ -55,10 +59,17 @@ Renderer::RendererId RendererSoftware::id = 0;
 
 Renderer::RendererId RendererSoftware::get_id() { return id; }
 
+Renderer::RendererId Renderer::TypesTemplate<RendererSoftware, Renderer::PrimitiveTypeSurface>::get_id()
+	{ return RendererSoftware::get_id(); }
+Renderer::RendererId Renderer::TypesTemplate<RendererSoftware, Renderer::PrimitiveTypeMesh>::get_id()
+	{ return RendererSoftware::get_id(); }
+
 void RendererSoftware::initialize()
 {
 	if (id != 0) return;
 	register_renderer(id);
+	register_func_create(KeyCreate(PrimitiveTypeSurface, id), func_default_create<PrimitiveData<synfig::Surface> >);
+	register_func_create(KeyCreate(PrimitiveTypeMesh, id), func_default_create<PrimitiveData<synfig::Mesh> >);
 	// TODO:
 }
 
@@ -69,6 +80,7 @@ void RendererSoftware::deinitialize()
 
 RendererSoftware::RendererSoftware()
 {
+	supported_primitives[PrimitiveTypeMesh] = true;
 	// TODO:
 }
 
@@ -78,8 +90,37 @@ Renderer::Result RendererSoftware::render_polygon(const Params &/* params */, co
 	{ return ResultNotSupported; }
 Renderer::Result RendererSoftware::render_colored_polygon(const Params &/* params */, const Primitive<PrimitiveTypeColoredPolygon> &/* primitive */)
 	{ return ResultNotSupported; }
-Renderer::Result RendererSoftware::render_mesh(const Params &/* params */, const Primitive<PrimitiveTypeMesh> &/* primitive */)
-	{ return ResultNotSupported; }
+
+Renderer::Result RendererSoftware::render_mesh(const Params &params, const Primitive<PrimitiveTypeMesh> &primitive)
+{
+	PrimitiveSurface *out_surface = dynamic_cast<PrimitiveSurface*>(params.out_surface);
+	const PrimitiveSurface *back_surface = dynamic_cast<const PrimitiveSurface*>(params.back_surface);
+	const PrimitiveSurface *texture_surface = dynamic_cast<const PrimitiveSurface*>(params.mesh_texture_surface);
+	if (out_surface == NULL || texture_surface == NULL) return ResultFail;
+
+	const synfig::Mesh *mesh = primitive.get<RendererType>();
+	const synfig::Surface *texture = texture_surface->get<RendererType>();
+	if (mesh == NULL || texture == NULL) return ResultFail;
+
+	// the background is read before the output is opened for editing,
+	// they may be the same primitive
+	synfig::Surface back;
+	if (back_surface != NULL && back_surface != out_surface)
+	{
+		const synfig::Surface *surface = back_surface->get<RendererType>();
+		if (surface == NULL) return ResultFail;
+		back = *surface;
+	}
+
+	synfig::Surface *surface = out_surface->begin_edit<RendererType>();
+	if (surface == NULL) return ResultFail;
+	if (back.is_valid()) *surface = back;
+
+	// the vertices are in the pixels of the surfaces already
+	render_mesh(*surface, *mesh, *texture, Matrix(), Matrix(), params.alpha, params.blend_method);
+	out_surface->end_edit();
+	return ResultSuccess;
+}
 
 
 struct RendererSoftware::Helper {
@@ -119,6 +160,276 @@ struct RendererSoftware::IntVector {
 	inline long long get_fixed_x_div_y() { return y == 0 ? 0 : Helper::int_to_fixed(x)/y; }
 };
 
+//! Draws triangles a span at a time, in parallel bands of rows
+struct RendererSoftware::Rasterizer {
+	//! Triangle converted to pixels, ready to be drawn
+	struct Triangle {
+		IntVector p0, p1, p2;
+		//! From the target to the texture, if the triangle has one
+		Matrix matrix;
+		Vector tdx;
+	};
+
+	//! Draws a span of one color
+	struct ColorSpans {
+		synfig::Surface &target;
+		//! As wide as the target and filled with the color
+		const Color *colors;
+		Color::BlendMethod blend_method;
+
+		ColorSpans(synfig::Surface &target, const Color *colors, Color::BlendMethod blend_method):
+			target(target), colors(colors), blend_method(blend_method) { }
+
+		void operator() (const Triangle &/* triangle */, int y, int x0, int x1) const
+			{ Color::blend_span(target[y] + x0, colors, x1 - x0 + 1, 1.0, blend_method); }
+	};
+
+	//! Draws a span of the texture
+	/*!	The samples are gathered into a row, and each run of pixels inside
+	**	the texture is blended at once. The pixels outside are left alone. */
+	struct TextureSpans {
+		synfig::Surface &target;
+		const synfig::Surface &texture;
+		Vector tex_size;
+		Real alpha;
+		Color::BlendMethod blend_method;
+		//! As wide as the target
+		Color *row;
+
+		TextureSpans(synfig::Surface &target, const synfig::Surface &texture, Real alpha, Color::BlendMethod blend_method, Color *row):
+			target(target),
+			texture(texture),
+			tex_size(Real(texture.get_w()), Real(texture.get_h())),
+			alpha(alpha),
+			blend_method(blend_method),
+			row(row)
+		{ }
+
+		void operator() (const Triangle &triangle, int y, int x0, int x1) const
+		{
+			Color *dest = target[y];
+			Vector tex_point = triangle.matrix.get_transformed(Vector(Real(x0), Real(y)));
+			int run = x0;
+			for(int x = x0; x <= x1; ++x)
+			{
+				if (tex_point[0] < 0.0 || tex_point[0] > tex_size[0]
+				 || tex_point[1] < 0.0 || tex_point[1] > tex_size[1])
+				{
+					if (run < x)
+						Color::blend_span(dest + run, row + run, x - run, alpha, blend_method);
+					run = x + 1;
+				}
+				else
+					row[x] = texture.cubic_sample(tex_point[0], tex_point[1]);
+				tex_point += triangle.tdx;
+			}
+			if (run <= x1)
+				Color::blend_span(dest + run, row + run, x1 - run + 1, alpha, blend_method);
+		}
+	};
+
+	//! Calls <tt>spans(triangle, y, x0, x1)</tt> for the rows of a triangle from \a row_begin to \a row_end
+	/*!	The edges are stepped in the same fixed point as when the triangle is drawn
+	**	whole, so the bands of a triangle join without seams or overlaps. */
+	template<typename Spans>
+	static void draw(const Triangle &triangle, int width, int height, int row_begin, int row_end, const Spans &spans)
+	{
+		IntVector ip0(triangle.p0), ip1(triangle.p1), ip2(triangle.p2);
+
+		// sort points
+		if (ip0.y > ip1.y) swap(ip0, ip1);
+		if (ip0.y > ip2.y) swap(ip0, ip2);
+		if (ip1.y > ip2.y) swap(ip1, ip2);
+
+		// increments
+		long long dx02 = (ip2-ip0).get_fixed_x_div_y();
+		long long dx01 = (ip1-ip0).get_fixed_x_div_y();
+		long long dx12 = (ip2-ip1).get_fixed_x_div_y();
+
+		row_begin = std::max(row_begin, 0);
+		row_end = std::min(row_end, height);
+
+		// top part of triangle, from the top point (p0)
+		long long wx = Helper::int_to_fixed(ip0.x);
+		long long left = std::min(dx02, dx01), right = std::max(dx02, dx01);
+		for(int y = std::max(ip0.y, row_begin); y < std::min(ip1.y, row_end); ++y)
+			draw_row(triangle, width, y, wx + left*(y - ip0.y), wx + right*(y - ip0.y), spans);
+
+		// bottom part of triangle
+		long long wx0, wx1;
+		if (ip0.y == ip1.y)
+		{
+			wx0 = Helper::int_to_fixed(ip0.x);
+			wx1 = Helper::int_to_fixed(ip1.x);
+			if (wx0 > wx1) swap(wx0, wx1);
+		}
+		else
+		{
+			wx0 = wx + left*(ip1.y - ip0.y);
+			wx1 = wx + right*(ip1.y - ip0.y);
+		}
+		left = std::max(dx02, dx12);
+		right = std::min(dx02, dx12);
+		for(int y = std::max(ip1.y, row_begin); y <= std::min(ip2.y, row_end - 1); ++y)
+			draw_row(triangle, width, y, wx0 + left*(y - ip1.y), wx1 + right*(y - ip1.y), spans);
+	}
+
+	template<typename Spans>
+	static void draw_row(const Triangle &triangle, int width, int y, long long wx0, long long wx1, const Spans &spans)
+	{
+		int x0 = Helper::fixed_to_int(wx0);
+		int x1 = Helper::fixed_to_int(wx1);
+		if (x0 < 0) x0 = 0;
+		if (x1 >= width) x1 = width-1;
+		if (x1 >= x0)
+			spans(triangle, y, x0, x1);
+	}
+
+	//! Converts the corners to pixels, \return \c false if nothing would be drawn
+	static bool prepare(const synfig::Surface &target_surface, const Vector &p0, const Vector &p1, const Vector &p2, Triangle &triangle)
+	{
+		// convert points to int
+		IntVector ip0(p0), ip1(p1), ip2(p2);
+		if (ip0 == ip1 || ip0 == ip2 || ip1 == ip2) return false;
+
+		if (ip0.x < 0 && ip1.x < 0 && ip2.x < 0) return false;
+		if (ip0.y < 0 && ip1.y < 0 && ip2.y < 0) return false;
+
+		int width = target_surface.get_w();
+		int height = target_surface.get_h();
+		if (width == 0 || height == 0) return false;
+
+		if (ip0.x >= width && ip1.x >= width && ip2.x >= width) return false;
+		if (ip0.y >= height && ip1.y >= height && ip2.y >= height) return false;
+
+		triangle.p0 = ip0;
+		triangle.p1 = ip1;
+		triangle.p2 = ip2;
+		return true;
+	}
+
+	//! Also prepares the mapping to the texture
+	static bool prepare(
+		const synfig::Surface &target_surface,
+		const Vector &p0,
+		const Vector &t0,
+		const Vector &p1,
+		const Vector &t1,
+		const Vector &p2,
+		const Vector &t2,
+		const synfig::Surface &texture,
+		Triangle &triangle )
+	{
+		if (t0[0] < 0.0 && t1[0] < 0.0 && t2[0] < 0.0) return false;
+		if (t0[1] < 0.0 && t1[1] < 0.0 && t2[1] < 0.0) return false;
+
+		if (!prepare(target_surface, p0, p1, p2, triangle)) return false;
+
+		int tex_width = texture.get_w();
+		int tex_height = texture.get_h();
+		if (tex_width == 0 || tex_height == 0) return false;
+		Vector tex_size = Vector(Real(tex_width), Real(tex_height));
+
+		if (t0[0] > tex_size[0] && t1[0] > tex_size[0] && t2[0] > tex_size[0]) return false;
+		if (t0[1] > tex_size[1] && t1[1] > tex_size[1] && t2[1] > tex_size[1]) return false;
+
+		// prepare texture matrix
+		Matrix matrix_of_texture_triangle(
+			t1[0]-t0[0], t1[1]-t0[1], 0.0,
+			t2[0]-t0[0], t2[1]-t0[1], 0.0,
+			t0[0], t0[1], 1.0 );
+		Matrix matrix_of_target_triangle(
+			p1[0]-p0[0], p1[1]-p0[1], 0.0,
+			p2[0]-p0[0], p2[1]-p0[1], 0.0,
+			p0[0], p0[1], 1.0 );
+		matrix_of_target_triangle.invert();
+
+		triangle.matrix = matrix_of_target_triangle * matrix_of_texture_triangle;
+		triangle.tdx = triangle.matrix.get_transformed(Vector(1.0, 0.0), false);
+		return true;
+	}
+
+	//! Draws the triangles of some bands of rows, in their order
+	struct Bands {
+		synfig::Surface &target;
+		const std::vector<Triangle> &triangles;
+		//! Triangles crossing each band
+		const std::vector< std::vector<int> > &bins;
+		const synfig::Surface *texture;
+		Real alpha;
+		Color color;
+		Color::BlendMethod blend_method;
+
+		Bands(
+			synfig::Surface &target,
+			const std::vector<Triangle> &triangles,
+			const std::vector< std::vector<int> > &bins,
+			const synfig::Surface *texture,
+			Real alpha,
+			const Color &color,
+			Color::BlendMethod blend_method
+		):
+			target(target), triangles(triangles), bins(bins), texture(texture),
+			alpha(alpha), color(color), blend_method(blend_method) { }
+
+		void operator() (int begin, int end) const
+		{
+			const int width = target.get_w(), height = target.get_h();
+			const int bands = bins.size();
+			std::vector<Color> row(width, color);
+			for(int band = begin; band < end; ++band)
+			{
+				const int row_begin = get_band_row(band, bands, height);
+				const int row_end = get_band_row(band + 1, bands, height);
+				for(std::vector<int>::const_iterator i = bins[band].begin(); i != bins[band].end(); ++i)
+					if (texture)
+						draw(triangles[*i], width, height, row_begin, row_end,
+							TextureSpans(target, *texture, alpha, blend_method, &row.front()));
+					else
+						draw(triangles[*i], width, height, row_begin, row_end,
+							ColorSpans(target, &row.front(), blend_method));
+			}
+		}
+	};
+
+	static int get_band_row(int band, int bands, int height)
+		{ return (int)((long long)height*band/bands); }
+
+	//! Draws \a triangles in order, with a texture or in one color
+	/*!	The triangles are sorted into bands of rows first, then each band
+	**	is drawn by its own thread. */
+	static void draw_all(
+		synfig::Surface &target,
+		const std::vector<Triangle> &triangles,
+		const synfig::Surface *texture,
+		Real alpha,
+		const Color &color,
+		Color::BlendMethod blend_method )
+	{
+		const int height = target.get_h();
+		if (triangles.empty() || height <= 0) return;
+
+		ThreadPool &pool = ThreadPool::instance();
+		const int bands = std::min(height, pool.get_threads()*4);
+
+		std::vector< std::vector<int> > bins(bands);
+		for(int i = 0; i < (int)triangles.size(); ++i)
+		{
+			const Triangle &t = triangles[i];
+			const int y0 = std::max(0, std::min(t.p0.y, std::min(t.p1.y, t.p2.y)));
+			const int y1 = std::min(height - 1, std::max(t.p0.y, std::max(t.p1.y, t.p2.y)));
+			if (y0 > y1) continue;
+			int band = (int)((long long)y0*bands/height);
+			while (band > 0 && get_band_row(band, bands, height) > y0) --band;
+			for(; band < bands && get_band_row(band, bands, height) <= y1; ++band)
+				if (get_band_row(band + 1, bands, height) > y0)
+					bins[band].push_back(i);
+		}
+
+		pool.run_bands(Bands(target, triangles, bins, texture, alpha, color, blend_method), bands, bands);
+	}
+};
+
 void
 RendererSoftware::render_triangle(
 	synfig::Surface &target_surface,
@@ -128,104 +439,12 @@ RendererSoftware::render_triangle(
 	const Color &color,
 	Color::BlendMethod blend_method )
 {
-	// convert points to int
-	IntVector ip0(p0), ip1(p1), ip2(p2);
-	if (ip0 == ip1 || ip0 == ip2 || ip1 == ip2) return;
-
-	if (ip0.x < 0 && ip1.x < 0 && ip2.x < 0) return;
-	if (ip0.y < 0 && ip1.y < 0 && ip2.y < 0) return;
-
-	int width = target_surface.get_w();
-	int height = target_surface.get_h();
-	if (width == 0 || height == 0) return;
-
-	if (ip0.x >= width && ip1.x >= width && ip2.x >= width) return;
-	if (ip0.y >= height && ip1.y >= height && ip2.y >= height) return;
-
-	Surface::alpha_pen apen(target_surface.get_pen(0, 0));
-	apen.set_alpha(1.0);
-	apen.set_blend_method(blend_method);
-
-    // sort points
-    if (ip0.y > ip1.y) swap(ip0, ip1);
-    if (ip0.y > ip2.y) swap(ip0, ip2);
-    if (ip1.y > ip2.y) swap(ip1, ip2);
-
-    // increments
-    long long dx02 = (ip2-ip0).get_fixed_x_div_y();
-    long long dx01 = (ip1-ip0).get_fixed_x_div_y();
-    long long dx12 = (ip2-ip1).get_fixed_x_div_y();
-
-    // work points
-    // initially at top point (p0)
-    long long wx0 = Helper::int_to_fixed(ip0.x);
-    long long wx1 = wx0;
-
-    // process top part of triangle
-
-    // make copy of dx02
-    long long dx02_copy = dx02;
-    // sort increments
-    if (dx01 < dx02) swap(dx02, dx01);
-    // rasterize
-    for (int y = ip0.y; y < ip1.y; ++y)
-    {
-		// draw horizontal line (this code has a copy below)
-    	if (y >= 0 && y < height)
-    	{
-			int x0 = Helper::fixed_to_int(wx0);
-			int x1 = Helper::fixed_to_int(wx1);
-			if (x0 < 0) x0 = 0;
-			if (x1 >= width) x1 = width-1;
-			if (x1 >= x0)
-			{
-				apen.move_to(x0, y);
-				for(int x = x0; x <= x1; ++x)
-				{
-					apen.put_value(color);
-					apen.inc_x();
-				}
-			}
-    	}
-
-		wx0 += dx02;
-		wx1 += dx01;
-    }
-
-    if (ip0.y == ip1.y) {
-		wx0 = Helper::int_to_fixed(ip0.x);
-		wx1 = Helper::int_to_fixed(ip1.x);
-		if (wx0 > wx1) swap(wx0, wx1);
-    }
-
-    // process bottom part of triangle
-
-    // sort increments
-    if (dx02_copy < dx12) swap(dx02_copy, dx12);
-
-    // rasterize
-    for (int y = ip1.y; y <= ip2.y; ++y){
-		// draw horizontal line (this code has a copy above)
-    	if (y >= 0 && y < height)
-    	{
-			int x0 = Helper::fixed_to_int(wx0);
-			int x1 = Helper::fixed_to_int(wx1);
-			if (x0 < 0) x0 = 0;
-			if (x1 >= width) x1 = width-1;
-			if (x1 >= x0)
-			{
-				apen.move_to(x0, y);
-				for(int x = x0; x <= x1; ++x)
-				{
-					apen.put_value(color);
-					apen.inc_x();
-				}
-			}
-    	}
+	Rasterizer::Triangle triangle;
+	if (!Rasterizer::prepare(target_surface, p0, p1, p2, triangle)) return;
 
-		wx0 += dx02_copy;
-		wx1 += dx12;
-    }
+	std::vector<Color> row(target_surface.get_w(), color);
+	Rasterizer::draw(triangle, target_surface.get_w(), target_surface.get_h(), 0, target_surface.get_h(),
+		Rasterizer::ColorSpans(target_surface, &row.front(), blend_method));
 }
 
 void
@@ -241,154 +460,12 @@ RendererSoftware::render_triangle(
 	Real alpha,
 	Color::BlendMethod blend_method )
 {
-	if (t0[0] < 0.0 && t1[0] < 0.0 && t2[0] < 0.0) return;
-	if (t0[1] < 0.0 && t1[1] < 0.0 && t2[1] < 0.0) return;
-
-	// convert points to int
-	IntVector ip0(p0), ip1(p1), ip2(p2);
-	if (ip0 == ip1 || ip0 == ip2 || ip1 == ip2) return;
-
-	if (ip0.x < 0 && ip1.x < 0 && ip2.x < 0) return;
-	if (ip0.y < 0 && ip1.y < 0 && ip2.y < 0) return;
-
-	int width = target_surface.get_w();
-	int height = target_surface.get_h();
-	if (width == 0 || height == 0) return;
-
-	if (ip0.x >= width && ip1.x >= width && ip2.x >= width) return;
-	if (ip0.y >= height && ip1.y >= height && ip2.y >= height) return;
-
-	int tex_width = texture.get_w();
-	int tex_height = texture.get_h();
-	if (tex_width == 0 || tex_height == 0) return;
-	Vector tex_size = Vector(Real(tex_width), Real(tex_height));
-
-	if (t0[0] > tex_size[0] && t1[0] > tex_size[0] && t2[0] > tex_size[0]) return;
-	if (t0[1] > tex_size[1] && t1[1] > tex_size[1] && t2[1] > tex_size[1]) return;
-
-	// prepare texture matrix
-	Matrix matrix_of_texture_triangle(
-		t1[0]-t0[0], t1[1]-t0[1], 0.0,
-		t2[0]-t0[0], t2[1]-t0[1], 0.0,
-		t0[0], t0[1], 1.0 );
-	Matrix matrix_of_target_triangle(
-		p1[0]-p0[0], p1[1]-p0[1], 0.0,
-		p2[0]-p0[0], p2[1]-p0[1], 0.0,
-		p0[0], p0[1], 1.0 );
-	matrix_of_target_triangle.invert();
-
-	Matrix matrix = matrix_of_target_triangle * matrix_of_texture_triangle;
-	Vector tdx = matrix.get_transformed(Vector(1.0, 0.0), false);
-	//Vector tdy = matrix.get_transformed(Vector(0.0, 1.0), false);
-
-	Surface::alpha_pen apen(target_surface.get_pen(0, 0));
-	apen.set_alpha(alpha);
-	apen.set_blend_method(blend_method);
-
-    // sort points
-    if (ip0.y > ip1.y) swap(ip0, ip1);
-    if (ip0.y > ip2.y) swap(ip0, ip2);
-    if (ip1.y > ip2.y) swap(ip1, ip2);
-
-    // increments
-    long long dx02 = (ip2-ip0).get_fixed_x_div_y();
-    long long dx01 = (ip1-ip0).get_fixed_x_div_y();
-    long long dx12 = (ip2-ip1).get_fixed_x_div_y();
-
-    // work points
-    // initially at top point (p0)
-    long long wx0 = Helper::int_to_fixed(ip0.x);
-    long long wx1 = wx0;
-
-    // process top part of triangle
-
-    // make copy of dx02
-    long long dx02_copy = dx02;
-    // sort increments
-    if (dx01 < dx02) swap(dx02, dx01);
-    // rasterize
-    for (int y = ip0.y; y < ip1.y; ++y)
-    {
-		// draw horizontal line (this code has a copy below)
-    	if (y >= 0 && y < height)
-    	{
-			int x0 = Helper::fixed_to_int(wx0);
-			int x1 = Helper::fixed_to_int(wx1);
-			if (x0 < 0) x0 = 0;
-			if (x1 >= width) x1 = width-1;
-			if (x1 >= x0)
-			{
-				apen.move_to(x0, y);
-				Vector tex_point = matrix.get_transformed(Vector(Real(x0), Real(y)));
-				for(int x = x0; x <= x1; ++x)
-				{
-					if (tex_point[0] < 0.0 || tex_point[0] > tex_size[0]
-					 || tex_point[1] < 0.0 || tex_point[1] > tex_size[1])
-					{
-						apen.set_alpha(0.0);
-						apen.put_value(Color());
-					}
-					else
-					{
-						apen.set_alpha(alpha);
-						apen.put_value(texture.cubic_sample(tex_point[0], tex_point[1]));
-					}
-					apen.inc_x();
-					tex_point += tdx;
-				}
-			}
-    	}
-
-		wx0 += dx02;
-		wx1 += dx01;
-    }
-
-    if (ip0.y == ip1.y) {
-		wx0 = Helper::int_to_fixed(ip0.x);
-		wx1 = Helper::int_to_fixed(ip1.x);
-		if (wx0 > wx1) swap(wx0, wx1);
-    }
-
-    // process bottom part of triangle
-
-    // sort increments
-    if (dx02_copy < dx12) swap(dx02_copy, dx12);
-
-    // rasterize
-    for (int y = ip1.y; y <= ip2.y; ++y){
-		// draw horizontal line (this code has a copy above)
-    	if (y >= 0 && y < height)
-    	{
-			int x0 = Helper::fixed_to_int(wx0);
-			int x1 = Helper::fixed_to_int(wx1);
-			if (x0 < 0) x0 = 0;
-			if (x1 >= width) x1 = width-1;
-			if (x1 >= x0)
-			{
-				apen.move_to(x0, y);
-				Vector tex_point = matrix.get_transformed(Vector(Real(x0), Real(y)));
-				for(int x = x0; x <= x1; ++x)
-				{
-					if (tex_point[0] < 0.0 || tex_point[0] > tex_size[0]
-					 || tex_point[1] < 0.0 || tex_point[1] > tex_size[1])
-					{
-						apen.set_alpha(0.0);
-						apen.put_value(Color());
-					}
-					else
-					{
-						apen.set_alpha(alpha);
-						apen.put_value(texture.cubic_sample(tex_point[0], tex_point[1]));
-					}
-					apen.inc_x();
-					tex_point += tdx;
-				}
-			}
-    	}
+	Rasterizer::Triangle triangle;
+	if (!Rasterizer::prepare(target_surface, p0, t0, p1, t1, p2, t2, texture, triangle)) return;
 
-		wx0 += dx02_copy;
-		wx1 += dx12;
-    }
+	std::vector<Color> row(target_surface.get_w());
+	Rasterizer::draw(triangle, target_surface.get_w(), target_surface.get_h(), 0, target_surface.get_h(),
+		Rasterizer::TextureSpans(target_surface, texture, alpha, blend_method, &row.front()));
 }
 
 void
@@ -401,14 +478,23 @@ RendererSoftware::render_polygon(
 {
 	if (!target_surface.is_valid()) return;
 
+	std::vector<Vector> vertices(polygon.vertices.size());
+	for(int i = 0; i < (int)vertices.size(); ++i)
+		vertices[i] = transform_matrix.get_transformed(polygon.vertices[i]);
+
+	std::vector<Rasterizer::Triangle> triangles;
+	triangles.reserve(polygon.triangles.size());
+	Rasterizer::Triangle triangle;
 	for(synfig::Polygon::TriangleList::const_iterator i = polygon.triangles.begin(); i != polygon.triangles.end(); ++i)
-		render_triangle(
+		if (Rasterizer::prepare(
 			target_surface,
-			transform_matrix.get_transformed(polygon.vertices[i->vertices[0]]),
-			transform_matrix.get_transformed(polygon.vertices[i->vertices[1]]),
-			transform_matrix.get_transformed(polygon.vertices[i->vertices[2]]),
-			color,
-			blend_method );
+			vertices[i->vertices[0]],
+			vertices[i->vertices[1]],
+			vertices[i->vertices[2]],
+			triangle ))
+				triangles.push_back(triangle);
+
+	Rasterizer::draw_all(target_surface, triangles, NULL, 1.0, color, blend_method);
 }
 
 
@@ -425,18 +511,30 @@ RendererSoftware::render_mesh(
 	if (!target_surface.is_valid()) return;
 	if (!texture.is_valid()) return;
 
+	std::vector<Vector> positions(mesh.vertices.size()), tex_coords(mesh.vertices.size());
+	for(int i = 0; i < (int)mesh.vertices.size(); ++i)
+	{
+		positions[i] = transform_matrix.get_transformed(mesh.vertices[i].position);
+		tex_coords[i] = texture_matrix.get_transformed(mesh.vertices[i].tex_coords);
+	}
+
+	std::vector<Rasterizer::Triangle> triangles;
+	triangles.reserve(mesh.triangles.size());
+	Rasterizer::Triangle triangle;
 	for(synfig::Mesh::TriangleList::const_iterator i = mesh.triangles.begin(); i != mesh.triangles.end(); ++i)
-		render_triangle(
+		if (Rasterizer::prepare(
 			target_surface,
-			transform_matrix.get_transformed(mesh.vertices[i->vertices[0]].position),
-			texture_matrix.get_transformed(mesh.vertices[i->vertices[0]].tex_coords),
-			transform_matrix.get_transformed(mesh.vertices[i->vertices[1]].position),
-			texture_matrix.get_transformed(mesh.vertices[i->vertices[1]].tex_coords),
-			transform_matrix.get_transformed(mesh.vertices[i->vertices[2]].position),
-			texture_matrix.get_transformed(mesh.vertices[i->vertices[2]].tex_coords),
+			positions[i->vertices[0]],
+			tex_coords[i->vertices[0]],
+			positions[i->vertices[1]],
+			tex_coords[i->vertices[1]],
+			positions[i->vertices[2]],
+			tex_coords[i->vertices[2]],
 			texture,
-			alpha,
-			blend_method );
+			triangle ))
+				triangles.push_back(triangle);
+
+	Rasterizer::draw_all(target_surface, triangles, &texture, alpha, Color(), blend_method);
 }
 
 
@@ -46,17 +46,20 @@ class RendererSoftware;
 
 template<>
 class Renderer::TypesTemplate<RendererSoftware, Renderer::PrimitiveTypeSurface>:
-	public Renderer::TypesTemplateBase<synfig::Surface> { };
+	public Renderer::TypesTemplateBase<synfig::Surface>
+	{ public: static RendererId get_id(); };
 
 template<>
 class Renderer::TypesTemplate<RendererSoftware, Renderer::PrimitiveTypeMesh>:
-	public Renderer::TypesTemplateBase<synfig::Mesh> { };
+	public Renderer::TypesTemplateBase<synfig::Mesh>
+	{ public: static RendererId get_id(); };
 
 class RendererSoftware: public Renderer {
 private:
 	static RendererId id;
 	struct Helper;
 	struct IntVector;
+	struct Rasterizer;
 public:
 	typedef RendererSoftware RendererType;
 	typedef Renderer::TypesBase<RendererType> Types;
@@ -189,35 +189,36 @@ synfig::Surface::blit_to(alpha_pen& pen, int x, int y, int w, int h)
 {
 	static const float epsilon(0.00001);
 	const float alpha(pen.get_alpha());
-	if(	pen.get_blend_method()==Color::BLEND_STRAIGHT && fabs(alpha-1.0f)<epsilon )
-	{
-		if(x>=get_w() || y>=get_w())
-			return;
 
-		//clip source origin
-		if(x<0)
-		{
-			w+=x;	//decrease
-			x=0;
-		}
+	if(x>=get_w() || y>=get_h())
+		return;
 
-		if(y<0)
-		{
-			h+=y;	//decrease
-			y=0;
-		}
+	//clip source origin
+	if(x<0)
+	{
+		w+=x;	//decrease
+		x=0;
+	}
 
-		//clip width against dest width
-		w = min((long)w,(long)(pen.end_x()-pen.x()));
-		h = min((long)h,(long)(pen.end_y()-pen.y()));
+	if(y<0)
+	{
+		h+=y;	//decrease
+		y=0;
+	}
 
-		//clip width against src width
-		w = min(w,get_w()-x);
-		h = min(h,get_h()-y);
+	//clip width against dest width
+	w = min((long)w,(long)(pen.end_x()-pen.x()));
+	h = min((long)h,(long)(pen.end_y()-pen.y()));
 
-		if(w<=0 || h<=0)
-			return;
+	//clip width against src width
+	w = min(w,get_w()-x);
+	h = min(h,get_h()-y);
+
+	if(w<=0 || h<=0)
+		return;
 
+	if(	pen.get_blend_method()==Color::BLEND_STRAIGHT && fabs(alpha-1.0f)<epsilon )
+	{
 		for(int i=0;i<h;i++)
 		{
 			char* src(static_cast<char*>(static_cast<void*>(operator[](y)+x))+i*get_w()*sizeof(Color));
@@ -230,37 +231,6 @@ synfig::Surface::blit_to(alpha_pen& pen, int x, int y, int w, int h)
 #ifdef HAS_VIMAGE
 	if(	pen.get_blend_method()==Color::BLEND_COMPOSITE && fabs(alpha-1.0f)<epsilon )
 	{
-		if(x>=get_w() || y>=get_w())
-			return;
-
-		//clip source origin
-		if(x<0)
-		{
-			//u-=x;	//increase
-			w+=x;	//decrease
-			x=0;
-		}
-
-		if(y<0)
-		{
-			//v-=y;	//increase
-			h+=y;	//decrease
-			y=0;
-		}
-
-		//clip width against dest width
-		w = min(w,pen.end_x()-pen.x());
-		h = min(h,pen.end_y()-pen.y());
-
-		//clip width against src width
-		w = min(w,get_w()-x);
-		h = min(h,get_h()-y);
-
-		if(w<=0 || h<=0)
-			return;
-
-
-
 		vImage_Buffer top,bottom;
 		vImage_Buffer& dest(bottom);
 
@@ -284,7 +254,11 @@ synfig::Surface::blit_to(alpha_pen& pen, int x, int y, int w, int h)
 		return;
 	}
 #endif
-	etl::surface<Color, ColorAccumulator, ColorPrep>::blit_to(pen,x,y,w,h);
+
+	// blend whole rows at once instead of going through the pen pixel by pixel
+	char* dest(static_cast<char*>(static_cast<void*>(pen.x())));
+	for(int i=0;i<h;i++,dest+=pen.get_pitch())
+		Color::blend_span(static_cast<Color*>(static_cast<void*>(dest)),operator[](y+i)+x,w,alpha,pen.get_blend_method());
 }
 
 void
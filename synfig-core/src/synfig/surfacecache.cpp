@@ -0,0 +1,151 @@
+/* === S Y N F I G ========================================================= */
+/*!	\file synfig/surfacecache.cpp
+**	\brief Cache of rendered surfaces
+**
+**	$Id$
+**
+**	\legal
+**	Copyright (c) 2016 Synfig contributors
+**
+**	This package is free software; you can redistribute it and/or
+**	modify it under the terms of the GNU General Public License as
+**	published by the Free Software Foundation; either version 2 of
+**	the License, or (at your option) any later version.
+**
+**	This package is distributed in the hope that it will be useful,
+**	but WITHOUT ANY WARRANTY; without even the implied warranty of
+**	MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE. See the GNU
+**	General Public License for more details.
+**	\endlegal
+*/
+/* ========================================================================= */
+
+/* === H E A D E R S ======================================================= */
+
+#ifdef USING_PCH
+#	include "pch.h"
+#else
+#ifdef HAVE_CONFIG_H
+#	include <config.h>
+#endif
+
+#include "surfacecache.h"
+
+#endif
+
+/* === U S I N G =========================================================== */
+
+using namespace std;
+using namespace synfig;
+
+/* === M A C R O S ========================================================= */
+
+/* === G L O B A L S ======================================================= */
+
+/* === P R O C E D U R E S ================================================= */
+
+/* === M E T H O D S ======================================================= */
+
+SurfaceCache::SurfaceCache(size_t budget):
+	budget_(budget)
+{ }
+
+SurfaceCache&
+SurfaceCache::instance()
+{
+	static SurfaceCache cache;
+	return cache;
+}
+
+void
+SurfaceCache::evict(size_t budget)
+{
+	while(!entries_.empty() && stats_.memory > budget)
+	{
+		stats_.memory -= entries_.back().size;
+		index_.erase(entries_.back().key);
+		entries_.pop_back();
+		++stats_.evictions;
+	}
+	stats_.entries = entries_.size();
+}
+
+bool
+SurfaceCache::get(Key key, Surface &surface)
+{
+	Mutex::Lock lock(mutex_);
+	std::map<Key, EntryList::iterator>::iterator i = index_.find(key);
+	if (i == index_.end())
+	{
+		++stats_.misses;
+		return false;
+	}
+
+	// move to the front, the list iterators stay valid
+	entries_.splice(entries_.begin(), entries_, i->second);
+	surface = i->second->surface;
+	++stats_.hits;
+	return true;
+}
+
+void
+SurfaceCache::put(Key key, const Surface &surface)
+{
+	size_t size = (size_t)surface.get_w()*surface.get_h()*sizeof(Color);
+
+	Mutex::Lock lock(mutex_);
+	if (!size || size > budget_/4 || index_.count(key))
+		return;
+
+	entries_.push_front(Entry());
+	entries_.front().key = key;
+	entries_.front().surface = surface;
+	entries_.front().size = size;
+	index_[key] = entries_.begin();
+	stats_.memory += size;
+
+	evict(budget_);
+}
+
+void
+SurfaceCache::set_budget(size_t budget)
+{
+	Mutex::Lock lock(mutex_);
+	budget_ = budget;
+	evict(budget_);
+}
+
+size_t
+SurfaceCache::get_budget()const
+{
+	Mutex::Lock lock(mutex_);
+	return budget_;
+}
+
+void
+SurfaceCache::clear()
+{
+	Mutex::Lock lock(mutex_);
+	entries_.clear();
+	index_.clear();
+	stats_.memory = 0;
+	stats_.entries = 0;
+}
+
+SurfaceCache::Stats
+SurfaceCache::get_stats()const
+{
+	Mutex::Lock lock(mutex_);
+	return stats_;
+}
+
+void
+SurfaceCache::reset_stats()
+{
+	Mutex::Lock lock(mutex_);
+	stats_.hits = 0;
+	stats_.misses = 0;
+	stats_.evictions = 0;
+}
+
+/* === E N D =============================================================== */
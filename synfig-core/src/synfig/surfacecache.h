@@ -0,0 +1,134 @@
+/* === S Y N F I G ========================================================= */
+/*!	\file synfig/surfacecache.h
+**	\brief Cache of rendered surfaces
+**
+**	$Id$
+**
+**	\legal
+**	Copyright (c) 2016 Synfig contributors
+**
+**	This package is free software; you can redistribute it and/or
+**	modify it under the terms of the GNU General Public License as
+**	published by the Free Software Foundation; either version 2 of
+**	the License, or (at your option) any later version.
+**
+**	This package is distributed in the hope that it will be useful,
+**	but WITHOUT ANY WARRANTY; without even the implied warranty of
+**	MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE. See the GNU
+**	General Public License for more details.
+**	\endlegal
+*/
+/* ========================================================================= */
+
+/* === S T A R T =========================================================== */
+
+#ifndef __SYNFIG_SURFACECACHE_H
+#define __SYNFIG_SURFACECACHE_H
+
+/* === H E A D E R S ======================================================= */
+
+#include <list>
+#include <map>
+#include <cstddef>
+#include <stdint.h>
+#include "surface.h"
+#include "mutex.h"
+
+/* === M A C R O S ========================================================= */
+
+/* === T Y P E D E F S ===================================================== */
+
+/* === C L A S S E S & S T R U C T S ======================================= */
+
+namespace synfig {
+
+/*!	\class SurfaceCache
+**	\brief Rendered surfaces addressed by a hash of everything they depend on
+**
+**	The caller builds a Key from whatever determines the pixels (layers and
+**	their revisions, RendDesc, quality...) and looks it up before rendering.
+**	Entries are evicted in least recently used order once the memory budget
+**	is exceeded. All methods are thread-safe.
+*/
+class SurfaceCache
+{
+public:
+	typedef uint64_t Key;
+
+	//! Builds a Key from a sequence of values (64-bit FNV-1a)
+	class KeyBuilder
+	{
+		Key hash;
+	public:
+		KeyBuilder(): hash(14695981039346656037ULL) { }
+
+		void add(const void *data, size_t size)
+		{
+			const unsigned char *bytes = (const unsigned char*)data;
+			for(size_t i = 0; i < size; ++i)
+				{ hash ^= bytes[i]; hash *= 1099511628211ULL; }
+		}
+		template<typename T>
+		void add(const T &x) { add(&x, sizeof(x)); }
+
+		Key get()const { return hash; }
+	};
+
+	struct Stats
+	{
+		long long hits;
+		long long misses;
+		long long evictions;
+		size_t entries;
+		size_t memory;
+		Stats(): hits(), misses(), evictions(), entries(), memory() { }
+	};
+
+private:
+	struct Entry
+	{
+		Key key;
+		Surface surface;
+		size_t size;
+	};
+	typedef std::list<Entry> EntryList;
+
+	mutable Mutex mutex_;
+	//! Most recently used entries first
+	EntryList entries_;
+	std::map<Key, EntryList::iterator> index_;
+	size_t budget_;
+	Stats stats_;
+
+	void evict(size_t budget);
+
+public:
+	explicit SurfaceCache(size_t budget = 256*1024*1024);
+
+	//! The cache shared by the layers
+	static SurfaceCache& instance();
+
+	//! Copies the surface stored for \a key into \a surface
+	/*!	\return \c false when there is no such entry */
+	bool get(Key key, Surface &surface);
+
+	//! Stores a copy of \a surface for \a key
+	/*!	Surfaces larger than a quarter of the budget are not stored. */
+	void put(Key key, const Surface &surface);
+
+	//! Sets the memory budget in bytes, zero disables the cache
+	void set_budget(size_t budget);
+	size_t get_budget()const;
+
+	//! Removes all the entries
+	void clear();
+
+	Stats get_stats()const;
+	void reset_stats();
+}; // END of class SurfaceCache
+
+}; // END of namespace synfig
+
+/* === E N D =============================================================== */
+
+#endif
@@ -33,6 +33,7 @@
 #include "target_null.h"
 #include "target_null_tile.h"
 #include "targetparam.h"
+#include <cstring>
 
 using namespace synfig;
 using namespace etl;
@@ -167,3 +168,30 @@ Target::next_frame(Time& time)
 	return total_frames- curr_frame_;
 }
 
+void
+Target::apply_alpha_mode(Color *dest, const Color *src, int count,
+						 TargetAlphaMode alpha_mode, const Color &bg_color)
+{
+	switch(alpha_mode)
+	{
+		case TARGET_ALPHA_MODE_FILL:
+			for(int i=0;i<count;i++)
+				dest[i]=Color::blend(src[i],bg_color,1.0f);
+			break;
+		case TARGET_ALPHA_MODE_EXTRACT:
+			for(int i=0;i<count;i++)
+			{
+				float a=src[i].get_a();
+				dest[i]=Color(a,a,a,a);
+			}
+			break;
+		case TARGET_ALPHA_MODE_REDUCE:
+			for(int i=0;i<count;i++)
+				dest[i]=Color(src[i].get_r(),src[i].get_g(),src[i].get_b(),1.0f);
+			break;
+		case TARGET_ALPHA_MODE_KEEP:
+			if(dest!=src)
+				memcpy(dest,src,sizeof(Color)*count);
+			break;
+	}
+}
@@ -238,6 +238,11 @@ public:
 	 **	\sa curr_frame_
 	*/
 	virtual int	next_frame(Time& time);
+
+	//! Applies \a alpha_mode to \a count colors of \a src and puts them into \a dest
+	/*!	\a dest may be \a src. \a bg_color is the color filled in by TARGET_ALPHA_MODE_FILL. */
+	static void apply_alpha_mode(Color *dest, const Color *src, int count,
+								 TargetAlphaMode alpha_mode, const Color &bg_color);
 }; // END of class Target
 
 }; // END of namespace synfig
@@ -37,6 +37,12 @@
 #include "render.h"
 #include "canvas.h"
 #include "context.h"
+#include "threadpool.h"
+
+#include <deque>
+#include <map>
+#include <algorithm>
+#include <glibmm/thread.h>
 
 #endif
 
@@ -66,8 +72,407 @@ using namespace synfig;
 
 /* === M E T H O D S ======================================================= */
 
+/*!	\struct Target_Scanline::FramePipeline
+**	\brief Converts and writes rendered frames while the next ones render
+**
+**	Rendering happens in the thread calling Target_Scanline::render(),
+**	the conversion and the target writing run in two threads of their
+**	own. The conversion applies the alpha mode and, for targets which
+**	tell their pixel format, turns the colors into the pixels the target
+**	writes. At most \c depth frames are rendered and waiting to be written
+**	at the same time; push() blocks until one is written.
+*/
+struct Target_Scanline::FramePipeline
+{
+	//! A rendered frame, as colors or, once converted, as pixels
+	struct Frame
+	{
+		Surface *surface;
+		std::vector<unsigned char> pixels;
+		int h;
+
+		explicit Frame(Surface *surface): surface(surface), h(surface->get_h()) { }
+		~Frame() { delete surface; }
+	};
+
+	Target_Scanline &target;
+	int depth;
+	bool use_pixels;
+	PixelFormat pixel_format;
+
+	Glib::Mutex mutex;
+	Glib::Cond cond;
+	std::deque<Frame*> convert_queue;
+	std::deque<Frame*> write_queue;
+	int in_flight;
+	bool closed;
+	bool converted;
+	bool aborted;
+	bool failed;
+	String error;
+
+	Glib::Thread *convert_thread;
+	Glib::Thread *write_thread;
+
+	FramePipeline(Target_Scanline &target, int depth):
+		target(target),
+		depth(depth),
+		use_pixels(false),
+		pixel_format(PF_RGB),
+		in_flight(0),
+		closed(false),
+		converted(false),
+		aborted(false),
+		failed(false),
+		convert_thread(NULL),
+		write_thread(NULL)
+	{
+		if (depth <= 0) return;
+		use_pixels = target.get_pixel_format(pixel_format);
+		if (!Glib::thread_supported())
+			Glib::thread_init();
+		convert_thread = Glib::Thread::create(sigc::mem_fun(*this, &FramePipeline::convert_loop), true);
+		write_thread = Glib::Thread::create(sigc::mem_fun(*this, &FramePipeline::write_loop), true);
+	}
+
+	~FramePipeline()
+	{
+		if (is_active())
+		{
+			{
+				Glib::Mutex::Lock lock(mutex);
+				aborted = true;
+				cond.broadcast();
+			}
+			join();
+		}
+		for(std::deque<Frame*>::iterator i = convert_queue.begin(); i != convert_queue.end(); ++i)
+			delete *i;
+		for(std::deque<Frame*>::iterator i = write_queue.begin(); i != write_queue.end(); ++i)
+			delete *i;
+	}
+
+	bool is_active()const { return convert_thread || write_thread; }
+
+	void join()
+	{
+		if (convert_thread) convert_thread->join();
+		if (write_thread) write_thread->join();
+		convert_thread = NULL;
+		write_thread = NULL;
+	}
+
+	//! Queues a rendered frame, takes ownership of \a surface
+	bool push(Surface *surface)
+	{
+		Glib::Mutex::Lock lock(mutex);
+		while(in_flight >= depth && !failed)
+			cond.wait(mutex);
+		if (failed)
+		{
+			delete surface;
+			return false;
+		}
+		++in_flight;
+		convert_queue.push_back(new Frame(surface));
+		cond.broadcast();
+		return true;
+	}
+
+	//! Waits until every queued frame is written
+	bool finish()
+	{
+		{
+			Glib::Mutex::Lock lock(mutex);
+			closed = true;
+			cond.broadcast();
+		}
+		join();
+		return !failed;
+	}
+
+	void convert(Frame &frame)const
+	{
+		Surface &surface = *frame.surface;
+		int w = surface.get_w();
+		for(int y = 0; y < frame.h; y++)
+			Target::apply_alpha_mode(surface[y], surface[y], w,
+				target.get_alpha_mode(), target.rend_desc().get_bg_color());
+		if (!use_pixels)
+			return;
+
+		// the pixels take a fraction of the memory of the colors
+		int rowspan = w*channels(pixel_format);
+		frame.pixels.resize(rowspan*frame.h);
+		for(int y = 0; y < frame.h; y++)
+			convert_color_format(&frame.pixels[rowspan*y], surface[y], w, pixel_format, target.gamma());
+		delete frame.surface;
+		frame.surface = NULL;
+	}
+
+	bool write(const Frame &frame)
+	{
+		if(!target.start_frame())
+			throw(string("add_frame(): target panic on start_frame()"));
+
+		if (frame.surface)
+			target.put_scanlines(*frame.surface, 0, TARGET_ALPHA_MODE_KEEP);
+		else
+		{
+			int rowspan = frame.h ? (int)frame.pixels.size()/frame.h : 0;
+			for(int y = 0; y < frame.h; y++)
+				if(!target.write_pixels(&frame.pixels[rowspan*y]))
+					throw(string("add_frame(): target panic on write_pixels()"));
+		}
+
+		target.end_frame();
+		return true;
+	}
+
+	void convert_loop()
+	{
+		while(true)
+		{
+			Frame *frame;
+			{
+				Glib::Mutex::Lock lock(mutex);
+				while(convert_queue.empty() && !closed && !aborted)
+					cond.wait(mutex);
+				if (aborted || convert_queue.empty())
+				{
+					converted = true;
+					cond.broadcast();
+					return;
+				}
+				frame = convert_queue.front();
+				convert_queue.pop_front();
+			}
+
+			convert(*frame);
+
+			Glib::Mutex::Lock lock(mutex);
+			write_queue.push_back(frame);
+			cond.broadcast();
+		}
+	}
+
+	void write_loop()
+	{
+		while(true)
+		{
+			Frame *frame;
+			{
+				Glib::Mutex::Lock lock(mutex);
+				while(write_queue.empty() && !converted && !aborted)
+					cond.wait(mutex);
+				if (aborted || write_queue.empty())
+					return;
+				frame = write_queue.front();
+				write_queue.pop_front();
+			}
+
+			bool success = false;
+			String message;
+			try
+			{
+				success = write(*frame);
+			}
+			catch(String str)
+			{
+				message = str;
+			}
+			catch(...)
+			{
+				message = _("Caught unknown error");
+			}
+			delete frame;
+
+			Glib::Mutex::Lock lock(mutex);
+			--in_flight;
+			if (!success)
+			{
+				failed = true;
+				aborted = true;
+				error = message;
+			}
+			cond.broadcast();
+		}
+	}
+};
+
+namespace {
+
+//! Renders the frame at \a time of \a canvas into \a surface
+bool
+render_canvas_frame(Canvas::Handle canvas, Time time, const RendDesc &desc, int quality, Surface &surface)
+{
+	ContextParams context_params(desc.get_render_excluded_contexts());
+
+	Context context;
+	// pass the Render Method to the context
+	context=canvas->get_context(context_params);
+	context.set_render_method(SOFTWARE);
+
+	canvas->set_time(time);
+
+#ifdef SYNFIG_OPTIMIZE_LAYER_TREE
+	Canvas::Handle op_canvas;
+	if (!getenv("SYNFIG_DISABLE_OPTIMIZE_LAYER_TREE"))
+	{
+		op_canvas = Canvas::create();
+		op_canvas->set_file_name(canvas->get_file_name());
+		optimize_layers(canvas->get_time(), canvas->get_context(context_params), op_canvas);
+		context=op_canvas->get_context(context_params);
+	}
+	else
+		context=canvas->get_context(context_params);
+#else
+	context=canvas->get_context(context_params);
+#endif
+
+	if(quality==0)
+		return parametric_render(context,surface,desc,0);
+	return context.accelerated_render(&surface,quality,desc,0);
+}
+
+} // END of anonymous namespace
+
+/*!	\struct Target_Scanline::FrameScheduler
+**	\brief Renders frames on several canvas copies and reorders them
+**
+**	Every worker thread owns one canvas. Workers take chunks of
+**	consecutive frames, so each one renders disjoint frame ranges, and
+**	the calling thread passes the finished frames to the target in order.
+**	Workers do not start frames more than \c window frames ahead of the
+**	last written one, which bounds the memory used by the reorder buffer.
+*/
+struct Target_Scanline::FrameScheduler
+{
+	Target_Scanline &target;
+	std::vector<Time> times;
+	int quality;
+	int chunk;
+	int window;
+
+	Glib::Mutex mutex;
+	Glib::Cond cond;
+	int next;
+	int written;
+	std::map<int, Surface*> ready;
+	bool aborted;
+	bool failed;
+
+	std::vector<Glib::Thread*> threads;
+
+	FrameScheduler(Target_Scanline &target, const std::vector<Time> &times, int quality, int workers):
+		target(target),
+		times(times),
+		quality(quality),
+		chunk(std::max(1, std::min(4, (int)times.size()/(workers*4)))),
+		window(workers*chunk*2),
+		next(0),
+		written(0),
+		aborted(false),
+		failed(false)
+	{ }
+
+	~FrameScheduler()
+	{
+		stop();
+		for(std::map<int, Surface*>::iterator i = ready.begin(); i != ready.end(); ++i)
+			delete i->second;
+	}
+
+	void start(const std::vector<Canvas::Handle> &canvases)
+	{
+		if (!Glib::thread_supported())
+			Glib::thread_init();
+		for(std::vector<Canvas::Handle>::const_iterator i = canvases.begin(); i != canvases.end(); ++i)
+			threads.push_back(Glib::Thread::create(
+				sigc::bind(sigc::mem_fun(*this, &FrameScheduler::worker), *i), true ));
+	}
+
+	void stop()
+	{
+		{
+			Glib::Mutex::Lock lock(mutex);
+			aborted = true;
+			cond.broadcast();
+		}
+		for(std::vector<Glib::Thread*>::iterator i = threads.begin(); i != threads.end(); ++i)
+			(*i)->join();
+		threads.clear();
+	}
+
+	//! Waits for the frame \a index, returns NULL if rendering failed
+	Surface* wait_frame(int index)
+	{
+		Glib::Mutex::Lock lock(mutex);
+		while(!ready.count(index) && !failed)
+			cond.wait(mutex);
+		if (failed) return NULL;
+		Surface *surface = ready[index];
+		ready.erase(index);
+		return surface;
+	}
+
+	void frame_written(int index)
+	{
+		Glib::Mutex::Lock lock(mutex);
+		written = index + 1;
+		cond.broadcast();
+	}
+
+	void worker(Canvas::Handle canvas)
+	{
+		while(true)
+		{
+			int first, last;
+			{
+				Glib::Mutex::Lock lock(mutex);
+				while(!aborted && next < (int)times.size() && next >= written + window)
+					cond.wait(mutex);
+				if (aborted || next >= (int)times.size())
+					return;
+				first = next;
+				last = std::min(first + chunk, (int)times.size());
+				next = last;
+			}
+
+			for(int i = first; i < last; ++i)
+			{
+				Surface *surface = new Surface();
+				bool success = false;
+				try
+				{
+					success = render_canvas_frame(canvas, times[i], target.desc, quality, *surface);
+				}
+				catch(...)
+				{
+					success = false;
+				}
+
+				Glib::Mutex::Lock lock(mutex);
+				if (!success || aborted)
+				{
+					if (!success)
+						synfig::error("Target_Scanline: rendering of frame %d failed", i);
+					delete surface;
+					failed = failed || !success;
+					aborted = true;
+					cond.broadcast();
+					return;
+				}
+				ready[i] = surface;
+				cond.broadcast();
+			}
+		}
+	}
+};
+
 Target_Scanline::Target_Scanline():
-	threads_(2)
+	threads_(2),
+	frame_queue_depth_(0)
 {
 	curr_frame_=0;
 }
@@ -102,12 +507,28 @@ synfig::Target_Scanline::render(ProgressCallback *cb)
 	frame_start=desc.get_frame_start();
 	frame_end=desc.get_frame_end();
 
+	// Several canvas copies allow rendering several frames at once
+	if(worker_canvases_.size()>1 && frame_end>frame_start)
+		return render_frames_parallel(cb);
+
 	ContextParams context_params(desc.get_render_excluded_contexts());
 
+	// Worker threads live for the whole render, not for a single frame
+	ThreadPool thread_pool(threads_>0?threads_:1);
+
 	// Calculate the number of frames
 	total_frames=frame_end-frame_start+1;
 	if(total_frames<=0)total_frames=1;
 
+	// Overlap the rendering of a frame with the conversion and
+	// writing of the previous ones, when frames go to the target whole
+	bool pipelined=quality!=0 && total_frames>1 && frame_queue_depth_>0;
+	#if USE_PIXELRENDERING_LIMIT
+	if(desc.get_w()*desc.get_h() > PIXEL_RENDERING_LIMIT)
+		pipelined=false;
+	#endif
+	FramePipeline frame_pipeline(*this, pipelined?frame_queue_depth_:0);
+
 	try {
 
 	//synfig::info("1time_set_to %s",t.get_string().c_str());
@@ -158,7 +579,7 @@ synfig::Target_Scanline::render(ProgressCallback *cb)
 				}
 				else
 				{
-					if(!synfig::render_threaded(context,this,desc,0,threads_))
+					if(!synfig::render_threaded(context,this,desc,0,thread_pool))
 						return false;
 				}
 			}
@@ -167,99 +588,34 @@ synfig::Target_Scanline::render(ProgressCallback *cb)
 				#if USE_PIXELRENDERING_LIMIT
 				if(desc.get_w()*desc.get_h() > PIXEL_RENDERING_LIMIT)
 				{
-					Surface surface;
-					int rowheight = PIXEL_RENDERING_LIMIT/desc.get_w();
-					if (!rowheight) rowheight = 1; // TODO: render partial lines to stay within the limit?
-					int rows = desc.get_h()/rowheight;
-					int lastrowheight = desc.get_h() - rows*rowheight;
-
-					rows++;
-
-					synfig::info("Render broken up into %d block%s %d pixels tall, and a final block %d pixels tall",
-								 rows-1, rows==2?"":"s", rowheight, lastrowheight);
-
-					// loop through all the full rows
-					if(!start_frame())
-					{
-						throw(string("add_frame(): target panic on start_frame()"));
+					if(!render_frame_in_blocks(context,thread_pool,0,cb))
 						return false;
-					}
-
-					for(int i=0; i < rows; ++i)
+				}else //use normal rendering...
+				{
+				#endif
+					if(frame_pipeline.is_active())
 					{
-						RendDesc	blockrd = desc;
+						Surface *surface=new Surface();
 
-						//render the strip at the normal size unless it's the last one...
-						if(i == rows-1)
+						if(!accelerated_render_threaded(context,surface,quality,desc,0,thread_pool))
 						{
-							if(!lastrowheight) break;
-							blockrd.set_subwindow(0,i*rowheight,desc.get_w(),lastrowheight);
-						}
-						else
-						{
-							blockrd.set_subwindow(0,i*rowheight,desc.get_w(),rowheight);
+							delete surface;
+							if(cb)cb->error(_("Accelerated Renderer Failure"));
+							return false;
 						}
 
-						if(!context.accelerated_render(&surface,quality,blockrd,0))
+						// The pipeline takes care of the surface from now on
+						if(!frame_pipeline.push(surface))
 						{
-							if(cb)cb->error(_("Accelerated Renderer Failure"));
+							if(cb)cb->error(_("Unable to put surface on target")+String(": ")+frame_pipeline.error);
 							return false;
-						}else
-						{
-							int y;
-							int rowspan=sizeof(Color)*surface.get_w();
-							Surface::pen pen = surface.begin();
-
-							int yoff = i*rowheight;
-
-							for(y = 0; y < blockrd.get_h(); y++, pen.inc_y())
-							{
-								Color *colordata= start_scanline(y + yoff);
-								if(!colordata)
-								{
-									throw(string("add_frame(): call to start_scanline(y) returned NULL"));
-									return false;
-								}
-
-								switch(get_alpha_mode())
-								{
-									case TARGET_ALPHA_MODE_FILL:
-										for(int i = 0; i < surface.get_w(); i++)
-											colordata[i] = Color::blend(surface[y][i],desc.get_bg_color(),1.0f);
-										break;
-									case TARGET_ALPHA_MODE_EXTRACT:
-										for(int i = 0; i < surface.get_w(); i++)
-										{
-											float a=surface[y][i].get_a();
-											colordata[i] = Color(a,a,a,a);
-										}
-										break;
-									case TARGET_ALPHA_MODE_REDUCE:
-										for(int i = 0; i < surface.get_w(); i++)
-											colordata[i] = Color(surface[y][i].get_r(),surface[y][i].get_g(),surface[y][i].get_b(),1.0f);
-										break;
-									case TARGET_ALPHA_MODE_KEEP:
-										memcpy(colordata,surface[y],rowspan);
-										break;
-								}	
-
-								if(!end_scanline())
-								{
-									throw(string("add_frame(): target panic on end_scanline()"));
-									return false;
-								}
-							}
 						}
+						continue;
 					}
 
-					end_frame();
-
-				}else //use normal rendering...
-				{
-				#endif
 					Surface surface;
 
-					if(!context.accelerated_render(&surface,quality,desc,0))
+					if(!accelerated_render_threaded(context,&surface,quality,desc,0,thread_pool))
 					{
 						// For some reason, the accelerated renderer failed.
 						if(cb)cb->error(_("Accelerated Renderer Failure"));
@@ -280,6 +636,12 @@ synfig::Target_Scanline::render(ProgressCallback *cb)
 				#endif
 			}
 		}while(frames);
+
+		if(!frame_pipeline.finish())
+		{
+			if(cb)cb->error(_("Unable to put surface on target")+String(": ")+frame_pipeline.error);
+			return false;
+		}
 	}
     else
     {
@@ -314,7 +676,7 @@ synfig::Target_Scanline::render(ProgressCallback *cb)
 			}
 			else
 			{
-				if(!synfig::render_threaded(context,this,desc,cb,threads_))
+				if(!synfig::render_threaded(context,this,desc,cb,thread_pool))
 					return false;
 			}
 		}
@@ -323,105 +685,14 @@ synfig::Target_Scanline::render(ProgressCallback *cb)
 			#if USE_PIXELRENDERING_LIMIT
 			if(desc.get_w()*desc.get_h() > PIXEL_RENDERING_LIMIT)
 			{
-				Surface surface;
-				int totalheight = desc.get_h();
-				int rowheight = PIXEL_RENDERING_LIMIT/desc.get_w();
-				if (!rowheight) rowheight = 1; // TODO: render partial lines to stay within the limit?
-				int rows = desc.get_h()/rowheight;
-				int lastrowheight = desc.get_h() - rows*rowheight;
-
-				rows++;
-
-				synfig::info("Render broken up into %d block%s %d pixels tall, and a final block %d pixels tall",
-							 rows-1, rows==2?"":"s", rowheight, lastrowheight);
-
-				// loop through all the full rows
-				if(!start_frame())
-				{
-					throw(string("add_frame(): target panic on start_frame()"));
+				if(!render_frame_in_blocks(context,thread_pool,cb,cb))
 					return false;
-				}
-
-				for(int i=0; i < rows; ++i)
-				{
-					RendDesc	blockrd = desc;
-
-					//render the strip at the normal size unless it's the last one...
-					if(i == rows-1)
-					{
-						if(!lastrowheight) break;
-						blockrd.set_subwindow(0,i*rowheight,desc.get_w(),lastrowheight);
-					}
-					else
-					{
-						blockrd.set_subwindow(0,i*rowheight,desc.get_w(),rowheight);
-					}
-
-					SuperCallback	sc(cb, i*rowheight, (i+1)*rowheight, totalheight);
-
-					if(!context.accelerated_render(&surface,quality,blockrd,&sc))
-					{
-						if(cb)cb->error(_("Accelerated Renderer Failure"));
-						return false;
-					}else
-					{
-						int y;
-						int rowspan=sizeof(Color)*surface.get_w();
-						Surface::pen pen = surface.begin();
-
-						int yoff = i*rowheight;
-
-						for(y = 0; y < blockrd.get_h(); y++, pen.inc_y())
-						{
-							Color *colordata= start_scanline(y + yoff);
-							if(!colordata)
-							{
-								throw(string("add_frame(): call to start_scanline(y) returned NULL"));
-								return false;
-							}
-
-							switch(get_alpha_mode())
-							{
-								case TARGET_ALPHA_MODE_FILL:
-									for(int i = 0; i < surface.get_w(); i++)
-										colordata[i] = Color::blend(surface[y][i],desc.get_bg_color(),1.0f);
-									break;
-								case TARGET_ALPHA_MODE_EXTRACT:
-									for(int i = 0; i < surface.get_w(); i++)
-									{
-										float a=surface[y][i].get_a();
-										colordata[i] = Color(a,a,a,a);
-									}
-									break;
-								case TARGET_ALPHA_MODE_REDUCE:
-									for(int i = 0; i < surface.get_w(); i++)
-										colordata[i] = Color(surface[y][i].get_r(),surface[y][i].get_g(),surface[y][i].get_b(),1.0f);
-									break;
-								case TARGET_ALPHA_MODE_KEEP:
-									memcpy(colordata,surface[y],rowspan);
-									break;
-							}	
-
-							if(!end_scanline())
-							{
-								throw(string("add_frame(): target panic on end_scanline()"));
-								return false;
-							}
-						}
-					}
-
-					//I'm done with this part
-					sc.amount_complete(100,100);
-				}
-
-				end_frame();
-
 			}else
 			{
 			#endif
 				Surface surface;
 
-				if(!context.accelerated_render(&surface,quality,desc,cb))
+				if(!accelerated_render_threaded(context,&surface,quality,desc,cb,thread_pool))
 				{
 					if(cb)cb->error(_("Accelerated Renderer Failure"));
 					return false;
@@ -462,60 +733,160 @@ synfig::Target_Scanline::render(ProgressCallback *cb)
 }
 
 bool
-Target_Scanline::add_frame(const Surface *surface)
+Target_Scanline::render_frames_parallel(ProgressCallback *cb)
 {
-	assert(surface);
+	// Gather the times of all frames
+	std::vector<Time> times;
+	Time t=0;
+	int frames;
+	curr_frame_=0;
+	do
+	{
+		frames=next_frame(t);
+		times.push_back(t);
+	}while(frames);
+
+	int total_frames=(int)times.size();
+
+	try {
+
+	FrameScheduler scheduler(*this, times, get_quality(), (int)worker_canvases_.size());
+	scheduler.start(worker_canvases_);
+
+	for(int i=0;i<total_frames;i++)
+	{
+		// If we have a callback, and it returns
+		// false, go ahead and bail. (it may be a user cancel)
+		if(cb && !cb->amount_complete(i,total_frames))
+			return false;
+
+		Surface *surface=scheduler.wait_frame(i);
+		if(!surface)
+		{
+			if(cb)cb->error(_("Accelerated Renderer Failure"));
+			return false;
+		}
+
+		// Put the surface we rendered onto the target.
+		bool success=add_frame(surface);
+		delete surface;
+		if(!success)
+		{
+			if(cb)cb->error(_("Unable to put surface on target"));
+			return false;
+		}
 
+		scheduler.frame_written(i);
+	}
 
-	int y;
-	int rowspan=sizeof(Color)*surface->get_w();
-	Surface::const_pen pen=surface->begin();
+	if(cb)
+		cb->amount_complete(total_frames,total_frames);
 
+	}
+	catch(String str)
+	{
+		if(cb)cb->error(_("Caught string :")+str);
+		return false;
+	}
+	catch(std::bad_alloc)
+	{
+		if(cb)cb->error(_("Ran out of memory (Probably a bug)"));
+		return false;
+	}
+	catch(...)
+	{
+		if(cb)cb->error(_("Caught unknown error, rethrowing..."));
+		throw;
+	}
+	return true;
+}
+
+bool
+Target_Scanline::render_frame_in_blocks(Context context, ThreadPool &thread_pool, ProgressCallback *progress, ProgressCallback *cb)
+{
+	Surface surface;
+	int totalheight = desc.get_h();
+	int rowheight = PIXEL_RENDERING_LIMIT/desc.get_w();
+	if (!rowheight) rowheight = 1; // TODO: render partial lines to stay within the limit?
+	int rows = desc.get_h()/rowheight;
+	int lastrowheight = desc.get_h() - rows*rowheight;
+
+	rows++;
+
+	synfig::info("Render broken up into %d block%s %d pixels tall, and a final block %d pixels tall",
+				 rows-1, rows==2?"":"s", rowheight, lastrowheight);
+
+	// loop through all the full rows
 	if(!start_frame())
 	{
 		throw(string("add_frame(): target panic on start_frame()"));
 		return false;
 	}
 
-	for(y=0;y<surface->get_h();y++,pen.inc_y())
+	for(int i=0; i < rows; ++i)
 	{
-		Color *colordata= start_scanline(y);
-		if(!colordata)
+		RendDesc	blockrd = desc;
+
+		//render the strip at the normal size unless it's the last one...
+		if(i == rows-1)
 		{
-			throw(string("add_frame(): call to start_scanline(y) returned NULL"));
-			return false;
+			if(!lastrowheight) break;
+			blockrd.set_subwindow(0,i*rowheight,desc.get_w(),lastrowheight);
 		}
-
-		switch(get_alpha_mode())
+		else
 		{
-			case TARGET_ALPHA_MODE_FILL:
-				for(int i=0;i<surface->get_w();i++)
-					colordata[i]=Color::blend((*surface)[y][i],desc.get_bg_color(),1.0f);
-				break;
-			case TARGET_ALPHA_MODE_EXTRACT:
-				for(int i=0;i<surface->get_w();i++)
-				{
-					float a=(*surface)[y][i].get_a();
-					colordata[i] = Color(a,a,a,a);
-				}
-				break;
-			case TARGET_ALPHA_MODE_REDUCE:
-				for(int i = 0; i < surface->get_w(); i++)
-					colordata[i] = Color((*surface)[y][i].get_r(),(*surface)[y][i].get_g(),(*surface)[y][i].get_b(),1.0f);
-				break;
-			case TARGET_ALPHA_MODE_KEEP:
-				memcpy(colordata,(*surface)[y],rowspan);
-				break;
+			blockrd.set_subwindow(0,i*rowheight,desc.get_w(),rowheight);
 		}
 
-		if(!end_scanline())
+		SuperCallback	sc(progress, i*rowheight, (i+1)*rowheight, totalheight);
+
+		if(!accelerated_render_threaded(context,&surface,get_quality(),blockrd,progress?&sc:0,thread_pool))
 		{
-			throw(string("add_frame(): target panic on end_scanline()"));
+			if(cb)cb->error(_("Accelerated Renderer Failure"));
 			return false;
 		}
+
+		put_scanlines(surface, i*rowheight, get_alpha_mode());
+
+		//I'm done with this part
+		if(progress)sc.amount_complete(100,100);
 	}
 
 	end_frame();
 
 	return true;
 }
+
+void
+Target_Scanline::put_scanlines(const Surface &surface, int first_scanline, TargetAlphaMode alpha_mode)
+{
+	for(int y=0;y<surface.get_h();y++)
+	{
+		Color *colordata= start_scanline(first_scanline+y);
+		if(!colordata)
+			throw(string("add_frame(): call to start_scanline(y) returned NULL"));
+
+		Target::apply_alpha_mode(colordata,surface[y],surface.get_w(),alpha_mode,desc.get_bg_color());
+
+		if(!end_scanline())
+			throw(string("add_frame(): target panic on end_scanline()"));
+	}
+}
+
+bool
+Target_Scanline::add_frame(const Surface *surface)
+{
+	assert(surface);
+
+	if(!start_frame())
+	{
+		throw(string("add_frame(): target panic on start_frame()"));
+		return false;
+	}
+
+	put_scanlines(*surface,0,get_alpha_mode());
+
+	end_frame();
+
+	return true;
+}
@@ -29,6 +29,7 @@
 /* === H E A D E R S ======================================================= */
 
 #include "target.h"
+#include <vector>
 
 /* === M A C R O S ========================================================= */
 
@@ -38,6 +39,8 @@
 
 namespace synfig {
 
+class ThreadPool;
+
 /*!	\class Target_Scanline
 **	\brief This is a Target class that implements the render fucntion
 * for a line by line render procedure
@@ -46,12 +49,19 @@ class Target_Scanline : public Target
 {
 	//! Number of threads to use
 	int threads_;
+	//! Maximum number of rendered frames waiting to be written
+	int frame_queue_depth_;
+	//! Independent copies of the canvas, one per frame rendering worker
+	std::vector<etl::handle<Canvas> > worker_canvases_;
+
+	struct FramePipeline;
+	struct FrameScheduler;
 
 public:
 	typedef etl::handle<Target_Scanline> Handle;
 	typedef etl::loose_handle<Target_Scanline> LooseHandle;
 	typedef etl::handle<const Target_Scanline> ConstHandle;
-	//! Default constructor (threads = 2 current frame = 0)
+	//! Default constructor (threads = 2, frame queue depth = 0, current frame = 0)
 	Target_Scanline();
 
 	//! Renders the canvas to the target
@@ -87,13 +97,52 @@ public:
 	**	\see start_scanline()
 	*/
 	virtual bool end_scanline()=0;
+
+	//! Gets the pixel format end_scanline() converts the scanlines to
+	/*!	A target whose end_scanline() only converts the colors to \a format
+	**	with convert_color_format() and gamma(), then writes them, may
+	**	return \c true and implement write_pixels(). Pipelined frames are
+	**	then converted before they reach the writing thread.
+	**	\see write_pixels()
+	*/
+	virtual bool get_pixel_format(PixelFormat &format)const { (void)format; return false; }
+
+	//! Writes the next scanline of the frame, already converted to get_pixel_format()
+	/*!	Called between start_frame() and end_frame(), once per scanline
+	**	and in order, instead of start_scanline() and end_scanline().
+	**	\return \c true on success, \c false on failure.
+	*/
+	virtual bool write_pixels(const unsigned char *data) { (void)data; return false; }
+
 	//! Sets the number of threads
 	void set_threads(int x) { threads_=x; }
 	//! Gets the number of threads
 	int get_threads()const { return threads_; }
+	//! Sets the number of rendered frames which may wait for conversion
+	//! and writing while the next frame renders. Zero disables pipelining.
+	/*!	\warning With pipelining enabled start_frame(), start_scanline(),
+	**	end_scanline() and end_frame() are called from a separate thread.
+	*/
+	void set_frame_queue_depth(int x) { frame_queue_depth_=x; }
+	//! Gets the number of rendered frames which may wait to be written
+	int get_frame_queue_depth()const { return frame_queue_depth_; }
+	//! Sets the canvases used to render several frames at once.
+	/*!	Each canvas must be an independent copy of get_canvas(), they are
+	**	modified by set_time() from their own threads. With more than one
+	**	canvas, render() hands out frames to one worker per canvas and
+	**	passes the rendered frames to the target in order. */
+	void set_worker_canvases(const std::vector<etl::handle<Canvas> > &x) { worker_canvases_=x; }
+	//! Gets the canvases used to render several frames at once
+	const std::vector<etl::handle<Canvas> >& get_worker_canvases()const { return worker_canvases_; }
 	//! Puts the rendered surface onto the target.
 	bool add_frame(const synfig::Surface *surface);
 private:
+	//! Renders all frames using one worker thread per worker canvas
+	bool render_frames_parallel(ProgressCallback *cb);
+	//! Renders a frame too big for one surface in blocks of rows and puts them onto the target
+	bool render_frame_in_blocks(Context context, ThreadPool &thread_pool, ProgressCallback *progress, ProgressCallback *cb);
+	//! Puts the rows of \a surface onto the target from \a first_scanline on, applying \a alpha_mode
+	void put_scanlines(const synfig::Surface &surface, int first_scanline, TargetAlphaMode alpha_mode);
 }; // END of class Target_Scanline
 
 }; // END of namespace synfig
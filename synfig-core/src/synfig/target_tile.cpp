@@ -38,10 +38,16 @@
 #include "canvas.h"
 #include "context.h"
 #include "general.h"
+#include "threadpool.h"
+#include "surfacecache.h"
+#include "transformation.h"
+#include "layers/layer_pastecanvas.h"
 #include <ETL/clock>
 
 #include <vector>
+#include <map>
 #include <algorithm>
+#include <cmath>
 
 #endif
 
@@ -67,6 +73,9 @@ const unsigned int	DEF_TILE_HEIGHT= TILE_SIZE / 2;
 // #define SYNFIG_DISPLAY_EFFICIENCY
 #endif
 
+// pixels added around a damaged area for antialiasing and resampling
+#define DAMAGE_MARGIN 2
+
 /* === G L O B A L S ======================================================= */
 
 /* === P R O C E D U R E S ================================================= */
@@ -140,14 +149,304 @@ struct Target_Tile::TileGroup
 			std::sort(group.tiles.begin(), group.tiles.end());
 		}
 	}
+
+	//! Halves the biggest groups until there are at least \a min_count groups
+	static void split_groups(std::vector<TileGroup> &groups, int min_count)
+	{
+		while((int)groups.size() < min_count)
+		{
+			// find the biggest group which still can be split
+			int biggest = -1;
+			for(int i = 0; i < (int)groups.size(); ++i)
+				if (groups[i].tiles.size() > 1
+				 && (biggest < 0 || groups[i].tiles.size() > groups[biggest].tiles.size()))
+					biggest = i;
+			if (biggest < 0) break;
+
+			TileGroup group = groups[biggest];
+			TileGroup &first = groups[biggest];
+			TileGroup second;
+			first.tiles.clear();
+
+			// split by rows, a column split is used for single-row groups only
+			if (group.y1 - group.y0 > 1)
+			{
+				int y = (group.y0 + group.y1)/2;
+				first.y1 = y;
+				second.x0 = group.x0; second.y0 = y;
+				second.x1 = group.x1; second.y1 = group.y1;
+			}
+			else
+			{
+				int x = (group.x0 + group.x1)/2;
+				first.x1 = x;
+				second.x0 = x; second.y0 = group.y0;
+				second.x1 = group.x1; second.y1 = group.y1;
+			}
+
+			for(std::vector<TileInfo>::const_iterator i = group.tiles.begin(); i != group.tiles.end(); ++i)
+				(i->x < first.x1 && i->y < first.y1 ? first : second).tiles.push_back(*i);
+
+			groups.insert(groups.begin() + biggest + 1, second);
+		}
+	}
+};
+
+//! Remembers the previous frame to find out which tiles must be rendered again
+struct Target_Tile::FrameHistory
+{
+	//! State of a layer of the root canvas
+	struct LayerState
+	{
+		GUID guid;
+		//! Changes whenever the layer or its pasted canvas changes
+		SurfaceCache::Key key;
+		//! Pixels the layer can change, clamped to the image
+		int x0, y0, x1, y1;
+		//! All the visible layers above only draw over their context,
+		//! so the pixels changed by this layer stay where they are
+		bool exposed;
+		LayerState(): key(), x0(), y0(), x1(), y1(), exposed() { }
+	};
+
+	bool enabled;
+	SurfaceCache::Key settings;
+	std::vector<LayerState> layers;
+	//! Tiles of the previous frame, by position in pixels
+	std::map<std::pair<int, int>, Surface> tiles;
+
+	//! Damaged area of the current frame
+	bool full_damage;
+	int x0, y0, x1, y1;
+
+	int reused_tiles;
+	int rendered_tiles;
+
+	explicit FrameHistory(bool enabled):
+		enabled(enabled), settings(), full_damage(true),
+		x0(), y0(), x1(), y1(), reused_tiles(), rendered_tiles() { }
+
+	//! Converts \a bounds to pixels of \a desc
+	static void to_pixels(const RendDesc &desc, const Rect &bounds, LayerState &state)
+	{
+		state.x0 = state.y0 = state.x1 = state.y1 = 0;
+		if (!bounds.is_valid())
+			return;
+
+		const Rect rect = Transformation::transform_bounds(desc.get_transformation_matrix(), bounds);
+		const Point &tl = desc.get_tl();
+		Real ax = (rect.minx - tl[0])/desc.get_pw(), bx = (rect.maxx - tl[0])/desc.get_pw();
+		Real ay = (rect.miny - tl[1])/desc.get_ph(), by = (rect.maxy - tl[1])/desc.get_ph();
+		if (ax > bx) std::swap(ax, bx);
+		if (ay > by) std::swap(ay, by);
+
+		// infinite or undefined bounds cover the whole image
+		const Real w = desc.get_w(), h = desc.get_h();
+		ax = ax == ax ? std::max(ax, Real(0)) : 0;
+		ay = ay == ay ? std::max(ay, Real(0)) : 0;
+		bx = bx == bx ? std::min(bx, w) : w;
+		by = by == by ? std::min(by, h) : h;
+		if (ax >= bx || ay >= by)
+			return;
+
+		state.x0 = std::max((int)floor(ax) - DAMAGE_MARGIN, 0);
+		state.y0 = std::max((int)floor(ay) - DAMAGE_MARGIN, 0);
+		state.x1 = std::min((int)ceil(bx) + DAMAGE_MARGIN, (int)w);
+		state.y1 = std::min((int)ceil(by) + DAMAGE_MARGIN, (int)h);
+	}
+
+	void add_damage(const LayerState &state)
+	{
+		if (!state.exposed)
+			{ full_damage = true; return; }
+		if (state.x0 >= state.x1 || state.y0 >= state.y1)
+			return;
+		if (x0 >= x1 || y0 >= y1)
+			{ x0 = state.x0; y0 = state.y0; x1 = state.x1; y1 = state.y1; return; }
+		x0 = std::min(x0, state.x0);
+		y0 = std::min(y0, state.y0);
+		x1 = std::max(x1, state.x1);
+		y1 = std::max(y1, state.y1);
+	}
+
+	//! Compares the layers of \a context with the previous frame
+	/*!	\a settings describes everything else the pixels depend on
+	**	(RendDesc, quality...), the history is dropped when it changes */
+	void update(Context context, const RendDesc &desc, SurfaceCache::Key settings)
+	{
+		x0 = y0 = x1 = y1 = 0;
+		full_damage = !enabled || tiles.empty() || settings != this->settings;
+		this->settings = settings;
+
+		std::vector<LayerState> current;
+		bool exposed = true;
+		for(; !context->empty(); ++context)
+		{
+			const Layer &layer(**context);
+			const bool visible = context.active() && context.in_z_range();
+
+			LayerState state;
+			state.guid = layer.get_guid();
+			state.exposed = exposed;
+
+			SurfaceCache::KeyBuilder key;
+			key.add(layer.get_revision());
+			key.add(visible);
+			if (visible && layer.is_time_dependent())
+				full_damage = true;
+			const Layer_PasteCanvas *paste = dynamic_cast<const Layer_PasteCanvas*>(&layer);
+			if (paste && paste->get_sub_canvas()
+			 && !Layer_PasteCanvas::add_canvas_to_cache_key(key, *paste->get_sub_canvas()) && visible)
+				full_damage = true;
+			state.key = key.get();
+
+			// A composite layer with a finite bounding rect only draws over its
+			// context. Anything else (filters, distortions, transformations)
+			// may change every pixel of its context and moves the changes of
+			// the layers below it.
+			bool plain = false;
+			Rect bounds;
+			const Layer_Composite *composite = dynamic_cast<const Layer_Composite*>(&layer);
+			if (composite && !Color::is_straight(composite->get_blend_method()))
+			{
+				bounds = paste
+				       ? paste->get_bounding_rect_context_dependent(context.get_params())
+				       : layer.get_bounding_rect();
+				plain = bounds.is_valid()
+				     && bounds.minx > -INFINITY && bounds.maxx < INFINITY
+				     && bounds.miny > -INFINITY && bounds.maxy < INFINITY;
+			}
+			if (!plain)
+				bounds = layer.get_full_bounding_rect(context.get_next());
+			to_pixels(desc, bounds, state);
+
+			if (visible && !plain)
+				exposed = false;
+			current.push_back(state);
+		}
+
+		if (!full_damage)
+		{
+			std::map<GUID, int> previous_index, current_index;
+			for(int i = 0; i < (int)layers.size(); ++i)
+				previous_index[layers[i].guid] = i;
+			for(int i = 0; i < (int)current.size(); ++i)
+				current_index[current[i].guid] = i;
+
+			// layers present in both frames must keep their order
+			int last = -1;
+			for(int i = 0; i < (int)current.size() && !full_damage; ++i)
+			{
+				std::map<GUID, int>::const_iterator j = previous_index.find(current[i].guid);
+				if (j == previous_index.end())
+					{ add_damage(current[i]); continue; }
+				if (j->second <= last)
+					{ full_damage = true; break; }
+				last = j->second;
+				if (layers[j->second].key != current[i].key)
+					{ add_damage(layers[j->second]); add_damage(current[i]); }
+			}
+			for(int i = 0; i < (int)layers.size() && !full_damage; ++i)
+				if (!current_index.count(layers[i].guid))
+					add_damage(layers[i]);
+		}
+
+		layers.swap(current);
+		if (full_damage)
+			tiles.clear();
+	}
+
+	//! Returns \c true if the tile must be rendered again
+	bool is_damaged(int x, int y, int w, int h)const
+	{
+		if (full_damage || !tiles.count(std::make_pair(x, y)))
+			return true;
+		return x < x1 && x0 < x + w && y < y1 && y0 < y + h;
+	}
+
+	//! Returns the tile of the previous frame at \a x, \a y
+	const Surface& get_tile(int x, int y)const
+		{ return tiles.find(std::make_pair(x, y))->second; }
+
+	void put_tile(int x, int y, const Surface &surface)
+		{ if (enabled) tiles[std::make_pair(x, y)] = surface; }
+};
+
+namespace {
+
+//! Renders a single tile with the parametric renderer
+class ParametricTileTask: public ThreadPool::Task
+{
+public:
+	Context context;
+	RendDesc desc;
+	TargetAlphaMode alpha_mode;
+	int x, y;
+	//! The tile didn't change since the previous frame
+	bool reused;
+	Surface surface;
+	bool success;
+
+	ParametricTileTask():
+		alpha_mode(TARGET_ALPHA_MODE_KEEP), x(), y(), reused(), success() { }
+
+	virtual void run()
+	{
+		try
+		{
+			success=parametric_render(context, surface, desc, 0);
+		}
+		catch(...)
+		{
+			success=false;
+		}
+		if(!success || !surface) return;
+
+		Target::apply_alpha_mode(surface[0], surface[0], surface.get_w()*surface.get_h(), alpha_mode, desc.get_bg_color());
+	}
 };
 
+//! Renders a group of tiles with the accelerated renderer
+class AcceleratedGroupTask: public ThreadPool::Task
+{
+public:
+	Context context;
+	RendDesc desc;
+	int quality;
+	TargetAlphaMode alpha_mode;
+	int x0, y0, x1, y1;
+	Surface surface;
+	bool success;
+
+	AcceleratedGroupTask():
+		quality(), alpha_mode(TARGET_ALPHA_MODE_KEEP),
+		x0(), y0(), x1(), y1(), success() { }
+
+	virtual void run()
+	{
+		try
+		{
+			success=context.accelerated_render(&surface, quality, desc, 0);
+		}
+		catch(...)
+		{
+			success=false;
+		}
+		if(!success || !surface) return;
+
+		Target::apply_alpha_mode(surface[0], surface[0], surface.get_w()*surface.get_h(), alpha_mode, desc.get_bg_color());
+	}
+};
+
+} // END of anonymous namespace
+
 Target_Tile::Target_Tile():
-	threads_(2),
+	threads_(1),
 	tile_w_(DEF_TILE_WIDTH),
 	tile_h_(DEF_TILE_HEIGHT),
 	curr_tile_(0),
-	clipping_(true)
+	clipping_(true),
+	incremental_(true)
 {
 	curr_frame_=0;
 }
@@ -169,15 +468,15 @@ Target_Tile::next_tile(int& x, int& y)
 	if(rend_desc().get_w()%tile_w_!=0)tw++;
 	if(rend_desc().get_h()%tile_h_!=0)th++;
 
-	x=(curr_tile_%tw)*tile_h_;
-	y=(curr_tile_/tw)*tile_w_;
+	x=(curr_tile_%tw)*tile_w_;
+	y=(curr_tile_/tw)*tile_h_;
 
 	curr_tile_++;
 	return (tw*th)-curr_tile_+1;
 }
 
 bool
-synfig::Target_Tile::render_frame_(Context context,ProgressCallback *cb)
+synfig::Target_Tile::render_frame_(Context context,ThreadPool &thread_pool,FrameHistory &history,ProgressCallback *cb)
 {
 	if(tile_w_<=0||tile_h_<=0)
 	{
@@ -185,6 +484,9 @@ synfig::Target_Tile::render_frame_(Context context,ProgressCallback *cb)
 		return false;
 	}
 	const RendDesc &rend_desc(desc);
+
+	// the tile groups all render the same layers at once
+	thread_pool.set_threads(context.is_thread_safe() ? thread_pool.get_max_threads() : 1);
 #define total_tiles total_tiles()
 
 	etl::clock total_time;
@@ -197,22 +499,14 @@ synfig::Target_Tile::render_frame_(Context context,ProgressCallback *cb)
 	// use the parametric scanline-renderer.
 	if(get_quality()==0)
 	{
-		Surface surface;
-
-		RendDesc tile_desc;
-		int x,y,w,h;
-		int i;
 		etl::clock tile_timer;
 		tile_timer.reset();
-		while((i=next_tile(x,y)))
-		{
-			find_tile_time+=tile_timer();
-			SuperCallback	super(cb,(total_tiles-i+1)*1000,(total_tiles-i+2)*1000,total_tiles*1000);
-			if(!super.amount_complete(0,1000))
-				return false;
-			//if(cb && !cb->amount_complete(total_tiles-i,total_tiles))
-			//	return false;
 
+		// Gather tiles
+		std::vector<ParametricTileTask> tile_tasks;
+		int x,y,w,h;
+		while(next_tile(x,y))
+		{
 			// Perform clipping on the tile
 			if(clipping_)
 			{
@@ -226,48 +520,77 @@ synfig::Target_Tile::render_frame_(Context context,ProgressCallback *cb)
 				h=tile_h_;
 			}
 
-			tile_desc=rend_desc;
-			tile_desc.set_subwindow(x,y,w,h);
-			if(!parametric_render(context, surface, tile_desc,&super))
+			tile_tasks.push_back(ParametricTileTask());
+			ParametricTileTask &task(tile_tasks.back());
+			task.context=context;
+			task.desc=rend_desc;
+			task.desc.set_subwindow(x,y,w,h);
+			task.alpha_mode=get_alpha_mode();
+			task.x=x;
+			task.y=y;
+			if(!history.is_damaged(x,y,w,h))
 			{
-				// For some reason, the parametric renderer failed.
-				if(cb)cb->error(_("Parametric Renderer Failure"));
-				return false;
+				task.reused=true;
+				task.success=true;
+				task.surface=history.get_tile(x,y);
 			}
-			else
+		}
+		find_tile_time+=tile_timer();
+
+		// Render the tiles in batches, a few tiles per thread, and
+		// hand them over to the target in their original order
+		int batch=thread_pool.get_threads()*4;
+		std::vector<ThreadPool::Task*> tasks;
+		for(int first=0;first<(int)tile_tasks.size();first+=batch)
+		{
+			int last=std::min(first+batch,(int)tile_tasks.size());
+			SuperCallback super(cb,first*1000,last*1000,(int)tile_tasks.size()*1000);
+			if(!super.amount_complete(0,1000))
+				return false;
+
+			tile_timer.reset();
+			tasks.clear();
+			for(int i=first;i<last;i++)
+				if(!tile_tasks[i].reused)
+					tasks.push_back(&tile_tasks[i]);
+			thread_pool.run(tasks);
+			work_time+=tile_timer();
+
+			for(int i=first;i<last;i++)
 			{
-				if(!surface)
+				ParametricTileTask &task(tile_tasks[i]);
+				if(!task.success)
 				{
-					if(cb)cb->error(_("Bad surface"));
+					// For some reason, the parametric renderer failed.
+					if(cb)cb->error(_("Parametric Renderer Failure"));
 					return false;
 				}
-				switch(get_alpha_mode())
+				if(!task.surface)
 				{
-					case TARGET_ALPHA_MODE_FILL:
-						for(int i=0;i<surface.get_w()*surface.get_h();i++)
-							surface[0][i]=Color::blend(surface[0][i],desc.get_bg_color(),1.0f);
-						break;
-					case TARGET_ALPHA_MODE_EXTRACT:
-						for(int i=0;i<surface.get_w()*surface.get_h();i++)
-						{
-							float a=surface[0][i].get_a();
-							surface[0][i] = Color(a,a,a,a);
-						}
-						break;
-					case TARGET_ALPHA_MODE_REDUCE:
-						for(int i=0;i<surface.get_w()*surface.get_h();i++)
-							surface[0][i].set_a(1.0f);
-						break;
+					if(cb)cb->error(_("Bad surface"));
+					return false;
 				}
 
 				// Add the tile to the target
-				if(!add_tile(surface,x,y))
+				tile_timer.reset();
+				if(!add_tile(task.surface,task.x,task.y))
 				{
 					if(cb)cb->error(_("add_tile():Unable to put surface on target"));
 					return false;
 				}
+				add_tile_time+=tile_timer();
+
+				if(task.reused)
+					history.reused_tiles++;
+				else
+				{
+					history.rendered_tiles++;
+					history.put_tile(task.x,task.y,task.surface);
+				}
+
+				// release the pixels early
+				task.surface=Surface();
 			}
-		tile_timer.reset();
 		}
 	}
 	else // If quality is set otherwise, then we use the accelerated renderer
@@ -278,12 +601,33 @@ synfig::Target_Tile::render_frame_(Context context,ProgressCallback *cb)
 		// Gather tiles
 		std::vector<TileGroup::TileInfo> tiles;
 		TileGroup::TileInfo tile_info;
+		// every tile in the order of next_tile(), with its pixels once they are known
+		std::vector<TileGroup::TileInfo> ordered_tiles;
+		std::vector<Surface> ordered_surfaces;
+		std::vector<bool> reused;
+		std::map<std::pair<int, int>, int> tile_positions;
 		while((tile_info.tile_index = next_tile(tile_info.x, tile_info.y)) != 0) {
 			if (clipping_)
 				if (tile_info.x >= rend_desc.get_w() || tile_info.y >= rend_desc.get_h())
 					continue;
+
+			ordered_tiles.push_back(tile_info);
+			ordered_surfaces.push_back(Surface());
+			reused.push_back(false);
+
+			// copy the tiles which didn't change since the previous frame
+			int w = clipping_ ? std::min(tile_w_, rend_desc.get_w() - tile_info.x) : tile_w_;
+			int h = clipping_ ? std::min(tile_h_, rend_desc.get_h() - tile_info.y) : tile_h_;
+			if (!history.is_damaged(tile_info.x, tile_info.y, w, h))
+			{
+				ordered_surfaces.back() = history.get_tile(tile_info.x, tile_info.y);
+				reused.back() = true;
+				continue;
+			}
+
 			tile_info.x /= tile_w_;
 			tile_info.y /= tile_h_;
+			tile_positions[std::make_pair(tile_info.x, tile_info.y)] = (int)ordered_tiles.size() - 1;
 			tiles.push_back(tile_info);
 		}
 		find_tile_time += tile_timer();
@@ -292,93 +636,118 @@ synfig::Target_Tile::render_frame_(Context context,ProgressCallback *cb)
 		std::vector<TileGroup> groups;
 		TileGroup::group_tiles(groups, tiles);
 
-		// Render groups
-		for(std::vector<TileGroup>::iterator i = groups.begin(); i != groups.end(); ++i)
-		{
-			// Progress callback
-			int group_index = i - groups.begin();
-			int groups_count = (int)groups.size();
-			SuperCallback super(cb, (groups_count-group_index)*1000, (groups_count-group_index+1)*1000, groups_count*1000);
-			if(!super.amount_complete(0,1000))
-				return false;
-
-			// Render group
-			tile_timer.reset();
+		// Make sure every thread gets a few groups to work on
+		TileGroup::split_groups(groups, thread_pool.get_threads()*4);
 
-			int x0 = i->x0 * tile_w_;
-			int y0 = i->y0 * tile_w_;
-			int x1 = i->x1 * tile_w_;
-			int y1 = i->y1 * tile_w_;
+		std::vector<AcceleratedGroupTask> group_tasks(groups.size());
+		for(int i = 0; i < (int)groups.size(); ++i)
+		{
+			AcceleratedGroupTask &task = group_tasks[i];
+			task.x0 = groups[i].x0 * tile_w_;
+			task.y0 = groups[i].y0 * tile_h_;
+			task.x1 = groups[i].x1 * tile_w_;
+			task.y1 = groups[i].y1 * tile_h_;
 
 			if (clipping_)
 			{
-				x1 = std::min(x1, rend_desc.get_w());
-				y1 = std::min(y1, rend_desc.get_h());
+				task.x1 = std::min(task.x1, rend_desc.get_w());
+				task.y1 = std::min(task.y1, rend_desc.get_h());
 			}
 
-			RendDesc group_desc=rend_desc;
-			group_desc.set_subwindow(x0,y0,x1-x0,y1-y0);
+			task.context = context;
+			task.desc = rend_desc;
+			task.desc.set_subwindow(task.x0, task.y0, task.x1-task.x0, task.y1-task.y0);
+			task.quality = get_quality();
+			task.alpha_mode = get_alpha_mode();
+		}
 
-			Surface surface;
-			if (!context.accelerated_render(&surface, get_quality(), group_desc, &super))
+		// Render groups in batches and split them by tiles. Every tile,
+		// rendered or reused, goes to the target in the order of next_tile()
+		// as soon as the tiles before it are there.
+		int batch = thread_pool.get_threads()*2;
+		int groups_count = (int)groups.size();
+		int next_tile_to_add = 0;
+		std::vector<ThreadPool::Task*> tasks;
+		for(int first = 0; ; first += batch)
+		{
+			// Add the tiles which are ready to the target
+			for(; next_tile_to_add < (int)ordered_tiles.size() && ordered_surfaces[next_tile_to_add]; ++next_tile_to_add)
 			{
-				// For some reason, the accelerated renderer failed.
-				if(cb)cb->error(_("Accelerated Renderer Failure"));
-				return false;
+				const TileGroup::TileInfo &tile = ordered_tiles[next_tile_to_add];
+				tile_timer.reset();
+				if(!add_tile(ordered_surfaces[next_tile_to_add], tile.x, tile.y))
+				{
+					if(cb)cb->error(_("add_tile():Unable to put surface on target"));
+					return false;
+				}
+				add_tile_time+=tile_timer();
+
+				if (reused[next_tile_to_add])
+					history.reused_tiles++;
+				else
+					history.rendered_tiles++;
+
+				// release the pixels early
+				ordered_surfaces[next_tile_to_add] = Surface();
 			}
 
-			if(!surface)
-			{
-				if(cb)cb->error(_("Bad surface"));
+			if (first >= groups_count)
+				break;
+			int last = std::min(first + batch, groups_count);
+
+			// Progress callback
+			SuperCallback super(cb, first*1000, last*1000, groups_count*1000);
+			if(!super.amount_complete(0,1000))
 				return false;
-			}
-			switch(get_alpha_mode())
-			{
-				case TARGET_ALPHA_MODE_FILL:
-					for(int i=0; i<surface.get_w()*surface.get_h(); ++i)
-						surface[0][i] = Color::blend(surface[0][i], desc.get_bg_color(), 1.0f);
-					break;
-				case TARGET_ALPHA_MODE_EXTRACT:
-					for(int i=0; i<surface.get_w()*surface.get_h(); ++i)
-					{
-						float a=surface[0][i].get_a();
-						surface[0][i] = Color(a,a,a,a);
-					}
-					break;
-				case TARGET_ALPHA_MODE_REDUCE:
-					for(int i=0;i<surface.get_w()*surface.get_h(); ++i)
-						surface[0][i].set_a(1.0f);
-					break;
-				}
 
+			// Render groups
+			tile_timer.reset();
+			tasks.clear();
+			for(int i = first; i < last; ++i)
+				tasks.push_back(&group_tasks[i]);
+			thread_pool.run(tasks);
 			work_time += tile_timer();
 
-			// Split group by tiles
-			for(std::vector<TileGroup::TileInfo>::iterator j = i->tiles.begin(); j != i->tiles.end(); ++j)
+			for(int i = first; i < last; ++i)
 			{
-				int tx0 = j->x * tile_w_;
-				int ty0 = j->y * tile_w_;
-				int tx1 = std::min(tx0 + tile_w_, x1);
-				int ty1 = std::min(ty0 + tile_w_, y1);
-
-				Surface tile_surface(Surface::size_type(tx1-tx0, ty1-ty0));
-				Surface::pen pen = tile_surface.get_pen(0, 0);
-				surface.blit_to(
-					pen,
-					tx0-x0, ty0-y0,
-					tile_surface.get_w(), tile_surface.get_h() );
+				AcceleratedGroupTask &task = group_tasks[i];
+				if (!task.success)
+				{
+					// For some reason, the accelerated renderer failed.
+					if(cb)cb->error(_("Accelerated Renderer Failure"));
+					return false;
+				}
 
-				// Add the tile to the target
-				tile_timer.reset();
-				if(!add_tile(tile_surface, tx0, ty0))
+				if(!task.surface)
 				{
-					if(cb)cb->error(_("add_tile():Unable to put surface on target"));
+					if(cb)cb->error(_("Bad surface"));
 					return false;
 				}
-				add_tile_time+=tile_timer();
-			}
 
-			signal_progress()();
+				// Split group by tiles
+				for(std::vector<TileGroup::TileInfo>::iterator j = groups[i].tiles.begin(); j != groups[i].tiles.end(); ++j)
+				{
+					int tx0 = j->x * tile_w_;
+					int ty0 = j->y * tile_h_;
+					int tx1 = std::min(tx0 + tile_w_, task.x1);
+					int ty1 = std::min(ty0 + tile_h_, task.y1);
+
+					Surface tile_surface(Surface::size_type(tx1-tx0, ty1-ty0));
+					Surface::pen pen = tile_surface.get_pen(0, 0);
+					task.surface.blit_to(
+						pen,
+						tx0-task.x0, ty0-task.y0,
+						tile_surface.get_w(), tile_surface.get_h() );
+
+					history.put_tile(tx0, ty0, tile_surface);
+					ordered_surfaces[tile_positions[std::make_pair(j->x, j->y)]] = tile_surface;
+				}
+
+				// release the pixels early
+				task.surface = Surface();
+
+				signal_progress()();
+			}
 		}
 	}
 	if(cb && !cb->amount_complete(total_tiles,total_tiles))
@@ -417,10 +786,31 @@ synfig::Target_Tile::render(ProgressCallback *cb)
 
 	ContextParams context_params(desc.get_render_excluded_contexts());
 
+	// Worker threads live for the whole render, not for a single frame
+	ThreadPool thread_pool(threads_>0?threads_:1);
+
+	// Everything but the layers which determines the rendered tiles
+	SurfaceCache::KeyBuilder settings;
+	settings.add(desc.get_w());
+	settings.add(desc.get_h());
+	settings.add(desc.get_tl());
+	settings.add(desc.get_br());
+	settings.add(desc.get_transformation_matrix());
+	settings.add(desc.get_antialias());
+	settings.add(desc.get_bg_color());
+	settings.add(get_quality());
+	settings.add(get_alpha_mode());
+	settings.add(tile_w_);
+	settings.add(tile_h_);
+	settings.add(clipping_);
+
 	// Calculate the number of frames
 	total_frames=frame_end-frame_start+1;
 	if(total_frames<=0)total_frames=1;
 
+	// Only a sequence of frames can reuse tiles
+	FrameHistory history(total_frames>1 && incremental_ && !getenv("SYNFIG_DISABLE_INCREMENTAL_RENDER"));
+
 	try {
 
 		if(total_frames>=1)
@@ -449,6 +839,10 @@ synfig::Target_Tile::render(ProgressCallback *cb)
 				// Why the above line was commented here and not in TargetScaline?
 					canvas->set_time(t);
 
+				// Find the tiles changed since the previous frame,
+				// the optimized layers are new copies every frame
+				history.update(canvas->get_context(context_params), desc, settings.get());
+
 	#ifdef SYNFIG_OPTIMIZE_LAYER_TREE
 				Canvas::Handle op_canvas;
 				if (!getenv("SYNFIG_DISABLE_OPTIMIZE_LAYER_TREE"))
@@ -481,7 +875,7 @@ synfig::Target_Tile::render(ProgressCallback *cb)
 				#endif
 	*/
 
-				if(!render_frame_(context,0))
+				if(!render_frame_(context,thread_pool,history,0))
 					return false;
 				end_frame();
 			}while(frames);
@@ -517,7 +911,7 @@ synfig::Target_Tile::render(ProgressCallback *cb)
 			context=canvas->get_context(context_params);
 #endif
 
-			if(!render_frame_(context, cb))
+			if(!render_frame_(context,thread_pool,history,cb))
 				return false;
 			end_frame();
 		}
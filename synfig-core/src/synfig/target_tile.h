@@ -41,6 +41,8 @@
 
 namespace synfig {
 
+class ThreadPool;
+
 /*!	\class Target_Tile
 **	\brief Render-target
 **	\todo writeme
@@ -58,8 +60,12 @@ class Target_Tile : public Target
 	//! Determines if the tiles should be clipped to the redener description
 	//! or not
 	bool clipping_;
+	//! Determines if the tiles which did not change since the previous
+	//! frame are copied instead of rendered again
+	bool incremental_;
 
 	struct TileGroup;
+	struct FrameHistory;
 public:
 	typedef etl::handle<Target_Tile> Handle;
 	typedef etl::loose_handle<Target_Tile> LooseHandle;
@@ -120,10 +126,14 @@ public:
 	bool get_clipping()const { return clipping_; }
 	//! Sets clipping
 	void set_clipping(bool x) { clipping_=x; }
+	//! Gets incremental rendering
+	bool get_incremental()const { return incremental_; }
+	//! Sets incremental rendering
+	void set_incremental(bool x) { incremental_=x; }
 
 private:
 	//! Renders the context to the surface
-	bool render_frame_(Context context,ProgressCallback *cb=0);
+	bool render_frame_(Context context,ThreadPool &thread_pool,FrameHistory &history,ProgressCallback *cb=0);
 
 }; // END of class Target_Tile
 
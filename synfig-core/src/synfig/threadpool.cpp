@@ -0,0 +1,324 @@
+/* === S Y N F I G ========================================================= */
+/*!	\file synfig/threadpool.cpp
+**	\brief Shared-memory thread pool with work stealing
+**
+**	$Id$
+**
+**	\legal
+**	Copyright (c) 2016 Synfig contributors
+**
+**	This package is free software; you can redistribute it and/or
+**	modify it under the terms of the GNU General Public License as
+**	published by the Free Software Foundation; either version 2 of
+**	the License, or (at your option) any later version.
+**
+**	This package is distributed in the hope that it will be useful,
+**	but WITHOUT ANY WARRANTY; without even the implied warranty of
+**	MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE. See the GNU
+**	General Public License for more details.
+**	\endlegal
+*/
+/* ========================================================================= */
+
+/* === H E A D E R S ======================================================= */
+
+#ifdef USING_PCH
+#	include "pch.h"
+#else
+#ifdef HAVE_CONFIG_H
+#	include <config.h>
+#endif
+
+#ifdef WIN32
+#include <windows.h>
+#else
+#include <unistd.h>
+#endif
+
+#include <glibmm/thread.h>
+#include <sigc++/bind.h>
+
+#include "threadpool.h"
+#include "mutex.h"
+
+#endif
+
+/* === U S I N G =========================================================== */
+
+using namespace std;
+using namespace synfig;
+
+/* === M A C R O S ========================================================= */
+
+/* === G L O B A L S ======================================================= */
+
+//! Workers of all the pools, and the threads helping in ThreadPool::run()
+static std::vector<Glib::Thread*> busy_threads;
+static Mutex busy_mutex;
+
+static ThreadPool *shared_pool;
+static int shared_pool_threads;
+static Mutex shared_pool_mutex;
+
+/* === P R O C E D U R E S ================================================= */
+
+//! Marks the calling thread as working for a pool while it exists
+class BusyThread
+{
+	Glib::Thread *self;
+public:
+	BusyThread(): self(Glib::Thread::self())
+	{
+		Mutex::Lock lock(busy_mutex);
+		busy_threads.push_back(self);
+	}
+	~BusyThread()
+	{
+		Mutex::Lock lock(busy_mutex);
+		busy_threads.erase(std::find(busy_threads.begin(), busy_threads.end(), self));
+	}
+};
+
+/* === M E T H O D S ======================================================= */
+
+//! Tasks submitted by a single call of ThreadPool::run()
+struct ThreadPool::Batch
+{
+	int pending;
+	Batch(): pending() { }
+};
+
+struct ThreadPool::Item
+{
+	Task *task;
+	Batch *batch;
+	Item(): task(), batch() { }
+	Item(Task *task, Batch *batch): task(task), batch(batch) { }
+};
+
+struct ThreadPool::Queue
+{
+	Glib::Mutex mutex;
+	std::deque<Item> items;
+};
+
+ThreadPool::Task::~Task() { }
+
+ThreadPool::ThreadPool(int threads, int max_threads):
+	max_threads_(std::max(threads > 0 ? threads : get_processor_count(), max_threads)),
+	threads_(threads > 0 ? threads : get_processor_count()),
+	stopping_(false),
+	queued_(0),
+	mutex_(new Glib::Mutex()),
+	cond_wake_(new Glib::Cond()),
+	cond_done_(new Glib::Cond())
+{
+	if (!Glib::thread_supported())
+		Glib::thread_init();
+
+	// queue 0 belongs to the thread calling run()
+	for(int i = 0; i < max_threads_; ++i)
+		queues_.push_back(new Queue());
+	for(int i = 1; i < max_threads_; ++i)
+		workers_.push_back(Glib::Thread::create(
+			sigc::bind(sigc::mem_fun(*this, &ThreadPool::worker), i), true ));
+}
+
+ThreadPool::~ThreadPool()
+{
+	{
+		Glib::Mutex::Lock lock(*mutex_);
+		stopping_ = true;
+		cond_wake_->broadcast();
+	}
+	for(std::vector<Glib::Thread*>::iterator i = workers_.begin(); i != workers_.end(); ++i)
+		(*i)->join();
+	for(std::vector<Queue*>::iterator i = queues_.begin(); i != queues_.end(); ++i)
+		delete *i;
+	delete cond_done_;
+	delete cond_wake_;
+	delete mutex_;
+}
+
+int
+ThreadPool::get_processor_count()
+{
+	int count = 1;
+#ifdef WIN32
+	SYSTEM_INFO info;
+	GetSystemInfo(&info);
+	count = (int)info.dwNumberOfProcessors;
+#elif defined(_SC_NPROCESSORS_ONLN)
+	count = (int)sysconf(_SC_NPROCESSORS_ONLN);
+#endif
+	return count > 0 ? count : 1;
+}
+
+bool
+ThreadPool::is_busy_thread()
+{
+	Glib::Thread *self = Glib::Thread::self();
+	Mutex::Lock lock(busy_mutex);
+	return std::find(busy_threads.begin(), busy_threads.end(), self) != busy_threads.end();
+}
+
+void
+ThreadPool::set_threads(int threads)
+{
+	if (threads <= 0) threads = get_processor_count();
+	Glib::Mutex::Lock lock(*mutex_);
+	threads_.set(std::min(threads, max_threads_));
+	// wake the workers which may take part again
+	cond_wake_->broadcast();
+}
+
+ThreadPool&
+ThreadPool::instance()
+{
+	Mutex::Lock lock(shared_pool_mutex);
+	if (!shared_pool)
+		shared_pool = new ThreadPool(shared_pool_threads, get_processor_count());
+	return *shared_pool;
+}
+
+void
+ThreadPool::set_instance_threads(int threads)
+{
+	Mutex::Lock lock(shared_pool_mutex);
+	shared_pool_threads = threads;
+	if (shared_pool)
+		shared_pool->set_threads(threads);
+}
+
+int
+ThreadPool::get_worker_index()const
+{
+	Glib::Thread *self = Glib::Thread::self();
+	for(int i = 0; i < (int)workers_.size(); ++i)
+		if (workers_[i] == self) return i + 1;
+	return 0;
+}
+
+bool
+ThreadPool::take(int index, Item &item)
+{
+	// own queue first, newest task (best cache locality)
+	{
+		Queue &queue = *queues_[index];
+		Glib::Mutex::Lock lock(queue.mutex);
+		if (!queue.items.empty())
+		{
+			item = queue.items.back();
+			queue.items.pop_back();
+			return true;
+		}
+	}
+
+	// steal the oldest task of the other workers, also from the queues
+	// of the workers left out by set_threads() while they had tasks
+	for(int i = 1; i < max_threads_; ++i)
+	{
+		Queue &queue = *queues_[(index + i) % max_threads_];
+		Glib::Mutex::Lock lock(queue.mutex);
+		if (!queue.items.empty())
+		{
+			item = queue.items.front();
+			queue.items.pop_front();
+			return true;
+		}
+	}
+
+	return false;
+}
+
+void
+ThreadPool::execute(const Item &item)
+{
+	{
+		Glib::Mutex::Lock lock(*mutex_);
+		--queued_;
+	}
+
+	item.task->run();
+
+	Glib::Mutex::Lock lock(*mutex_);
+	if (--item.batch->pending == 0)
+		cond_done_->broadcast();
+}
+
+void
+ThreadPool::worker(int index)
+{
+	BusyThread busy;
+	Item item;
+	while(true)
+	{
+		{
+			Glib::Mutex::Lock lock(*mutex_);
+			while(!stopping_ && (queued_ <= 0 || index >= threads_.get()))
+				cond_wake_->wait(*mutex_);
+			if (stopping_) return;
+		}
+		while(take(index, item))
+			execute(item);
+	}
+}
+
+void
+ThreadPool::run(const std::vector<Task*> &tasks)
+{
+	if (tasks.empty()) return;
+
+	// single thread or single task - nothing to distribute, and a thread
+	// which already works for a pool keeps its batch to itself
+	int threads = threads_.get();
+	if (threads <= 1 || tasks.size() == 1 || is_busy_thread())
+	{
+		for(std::vector<Task*>::const_iterator i = tasks.begin(); i != tasks.end(); ++i)
+			(*i)->run();
+		return;
+	}
+
+	BusyThread busy;
+	int index = get_worker_index();
+
+	Batch batch;
+	batch.pending = (int)tasks.size();
+
+	// deal tasks to the deques in contiguous runs, so neighbouring
+	// tasks (adjacent rows or tiles) tend to stay on one worker
+	int count = (int)tasks.size();
+	for(int q = 0; q < threads; ++q)
+	{
+		int begin = count*q/threads;
+		int end = count*(q + 1)/threads;
+		if (begin == end) continue;
+		Queue &queue = *queues_[(index + q) % threads];
+		Glib::Mutex::Lock lock(queue.mutex);
+		for(int i = end - 1; i >= begin; --i)
+			queue.items.push_back(Item(tasks[i], &batch));
+	}
+
+	{
+		Glib::Mutex::Lock lock(*mutex_);
+		queued_ += count;
+		cond_wake_->broadcast();
+	}
+
+	// help with the work until our batch is finished
+	Item item;
+	while(true)
+	{
+		if (take(index, item))
+		{
+			execute(item);
+			continue;
+		}
+
+		Glib::Mutex::Lock lock(*mutex_);
+		if (batch.pending == 0) break;
+		if (queued_ <= 0) cond_done_->wait(*mutex_);
+	}
+}
+
+/* === E N D =============================================================== */
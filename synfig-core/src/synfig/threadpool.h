@@ -0,0 +1,183 @@
+/* === S Y N F I G ========================================================= */
+/*!	\file synfig/threadpool.h
+**	\brief Shared-memory thread pool with work stealing
+**
+**	$Id$
+**
+**	\legal
+**	Copyright (c) 2016 Synfig contributors
+**
+**	This package is free software; you can redistribute it and/or
+**	modify it under the terms of the GNU General Public License as
+**	published by the Free Software Foundation; either version 2 of
+**	the License, or (at your option) any later version.
+**
+**	This package is distributed in the hope that it will be useful,
+**	but WITHOUT ANY WARRANTY; without even the implied warranty of
+**	MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE. See the GNU
+**	General Public License for more details.
+**	\endlegal
+*/
+/* ========================================================================= */
+
+/* === S T A R T =========================================================== */
+
+#ifndef __SYNFIG_THREADPOOL_H
+#define __SYNFIG_THREADPOOL_H
+
+/* === H E A D E R S ======================================================= */
+
+#include <vector>
+#include <deque>
+#include <algorithm>
+#include <ETL/handle>
+
+/* === M A C R O S ========================================================= */
+
+/* === T Y P E D E F S ===================================================== */
+
+namespace Glib { class Thread; class Mutex; class Cond; }
+
+/* === C L A S S E S & S T R U C T S ======================================= */
+
+namespace synfig {
+
+/*!	\class ThreadPool
+**	\brief Fixed set of worker threads fed through per-worker deques
+**
+**	Every worker owns a deque of tasks. A worker pops work from the back
+**	of its own deque and, once that is empty, steals from the front of
+**	the other deques. The thread calling run() takes part in the work as
+**	well, so a pool of \c N threads starts only <tt>N-1</tt> extra threads.
+**
+**	A batch submitted by a thread which already works for a pool, either
+**	as one of its workers or as the caller helping in run(), runs on the
+**	spot in that thread. Nested pools (tiles, then the bands of a layer)
+**	so never use more threads than the outermost one.
+*/
+class ThreadPool
+{
+public:
+	//! Unit of work handed to the pool
+	class Task
+	{
+	public:
+		virtual ~Task();
+		//! Performs the work. Must not throw.
+		virtual void run()=0;
+	};
+
+private:
+	struct Batch;
+	struct Item;
+	struct Queue;
+
+	//! Calls a pass over one band of a run_bands() call
+	template<typename Pass>
+	class BandTask: public Task
+	{
+		const Pass *pass_;
+		int begin_, end_;
+	public:
+		BandTask(const Pass &pass, int begin, int end):
+			pass_(&pass), begin_(begin), end_(end) { }
+		virtual void run() { (*pass_)(begin_, end_); }
+	};
+
+	//! Number of queues and workers, fixed when the pool is created
+	int max_threads_;
+	//! Number of them taking part in the batches, see set_threads()
+	etl::atomic_counter threads_;
+	bool stopping_;
+	//! Number of items pushed into the queues and not yet taken
+	int queued_;
+
+	std::vector<Queue*> queues_;
+	std::vector<Glib::Thread*> workers_;
+
+	Glib::Mutex *mutex_;
+	Glib::Cond *cond_wake_;
+	Glib::Cond *cond_done_;
+
+	int get_worker_index()const;
+	bool take(int index, Item &item);
+	void execute(const Item &item);
+	void worker(int index);
+
+	//! Non-copyable
+	ThreadPool(const ThreadPool&);
+	//! Non-assignable
+	void operator=(const ThreadPool&);
+
+public:
+	//! Creates a pool which uses \a threads threads (including the caller).
+	/*! Values lower than one select get_processor_count() threads.
+	**	The pool may later be resized up to \a max_threads threads,
+	**	by default the number it was created with. */
+	explicit ThreadPool(int threads=0, int max_threads=0);
+	~ThreadPool();
+
+	//! Number of threads working on a batch, including the caller
+	int get_threads()const { return threads_.get(); }
+	//! Number of threads the pool may be resized to
+	int get_max_threads()const { return max_threads_; }
+
+	//! Changes the number of threads working on the batches submitted from now on
+	/*!	Values lower than one select get_processor_count() threads, values
+	**	above get_max_threads() are clamped. The workers beyond the new count
+	**	finish the task they are running and then wait, the tasks left in their
+	**	queues are taken by the others. Safe to call while batches run. */
+	void set_threads(int threads);
+
+	//! Runs every task of \a tasks and returns when all of them are done
+	void run(const std::vector<Task*> &tasks);
+
+	//! Splits \a count rows (columns, items...) into at most \a bands
+	//! contiguous bands and calls <tt>pass(begin, end)</tt> for each of them
+	/*!	The bands run concurrently, so \a pass must only write to its own band. */
+	template<typename Pass>
+	void run_bands(const Pass &pass, int count, int bands)
+	{
+		bands = std::min(bands, count);
+		if (bands <= 1)
+		{
+			if (count > 0) pass(0, count);
+			return;
+		}
+
+		std::vector< BandTask<Pass> > tasks;
+		tasks.reserve(bands);
+		for(int i = 0; i < bands; ++i)
+			tasks.push_back(BandTask<Pass>(pass, count*i/bands, count*(i + 1)/bands));
+
+		std::vector<Task*> list;
+		for(int i = 0; i < bands; ++i)
+			list.push_back(&tasks[i]);
+		run(list);
+	}
+
+	//! Number of online processors, at least one
+	static int get_processor_count();
+
+	//! Whether the calling thread works for a pool, so batches it submits run on the spot
+	static bool is_busy_thread();
+
+	//! Pool shared by the code which does not run on a pool of its own
+	/*!	Created on first use with the number of threads given to
+	**	set_instance_threads(), get_processor_count() by default, and never
+	**	replaced, so the reference may be kept. Tasks of several callers may
+	**	be queued at once, each caller waits for its own. */
+	static ThreadPool& instance();
+
+	//! Sets the number of threads of instance(), values lower than one select get_processor_count()
+	/*!	Once the pool exists it is resized in place with set_threads(). It
+	**	has room for at least get_processor_count() threads, or for the
+	**	number set before it was created if that is more. */
+	static void set_instance_threads(int threads);
+}; // END of class ThreadPool
+
+}; // END of namespace synfig
+
+/* === E N D =============================================================== */
+
+#endif
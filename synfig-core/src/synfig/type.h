@@ -28,6 +28,7 @@
 /* === H E A D E R S ======================================================= */
 
 #include <cassert>
+#include <new>
 #include <vector>
 #include <map>
 #include <typeinfo>
@@ -143,9 +144,15 @@ public:
 		TYPE_COPY,
 		TYPE_COMPARE,
 		TYPE_TO_STRING,
+		TYPE_CREATE_INLINE,
+		TYPE_DESTROY_INLINE,
 	};
 
+	//! Bytes a value may take to be stored inside ValueBase, see Type::register_inline()
+	enum { INLINE_SIZE = 3*sizeof(double) };
+
 	typedef InternalPointer	(*CreateFunc)	();
+	typedef InternalPointer	(*CreateInlineFunc)	(InternalPointer place);
 	typedef void			(*DestroyFunc)	(const InternalPointer);
 	typedef void			(*CopyFunc)		(const InternalPointer dest, const InternalPointer src);
 	typedef bool			(*CompareFunc)	(const InternalPointer, const InternalPointer);
@@ -172,6 +179,12 @@ public:
 		template<typename Inner>
 		static void destroy(const InternalPointer x)
 			{ return delete (Inner*)x; }
+		template<typename Inner>
+		static InternalPointer create_inline(InternalPointer place)
+			{ return new(place) Inner(); }
+		template<typename Inner>
+		static void destroy_inline(const InternalPointer x)
+			{ ((Inner*)x)->~Inner(); }
 		template<typename Inner, typename Outer>
 		static void set(InternalPointer dest, const Outer &src)
 			{ *(Inner*)dest = src; }
@@ -241,6 +254,40 @@ public:
 			{ return Description(TYPE_TO_STRING, 0, type); }
 		inline static Description get_binary(OperationType operation_type, TypeId return_type, TypeId type_a, TypeId type_b)
 			{ return Description(operation_type, return_type, type_a, type_b); }
+		inline static Description get_create_inline(TypeId type)
+			{ return Description(TYPE_CREATE_INLINE, type); }
+		inline static Description get_destroy_inline(TypeId type)
+			{ return Description(TYPE_DESTROY_INLINE, 0, type); }
+
+		//! Tells whether the operation concerns a single type, as built
+		//! by get_create(), get_set(), get_copy(TypeId)... and if so gives it
+		/*!	Such operations are looked up in a table indexed by the type,
+		**	the others in a map of descriptions */
+		inline bool get_indexed_type(TypeId &type) const
+		{
+			switch(operation_type)
+			{
+			case TYPE_CREATE:
+			case TYPE_CREATE_INLINE:
+				type = return_type;
+				return type_a == 0 && type_b == 0;
+			case TYPE_DESTROY:
+			case TYPE_DESTROY_INLINE:
+			case TYPE_SET:
+			case TYPE_GET:
+			case TYPE_TO_STRING:
+				type = type_a;
+				return return_type == 0 && type_b == 0;
+			case TYPE_PUT:
+				type = type_b;
+				return return_type == 0 && type_a == 0;
+			case TYPE_COPY:
+				type = type_a;
+				return return_type == 0 && type_a == type_b;
+			default:
+				return false;
+			}
+		}
 	};
 
 private:
@@ -297,53 +344,111 @@ private:
 	public:
 		typedef std::pair<Type*, T> Entry;
 		typedef std::map<Operation::Description, Entry> Map;
+		//! Functions of the single type operations, by operation type and type id
+		typedef std::vector< std::vector<T> > Index;
 
 		static OperationBook instance;
 
 	private:
-		Map map;
-		Map *map_alias;
+		struct Storage
+		{
+			Map map;
+			Index index;
+
+			void add_to_index(const Operation::Description &description, T func)
+			{
+				TypeId type;
+				if (!description.get_indexed_type(type)) return;
+				if (index.size() <= (size_t)description.operation_type)
+					index.resize(description.operation_type + 1);
+				std::vector<T> &row = index[description.operation_type];
+				if (row.size() <= type)
+					row.resize(type + 1, T());
+				row[type] = func;
+			}
 
-		OperationBook(): map_alias(&map) { }
+			void reindex()
+			{
+				index.clear();
+				for(typename Map::const_iterator i = map.begin(); i != map.end(); ++i)
+					add_to_index(i->first, i->second.second);
+			}
+		};
 
-	public:
-		inline Map& get_map()
+		Storage storage;
+		Storage *storage_alias;
+
+		OperationBook(): storage_alias(&storage) { }
+
+		inline Storage& get_storage()
 		{
 #ifdef INITIALIZE_TYPE_BEFORE_USE
 			if (!OperationBookBase::initialized) OperationBookBase::initialize_all();
 #endif
-			return *map_alias;
+			return *storage_alias;
 		}
 
-		inline const Map& get_map() const
+		inline const Storage& get_storage() const
 		{
 #ifdef INITIALIZE_TYPE_BEFORE_USE
 			if (!OperationBookBase::initialized) OperationBookBase::initialize_all();
 #endif
-			return *map_alias;
+			return *storage_alias;
+		}
+
+	public:
+		inline const Map& get_map() const
+			{ return get_storage().map; }
+
+		//! Returns the function registered for \a description, or NULL
+		inline T find(const Operation::Description &description) const
+		{
+			const Storage &storage = get_storage();
+			TypeId type;
+			if (description.get_indexed_type(type))
+			{
+				const Index &index = storage.index;
+				return (size_t)description.operation_type < index.size()
+				    && type < index[description.operation_type].size()
+				     ? index[description.operation_type][type] : NULL;
+			}
+			typename Map::const_iterator i = storage.map.find(description);
+			return i == storage.map.end() ? NULL : i->second.second;
+		}
+
+		void add(const Operation::Description &description, const Entry &entry)
+		{
+			Storage &storage = get_storage();
+			assert(!storage.map.count(description) || storage.map[description].first == entry.first);
+			storage.map[description] = entry;
+			storage.add_to_index(description, entry.second);
 		}
 
 		virtual void set_alias(OperationBookBase *alias)
 		{
-			map_alias = alias == NULL ? &map : ((OperationBook<T>*)alias)->map_alias;
-			if (map_alias != &map)
+			storage_alias = alias == NULL ? &storage : ((OperationBook<T>*)alias)->storage_alias;
+			if (storage_alias != &storage)
 			{
-				map_alias->insert(map.begin(), map.end());
-				map.clear();
+				storage_alias->map.insert(storage.map.begin(), storage.map.end());
+				storage_alias->reindex();
+				storage.map.clear();
+				storage.index.clear();
 			}
 		}
 
 		virtual void remove_type(TypeId identifier)
 		{
-			Map &map = get_map();
-			for(typename Map::iterator i = map.begin(); i != map.end();)
+			Storage &storage = get_storage();
+			bool removed = false;
+			for(typename Map::iterator i = storage.map.begin(); i != storage.map.end();)
 				if (i->second.first->identifier == identifier)
-					map.erase(i++); else ++i;
+					{ storage.map.erase(i++); removed = true; } else ++i;
+			if (removed) storage.reindex();
 		}
 
 		~OperationBook() {
-			while(!map.empty())
-				map.begin()->second.first->deinitialize();
+			while(!storage.map.empty())
+				storage.map.begin()->second.first->deinitialize();
 		}
 	};
 
@@ -391,13 +496,7 @@ private:
 private:
 	template<typename T>
 	void register_operation(const Operation::Description &description, T func)
-	{
-		typedef typename OperationBook<T>::Entry Entry;
-		typedef typename OperationBook<T>::Map Map;
-		Map &map = OperationBook<T>::instance.get_map();
-		assert(!map.count(description) || map[description].first == this);
-		map[description] = Entry(this, func);
-	}
+		{ OperationBook<T>::instance.add(description, typename OperationBook<T>::Entry(this, func)); }
 
 protected:
 	virtual void initialize_vfunc(Description &description)
@@ -424,12 +523,7 @@ public:
 
 	template<typename T>
 	static T get_operation(const Operation::Description &description)
-	{
-		typedef typename OperationBook<T>::Map Map;
-		const Map &map = OperationBook<T>::instance.get_map();
-		typename Map::const_iterator i = map.find(description);
-		return i == map.end() ? NULL : i->second.second;
-	}
+		{ return OperationBook<T>::instance.find(description); }
 
 	template<typename T>
 	static T get_operation_by_type(const Operation::Description &description, T)
@@ -519,6 +613,18 @@ protected:
 	inline void register_to_string(Operation::ToStringFunc func)
 		{ register_to_string(identifier, func); }
 
+	//! Lets ValueBase keep values of this type in its own storage instead of allocating them
+	/*!	Meant for small values which are copied often. A ValueBase holding
+	**	such a value copies it on copy instead of sharing it. */
+	template<typename Inner>
+	inline void register_inline()
+	{
+		// Inner has to fit into Operation::INLINE_SIZE bytes
+		(void)sizeof(char[sizeof(Inner) <= Operation::INLINE_SIZE ? 1 : -1]);
+		register_operation(Operation::Description::get_create_inline(identifier), (Operation::CreateInlineFunc)Operation::DefaultFuncs::create_inline<Inner>);
+		register_operation(Operation::Description::get_destroy_inline(identifier), (Operation::DestroyFunc)Operation::DefaultFuncs::destroy_inline<Inner>);
+	}
+
 	// default register
 	inline void register_default(Operation::CreateFunc func)
 		{ register_create(identifier, func); }
@@ -82,6 +82,22 @@ ValueBase::ValueBase(Type &x):
 	create(x);
 }
 
+ValueBase::ValueBase(const ValueBase &x):
+	type(x.type),data(x.data),ref_count(x.ref_count),loop_(x.loop_),static_(x.static_),interpolation_(x.interpolation_)
+{
+	if (x.is_inline())
+	{
+		type = &type_nil;
+		data = 0;
+		create(*x.type);
+		Operation::CopyFunc func =
+			Type::get_operation<Operation::CopyFunc>(
+				Operation::Description::get_copy(type->identifier) );
+		assert(func != NULL);
+		func(data, x.data);
+	}
+}
+
 ValueBase::~ValueBase()
 {
 	clear();
@@ -101,7 +117,7 @@ ValueBase::get_string() const
 bool
 ValueBase::is_valid()const
 {
-	return type != &type_nil && ref_count;
+	return type != &type_nil && (ref_count || is_inline());
 }
 
 void
@@ -111,6 +127,16 @@ ValueBase::create(Type &type)
 	type.initialize();
 #endif
 	if (type == type_nil) { clear(); return; }
+	Operation::CreateInlineFunc inline_func =
+		Type::get_operation<Operation::CreateInlineFunc>(
+			Operation::Description::get_create_inline(type.identifier) );
+	if (inline_func != NULL)
+	{
+		clear();
+		this->type = &type;
+		data = inline_func(inline_data.bytes);
+		return;
+	}
 	Operation::CreateFunc func =
 		Type::get_operation<Operation::CreateFunc>(
 			Operation::Description::get_create(type.identifier) );
@@ -129,7 +155,7 @@ ValueBase::copy(const ValueBase& x)
 			Operation::Description::get_copy(type->identifier, x.type->identifier));
 	if (func != NULL)
 	{
-		if (!ref_count.unique()) create();
+		if (!is_unique()) create();
 		func(data, x.data);
 	}
 	else
@@ -139,7 +165,7 @@ ValueBase::copy(const ValueBase& x)
 				Operation::Description::get_copy(x.type->identifier, x.type->identifier));
 		if (func != NULL)
 		{
-			if (!ref_count.unique()) create(*x.type);
+			if (!is_unique() || type != x.type) create(*x.type);
 			func(data, x.data);
 		}
 	}
@@ -180,7 +206,17 @@ ValueBase::operator=(const ValueBase& x)
 				Operation::Description::get_copy(current_type.identifier, new_type.identifier) );
 		if (func != NULL)
 		{
-			create(current_type);
+			// the data is ours alone, so it is overwritten in place
+			if (!is_unique()) create(current_type);
+			func(data, x.data);
+		}
+		else if (x.is_inline())
+		{
+			create(new_type);
+			Operation::CopyFunc func =
+				Type::get_operation<Operation::CopyFunc>(
+					Operation::Description::get_copy(new_type.identifier) );
+			assert(func != NULL);
 			func(data, x.data);
 		}
 		else
@@ -200,6 +236,15 @@ ValueBase::operator=(const ValueBase& x)
 void
 ValueBase::clear()
 {
+	if(is_inline())
+	{
+		Operation::DestroyFunc func =
+			Type::get_operation<Operation::DestroyFunc>(
+				Operation::Description::get_destroy_inline(type->identifier) );
+		assert(func != NULL);
+		func(data);
+	}
+	else
 	if(ref_count.unique() && data)
 	{
 		Operation::DestroyFunc func =
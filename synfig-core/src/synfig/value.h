@@ -100,8 +100,11 @@ protected:
 	void *data;
 	//! Counter of Value Nodes that refers to this Value Base
 	//! Value base can only be destructed if the ref_count is not greater than 0
+	//! Not used when the data is inline.
 	//!\see etl::reference_counter
 	etl::reference_counter ref_count;
+	//! Holds the data of types registered with Type::register_inline()
+	union { double align; unsigned char bytes[Operation::INLINE_SIZE]; } inline_data;
 	//! For Values with loop option like TYPE_LIST
 	bool loop_;
 	//! For Values of Constant Value Nodes
@@ -144,6 +147,9 @@ public:
 	//! Copy constructor. The data is not copied, just the type.
 	ValueBase(Type &x);
 
+	//! Copy constructor. Shares the data of \a x, unless it is inline.
+	ValueBase(const ValueBase &x);
+
 	//! Default destructor
 	~ValueBase();
 
@@ -346,6 +352,11 @@ private:
 	void create(Type &type);
 	inline void create() { create(*type); }
 
+	//! True if the data is kept in \c inline_data
+	bool is_inline()const { return data == inline_data.bytes; }
+	//! True if no other ValueBase shares the data
+	bool is_unique()const { return is_inline() || ref_count.unique(); }
+
 	template <typename T>
 	inline static bool _can_get(const TypeId type, const T &)
 	{
@@ -421,7 +432,7 @@ private:
 					Operation::Description::get_set(current_type.identifier) );
 			if (func != NULL)
 			{
-				if (!ref_count.unique()) create(current_type);
+				if (!is_unique()) create(current_type);
 				func(data, x);
 				return;
 			}
@@ -117,6 +117,13 @@ static int value_node_count(0);
 
 static LinkableValueNode::Book *book_;
 
+static bool cache_stats_enabled_(false);
+//! Counted without a lock, render threads evaluate nodes all the time
+static etl::atomic_counter cache_evaluations_(0);
+static etl::atomic_counter cache_saved_(0);
+//! Incremented by ValueNode::clear_caches(), a cached value of an older generation is stale
+static etl::atomic_counter cache_generation_counter_(0);
+
 
 ValueNode::LooseHandle
 synfig::find_value_node(const GUID& guid)
@@ -231,7 +238,94 @@ ValueNode::subsys_stop()
 	return true;
 }
 
-ValueNode::ValueNode(Type &type):type(&type)
+static void
+count_evaluation(bool saved)
+{
+	cache_evaluations_.increment();
+	if (saved) cache_saved_.increment();
+}
+
+void
+ValueNode::set_cache_stats_enabled(bool x)
+	{ cache_stats_enabled_ = x; }
+
+void
+ValueNode::get_cache_stats(long long &evaluations, long long &saved)
+{
+	evaluations = cache_evaluations_.get();
+	saved = cache_saved_.get();
+}
+
+void
+ValueNode::reset_cache_stats()
+{
+	cache_evaluations_.set(0);
+	cache_saved_.set(0);
+}
+
+ValueBase
+ValueNode::operator()(Time t)const
+{
+	if (!is_cacheable())
+		return get_value_vfunc(t);
+
+	int stamp;
+	int generation = cache_generation_counter_.get();
+	{
+		Mutex::Lock lock(cache_mutex_);
+		if (cache_valid_ && cache_generation_ == generation && (double)cache_time_ == (double)t)
+		{
+			if (cache_stats_enabled_) count_evaluation(true);
+			return cache_value_;
+		}
+		stamp = cache_stamp_;
+	}
+
+	// evaluate unlocked: children have their own caches and
+	// several threads may evaluate the same graph at once
+	ValueBase value = get_value_vfunc(t);
+	if (cache_stats_enabled_) count_evaluation(false);
+
+	Mutex::Lock lock(cache_mutex_);
+	if (stamp == cache_stamp_)
+	{
+		cache_valid_ = true;
+		cache_generation_ = generation;
+		cache_time_ = t;
+		cache_value_ = value;
+	}
+	return value;
+}
+
+void
+ValueNode::get_invariance(Time t, Time &begin, Time &end)const
+{
+	if (begin < t) begin = t;
+	if (end > t) end = t;
+}
+
+void
+ValueNode::invalidate_cache()const
+{
+	{
+		Mutex::Lock lock(cache_mutex_);
+		cache_valid_ = false;
+		++cache_stamp_;
+	}
+	for(std::set<Node*>::const_iterator iter = parent_set.begin(); iter != parent_set.end(); ++iter)
+		if (const ValueNode *parent = dynamic_cast<const ValueNode*>(*iter))
+			parent->invalidate_cache();
+}
+
+void
+ValueNode::clear_caches()
+	{ cache_generation_counter_.increment(); }
+
+ValueNode::ValueNode(Type &type):
+	type(&type),
+	cache_valid_(false),
+	cache_stamp_(0),
+	cache_generation_(0)
 {
 	value_node_count++;
 }
@@ -338,6 +432,13 @@ ValueNode::on_changed()
 	if (getenv("SYNFIG_DEBUG_ON_CHANGED"))
 		printf("%s:%d ValueNode::on_changed()\n", __FILE__, __LINE__);
 
+	// the parents are invalidated by Node::on_changed() below
+	{
+		Mutex::Lock lock(cache_mutex_);
+		cache_valid_ = false;
+		++cache_stamp_;
+	}
+
 	etl::loose_handle<Canvas> parent_canvas = get_parent_canvas();
 	if(parent_canvas)
 		do						// signal to all the ancestor canvases
@@ -576,7 +677,7 @@ PlaceholderValueNode::create(Type &type)
 }
 
 ValueBase
-PlaceholderValueNode::operator()(Time /*t*/)const
+PlaceholderValueNode::get_value_vfunc(Time /*t*/)const
 {
 	assert(0);
 	return ValueBase();
@@ -717,6 +818,15 @@ void LinkableValueNode::get_times_vfunc(Node::time_set &set) const
 	}
 }
 
+void
+LinkableValueNode::get_invariance(Time t, Time &begin, Time &end)const
+{
+	int size = link_count();
+	for(int i=0; i < size && begin < end; ++i)
+		if (ValueNode::LooseHandle h = get_link(i))
+			h->get_invariance(t, begin, end);
+}
+
 String
 LinkableValueNode::get_description(int index, bool show_exported_name)const
 {
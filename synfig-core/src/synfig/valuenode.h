@@ -133,6 +133,18 @@ private:
 	//! The root canvas this Value Node belongs to
 	etl::loose_handle<Canvas> root_canvas_;
 
+	//! Guards the evaluation cache below
+	mutable Mutex cache_mutex_;
+	//! True when cache_value_ holds the value at cache_time_
+	mutable bool cache_valid_;
+	//! Incremented on every invalidation, so a value computed
+	//! before an invalidation is never stored afterwards
+	mutable int cache_stamp_;
+	//! Value of the counter of clear_caches() when cache_value_ was stored
+	mutable int cache_generation_;
+	mutable Time cache_time_;
+	mutable ValueBase cache_value_;
+
 	/*
  -- ** -- S I G N A L S -------------------------------------------------------
 	*/
@@ -200,8 +212,31 @@ public:
 public:
 
 	//! Returns the value of the ValueNode at time \a t
-	virtual ValueBase operator()(Time /*t*/)const
-		{ return ValueBase(); }
+	/*!	The last evaluated value is remembered, so a node shared by
+	**	several layers or links is only evaluated once per time.
+	**	The cache is dropped whenever the node or one of its children
+	**	is changed(). Safe to call from several threads at once. */
+	ValueBase operator()(Time t)const;
+
+	//! Forgets the cached value of this node and of every node using it
+	/*!	Only needed by nodes whose value changes without changed()
+	**	being emitted (e.g. the index of ValueNode_Duplicate). */
+	void invalidate_cache()const;
+
+	//! Forgets the cached values of every node
+	static void clear_caches();
+
+	//! Narrows [\a begin, \a end] to an interval around \a t where the value stays the same
+	/*!	The default implementation assumes that the value may change at any time
+	**	and narrows the interval down to \a t itself. */
+	virtual void get_invariance(Time t, Time &begin, Time &end)const;
+
+	//! Enables collecting of the evaluation cache statistics
+	static void set_cache_stats_enabled(bool x);
+	//! Returns the number of evaluations requested and the number of
+	//! them answered from the cache since the last reset_cache_stats()
+	static void get_cache_stats(long long &evaluations, long long &saved);
+	static void reset_cache_stats();
 
 	//! \internal Sets the id of the ValueNode
 	void set_id(const String &x);
@@ -264,6 +299,13 @@ protected:
 	//! Sets the type of the ValueNode
 	void set_type(Type &t) { type=&t; }
 
+	//! Computes the value of the ValueNode at time \a t, called by operator()()
+	virtual ValueBase get_value_vfunc(Time /*t*/)const
+		{ return ValueBase(); }
+
+	//! Returns false for nodes which are cheaper to evaluate than to cache
+	virtual bool is_cacheable()const { return true; }
+
 	virtual void on_changed();
 }; // END of class ValueNode
 
@@ -289,7 +331,7 @@ private:
 
 public:
 
-	virtual ValueBase operator()(Time t)const;
+	virtual ValueBase get_value_vfunc(Time t)const;
 
 	virtual String get_name()const;
 
@@ -424,6 +466,11 @@ public:
 
 	virtual void set_root_canvas(etl::loose_handle<Canvas> x);
 
+	//! Intersects the invariance intervals of all the links
+	/*!	Nodes which use the time by themselves, not only to evaluate
+	**	their links, must override this. */
+	virtual void get_invariance(Time t, Time &begin, Time &end)const;
+
 protected:
 	//! Member to store the children vocabulary
 	Vocab children_vocab;
@@ -132,7 +132,7 @@ synfig::ValueNode_Add::~ValueNode_Add()
 }
 
 synfig::ValueBase
-synfig::ValueNode_Add::operator()(Time t)const
+synfig::ValueNode_Add::get_value_vfunc(Time t)const
 {
 	if (getenv("SYNFIG_DEBUG_VALUENODE_OPERATORS"))
 		printf("%s:%d operator()\n", __FILE__, __LINE__);
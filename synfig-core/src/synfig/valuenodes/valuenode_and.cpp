@@ -106,7 +106,7 @@ ValueNode_And::get_link_vfunc(int i)const
 }
 
 ValueBase
-ValueNode_And::operator()(Time t)const
+ValueNode_And::get_value_vfunc(Time t)const
 {
 	if (getenv("SYNFIG_DEBUG_VALUENODE_OPERATORS"))
 		printf("%s:%d operator()\n", __FILE__, __LINE__);
@@ -47,7 +47,7 @@ public:
 	typedef etl::handle<const ValueNode_And> ConstHandle;
 
 	ValueNode_And(const ValueBase &x);
-	virtual ValueBase operator()(Time t)const;
+	virtual ValueBase get_value_vfunc(Time t)const;
 	virtual ~ValueNode_And();
 	virtual String get_name()const;
 	virtual String get_local_name()const;
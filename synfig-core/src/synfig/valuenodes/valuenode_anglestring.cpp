@@ -88,7 +88,7 @@ ValueNode_AngleString::~ValueNode_AngleString()
 }
 
 ValueBase
-ValueNode_AngleString::operator()(Time t)const
+ValueNode_AngleString::get_value_vfunc(Time t)const
 {
 	if (getenv("SYNFIG_DEBUG_VALUENODE_OPERATORS"))
 		printf("%s:%d operator()\n", __FILE__, __LINE__);
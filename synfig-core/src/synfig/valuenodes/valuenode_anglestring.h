@@ -51,7 +51,7 @@ public:
 	typedef etl::handle<ValueNode_AngleString> Handle;
 	typedef etl::handle<const ValueNode_AngleString> ConstHandle;
 
-	virtual ValueBase operator()(Time t)const;
+	virtual ValueBase get_value_vfunc(Time t)const;
 	virtual ~ValueNode_AngleString();
 	virtual String get_name()const;
 	virtual String get_local_name()const;
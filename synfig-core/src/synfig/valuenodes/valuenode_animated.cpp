@@ -298,6 +298,11 @@ private:
 		mutable hermite<value_type,Time> second;
 		WaypointList::iterator start;
 		WaypointList::iterator end;
+		//! True when both waypoints have no temporal tension,
+		//! \a first is the identity then and need not be evaluated
+		bool linear_time;
+
+		PathSegment(): linear_time(false) { }
 
 		value_type resolve(const Time &t)const
 		{
@@ -321,8 +326,12 @@ private:
 				second.sync();
 			}
 
-			return second(first(t));
+			return second(linear_time ? t : first(t));
 		}
+
+		//! Ordering for the binary search, matches the linear scan it replaces
+		static bool time_before_end(const Time &t, const PathSegment &x)
+			{ return !(t >= x.first.get_s()); }
 	}; // END of struct PathSegment
 	typedef vector<PathSegment> curve_list_type;
 
@@ -331,6 +340,32 @@ private:
 	// Bounds of this curve
 	Time r,s;
 
+	//! Index of the segment found by the previous lookup. Time usually
+	//! goes forward by a frame, so that segment or the next one is tried
+	//! before the binary search. A stale value only costs the search.
+	//! Threads rendering the same node at once overwrite each other's
+	//! hint, so it is read and written as a single relaxed atomic.
+	mutable etl::atomic_counter segment_hint;
+
+	//! Returns the segment containing \a t, or curve_list.end()
+	typename curve_list_type::const_iterator find_segment(const Time &t)const
+	{
+		size_t size = curve_list.size();
+		size_t hint = segment_hint.get();
+		for(size_t i = hint; i < size && i <= hint + 1; ++i)
+			if ( PathSegment::time_before_end(t, curve_list[i])
+			 && (i == 0 || !PathSegment::time_before_end(t, curve_list[i-1])) )
+			{
+				segment_hint.set(i);
+				return curve_list.begin() + i;
+			}
+
+		typename curve_list_type::const_iterator iter =
+			std::upper_bound(curve_list.begin(), curve_list.end(), t, &PathSegment::time_before_end);
+		segment_hint.set(iter - curve_list.begin());
+		return iter;
+	}
+
 public:
 	ValueNode::Handle clone(Canvas::LooseHandle canvas, const synfig::GUID& deriv_guid)const
 	{
@@ -343,7 +378,7 @@ public:
 		return ret;
 	}
 
-	_Hermite()
+	_Hermite(): segment_hint(0)
 	{
 		set_type(ValueBase(value_type()).get_type());
 	}
@@ -414,6 +449,7 @@ public:
 		s=waypoint_list_.back().get_time();
 
 		curve_list.clear();
+		segment_hint.set(0);
 
 		WaypointList::iterator prev,iter,next=waypoint_list_.begin();
 		int i=0;
@@ -640,6 +676,7 @@ public:
 			curve.first.p2()=next->get_time();
 			curve.first.t1()=(curve.first.p2()-curve.first.p1())*(1.0f-iter->get_temporal_tension());
 			curve.first.t2()=(curve.first.p2()-curve.first.p1())*(1.0f-next->get_temporal_tension());
+			curve.linear_time=iter->get_temporal_tension()==0 && next->get_temporal_tension()==0;
 
 
 			curve.first.sync();
@@ -649,7 +686,7 @@ public:
 		}
 	}
 
-	virtual ValueBase operator()(Time t)const
+	virtual ValueBase get_value_vfunc(Time t)const
 	{
 		if(waypoint_list_.empty())
 			return value_type();	//! \todo Perhaps we should throw something here?
@@ -660,12 +697,7 @@ public:
 		if(t>=s)
 			return waypoint_list_.back().get_value(t);
 
-		typename curve_list_type::const_iterator iter;
-
-		// This next line will set iter to the
-		// correct iterator for the given time.
-		for(iter=curve_list.begin();iter<curve_list.end() && t>=iter->first.get_s();++iter)
-			continue;
+		typename curve_list_type::const_iterator iter(find_segment(t));
 		if(iter==curve_list.end())
 			return waypoint_list_.back().get_value(t);
 		return iter->resolve(t);
@@ -753,7 +785,7 @@ public:
 
 	}
 
-	virtual ValueBase operator()(Time t)const
+	virtual ValueBase get_value_vfunc(Time t)const
 	{
 		if(waypoint_list_.size()==1)
 			return waypoint_list_.front().get_value(t);
@@ -856,7 +888,7 @@ public:
 
 	}
 
-	virtual ValueBase operator()(Time t)const
+	virtual ValueBase get_value_vfunc(Time t)const
 	{
 		if(waypoint_list_.size()==1)
 			return waypoint_list_.front().get_value(t);
@@ -1203,6 +1235,37 @@ ValueNode_Animated::get_local_name()const
 	return _("Animated");
 }
 
+void
+ValueNode_Animated::get_invariance(Time t, Time &begin, Time &end)const
+{
+	if (waypoint_list().empty()) return;
+
+	WaypointList::const_iterator first = waypoint_list().begin(), last = first;
+	for(WaypointList::const_iterator i = first; i != waypoint_list().end(); ++i)
+	{
+		if (i->get_time() < first->get_time()) first = i;
+		if (i->get_time() > last->get_time()) last = i;
+	}
+
+	// a single waypoint holds its value at any time
+	if (first == last)
+		first->get_value_node()->get_invariance(t, begin, end);
+	else
+	if (t <= first->get_time())
+	{
+		if (end > first->get_time()) end = first->get_time();
+		first->get_value_node()->get_invariance(t, begin, end);
+	}
+	else
+	if (t >= last->get_time())
+	{
+		if (begin < last->get_time()) begin = last->get_time();
+		last->get_value_node()->get_invariance(t, begin, end);
+	}
+	else
+		ValueNode::get_invariance(t, begin, end);
+}
+
 void ValueNode_Animated::get_times_vfunc(Node::time_set &set) const
 {
 	//add all the way point times to the value node...
@@ -147,6 +147,9 @@ public:
 	virtual Interpolation get_interpolation()const { return interpolation_; }
 	virtual void set_interpolation(Interpolation i) { interpolation_=i; }
 
+	//! The value is known to hold only before the first and after the last waypoint
+	virtual void get_invariance(Time t, Time &begin, Time &end)const;
+
 	
 
 protected:
@@ -81,11 +81,11 @@ ValueNode_Average::create(const ValueBase &value, Canvas::LooseHandle canvas)
 	{ return new ValueNode_Average(value, canvas); }
 
 ValueBase
-ValueNode_Average::operator()(Time t)const
+ValueNode_Average::get_value_vfunc(Time t)const
 {
 	if (getenv("SYNFIG_DEBUG_VALUENODE_OPERATORS"))
 		printf("%s:%d operator()\n", __FILE__, __LINE__);
-	return ValueAverage::average( ValueNode_DynamicList::operator()(t), ValueBase(), ValueBase(get_type()));
+	return ValueAverage::average( ValueNode_DynamicList::get_value_vfunc(t), ValueBase(), ValueBase(get_type()));
 }
 
 String
@@ -627,7 +627,7 @@ ValueNode_BLine::create_list_entry(int index, Time time, Real origin)
 
 
 ValueBase
-ValueNode_BLine::operator()(Time t)const
+ValueNode_BLine::get_value_vfunc(Time t)const
 {
 	if (getenv("SYNFIG_DEBUG_VALUENODE_OPERATORS"))
 		printf("%s:%d operator()\n", __FILE__, __LINE__);
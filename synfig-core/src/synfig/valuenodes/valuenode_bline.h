@@ -79,7 +79,7 @@ public:
 
 public:
 
- 	virtual ValueBase operator()(Time t)const;
+ 	virtual ValueBase get_value_vfunc(Time t)const;
 
 	virtual ~ValueNode_BLine();
 
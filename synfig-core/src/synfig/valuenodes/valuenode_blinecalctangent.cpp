@@ -168,7 +168,7 @@ ValueNode_BLineCalcTangent::operator()(Time t, Real amount)const
 }
 
 ValueBase
-ValueNode_BLineCalcTangent::operator()(Time t)const
+ValueNode_BLineCalcTangent::get_value_vfunc(Time t)const
 {
 	Real amount((*amount_)(t).get(Real()));
 	return (*this)(t, amount);
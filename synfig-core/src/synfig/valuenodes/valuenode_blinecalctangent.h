@@ -54,8 +54,9 @@ public:
 	typedef etl::handle<ValueNode_BLineCalcTangent> Handle;
 	typedef etl::handle<const ValueNode_BLineCalcTangent> ConstHandle;
 
+	using ValueNode::operator();
 	virtual ValueBase operator()(Time t, Real amount)const;
-	virtual ValueBase operator()(Time t)const;
+	virtual ValueBase get_value_vfunc(Time t)const;
 
 	virtual ~ValueNode_BLineCalcTangent();
 
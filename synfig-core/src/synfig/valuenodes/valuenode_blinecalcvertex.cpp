@@ -89,7 +89,7 @@ ValueNode_BLineCalcVertex::~ValueNode_BLineCalcVertex()
 }
 
 ValueBase
-ValueNode_BLineCalcVertex::operator()(Time t)const
+ValueNode_BLineCalcVertex::get_value_vfunc(Time t)const
 {
 	if (getenv("SYNFIG_DEBUG_VALUENODE_OPERATORS"))
 		printf("%s:%d operator()\n", __FILE__, __LINE__);
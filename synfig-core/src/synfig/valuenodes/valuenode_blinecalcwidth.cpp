@@ -137,7 +137,7 @@ ValueNode_BLineCalcWidth::operator()(Time t, Real amount)const
 }
 
 ValueBase
-ValueNode_BLineCalcWidth::operator()(Time t)const
+ValueNode_BLineCalcWidth::get_value_vfunc(Time t)const
 {
 	Real amount((*amount_)(t).get(Real()));
 	return (*this)(t, amount);
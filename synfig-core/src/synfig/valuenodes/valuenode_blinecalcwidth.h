@@ -52,8 +52,9 @@ public:
 	typedef etl::handle<ValueNode_BLineCalcWidth> Handle;
 	typedef etl::handle<const ValueNode_BLineCalcWidth> ConstHandle;
 
+	using ValueNode::operator();
 	virtual ValueBase operator()(Time t, Real amount)const;
-	virtual ValueBase operator()(Time t)const;
+	virtual ValueBase get_value_vfunc(Time t)const;
 
 	virtual ~ValueNode_BLineCalcWidth();
 
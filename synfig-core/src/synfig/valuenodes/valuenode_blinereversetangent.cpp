@@ -91,7 +91,7 @@ ValueNode_BLineRevTangent::~ValueNode_BLineRevTangent()
 }
 
 ValueBase
-ValueNode_BLineRevTangent::operator()(Time t)const
+ValueNode_BLineRevTangent::get_value_vfunc(Time t)const
 {
 	if (getenv("SYNFIG_DEBUG_VALUENODE_OPERATORS"))
 		printf("%s:%d operator()\n", __FILE__, __LINE__);
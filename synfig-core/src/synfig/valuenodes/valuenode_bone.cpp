@@ -419,7 +419,7 @@ ValueNode_Bone::get_parent(Time t)const
 }
 
 ValueBase
-ValueNode_Bone::operator()(Time t)const
+ValueNode_Bone::get_value_vfunc(Time t)const
 {
 	if (getenv("SYNFIG_DEBUG_VALUENODE_OPERATORS"))
 		printf("%s:%d operator()\n", __FILE__, __LINE__);
@@ -1001,7 +1001,7 @@ ValueNode_Bone_Root::~ValueNode_Bone_Root()
 }
 
 ValueBase
-ValueNode_Bone_Root::operator()(Time t __attribute__ ((unused)))const
+ValueNode_Bone_Root::get_value_vfunc(Time t __attribute__ ((unused)))const
 {
 	Bone ret;
 	ret.set_name			(get_local_name());
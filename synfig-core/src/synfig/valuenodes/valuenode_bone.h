@@ -63,7 +63,7 @@ public:
 	typedef std::set<LooseHandle> BoneSet;
 	typedef std::list<LooseHandle> BoneList;
 
-	virtual ValueBase operator()(Time t)const;
+	virtual ValueBase get_value_vfunc(Time t)const;
 
 	virtual ValueNode::Handle clone(etl::loose_handle<Canvas> canvas, const GUID& deriv_guid=GUID())const;
 
@@ -139,7 +139,7 @@ public:
 	ValueNode_Bone_Root();
 	virtual ~ValueNode_Bone_Root();
 
-	virtual ValueBase operator()(Time t)const;
+	virtual ValueBase get_value_vfunc(Time t)const;
 
 	virtual String get_name()const;
 	virtual String get_local_name()const;
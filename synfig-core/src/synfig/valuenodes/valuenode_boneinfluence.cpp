@@ -108,7 +108,7 @@ ValueNode_BoneInfluence::~ValueNode_BoneInfluence()
 }
 
 ValueBase
-ValueNode_BoneInfluence::operator()(Time t)const
+ValueNode_BoneInfluence::get_value_vfunc(Time t)const
 {
 	if (getenv("SYNFIG_DEBUG_VALUENODE_OPERATORS"))
 		printf("%s:%d operator()\n", __FILE__, __LINE__);
@@ -170,7 +170,7 @@ ValueNode_BoneLink::get_bone_transformation(Time t)const
 }
 
 ValueBase
-ValueNode_BoneLink::operator()(Time t)const
+ValueNode_BoneLink::get_value_vfunc(Time t)const
 {
 	if (getenv("SYNFIG_DEBUG_VALUENODE_OPERATORS"))
 		printf("%s:%d operator()\n", __FILE__, __LINE__);
@@ -52,7 +52,7 @@ public:
 	ValueNode_BoneLink(const ValueBase &x);
 
 	Transformation get_bone_transformation(Time t)const;
-	virtual ValueBase operator()(Time t)const;
+	virtual ValueBase get_value_vfunc(Time t)const;
 
 	virtual ~ValueNode_BoneLink();
 
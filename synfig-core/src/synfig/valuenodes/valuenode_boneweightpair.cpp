@@ -96,7 +96,7 @@ ValueNode_BoneWeightPair::~ValueNode_BoneWeightPair()
 }
 
 ValueBase
-ValueNode_BoneWeightPair::operator()(Time t)const
+ValueNode_BoneWeightPair::get_value_vfunc(Time t)const
 {
 	if (getenv("SYNFIG_DEBUG_VALUENODE_OPERATORS"))
 		printf("%s:%d operator()\n", __FILE__, __LINE__);
@@ -50,7 +50,7 @@ public:
 	typedef etl::handle<const ValueNode_BoneWeightPair> ConstHandle;
 
 
-	virtual ValueBase operator()(Time t)const;
+	virtual ValueBase get_value_vfunc(Time t)const;
 
 	virtual ~ValueNode_BoneWeightPair();
 
@@ -116,7 +116,7 @@ ValueNode_Compare::get_link_vfunc(int i)const
 }
 
 ValueBase
-ValueNode_Compare::operator()(Time t)const
+ValueNode_Compare::get_value_vfunc(Time t)const
 {
 	if (getenv("SYNFIG_DEBUG_VALUENODE_OPERATORS"))
 		printf("%s:%d operator()\n", __FILE__, __LINE__);
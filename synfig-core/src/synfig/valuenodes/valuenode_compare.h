@@ -52,7 +52,7 @@ public:
 
 	ValueNode_Compare(const ValueBase &x);
 
-	virtual ValueBase operator()(Time t)const;
+	virtual ValueBase get_value_vfunc(Time t)const;
 
 	virtual ~ValueNode_Compare();
 
@@ -52,7 +52,7 @@ public:
 
 	virtual ValueNode::LooseHandle get_link_vfunc(int i)const;
 	virtual String link_name(int i)const;
-	virtual ValueBase operator()(Time t)const;
+	virtual ValueBase get_value_vfunc(Time t)const;
 	virtual String get_name()const;
 	virtual String get_local_name()const;
 	virtual int get_link_index_from_name(const String &name)const;
@@ -119,7 +119,7 @@ ValueNode_Const::~ValueNode_Const()
 
 
 ValueBase
-ValueNode_Const::operator()(Time /*t*/)const
+ValueNode_Const::get_value_vfunc(Time /*t*/)const
 {
 	if (getenv("SYNFIG_DEBUG_VALUENODE_OPERATORS"))
 		printf("%s:%d operator()\n", __FILE__, __LINE__);
@@ -49,7 +49,9 @@ private:
 
 public:
 
-	virtual ValueBase operator()(Time t)const;
+	virtual ValueBase get_value_vfunc(Time t)const;
+	//! Constant values never change, the interval is left untouched
+	virtual void get_invariance(Time /*t*/, Time &/*begin*/, Time &/*end*/)const { }
 	virtual ~ValueNode_Const();
 
 	const ValueBase &get_value()const;
@@ -74,6 +76,7 @@ public:
 
 protected:
 	virtual void get_times_vfunc(Node::time_set &set) const;
+	virtual bool is_cacheable()const { return false; }
 };
 
 }; // END of namespace synfig
@@ -85,7 +85,7 @@ ValueNode_Cos::~ValueNode_Cos()
 }
 
 ValueBase
-ValueNode_Cos::operator()(Time t)const
+ValueNode_Cos::get_value_vfunc(Time t)const
 {
 	if (getenv("SYNFIG_DEBUG_VALUENODE_OPERATORS"))
 		printf("%s:%d operator()\n", __FILE__, __LINE__);
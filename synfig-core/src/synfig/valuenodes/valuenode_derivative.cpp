@@ -183,7 +183,7 @@ ValueNode_Derivative::~ValueNode_Derivative()
 }
 
 ValueBase
-ValueNode_Derivative::operator()(Time t)const
+ValueNode_Derivative::get_value_vfunc(Time t)const
 {
 	if (getenv("SYNFIG_DEBUG_VALUENODE_OPERATORS"))
 		printf("%s:%d operator()\n", __FILE__, __LINE__);
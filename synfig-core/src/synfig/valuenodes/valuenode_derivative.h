@@ -67,7 +67,10 @@ public:
 	typedef etl::handle<ValueNode_Derivative> Handle;
 	typedef etl::handle<const ValueNode_Derivative> ConstHandle;
 
-	virtual ValueBase operator()(Time t)const;
+	virtual ValueBase get_value_vfunc(Time t)const;
+	//! The value depends on the time directly, not only through the links
+	virtual void get_invariance(Time t, Time &begin, Time &end)const
+		{ ValueNode::get_invariance(t, begin, end); }
 
 	virtual ~ValueNode_Derivative();
 
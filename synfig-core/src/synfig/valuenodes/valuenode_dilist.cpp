@@ -122,7 +122,7 @@ ValueNode_DIList::create_list_entry(int index, Time time, Real /*origin*/)
 }
 
 ValueBase
-ValueNode_DIList::operator()(Time t)const
+ValueNode_DIList::get_value_vfunc(Time t)const
 {
 	if (getenv("SYNFIG_DEBUG_VALUENODE_OPERATORS"))
 		printf("%s:%d operator()\n", __FILE__, __LINE__);
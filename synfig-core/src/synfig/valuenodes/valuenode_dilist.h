@@ -62,7 +62,7 @@ public:
 
 public:
 
- 	virtual ValueBase operator()(Time t)const;
+ 	virtual ValueBase get_value_vfunc(Time t)const;
 	virtual ~ValueNode_DIList();
 	virtual String link_local_name(int i)const;
 	virtual String get_name()const;
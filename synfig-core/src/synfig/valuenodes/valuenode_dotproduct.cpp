@@ -90,7 +90,7 @@ ValueNode_DotProduct::~ValueNode_DotProduct()
 }
 
 ValueBase
-ValueNode_DotProduct::operator()(Time t)const
+ValueNode_DotProduct::get_value_vfunc(Time t)const
 {
 	if (getenv("SYNFIG_DEBUG_VALUENODE_OPERATORS"))
 		printf("%s:%d operator()\n", __FILE__, __LINE__);
@@ -116,6 +116,7 @@ ValueNode_Duplicate::reset_index(Time t)const
 {
 	Real from = (*from_)(t).get(Real());
 	index = from;
+	invalidate_cache();
 }
 
 bool
@@ -130,6 +131,9 @@ ValueNode_Duplicate::step(Time t)const
 
 	step = abs(step);
 
+	// nodes depending on the index must not reuse their cached values
+	invalidate_cache();
+
 	if (from < to)
 	{
 		if ((index += step) <= to) return true;
@@ -155,7 +159,7 @@ ValueNode_Duplicate::count_steps(Time t)const
 }
 
 ValueBase
-ValueNode_Duplicate::operator()(Time t __attribute__ ((unused)))const
+ValueNode_Duplicate::get_value_vfunc(Time t __attribute__ ((unused)))const
 {
 	if (getenv("SYNFIG_DEBUG_VALUENODE_OPERATORS"))
 		printf("%s:%d operator()\n", __FILE__, __LINE__);
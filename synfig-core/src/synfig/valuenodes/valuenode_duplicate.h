@@ -51,7 +51,10 @@ public:
 	ValueNode_Duplicate(Type &x);
 	ValueNode_Duplicate(const ValueBase &x);
 
-	virtual ValueBase operator()(Time t)const;
+	virtual ValueBase get_value_vfunc(Time t)const;
+	//! The value depends on the time directly, not only through the links
+	virtual void get_invariance(Time t, Time &begin, Time &end)const
+		{ ValueNode::get_invariance(t, begin, end); }
 	void reset_index(Time t)const;
 	bool step(Time t)const;
 	int count_steps(Time t)const;
@@ -66,6 +69,8 @@ public:
 protected:
 	LinkableValueNode* create_new()const;
 	virtual bool set_link_vfunc(int i,ValueNode::Handle x);
+	//! The index changes without changed(), see step()
+	virtual bool is_cacheable()const { return false; }
 
 public:
 	using synfig::LinkableValueNode::get_link_vfunc;
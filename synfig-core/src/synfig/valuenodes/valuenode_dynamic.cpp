@@ -114,7 +114,7 @@ ValueNode_Dynamic::~ValueNode_Dynamic()
 }
 
 ValueBase
-ValueNode_Dynamic::operator()(Time t)const
+ValueNode_Dynamic::get_value_vfunc(Time t)const
 {
 	if (getenv("SYNFIG_DEBUG_VALUENODE_OPERATORS"))
 		printf("%s:%d operator()\n", __FILE__, __LINE__);
@@ -645,8 +645,18 @@ ValueNode_DynamicList::create_from(const ValueBase &value)
 	return value_node;
 }
 
+void
+ValueNode_DynamicList::get_invariance(Time t, Time &begin, Time &end)const
+{
+	// entries switched on and off by activepoints make the list change in time
+	for(std::vector<ListEntry>::const_iterator iter = list.begin(); iter != list.end(); ++iter)
+		if (!iter->timing_info.empty())
+			{ ValueNode::get_invariance(t, begin, end); return; }
+	LinkableValueNode::get_invariance(t, begin, end);
+}
+
 ValueBase
-ValueNode_DynamicList::operator()(Time t)const
+ValueNode_DynamicList::get_value_vfunc(Time t)const
 {
 	if (getenv("SYNFIG_DEBUG_VALUENODE_OPERATORS"))
 		printf("%s:%d operator()\n", __FILE__, __LINE__);
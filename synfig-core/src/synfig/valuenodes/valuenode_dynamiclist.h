@@ -189,7 +189,9 @@ public:
 
 	virtual String link_name(int i)const;
 
- 	virtual ValueBase operator()(Time t)const;
+ 	virtual ValueBase get_value_vfunc(Time t)const;
+
+	virtual void get_invariance(Time t, Time &begin, Time &end)const;
 
 	virtual ~ValueNode_DynamicList();
 
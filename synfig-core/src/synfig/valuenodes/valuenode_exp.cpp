@@ -85,7 +85,7 @@ ValueNode_Exp::~ValueNode_Exp()
 }
 
 ValueBase
-ValueNode_Exp::operator()(Time t)const
+ValueNode_Exp::get_value_vfunc(Time t)const
 {
 	if (getenv("SYNFIG_DEBUG_VALUENODE_OPERATORS"))
 		printf("%s:%d operator()\n", __FILE__, __LINE__);
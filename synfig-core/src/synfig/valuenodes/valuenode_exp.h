@@ -49,7 +49,7 @@ public:
 	typedef etl::handle<const ValueNode_Exp> ConstHandle;
 
 
-	virtual ValueBase operator()(Time t)const;
+	virtual ValueBase get_value_vfunc(Time t)const;
 
 	virtual ~ValueNode_Exp();
 
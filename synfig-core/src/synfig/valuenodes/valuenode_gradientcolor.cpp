@@ -87,7 +87,7 @@ ValueNode_GradientColor::~ValueNode_GradientColor()
 }
 
 ValueBase
-ValueNode_GradientColor::operator()(Time t)const
+ValueNode_GradientColor::get_value_vfunc(Time t)const
 {
 	if (getenv("SYNFIG_DEBUG_VALUENODE_OPERATORS"))
 		printf("%s:%d operator()\n", __FILE__, __LINE__);
@@ -122,7 +122,7 @@ ValueNode_Integer::get_link_vfunc(int i)const
 }
 
 ValueBase
-ValueNode_Integer::operator()(Time t)const
+ValueNode_Integer::get_value_vfunc(Time t)const
 {
 	if (getenv("SYNFIG_DEBUG_VALUENODE_OPERATORS"))
 		printf("%s:%d operator()\n", __FILE__, __LINE__);
@@ -48,7 +48,7 @@ public:
 	ValueNode_Integer(Type &x);
 	ValueNode_Integer(const ValueBase &x);
 
-	virtual ValueBase operator()(Time t)const;
+	virtual ValueBase get_value_vfunc(Time t)const;
 
 	virtual ~ValueNode_Integer();
 
@@ -51,7 +51,7 @@ public:
 	typedef etl::handle<const ValueNode_IntString> ConstHandle;
 
 
-	virtual ValueBase operator()(Time t)const;
+	virtual ValueBase get_value_vfunc(Time t)const;
 
 	virtual ~ValueNode_IntString();
 
@@ -95,7 +95,7 @@ ValueNode_Join::~ValueNode_Join()
 }
 
 ValueBase
-ValueNode_Join::operator()(Time t)const
+ValueNode_Join::get_value_vfunc(Time t)const
 {
 	if (getenv("SYNFIG_DEBUG_VALUENODE_OPERATORS"))
 		printf("%s:%d operator()\n", __FILE__, __LINE__);
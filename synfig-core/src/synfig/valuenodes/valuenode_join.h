@@ -52,7 +52,7 @@ public:
 	typedef etl::handle<const ValueNode_Join> ConstHandle;
 
 
-	virtual ValueBase operator()(Time t)const;
+	virtual ValueBase get_value_vfunc(Time t)const;
 
 	virtual ~ValueNode_Join();
 
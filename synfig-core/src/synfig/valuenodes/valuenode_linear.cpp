@@ -118,7 +118,7 @@ ValueNode_Linear::~ValueNode_Linear()
 }
 
 ValueBase
-ValueNode_Linear::operator()(Time t)const
+ValueNode_Linear::get_value_vfunc(Time t)const
 {
 	if (getenv("SYNFIG_DEBUG_VALUENODE_OPERATORS"))
 		printf("%s:%d operator()\n", __FILE__, __LINE__);
@@ -111,7 +111,7 @@ ValueNode_Logarithm::get_link_vfunc(int i)const
 }
 
 ValueBase
-ValueNode_Logarithm::operator()(Time t)const
+ValueNode_Logarithm::get_value_vfunc(Time t)const
 {
 	if (getenv("SYNFIG_DEBUG_VALUENODE_OPERATORS"))
 		printf("%s:%d operator()\n", __FILE__, __LINE__);
@@ -101,7 +101,7 @@ ValueNode_Not::get_link_vfunc(int i)const
 }
 
 ValueBase
-ValueNode_Not::operator()(Time t)const
+ValueNode_Not::get_value_vfunc(Time t)const
 {
 	if (getenv("SYNFIG_DEBUG_VALUENODE_OPERATORS"))
 		printf("%s:%d operator()\n", __FILE__, __LINE__);
@@ -47,7 +47,7 @@ public:
 
 	ValueNode_Not(const ValueBase &x);
 
-	virtual ValueBase operator()(Time t)const;
+	virtual ValueBase get_value_vfunc(Time t)const;
 
 	virtual ~ValueNode_Not();
 
@@ -112,7 +112,7 @@ ValueNode_Pow::get_link_vfunc(int i)const
 }
 
 ValueBase
-ValueNode_Pow::operator()(Time t)const
+ValueNode_Pow::get_value_vfunc(Time t)const
 {
 	if (getenv("SYNFIG_DEBUG_VALUENODE_OPERATORS"))
 		printf("%s:%d operator()\n", __FILE__, __LINE__);
@@ -51,7 +51,7 @@ public:
 
 	ValueNode_Pow(const ValueBase &x);
 
-	virtual ValueBase operator()(Time t)const;
+	virtual ValueBase get_value_vfunc(Time t)const;
 
 	virtual ~ValueNode_Pow();
 
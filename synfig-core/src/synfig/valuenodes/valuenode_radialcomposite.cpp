@@ -98,7 +98,7 @@ ValueNode_RadialComposite::create_new()const
 }
 
 ValueBase
-synfig::ValueNode_RadialComposite::operator()(Time t)const
+synfig::ValueNode_RadialComposite::get_value_vfunc(Time t)const
 {
 	if (getenv("SYNFIG_DEBUG_VALUENODE_OPERATORS"))
 		printf("%s:%d operator()\n", __FILE__, __LINE__);
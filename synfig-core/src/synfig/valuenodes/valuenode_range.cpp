@@ -119,7 +119,7 @@ synfig::ValueNode_Range::~ValueNode_Range()
 }
 
 synfig::ValueBase
-synfig::ValueNode_Range::operator()(Time t)const
+synfig::ValueNode_Range::get_value_vfunc(Time t)const
 {
 	if (getenv("SYNFIG_DEBUG_VALUENODE_OPERATORS"))
 		printf("%s:%d operator()\n", __FILE__, __LINE__);
@@ -119,7 +119,7 @@ ValueNode_Real::get_link_vfunc(int i)const
 }
 
 ValueBase
-ValueNode_Real::operator()(Time t)const
+ValueNode_Real::get_value_vfunc(Time t)const
 {
 	if (getenv("SYNFIG_DEBUG_VALUENODE_OPERATORS"))
 		printf("%s:%d operator()\n", __FILE__, __LINE__);
@@ -88,7 +88,7 @@ ValueNode_RealString::~ValueNode_RealString()
 }
 
 ValueBase
-ValueNode_RealString::operator()(Time t)const
+ValueNode_RealString::get_value_vfunc(Time t)const
 {
 	if (getenv("SYNFIG_DEBUG_VALUENODE_OPERATORS"))
 		printf("%s:%d operator()\n", __FILE__, __LINE__);
@@ -114,7 +114,7 @@ ValueNode_Reciprocal::get_link_vfunc(int i)const
 }
 
 ValueBase
-ValueNode_Reciprocal::operator()(Time t)const
+ValueNode_Reciprocal::get_value_vfunc(Time t)const
 {
 	if (getenv("SYNFIG_DEBUG_VALUENODE_OPERATORS"))
 		printf("%s:%d operator()\n", __FILE__, __LINE__);
@@ -49,7 +49,7 @@ public:
 
 	ValueNode_Reciprocal(const ValueBase &x);
 
-	virtual ValueBase operator()(Time t)const;
+	virtual ValueBase get_value_vfunc(Time t)const;
 
 	virtual ~ValueNode_Reciprocal();
 
@@ -102,7 +102,7 @@ ValueNode_Reference::get_link_vfunc(int i __attribute__ ((unused)))const
 }
 
 ValueBase
-ValueNode_Reference::operator()(Time t)const
+ValueNode_Reference::get_value_vfunc(Time t)const
 {
 	if (getenv("SYNFIG_DEBUG_VALUENODE_OPERATORS"))
 		printf("%s:%d operator()\n", __FILE__, __LINE__);
@@ -97,7 +97,7 @@ synfig::ValueNode_Repeat_Gradient::~ValueNode_Repeat_Gradient()
 }
 
 synfig::ValueBase
-synfig::ValueNode_Repeat_Gradient::operator()(Time t)const
+synfig::ValueNode_Repeat_Gradient::get_value_vfunc(Time t)const
 {
 	if (getenv("SYNFIG_DEBUG_VALUENODE_OPERATORS"))
 		printf("%s:%d operator()\n", __FILE__, __LINE__);
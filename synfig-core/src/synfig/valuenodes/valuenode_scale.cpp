@@ -111,7 +111,7 @@ synfig::ValueNode_Scale::~ValueNode_Scale()
 }
 
 synfig::ValueBase
-synfig::ValueNode_Scale::operator()(Time t)const
+synfig::ValueNode_Scale::get_value_vfunc(Time t)const
 {
 	if (getenv("SYNFIG_DEBUG_VALUENODE_OPERATORS"))
 		printf("%s:%d operator()\n", __FILE__, __LINE__);
@@ -58,7 +58,7 @@ public:
 
 	virtual ValueNode::LooseHandle get_link_vfunc(int i)const;
 
-	virtual ValueBase operator()(Time t)const;
+	virtual ValueBase get_value_vfunc(Time t)const;
 
 	//! Returns the modified Link to match the target value at time t
 	ValueBase get_inverse(Time t, const synfig::Vector &target_value) const;
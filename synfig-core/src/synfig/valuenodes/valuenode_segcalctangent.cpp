@@ -80,7 +80,7 @@ ValueNode_SegCalcTangent::~ValueNode_SegCalcTangent()
 }
 
 ValueBase
-ValueNode_SegCalcTangent::operator()(Time t)const
+ValueNode_SegCalcTangent::get_value_vfunc(Time t)const
 {
 	if (getenv("SYNFIG_DEBUG_VALUENODE_OPERATORS"))
 		printf("%s:%d operator()\n", __FILE__, __LINE__);
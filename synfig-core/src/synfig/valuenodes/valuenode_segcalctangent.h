@@ -51,7 +51,7 @@ public:
 	//static Handle create(Type &x=type_vector);
 
 
-	virtual ValueBase operator()(Time t)const;
+	virtual ValueBase get_value_vfunc(Time t)const;
 
 	virtual ~ValueNode_SegCalcTangent();
 
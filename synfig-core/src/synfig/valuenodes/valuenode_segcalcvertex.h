@@ -48,7 +48,7 @@ public:
 	typedef etl::handle<ValueNode_SegCalcVertex> Handle;
 	typedef etl::handle<const ValueNode_SegCalcVertex> ConstHandle;
 
-	virtual ValueBase operator()(Time t)const;
+	virtual ValueBase get_value_vfunc(Time t)const;
 
 	virtual ~ValueNode_SegCalcVertex();
 
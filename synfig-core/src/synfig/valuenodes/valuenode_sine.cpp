@@ -85,7 +85,7 @@ ValueNode_Sine::~ValueNode_Sine()
 }
 
 ValueBase
-ValueNode_Sine::operator()(Time t)const
+ValueNode_Sine::get_value_vfunc(Time t)const
 {
 	if (getenv("SYNFIG_DEBUG_VALUENODE_OPERATORS"))
 		printf("%s:%d operator()\n", __FILE__, __LINE__);
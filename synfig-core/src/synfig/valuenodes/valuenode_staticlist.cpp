@@ -334,7 +334,7 @@ ValueNode_StaticList::create_from(const ValueBase &value) // line 568
 }
 
 ValueBase
-ValueNode_StaticList::operator()(Time t)const // line 596
+ValueNode_StaticList::get_value_vfunc(Time t)const // line 596
 {
 	if (getenv("SYNFIG_DEBUG_VALUENODE_OPERATORS"))
 		printf("%s:%d operator()\n", __FILE__, __LINE__);
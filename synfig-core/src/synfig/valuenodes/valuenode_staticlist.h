@@ -79,7 +79,7 @@ public:
 
 	virtual String link_name(int i)const;
 
-	virtual ValueBase operator()(Time t)const;
+	virtual ValueBase get_value_vfunc(Time t)const;
 
 	virtual String link_local_name(int i)const;
 	virtual int get_link_index_from_name(const String &name)const;
@@ -101,7 +101,7 @@ ValueNode_Step::~ValueNode_Step()
 }
 
 ValueBase
-ValueNode_Step::operator()(Time t)const
+ValueNode_Step::get_value_vfunc(Time t)const
 {
 	if (getenv("SYNFIG_DEBUG_VALUENODE_OPERATORS"))
 		printf("%s:%d operator()\n", __FILE__, __LINE__);
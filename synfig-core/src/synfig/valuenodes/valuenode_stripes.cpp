@@ -94,7 +94,7 @@ synfig::ValueNode_Stripes::~ValueNode_Stripes()
 }
 
 synfig::ValueBase
-synfig::ValueNode_Stripes::operator()(Time t)const
+synfig::ValueNode_Stripes::get_value_vfunc(Time t)const
 {
 	if (getenv("SYNFIG_DEBUG_VALUENODE_OPERATORS"))
 		printf("%s:%d operator()\n", __FILE__, __LINE__);
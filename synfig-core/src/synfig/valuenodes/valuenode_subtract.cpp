@@ -136,7 +136,7 @@ synfig::ValueNode_Subtract::~ValueNode_Subtract()
 }
 
 synfig::ValueBase
-synfig::ValueNode_Subtract::operator()(Time t)const
+synfig::ValueNode_Subtract::get_value_vfunc(Time t)const
 {
 	if (getenv("SYNFIG_DEBUG_VALUENODE_OPERATORS"))
 		printf("%s:%d operator()\n", __FILE__, __LINE__);
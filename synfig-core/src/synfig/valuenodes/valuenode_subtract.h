@@ -54,7 +54,7 @@ public:
 	LinkableValueNode* create_new()const;
 	static ValueNode_Subtract* create(const ValueBase &value=ValueBase());
 	virtual ~ValueNode_Subtract();
-	virtual ValueBase operator()(Time t)const;
+	virtual ValueBase get_value_vfunc(Time t)const;
 	virtual bool set_link_vfunc(int i,ValueNode::Handle x);
 	virtual ValueNode::LooseHandle get_link_vfunc(int i)const;
 	virtual String get_name()const;
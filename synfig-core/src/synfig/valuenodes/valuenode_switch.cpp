@@ -112,7 +112,7 @@ ValueNode_Switch::get_link_vfunc(int i)const
 }
 
 ValueBase
-ValueNode_Switch::operator()(Time t)const
+ValueNode_Switch::get_value_vfunc(Time t)const
 {
 	if (getenv("SYNFIG_DEBUG_VALUENODE_OPERATORS"))
 		printf("%s:%d operator()\n", __FILE__, __LINE__);
@@ -122,7 +122,7 @@ synfig::ValueNode_TimedSwap::~ValueNode_TimedSwap()
 }
 
 synfig::ValueBase
-synfig::ValueNode_TimedSwap::operator()(Time t)const
+synfig::ValueNode_TimedSwap::get_value_vfunc(Time t)const
 {
 	if (getenv("SYNFIG_DEBUG_VALUENODE_OPERATORS"))
 		printf("%s:%d operator()\n", __FILE__, __LINE__);
@@ -113,7 +113,7 @@ ValueNode_TimeLoop::get_link_vfunc(int i)const
 }
 
 ValueBase
-ValueNode_TimeLoop::operator()(Time t)const
+ValueNode_TimeLoop::get_value_vfunc(Time t)const
 {
 	if (getenv("SYNFIG_DEBUG_VALUENODE_OPERATORS"))
 		printf("%s:%d operator()\n", __FILE__, __LINE__);
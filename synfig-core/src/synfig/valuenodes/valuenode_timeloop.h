@@ -51,7 +51,10 @@ public:
 	ValueNode_TimeLoop(Type &x);
 	ValueNode_TimeLoop(const ValueNode::Handle &x);
 
-	virtual ValueBase operator()(Time t)const;
+	virtual ValueBase get_value_vfunc(Time t)const;
+	//! The value depends on the time directly, not only through the links
+	virtual void get_invariance(Time t, Time &begin, Time &end)const
+		{ ValueNode::get_invariance(t, begin, end); }
 
 	virtual ~ValueNode_TimeLoop();
 
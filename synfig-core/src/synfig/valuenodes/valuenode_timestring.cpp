@@ -81,7 +81,7 @@ ValueNode_TimeString::~ValueNode_TimeString()
 }
 
 ValueBase
-ValueNode_TimeString::operator()(Time t)const
+ValueNode_TimeString::get_value_vfunc(Time t)const
 {
 	if (getenv("SYNFIG_DEBUG_VALUENODE_OPERATORS"))
 		printf("%s:%d operator()\n", __FILE__, __LINE__);
@@ -87,7 +87,7 @@ synfig::ValueNode_TwoTone::~ValueNode_TwoTone()
 }
 
 synfig::ValueBase
-synfig::ValueNode_TwoTone::operator()(Time t)const
+synfig::ValueNode_TwoTone::get_value_vfunc(Time t)const
 {
 	if (getenv("SYNFIG_DEBUG_VALUENODE_OPERATORS"))
 		printf("%s:%d operator()\n", __FILE__, __LINE__);
@@ -81,7 +81,7 @@ ValueNode_VectorAngle::~ValueNode_VectorAngle()
 }
 
 ValueBase
-ValueNode_VectorAngle::operator()(Time t)const
+ValueNode_VectorAngle::get_value_vfunc(Time t)const
 {
 	if (getenv("SYNFIG_DEBUG_VALUENODE_OPERATORS"))
 		printf("%s:%d operator()\n", __FILE__, __LINE__);
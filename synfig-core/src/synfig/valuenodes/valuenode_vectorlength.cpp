@@ -80,7 +80,7 @@ ValueNode_VectorLength::~ValueNode_VectorLength()
 }
 
 ValueBase
-ValueNode_VectorLength::operator()(Time t)const
+ValueNode_VectorLength::get_value_vfunc(Time t)const
 {
 	if (getenv("SYNFIG_DEBUG_VALUENODE_OPERATORS"))
 		printf("%s:%d operator()\n", __FILE__, __LINE__);
@@ -80,7 +80,7 @@ ValueNode_VectorX::~ValueNode_VectorX()
 }
 
 ValueBase
-ValueNode_VectorX::operator()(Time t)const
+ValueNode_VectorX::get_value_vfunc(Time t)const
 {
 	if (getenv("SYNFIG_DEBUG_VALUENODE_OPERATORS"))
 		printf("%s:%d operator()\n", __FILE__, __LINE__);
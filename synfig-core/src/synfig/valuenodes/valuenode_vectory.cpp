@@ -80,7 +80,7 @@ ValueNode_VectorY::~ValueNode_VectorY()
 }
 
 ValueBase
-ValueNode_VectorY::operator()(Time t)const
+ValueNode_VectorY::get_value_vfunc(Time t)const
 {
 	if (getenv("SYNFIG_DEBUG_VALUENODE_OPERATORS"))
 		printf("%s:%d operator()\n", __FILE__, __LINE__);
@@ -89,11 +89,11 @@ ValueNode_WeightedAverage::create(const ValueBase &value, Canvas::LooseHandle ca
 }
 
 ValueBase
-ValueNode_WeightedAverage::operator()(Time t)const
+ValueNode_WeightedAverage::get_value_vfunc(Time t)const
 {
 	if (getenv("SYNFIG_DEBUG_VALUENODE_OPERATORS"))
 		printf("%s:%d operator()\n", __FILE__, __LINE__);
-	return ValueAverage::average_weighted(ValueNode_DynamicList::operator()(t), ValueBase(get_type()));
+	return ValueAverage::average_weighted(ValueNode_DynamicList::get_value_vfunc(t), ValueBase(get_type()));
 }
 
 String
@@ -47,7 +47,7 @@ public:
 	ValueNode_WeightedAverage(Type &type, etl::loose_handle<Canvas> canvas = 0);
 	virtual ~ValueNode_WeightedAverage();
 
- 	virtual ValueBase operator()(Time t)const;
+ 	virtual ValueBase get_value_vfunc(Time t)const;
 
 	virtual String get_name()const;
 	virtual String get_local_name()const;
@@ -274,7 +274,7 @@ ValueNode_WPList::create_list_entry(int index, Time time, Real /*origin*/)
 }
 
 ValueBase
-ValueNode_WPList::operator()(Time t)const
+ValueNode_WPList::get_value_vfunc(Time t)const
 {
 	if (getenv("SYNFIG_DEBUG_VALUENODE_OPERATORS"))
 		printf("%s:%d operator()\n", __FILE__, __LINE__);
@@ -74,7 +74,7 @@ public:
 
 public:
 
- 	virtual ValueBase operator()(Time t)const;
+ 	virtual ValueBase get_value_vfunc(Time t)const;
 	virtual ~ValueNode_WPList();
 	virtual String link_local_name(int i)const;
 	virtual String get_name()const;
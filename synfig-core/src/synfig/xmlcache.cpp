@@ -0,0 +1,407 @@
+/* === S Y N F I G ========================================================= */
+/*!	\file synfig/xmlcache.cpp
+**	\brief Binary copy of an XML document, read by XMLReader instead of the document
+**
+**	$Id$
+**
+**	\legal
+**	Copyright (c) 2016 Synfig contributors
+**
+**	This package is free software; you can redistribute it and/or
+**	modify it under the terms of the GNU General Public License as
+**	published by the Free Software Foundation; either version 2 of
+**	the License, or (at your option) any later version.
+**
+**	This package is distributed in the hope that it will be useful,
+**	but WITHOUT ANY WARRANTY; without even the implied warranty of
+**	MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE. See the GNU
+**	General Public License for more details.
+**	\endlegal
+*/
+/* ========================================================================= */
+
+/* === H E A D E R S ======================================================= */
+
+#ifdef USING_PCH
+#	include "pch.h"
+#else
+#ifdef HAVE_CONFIG_H
+#	include <config.h>
+#endif
+
+#include "xmlcache.h"
+
+#include <cstring>
+#include <map>
+#include <stdexcept>
+#include <vector>
+#include <glib.h>
+#include <libxml/xmlreader.h>
+#include <ETL/stringf>
+#include "zstreambuf.h"
+
+#endif
+
+/* === U S I N G =========================================================== */
+
+using namespace std;
+using namespace etl;
+using namespace synfig;
+
+/* === M A C R O S ========================================================= */
+
+#define CACHE_MAGIC		"SIFCACHE"
+#define CACHE_VERSION	1
+#define BYTE_ORDER_MARK	0x01020304
+
+/* === G L O B A L S ======================================================= */
+
+//! Start of the file, followed by the nodes, the attributes and the strings
+struct XMLCache::Header
+{
+	char magic[8];
+	uint32_t version;
+	uint32_t byte_order;
+	uint64_t source_size;
+	uint64_t source_hash;
+	uint32_t node_count;
+	uint32_t attribute_count;
+	uint32_t strings_size;
+	uint32_t reserved;
+};
+
+/* === P R O C E D U R E S ================================================= */
+
+//! Size and FNV-1a hash of everything in \a stream
+static void
+hash_stream(istream &stream, uint64_t &size, uint64_t &hash)
+{
+	char buffer[65536];
+	size = 0;
+	hash = 14695981039346656037ULL;
+	while(stream)
+	{
+		stream.read(buffer, sizeof(buffer));
+		streamsize count = stream.gcount();
+		for(streamsize i = 0; i < count; ++i)
+			hash = (hash ^ (unsigned char)buffer[i]) * 1099511628211ULL;
+		size += count;
+	}
+}
+
+static int
+read_stream(void *context, char *buffer, int len)
+{
+	istream &stream = *static_cast<istream*>(context);
+	stream.read(buffer, len);
+	return stream.bad() ? -1 : (int)stream.gcount();
+}
+
+static void
+collect_error(void *arg, const char *msg, xmlParserSeverities severity, xmlTextReaderLocatorPtr /* locator */)
+{
+	if (severity == XML_PARSER_SEVERITY_ERROR || severity == XML_PARSER_SEVERITY_VALIDITY_ERROR)
+		*static_cast<String*>(arg) += msg;
+}
+
+static inline bool
+is_blank(int type)
+	{ return type == XML_READER_TYPE_WHITESPACE || type == XML_READER_TYPE_SIGNIFICANT_WHITESPACE; }
+
+//! Tables of a cache while it is built
+class CacheBuilder
+{
+public:
+	vector<XMLCache::Node> nodes;
+	vector<XMLCache::Attribute> attributes;
+	String strings;
+	map<String, uint32_t> offsets;
+
+	//! Offset of \a s in the strings, each one is stored once
+	uint32_t add_string(const char *s)
+	{
+		String key(s ? s : "");
+		map<String, uint32_t>::iterator i = offsets.find(key);
+		if (i != offsets.end())
+			return i->second;
+		uint32_t offset = (uint32_t)strings.size();
+		strings.append(key.c_str(), key.size() + 1);
+		offsets[key] = offset;
+		return offset;
+	}
+
+	//! Leaves out the blank text just read at \a depth, since there is an element beside it
+	void drop_blank(int depth)
+	{
+		while(!nodes.empty() && (int)nodes.back().depth == depth && is_blank(nodes.back().type))
+			nodes.pop_back();
+	}
+
+	//! Adds the node \a reader is at
+	void add(xmlTextReaderPtr reader, int type, int depth)
+	{
+		XMLCache::Node node;
+		memset(&node, 0, sizeof(node));
+		node.type = (uint8_t)type;
+		node.depth = (uint32_t)depth;
+		node.first_attribute = (uint32_t)attributes.size();
+		node.next = (uint32_t)nodes.size() + 1;
+
+		if (type != XML_READER_TYPE_ELEMENT)
+		{
+			node.text = add_string((const char*)xmlTextReaderConstValue(reader));
+			nodes.push_back(node);
+			return;
+		}
+
+		node.text = add_string((const char*)xmlTextReaderConstLocalName(reader));
+		node.line = (uint32_t)xmlGetLineNo(xmlTextReaderCurrentNode(reader));
+		node.empty = xmlTextReaderIsEmptyElement(reader) == 1;
+		if (xmlTextReaderMoveToFirstAttribute(reader) == 1)
+		{
+			do
+			{
+				if (xmlTextReaderIsNamespaceDecl(reader) == 1)
+					continue;
+				if (node.attribute_count == 0xffff)
+					throw runtime_error("Too many attributes in an element");
+				XMLCache::Attribute attribute;
+				attribute.name = add_string((const char*)xmlTextReaderConstLocalName(reader));
+				attribute.value = add_string((const char*)xmlTextReaderConstValue(reader));
+				attributes.push_back(attribute);
+				node.attribute_count++;
+			} while(xmlTextReaderMoveToNextAttribute(reader) == 1);
+			xmlTextReaderMoveToElement(reader);
+		}
+		nodes.push_back(node);
+	}
+
+	//! Reads the whole document from \a reader
+	void build(xmlTextReaderPtr reader, const String &errors)
+	{
+		// Elements whose end tag is still to come, and whether they have child elements
+		vector<uint32_t> open;
+		vector<bool> elements;
+
+		int ret;
+		while((ret = xmlTextReaderRead(reader)) == 1)
+		{
+			int type = xmlTextReaderNodeType(reader);
+			int depth = xmlTextReaderDepth(reader);
+
+			if (type == XML_READER_TYPE_END_ELEMENT)
+			{
+				if (elements.back())
+					drop_blank(depth + 1);
+				nodes[open.back()].next = (uint32_t)nodes.size();
+				open.pop_back();
+				elements.pop_back();
+				continue;
+			}
+
+			if (!open.empty())
+			{
+				if (type == XML_READER_TYPE_ELEMENT)
+				{
+					drop_blank(depth);
+					elements.back() = true;
+				}
+				else
+				if (is_blank(type) && elements.back())
+					continue;
+			}
+
+			add(reader, type, depth);
+			if (type == XML_READER_TYPE_ELEMENT && !nodes.back().empty)
+			{
+				open.push_back((uint32_t)nodes.size() - 1);
+				elements.push_back(false);
+			}
+		}
+
+		if (ret < 0)
+			throw runtime_error(errors.empty() ? String("Error in XML document") : errors);
+		if (nodes.empty() || !open.empty())
+			throw runtime_error("No elements in XML document");
+		if (strings.size() >= 0xffffffffu || nodes.size() >= 0xffffffffu)
+			throw runtime_error("XML document too big to cache");
+	}
+};
+
+/* === M E T H O D S ======================================================= */
+
+XMLCache::XMLCache():
+	file(NULL), nodes(NULL), attributes(NULL), strings(NULL), node_count(0)
+{ }
+
+XMLCache::~XMLCache()
+	{ close(); }
+
+bool
+XMLCache::open(const FileSystem::Identifier &source)
+{
+	close();
+	if (!source.file_system)
+		return false;
+
+	// The cache is only mapped from disk, it is not read through streams
+	String filename = source.file_system->get_real_filename(get_filename(source.filename));
+	if (filename.empty())
+		return false;
+	file = g_mapped_file_new(filename.c_str(), FALSE, NULL);
+	if (!file)
+		return false;
+
+	if (!check(source))
+	{
+		close();
+		return false;
+	}
+	return true;
+}
+
+void
+XMLCache::close()
+{
+	if (file)
+		g_mapped_file_unref(file);
+	file = NULL;
+	nodes = NULL;
+	attributes = NULL;
+	strings = NULL;
+	node_count = 0;
+}
+
+bool
+XMLCache::check(const FileSystem::Identifier &source)
+{
+	size_t size = g_mapped_file_get_length(file);
+	const char *data = g_mapped_file_get_contents(file);
+	if (size < sizeof(Header))
+		return false;
+
+	const Header &header = *(const Header*)data;
+	if (memcmp(header.magic, CACHE_MAGIC, sizeof(header.magic))
+	 || header.version != CACHE_VERSION
+	 || header.byte_order != BYTE_ORDER_MARK
+	 || header.strings_size == 0
+	 || size != sizeof(Header)
+	          + header.node_count*(size_t)sizeof(Node)
+	          + header.attribute_count*(size_t)sizeof(Attribute)
+	          + header.strings_size
+	 || data[size - 1] != 0)
+		return false;
+
+	FileSystem::ReadStreamHandle stream = source.get_read_stream();
+	if (!stream)
+		return false;
+	uint64_t source_size, source_hash;
+	hash_stream(*stream, source_size, source_hash);
+	if (source_size != header.source_size || source_hash != header.source_hash)
+		return false;
+
+	nodes = (const Node*)(data + sizeof(Header));
+	attributes = (const Attribute*)(nodes + header.node_count);
+	strings = (const char*)(attributes + header.attribute_count);
+	node_count = header.node_count;
+
+	// Whatever the file holds, the reader must not leave it: a node can
+	// be at most one level below the elements still open before it, and
+	// skipping an element has to come out at its level or above
+	uint32_t open = 0;
+	for(uint32_t i = 0; i < node_count; ++i)
+	{
+		const Node &node = nodes[i];
+		if (node.depth > open
+		 || node.text >= header.strings_size
+		 || node.next <= i || node.next > node_count
+		 || (node.next < node_count && nodes[node.next].depth > node.depth)
+		 || node.first_attribute > header.attribute_count
+		 || node.attribute_count > header.attribute_count - node.first_attribute)
+			return false;
+		open = node.depth;
+		if (node.type == XML_READER_TYPE_ELEMENT && !node.empty)
+			++open;
+	}
+	for(uint32_t i = 0; i < header.attribute_count; ++i)
+		if (attributes[i].name >= header.strings_size || attributes[i].value >= header.strings_size)
+			return false;
+	return true;
+}
+
+bool
+XMLCache::create(const FileSystem::Identifier &source, String &errors)
+{
+	Header header;
+	memset(&header, 0, sizeof(header));
+	memcpy(header.magic, CACHE_MAGIC, sizeof(header.magic));
+	header.version = CACHE_VERSION;
+	header.byte_order = BYTE_ORDER_MARK;
+
+	FileSystem::ReadStreamHandle stream = source.get_read_stream();
+	if (!stream)
+	{
+		errors = strprintf("Can't open file \"%s\"", source.filename.c_str());
+		return false;
+	}
+	hash_stream(*stream, header.source_size, header.source_hash);
+
+	CacheBuilder builder;
+	stream = source.get_read_stream();
+	if (stream && filename_extension(source.filename) == ".sifz")
+		stream = FileSystem::ReadStreamHandle(new ZReadStream(stream));
+	String parse_errors;
+	xmlTextReaderPtr reader = stream
+		? xmlReaderForIO(read_stream, NULL, static_cast<istream*>(&*stream), source.filename.c_str(), NULL, 0)
+		: NULL;
+	if (!reader)
+	{
+		errors = strprintf("Can't open file \"%s\"", source.filename.c_str());
+		return false;
+	}
+	xmlTextReaderSetErrorHandler(reader, collect_error, &parse_errors);
+	try
+	{
+		builder.build(reader, parse_errors);
+	}
+	catch(const exception &x)
+	{
+		xmlFreeTextReader(reader);
+		errors = x.what();
+		return false;
+	}
+	xmlFreeTextReader(reader);
+
+	header.node_count = (uint32_t)builder.nodes.size();
+	header.attribute_count = (uint32_t)builder.attributes.size();
+	header.strings_size = (uint32_t)builder.strings.size();
+
+	// A loader mapping the cache meanwhile sees either the old file or the
+	// complete new one, never a partly written one
+	String filename = get_filename(source.filename);
+	String tmp_filename = filename + ".TMP";
+	FileSystem::WriteStreamHandle out = source.file_system->get_write_stream(tmp_filename);
+	if (!out
+	 || !out->write_whole_block(&header, sizeof(header))
+	 || !out->write_whole_block(&builder.nodes.front(), builder.nodes.size()*sizeof(Node))
+	 || (!builder.attributes.empty()
+	  && !out->write_whole_block(&builder.attributes.front(), builder.attributes.size()*sizeof(Attribute)))
+	 || !out->write_whole_block(builder.strings.data(), builder.strings.size()))
+	{
+		out.reset();
+		source.file_system->file_remove(tmp_filename);
+		errors = strprintf("Can't write file \"%s\"", tmp_filename.c_str());
+		return false;
+	}
+	out.reset();
+
+	if (!source.file_system->file_rename(tmp_filename, filename))
+	{
+		source.file_system->file_remove(tmp_filename);
+		errors = strprintf("Can't rename file \"%s\" to \"%s\"", tmp_filename.c_str(), filename.c_str());
+		return false;
+	}
+	return true;
+}
+
+/* === E N D =============================================================== */
@@ -0,0 +1,125 @@
+/* === S Y N F I G ========================================================= */
+/*!	\file synfig/xmlcache.h
+**	\brief Binary copy of an XML document, read by XMLReader instead of the document
+**
+**	$Id$
+**
+**	\legal
+**	Copyright (c) 2016 Synfig contributors
+**
+**	This package is free software; you can redistribute it and/or
+**	modify it under the terms of the GNU General Public License as
+**	published by the Free Software Foundation; either version 2 of
+**	the License, or (at your option) any later version.
+**
+**	This package is distributed in the hope that it will be useful,
+**	but WITHOUT ANY WARRANTY; without even the implied warranty of
+**	MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE. See the GNU
+**	General Public License for more details.
+**	\endlegal
+*/
+/* ========================================================================= */
+
+/* === S T A R T =========================================================== */
+
+#ifndef __SYNFIG_XMLCACHE_H
+#define __SYNFIG_XMLCACHE_H
+
+/* === H E A D E R S ======================================================= */
+
+#include <stdint.h>
+#include "filesystem.h"
+#include "string.h"
+
+/* === M A C R O S ========================================================= */
+
+/* === T Y P E D E F S ===================================================== */
+
+struct _GMappedFile;
+
+/* === C L A S S E S & S T R U C T S ======================================= */
+
+namespace synfig {
+
+/*!	\class XMLCache
+**	\brief The nodes of an XML document as XMLReader sees them, in a file which is mapped into memory as it is
+**
+**	The cache of \c file.sifz is \c file.sifz.cache, written by create()
+**	(<tt>synfig --precompile</tt>). It holds a table of the nodes of the
+**	document in the order libxml2 reads them, a table of attributes and
+**	the strings they refer to. Reading it skips the decompression and the
+**	XML parsing, the canvas is still built from the nodes by CanvasParser.
+**	Blank text between elements is left out.
+**
+**	The cache is only used while the size and the hash of the source file
+**	are the ones it was made from, checked by open(). It is written in the
+**	byte order of the machine, a cache from another one is ignored.
+*/
+class XMLCache
+{
+public:
+	//! Element, text or other node of the document
+	struct Node
+	{
+		uint8_t type;				//!< xmlReaderTypes of libxml2
+		uint8_t empty;				//!< Element without an end tag
+		uint16_t attribute_count;
+		uint32_t depth;
+		uint32_t text;				//!< Name of an element, value of anything else
+		uint32_t line;
+		uint32_t first_attribute;
+		uint32_t next;				//!< First node after the subtree
+	};
+
+	struct Attribute
+	{
+		uint32_t name;
+		uint32_t value;
+	};
+
+private:
+	struct Header;
+
+	_GMappedFile *file;
+	const Node *nodes;
+	const Attribute *attributes;
+	const char *strings;
+	uint32_t node_count;
+
+	//! Non-copyable
+	XMLCache(const XMLCache&);
+	//! Non-assignable
+	void operator=(const XMLCache&);
+
+	//! Points the tables into the mapped file, if it is a cache of \a source
+	bool check(const FileSystem::Identifier &source);
+
+public:
+	XMLCache();
+	~XMLCache();
+
+	//! Maps the cache of \a source, if there is one on disk and \a source didn't change since it was written
+	bool open(const FileSystem::Identifier &source);
+	void close();
+
+	bool is_open()const { return file; }
+
+	uint32_t get_node_count()const { return node_count; }
+	const Node& get_node(uint32_t i)const { return nodes[i]; }
+	const Attribute& get_attribute(uint32_t i)const { return attributes[i]; }
+	const char* get_string(uint32_t offset)const { return strings + offset; }
+
+	//! Reads \a source and writes its cache next to it
+	/*!	The cache is written to a temporary file, which then replaces the old cache.
+	**	\return \c false if \a source can't be read or parsed, or the cache can't be written, with the reason in \a errors */
+	static bool create(const FileSystem::Identifier &source, String &errors);
+
+	//! Name of the cache of \a filename
+	static String get_filename(const String &filename) { return filename + ".cache"; }
+}; // END of class XMLCache
+
+}; // END of namespace synfig
+
+/* === E N D =============================================================== */
+
+#endif
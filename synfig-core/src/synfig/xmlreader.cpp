@@ -0,0 +1,361 @@
+/* === S Y N F I G ========================================================= */
+/*!	\file synfig/xmlreader.cpp
+**	\brief Single pass reader of XML documents
+**
+**	$Id$
+**
+**	\legal
+**	Copyright (c) 2016 Synfig contributors
+**
+**	This package is free software; you can redistribute it and/or
+**	modify it under the terms of the GNU General Public License as
+**	published by the Free Software Foundation; either version 2 of
+**	the License, or (at your option) any later version.
+**
+**	This package is distributed in the hope that it will be useful,
+**	but WITHOUT ANY WARRANTY; without even the implied warranty of
+**	MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE. See the GNU
+**	General Public License for more details.
+**	\endlegal
+*/
+/* ========================================================================= */
+
+/* === H E A D E R S ======================================================= */
+
+#ifdef USING_PCH
+#	include "pch.h"
+#else
+#ifdef HAVE_CONFIG_H
+#	include <config.h>
+#endif
+
+#include "xmlreader.h"
+#include "xmlcache.h"
+
+#include <stdexcept>
+#include <libxml/xmlreader.h>
+
+#endif
+
+/* === U S I N G =========================================================== */
+
+using namespace std;
+using namespace synfig;
+
+/* === M A C R O S ========================================================= */
+
+/* === G L O B A L S ======================================================= */
+
+/* === P R O C E D U R E S ================================================= */
+
+static int
+read_stream(void *context, char *buffer, int len)
+{
+	istream &stream = *static_cast<istream*>(context);
+	stream.read(buffer, len);
+	return stream.bad() ? -1 : (int)stream.gcount();
+}
+
+static void
+collect_error(void *arg, const char *msg, xmlParserSeverities severity, xmlTextReaderLocatorPtr /* locator */)
+{
+	if (severity == XML_PARSER_SEVERITY_ERROR || severity == XML_PARSER_SEVERITY_VALIDITY_ERROR)
+		*static_cast<String*>(arg) += msg;
+}
+
+static inline bool
+is_text(int type)
+{
+	return type == XML_READER_TYPE_TEXT
+	    || type == XML_READER_TYPE_CDATA
+	    || type == XML_READER_TYPE_WHITESPACE
+	    || type == XML_READER_TYPE_SIGNIFICANT_WHITESPACE;
+}
+
+/* === M E T H O D S ======================================================= */
+
+XMLReader::XMLReader():
+	reader(NULL),
+	cache(NULL),
+	cache_node(0),
+	cache_next(0),
+	cache_open(0),
+	position(0),
+	type(XML_READER_TYPE_NONE),
+	depth(-1)
+{ }
+
+XMLReader::~XMLReader()
+	{ close(); }
+
+void
+XMLReader::open(xmlTextReaderPtr x)
+{
+	close();
+	reader = x;
+	if (reader)
+		xmlTextReaderSetErrorHandler(reader, collect_error, &errors);
+}
+
+void
+XMLReader::open_stream(std::istream &stream, const String &url)
+	{ open(xmlReaderForIO(read_stream, NULL, &stream, url.empty() ? NULL : url.c_str(), NULL, 0)); }
+
+void
+XMLReader::open_memory(const String &data, const String &url)
+	{ open(xmlReaderForMemory(data.c_str(), (int)data.size(), url.empty() ? NULL : url.c_str(), NULL, 0)); }
+
+void
+XMLReader::open_document(xmlDocPtr document)
+	{ open(xmlReaderWalker(document)); }
+
+void
+XMLReader::open_cache(const XMLCache &x)
+{
+	close();
+	if (x.is_open())
+		cache = &x;
+}
+
+void
+XMLReader::close()
+{
+	if (reader)
+		xmlFreeTextReader(reader);
+	reader = NULL;
+	cache = NULL;
+	cache_node = cache_next = 0;
+	cache_open = 0;
+	errors.clear();
+	position = 0;
+	type = XML_READER_TYPE_NONE;
+	depth = -1;
+}
+
+bool
+XMLReader::read()
+{
+	if (cache)
+	{
+		// The cache leaves out end tags, they come before the first
+		// node which is not deeper than the element they close
+		if (cache_next < cache->get_node_count() && (int)cache->get_node(cache_next).depth >= cache_open)
+		{
+			const XMLCache::Node &node = cache->get_node(cache_node = cache_next++);
+			type = node.type;
+			depth = (int)node.depth;
+			if (type == XML_READER_TYPE_ELEMENT && !node.empty)
+				++cache_open;
+		}
+		else
+		if (cache_open > 0)
+		{
+			type = XML_READER_TYPE_END_ELEMENT;
+			depth = --cache_open;
+		}
+		else
+			return false;
+		++position;
+		return true;
+	}
+
+	int ret = reader ? xmlTextReaderRead(reader) : 0;
+	if (ret < 0)
+		throw runtime_error(errors.empty() ? String("Error in XML document") : errors);
+	if (ret == 0)
+		return false;
+	++position;
+	type = xmlTextReaderNodeType(reader);
+	depth = xmlTextReaderDepth(reader);
+	return true;
+}
+
+bool
+XMLReader::skip()
+{
+	if (cache)
+	{
+		const XMLCache::Node &node = cache->get_node(cache_node);
+		if (type == XML_READER_TYPE_ELEMENT && !node.empty)
+		{
+			cache_next = node.next;
+			--cache_open;
+		}
+		return read();
+	}
+
+	int ret = xmlTextReaderNext(reader);
+	if (ret < 0)
+		throw runtime_error(errors.empty() ? String("Error in XML document") : errors);
+	if (ret == 0)
+		return false;
+	++position;
+	type = xmlTextReaderNodeType(reader);
+	depth = xmlTextReaderDepth(reader);
+	return true;
+}
+
+void
+XMLReader::enter()
+{
+	if ((int)frames.size() <= depth)
+		frames.resize(depth + 1);
+
+	// Assigning to the strings of the frame reuses their storage, so no
+	// memory is allocated once the reader has seen a few elements
+	Frame &frame = frames[depth];
+	frame.position = position;
+	frame.text_read = false;
+	frame.peeked = false;
+
+	if (cache)
+	{
+		const XMLCache::Node &node = cache->get_node(cache_node);
+		frame.name = cache->get_string(node.text);
+		frame.line = (int)node.line;
+		frame.empty = node.empty;
+		frame.attribute_count = node.attribute_count;
+		if ((int)frame.attributes.size() < frame.attribute_count)
+			frame.attributes.resize(frame.attribute_count);
+		for(int i = 0; i < frame.attribute_count; ++i)
+		{
+			const XMLCache::Attribute &attribute = cache->get_attribute(node.first_attribute + i);
+			frame.attributes[i].name = cache->get_string(attribute.name);
+			frame.attributes[i].value = cache->get_string(attribute.value);
+		}
+		return;
+	}
+
+	frame.name = (const char*)xmlTextReaderConstLocalName(reader);
+	frame.line = (int)xmlGetLineNo(xmlTextReaderCurrentNode(reader));
+	frame.empty = xmlTextReaderIsEmptyElement(reader) == 1;
+	frame.attribute_count = 0;
+
+	if (xmlTextReaderMoveToFirstAttribute(reader) != 1)
+		return;
+	do
+	{
+		if (xmlTextReaderIsNamespaceDecl(reader) == 1)
+			continue;
+		if (frame.attribute_count == (int)frame.attributes.size())
+			frame.attributes.push_back(Attribute());
+		Attribute &attribute = frame.attributes[frame.attribute_count++];
+		attribute.name = (const char*)xmlTextReaderConstLocalName(reader);
+		attribute.value = (const char*)xmlTextReaderConstValue(reader);
+	} while(xmlTextReaderMoveToNextAttribute(reader) == 1);
+	xmlTextReaderMoveToElement(reader);
+}
+
+const char*
+XMLReader::value()const
+{
+	if (cache)
+		return cache->get_string(cache->get_node(cache_node).text);
+	const xmlChar *value = xmlTextReaderConstValue(reader);
+	return value ? (const char*)value : "";
+}
+
+bool
+XMLReader::at_children(int level)
+{
+	const Frame &frame = frames[level];
+	if (frame.empty)
+		return false;
+	if (position == frame.position)
+		return read();
+	return frame.peeked && position == frame.position + 1;
+}
+
+XMLElement::XMLElement(XMLReader &reader):
+	reader(&reader), depth(0), parent_position(-1), started(false), done(false)
+{ }
+
+XMLElement::XMLElement(const XMLElement *parent):
+	reader(parent->reader),
+	depth(parent->depth + 1),
+	parent_position(parent->frame().position),
+	started(false),
+	done(false)
+{ }
+
+bool
+XMLElement::next()
+{
+	if (done)
+		return false;
+
+	bool ok;
+	if (!started)
+	{
+		started = true;
+		if (depth == 0)
+			ok = reader->read();
+		else
+			ok = reader->frames[depth - 1].position == parent_position
+			  && reader->at_children(depth - 1);
+	}
+	else
+	if (reader->position == frame().position)
+	{
+		// Nothing was read from the current element
+		ok = reader->skip();
+	}
+	else
+	{
+		// Whoever read the current element may have stopped anywhere inside it
+		ok = true;
+		while(ok && !(reader->depth == depth && reader->type == XML_READER_TYPE_END_ELEMENT))
+			ok = reader->read();
+		if (ok)
+			ok = reader->read();
+	}
+
+	for(; ok && reader->depth >= depth; ok = reader->read())
+		if (reader->depth == depth && reader->type == XML_READER_TYPE_ELEMENT)
+		{
+			reader->enter();
+			return true;
+		}
+
+	done = true;
+	return false;
+}
+
+const XMLReader::Attribute*
+XMLElement::get_attribute(const char *name)const
+{
+	const XMLReader::Frame &f = frame();
+	for(int i = 0; i < f.attribute_count; ++i)
+		if (f.attributes[i].get_name() == name)
+			return &f.attributes[i];
+	return NULL;
+}
+
+bool
+XMLElement::has_children()const
+{
+	XMLReader::Frame &f = frame();
+	if (f.empty)
+		return false;
+	if (reader->position == f.position)
+	{
+		f.peeked = true;
+		reader->read();
+	}
+	return f.peeked && reader->position == f.position + 1 && reader->depth > depth;
+}
+
+const String&
+XMLElement::get_child_text()const
+{
+	XMLReader::Frame &f = frame();
+	if (!f.text_read)
+	{
+		f.text_read = true;
+		f.text.clear();
+		for(bool ok = reader->at_children(depth); ok && reader->depth > depth; ok = reader->read())
+			if (reader->depth == depth + 1 && is_text(reader->type))
+				f.text += reader->value();
+	}
+	return f.text;
+}
@@ -0,0 +1,197 @@
+/* === S Y N F I G ========================================================= */
+/*!	\file synfig/xmlreader.h
+**	\brief Single pass reader of XML documents
+**
+**	$Id$
+**
+**	\legal
+**	Copyright (c) 2016 Synfig contributors
+**
+**	This package is free software; you can redistribute it and/or
+**	modify it under the terms of the GNU General Public License as
+**	published by the Free Software Foundation; either version 2 of
+**	the License, or (at your option) any later version.
+**
+**	This package is distributed in the hope that it will be useful,
+**	but WITHOUT ANY WARRANTY; without even the implied warranty of
+**	MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE. See the GNU
+**	General Public License for more details.
+**	\endlegal
+*/
+/* ========================================================================= */
+
+/* === S T A R T =========================================================== */
+
+#ifndef __SYNFIG_XMLREADER_H
+#define __SYNFIG_XMLREADER_H
+
+/* === H E A D E R S ======================================================= */
+
+#include <istream>
+#include <vector>
+#include <deque>
+#include "string.h"
+
+/* === M A C R O S ========================================================= */
+
+/* === T Y P E D E F S ===================================================== */
+
+struct _xmlTextReader;
+struct _xmlDoc;
+
+/* === C L A S S E S & S T R U C T S ======================================= */
+
+namespace synfig {
+
+class XMLElement;
+class XMLCache;
+
+/*!	\class XMLReader
+**	\brief Reads an XML document once from start to end, through the xmlTextReader interface of libxml2
+**
+**	Nothing of the document is kept but the start tags of the elements
+**	enclosing the current position, so the memory needed doesn't grow with
+**	the size of the document. The elements are visited with XMLElement.
+**	A document which is not well-formed throws std::runtime_error where
+**	the error is found.
+**
+**	The nodes can also come from an XMLCache of the document, which is
+**	read the same way without parsing anything.
+*/
+class XMLReader
+{
+	friend class XMLElement;
+
+public:
+	//! Name and value of an attribute
+	class Attribute
+	{
+		friend class XMLReader;
+		String name, value;
+	public:
+		const String& get_name()const { return name; }
+		const String& get_value()const { return value; }
+	};
+
+private:
+	//! Start tag of an element enclosing the current position, the storage is reused by its siblings
+	struct Frame
+	{
+		String name;
+		int line;
+		bool empty;
+		long position;
+		std::vector<Attribute> attributes;
+		int attribute_count;
+		String text;
+		bool text_read;
+		bool peeked;	//!< Whether the reader went on to the first child to see if there is one
+
+		Frame(): line(0), empty(true), position(-1), attribute_count(0), text_read(false), peeked(false) { }
+	};
+
+	_xmlTextReader *reader;
+	const XMLCache *cache;
+	unsigned int cache_node;	//!< Node of the cache the reader is at
+	unsigned int cache_next;	//!< Node of the cache to read next
+	int cache_open;			//!< Elements of the cache whose end is still to be read
+	String errors;
+	std::deque<Frame> frames;
+	long position;
+	int type, depth;
+
+	//! Non-copyable
+	XMLReader(const XMLReader&);
+	//! Non-assignable
+	void operator=(const XMLReader&);
+
+	void open(_xmlTextReader *x);
+	//! Moves to the next node, entering elements
+	bool read();
+	//! Moves to the next node, past the subtree of the current one
+	bool skip();
+	//! Stores the start tag the reader is at
+	void enter();
+	//! Value of the text node the reader is at
+	const char* value()const;
+	//! Moves from the start tag of the element at \a level to its first child, unless it is already there
+	/*!	\return \c false if the element is empty or was read past its first child */
+	bool at_children(int level);
+
+public:
+	XMLReader();
+	~XMLReader();
+
+	//! Reads from \a stream, which has to stay alive until the reader is closed
+	/*!	\a url is only used in the messages about errors in the document.
+	**	\see is_open() */
+	void open_stream(std::istream &stream, const String &url = String());
+	//! Reads from \a data, which has to stay alive until the reader is closed
+	void open_memory(const String &data, const String &url = String());
+	//! Walks a document already parsed by libxml2
+	void open_document(_xmlDoc *document);
+	//! Reads the nodes of \a cache, which has to stay open until the reader is closed
+	void open_cache(const XMLCache &cache);
+	void close();
+
+	bool is_open()const { return reader || cache; }
+}; // END of class XMLReader
+
+/*!	\class XMLElement
+**	\brief Cursor over the child elements of an element, or over the root element of a document
+**
+**	The cursor stays before the first element until next() is called:
+**	\code
+**	for(XMLElement child(element); child.next(); )
+**		if (child.get_name() == "layer") ...
+**	\endcode
+**	Since the document is read only once, an element is available until
+**	the cursor moves past it, and its children and text are read at most
+**	once: either iterate over the children or call get_child_text().
+**	Leaving a loop early is fine, next() at an outer level skips whatever
+**	was left unread.
+*/
+class XMLElement
+{
+	XMLReader *reader;
+	int depth;
+	long parent_position;
+	bool started, done;
+
+	XMLReader::Frame& frame()const { return reader->frames[depth]; }
+
+public:
+	//! Cursor over the root element of the document of \a reader
+	explicit XMLElement(XMLReader &reader);
+	//! Cursor over the children of \a parent, which has to be at its start tag still
+	explicit XMLElement(const XMLElement *parent);
+
+	//! Moves to the next element, skipping the rest of the current one
+	/*!	\return \c false when there are no more elements, the cursor is no longer usable then */
+	bool next();
+
+	//! Local name of the element
+	const String& get_name()const { return frame().name; }
+	//! Line of the start tag of the element, for messages
+	int get_line()const { return frame().line; }
+
+	//! The attribute named \a name, or NULL if the element has none
+	const XMLReader::Attribute* get_attribute(const char *name)const;
+	const XMLReader::Attribute* get_attribute(const String &name)const { return get_attribute(name.c_str()); }
+	int get_attribute_count()const { return frame().attribute_count; }
+	const XMLReader::Attribute& get_attribute_at(int i)const { return frame().attributes[i]; }
+
+	//! Whether there is anything inside the element, even blank text or comments
+	/*!	Has to be asked before reading the children or the text */
+	bool has_children()const;
+
+	//! The text directly inside the element, read on the first call
+	/*!	Child elements are skipped, which leaves none for a cursor over the children */
+	const String& get_child_text()const;
+}; // END of class XMLElement
+
+}; // END of namespace synfig
+
+/* === E N D =============================================================== */
+
+#endif
@@ -51,7 +51,10 @@ SynfigToolGeneralOptions::SynfigToolGeneralOptions(const char* argv0)
 	_verbosity = 0;
 	_should_be_quiet = false;
 	_should_print_benchmarks = false;
+	_should_benchmark_threads = false;
 	_threads = 1;
+	_frame_workers = 1;
+	_frame_queue_depth = 0;
 }
 
 boost::filesystem::path SynfigToolGeneralOptions::get_binary_path() const
@@ -69,6 +72,26 @@ void SynfigToolGeneralOptions::set_threads(size_t threads)
 	_threads = threads;
 }
 
+int SynfigToolGeneralOptions::get_frame_workers() const
+{
+	return _frame_workers;
+}
+
+void SynfigToolGeneralOptions::set_frame_workers(int workers)
+{
+	_frame_workers = workers;
+}
+
+int SynfigToolGeneralOptions::get_frame_queue_depth() const
+{
+	return _frame_queue_depth;
+}
+
+void SynfigToolGeneralOptions::set_frame_queue_depth(int depth)
+{
+	_frame_queue_depth = depth;
+}
+
 int SynfigToolGeneralOptions::get_verbosity() const
 {
 	return _verbosity;
@@ -98,3 +121,13 @@ void SynfigToolGeneralOptions::set_should_print_benchmarks(bool print_benchmarks
 {
 	_should_print_benchmarks = print_benchmarks;
 }
+
+bool SynfigToolGeneralOptions::should_benchmark_threads() const
+{
+	return _should_benchmark_threads;
+}
+
+void SynfigToolGeneralOptions::set_should_benchmark_threads(bool benchmark_threads)
+{
+	_should_benchmark_threads = benchmark_threads;
+}
@@ -90,6 +90,14 @@ public:
 
 	void set_threads(size_t threads);
 
+	int get_frame_workers() const;
+
+	void set_frame_workers(int workers);
+
+	int get_frame_queue_depth() const;
+
+	void set_frame_queue_depth(int depth);
+
 	int get_verbosity() const;
 
 	void set_verbosity(int verbosity);
@@ -102,14 +110,21 @@ public:
 
 	void set_should_print_benchmarks(bool print_benchmarks);
 
+	bool should_benchmark_threads() const;
+
+	void set_should_benchmark_threads(bool benchmark_threads);
+
 private:
 	SynfigToolGeneralOptions(const char* argv0);
 
 	boost::filesystem::path _binary_path;
 	int _verbosity;
 	size_t _threads;
+	int _frame_workers;
+	int _frame_queue_depth;
 	bool _should_be_quiet,
-		 _should_print_benchmarks;
+		 _should_print_benchmarks,
+		 _should_benchmark_threads;
 
 	static boost::shared_ptr<SynfigToolGeneralOptions> _instance;
 };
@@ -46,9 +46,14 @@
 #include <synfig/canvas.h>
 #include <synfig/target.h>
 #include <synfig/layer.h>
+#include <synfig/layers/layer_pastecanvas.h>
 #include <synfig/time.h>
 #include <synfig/target_scanline.h>
+#include <synfig/target_tile.h>
+#include <synfig/threadpool.h>
 #include <synfig/paramdesc.h>
+#include <synfig/valuenode.h>
+#include <synfig/surfacecache.h>
 #include <synfig/module.h>
 #include <synfig/importer.h>
 #include <synfig/loadcanvas.h>
@@ -189,12 +194,158 @@ bool setup_job(Job& job, const TargetParam& target_parameters)
 	}
 
 	// Set the threads for the target
+	set_target_threads(job.target, SynfigToolGeneralOptions::instance()->get_threads());
+
+	// Set how many frames may wait to be written while the next one renders
 	if (job.target && Target_Scanline::Handle::cast_dynamic(job.target))
-		Target_Scanline::Handle::cast_dynamic(job.target)->set_threads(SynfigToolGeneralOptions::instance()->get_threads());
+		Target_Scanline::Handle::cast_dynamic(job.target)->set_frame_queue_depth(
+			SynfigToolGeneralOptions::instance()->get_frame_queue_depth());
+
+	// Render several frames at once on independent copies of the canvas
+	int frame_workers = SynfigToolGeneralOptions::instance()->get_frame_workers();
+	if (frame_workers > 1 && job.target && Target_Scanline::Handle::cast_dynamic(job.target))
+	{
+		if (job.canvas != job.root)
+			synfig::warning(_("Rendering several frames at once is supported for the root canvas only"));
+		else
+		if (!can_copy_canvas(job.canvas))
+			synfig::warning(_("Rendering one frame at a time, the document uses external files or animated images"));
+		else
+		{
+			VERBOSE_OUT(4) << _("Copying the canvas for the frame workers...") << std::endl;
+			Target_Scanline::Handle::cast_dynamic(job.target)->set_worker_canvases(
+				copy_canvas(job.canvas, frame_workers));
+		}
+	}
 
 	return true;
 }
 
+static bool can_copy_layers(const Canvas::Handle& canvas, const Canvas::LooseHandle& root)
+{
+	for(Canvas::const_iterator iter = canvas->begin(); iter != canvas->end(); ++iter)
+	{
+		// animated imports read their frames through the shared importer
+		if ((*iter)->get_name() == "import" && (*iter)->is_time_dependent())
+			return false;
+
+		etl::handle<Layer_PasteCanvas> paste_canvas = etl::handle<Layer_PasteCanvas>::cast_dynamic(*iter);
+		if (!paste_canvas || !paste_canvas->get_sub_canvas())
+			continue;
+		Canvas::Handle sub_canvas = paste_canvas->get_sub_canvas();
+		if (sub_canvas->get_root() != root)
+			return false;
+		if (sub_canvas->is_inline() && !can_copy_layers(sub_canvas, root))
+			return false;
+	}
+
+	// exported canvases of the document are reparsed with it
+	for(Canvas::Children::const_iterator iter = canvas->children().begin(); iter != canvas->children().end(); ++iter)
+		if (!can_copy_layers(*iter, root))
+			return false;
+	return true;
+}
+
+bool can_copy_canvas(const Canvas::Handle& canvas)
+{
+	return can_copy_layers(canvas, canvas->get_root());
+}
+
+std::vector<Canvas::Handle> copy_canvas(const Canvas::Handle& canvas, int count)
+{
+	std::vector<Canvas::Handle> canvases;
+	canvases.push_back(canvas);
+
+	// Reparse the saved canvas, so every copy gets its own layers
+	// and value nodes, including the exported ones
+	const std::string data = canvas_to_string(canvas);
+	for(int i = 1; i < count; ++i)
+	{
+		std::string errors, warnings;
+		Canvas::Handle copy = open_canvas_from_string_as(
+			data, canvas->get_identifier(), canvas->get_file_name(), errors, warnings);
+		if (!copy)
+		{
+			synfig::warning((boost::format(_("Unable to copy the canvas: %s")) % errors).str());
+			break;
+		}
+		copy->rend_desc() = canvas->rend_desc();
+		canvases.push_back(copy);
+	}
+
+	return canvases;
+}
+
+void set_target_threads(const Target::Handle& target, int threads)
+{
+	if (Target_Scanline::Handle::cast_dynamic(target))
+		Target_Scanline::Handle::cast_dynamic(target)->set_threads(threads);
+	else
+	if (Target_Tile::Handle::cast_dynamic(target))
+		Target_Tile::Handle::cast_dynamic(target)->set_threads(threads);
+}
+
+void benchmark_threads(Job& job, ProgressCallback *cb)
+{
+	int max_threads = SynfigToolGeneralOptions::instance()->get_threads();
+	if (max_threads <= 1)
+		max_threads = ThreadPool::get_processor_count();
+
+	// Render the frames without writing them, so every run measures
+	// the same work and the output file is left alone
+	Target::Handle target = Target::create(
+		Target_Tile::Handle::cast_dynamic(job.target) ? "null-tile" : "null",
+		job.outfilename, TargetParam());
+	if (!target)
+		throw (SynfigToolException(SYNFIGTOOL_RENDERFAILURE, _("Unable to create the null target.")));
+	target->set_canvas(job.canvas);
+	target->set_quality(job.quality);
+	if (job.alpha_mode!=TARGET_ALPHA_MODE_KEEP)
+		target->set_alpha_mode(job.alpha_mode);
+
+	Target_Scanline::Handle scanline = Target_Scanline::Handle::cast_dynamic(job.target);
+	Target_Scanline::Handle null_scanline = Target_Scanline::Handle::cast_dynamic(target);
+	if (scanline && null_scanline)
+	{
+		null_scanline->set_frame_queue_depth(scanline->get_frame_queue_depth());
+		null_scanline->set_worker_canvases(scanline->get_worker_canvases());
+	}
+
+	double single_thread_duration = 0.0;
+	for(int threads = 1; ; threads = std::min(threads*2, max_threads))
+	{
+		set_target_threads(target, threads);
+		ThreadPool::set_instance_threads(threads);
+
+		// start every run from cold caches
+		ValueNode::clear_caches();
+		SurfaceCache::instance().clear();
+
+		boost::chrono::system_clock::time_point start_timepoint =
+			boost::chrono::system_clock::now();
+
+		if(!target->render(cb))
+			throw (SynfigToolException(SYNFIGTOOL_RENDERFAILURE, _("Render Failure.")));
+
+		boost::chrono::duration<double> duration =
+			boost::chrono::system_clock::now() - start_timepoint;
+		if (threads == 1)
+			single_thread_duration = duration.count();
+
+		double speedup = duration.count() > 0.0 ? single_thread_duration/duration.count() : 0.0;
+		std::cout << boost::format(_("%s: %3d threads: %10.3f seconds, speedup %6.2fx, efficiency %5.1f%%"))
+						% job.filename
+						% threads
+						% duration.count()
+						% speedup
+						% (100.0*speedup/threads)
+				  << std::endl;
+
+		if (threads >= max_threads)
+			break;
+	}
+}
+
 void process_job (Job& job)
 {
 	VERBOSE_OUT(3) << job.filename.c_str() << " -- " << std::endl;
@@ -229,6 +380,21 @@ void process_job (Job& job)
 	}
 	else
 	{
+		if(SynfigToolGeneralOptions::instance()->should_benchmark_threads())
+		{
+			VERBOSE_OUT(1) << _("Benchmarking threads...") << std::endl;
+			benchmark_threads(job, &p);
+			VERBOSE_OUT(1) << _("Done.") << std::endl;
+			return;
+		}
+
+		if(SynfigToolGeneralOptions::instance()->should_print_benchmarks())
+		{
+			ValueNode::set_cache_stats_enabled(true);
+			ValueNode::reset_cache_stats();
+			SurfaceCache::instance().reset_stats();
+		}
+
 		VERBOSE_OUT(1) << _("Rendering...") << std::endl;
 		boost::chrono::system_clock::time_point start_timepoint =
             boost::chrono::system_clock::now();
@@ -246,6 +412,19 @@ void process_job (Job& job)
                       << _(": Rendered in ")
                       << duration.count()
                       << _(" seconds.") << std::endl;
+
+			long long evaluations, saved;
+			ValueNode::get_cache_stats(evaluations, saved);
+			int frames = std::max(1, job.desc.get_frame_end() - job.desc.get_frame_start() + 1);
+			std::cout << boost::format(_("Value nodes: %d evaluations, %d answered from cache (%.1f per frame)"))
+			             % evaluations % saved % ((double)saved/frames)
+			          << std::endl;
+
+			SurfaceCache::Stats stats = SurfaceCache::instance().get_stats();
+			std::cout << boost::format(_("Surface cache: %d hits, %d misses, %d evicted, %d entries using %.1f MiB"))
+			             % stats.hits % stats.misses % stats.evictions
+			             % stats.entries % (stats.memory/1048576.0)
+			          << std::endl;
         }
 	}
 
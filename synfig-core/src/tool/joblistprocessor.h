@@ -26,6 +26,7 @@
 #define __SYNFIG_JOBLISTPROCESSOR_H
 
 #include <list>
+#include <vector>
 #include <synfig/targetparam.h>
 #include "job.h"
 
@@ -40,4 +41,18 @@ bool setup_job(Job& job, const synfig::TargetParam& target_parameters);
 /// Process an individual job
 void process_job(Job& job);
 
+/// Whether copies of \a canvas made by copy_canvas() share no state while they render.
+/// External canvases and the importers of animated files are opened once for
+/// every document using them, so a copy can't set their time on its own.
+bool can_copy_canvas(const synfig::Canvas::Handle& canvas);
+
+/// Make \a count independent copies of \a canvas, the first one being \a canvas itself
+std::vector<synfig::Canvas::Handle> copy_canvas(const synfig::Canvas::Handle& canvas, int count);
+
+/// Set the number of render threads on scanline and tile targets
+void set_target_threads(const synfig::Target::Handle& target, int threads);
+
+/// Render a job to a null target with 1, 2, 4... threads from cold caches and print the scaling
+void benchmark_threads(Job& job, synfig::ProgressCallback *cb);
+
 #endif // __SYNFIG_JOBLISTPROCESSOR_H
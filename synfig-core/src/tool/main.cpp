@@ -121,6 +121,9 @@ int main(int argc, char* argv[])
 		named_type<int>* quality_arg_desc = new named_type<int>("0..10");
 		named_type<float>* gamma_arg_desc = new named_type<float>("NUM (=2.2)");
 		named_type<int>* threads_arg_desc = new named_type<int>("NUM");
+		named_type<int>* frame_queue_arg_desc = new named_type<int>("NUM");
+		named_type<int>* surface_cache_arg_desc = new named_type<int>("MB");
+		named_type<int>* frame_workers_arg_desc = new named_type<int>("NUM");
 		named_type<int>* verbosity_arg_desc = new named_type<int>("NUM");
 		named_type<std::string>* canvas_arg_desc = new named_type<std::string>("canvas-id");
 		named_type<std::string>* output_file_arg_desc = new named_type<std::string>("filename");
@@ -150,6 +153,9 @@ int main(int argc, char* argv[])
             ("quality,Q", quality_arg_desc->default_value(DEFAULT_QUALITY), (boost::format(_("Specify image quality for accelerated renderer (Default: %d)")) % DEFAULT_QUALITY).str().c_str())
             ("gamma,g", gamma_arg_desc, _("Gamma"))
             ("threads,T", threads_arg_desc, _("Enable multithreaded renderer using the specified number of threads"))
+            ("frame-workers", frame_workers_arg_desc, _("Render the specified number of frames at once, each on its own copy of the canvas"))
+            ("frame-queue", frame_queue_arg_desc, _("Number of rendered frames which may wait to be written (0 disables pipelining, Default: 0)"))
+            ("surface-cache", surface_cache_arg_desc, _("Megabytes of rendered layers kept for the next frames (0 disables the cache, Default: 256)"))
             ("input-file,i", input_file_arg_desc, _("Specify input filename"))
             ("output-file,o", output_file_arg_desc, _("Specify output filename"))
             ("sequence-separator", sequence_separator_arg_desc, _("Output file sequence separator string (Use double quotes if you want to use spaces)"))
@@ -169,6 +175,7 @@ int main(int argc, char* argv[])
             ("verbose,v", verbosity_arg_desc, _("Output verbosity level"))
             ("quiet,q", _("Quiet mode (No progress/time-remaining display)"))
             ("benchmarks,b", _("Print benchmarks"))
+            ("benchmark-threads", _("Render with 1, 2, 4... up to --threads threads without writing the output and print the speedup"))
             ("extract-alpha,x", _("Extract alpha"))
             ;
 
@@ -177,6 +184,7 @@ int main(int argc, char* argv[])
 			("append", append_filename_arg_desc, _("Append layers in <filename> to composition"))
             ("canvas-info", canvas_info_fields_arg_desc, _("Print out specified details of the root canvas"))
             ("canvases", _("Print out the list of exported canvases in the composition"))
+            ("precompile", _("Write the parsed XML of the input file next to it, read instead of the file as long as the file is unchanged"))
             ;
 
         po::options_description po_ffmpeg(_("FFMPEG target options"));
@@ -267,6 +275,9 @@ int main(int argc, char* argv[])
         // Info options -----------------------------------------------
         op.process_info_options();
 
+		// Precompile option ------------------------------------------
+		op.process_precompile_options();
+
 		std::list<Job> job_list;
 
 		// Processing --------------------------------------------------
@@ -43,6 +43,9 @@
 #include <synfig/main.h>
 #include <synfig/importer.h>
 #include <synfig/loadcanvas.h>
+#include <synfig/xmlcache.h>
+#include <synfig/threadpool.h>
+#include <synfig/surfacecache.h>
 #include <synfig/guid.h>
 #include <synfig/filesystemgroup.h>
 #include <synfig/filesystemnative.h>
@@ -163,6 +166,11 @@ void OptionsProcessor::process_settings_options()
 		SynfigToolGeneralOptions::instance()->set_should_print_benchmarks(true);
 	}
 
+	if (_vm.count("benchmark-threads"))
+	{
+		SynfigToolGeneralOptions::instance()->set_should_benchmark_threads(true);
+	}
+
 	if (_vm.count("quiet"))
 	{
 		SynfigToolGeneralOptions::instance()->set_should_be_quiet(true);
@@ -170,11 +178,34 @@ void OptionsProcessor::process_settings_options()
 
 	if (_vm.count("threads"))
 	{
-		SynfigToolGeneralOptions::instance()->set_threads(_vm["threads"].as<size_t>());
+		SynfigToolGeneralOptions::instance()->set_threads(_vm["threads"].as<int>());
+		// the layers which split their work use the shared pool
+		ThreadPool::set_instance_threads(_vm["threads"].as<int>());
 	}
 
 	VERBOSE_OUT(1) << _("Threads set to ")
 				   << SynfigToolGeneralOptions::instance()->get_threads() << std::endl;
+
+	if (_vm.count("frame-workers"))
+	{
+		SynfigToolGeneralOptions::instance()->set_frame_workers(_vm["frame-workers"].as<int>());
+		VERBOSE_OUT(1) << _("Frame workers set to ")
+					   << SynfigToolGeneralOptions::instance()->get_frame_workers() << std::endl;
+	}
+
+	if (_vm.count("frame-queue"))
+	{
+		SynfigToolGeneralOptions::instance()->set_frame_queue_depth(_vm["frame-queue"].as<int>());
+		VERBOSE_OUT(1) << _("Frame queue depth set to ")
+					   << SynfigToolGeneralOptions::instance()->get_frame_queue_depth() << std::endl;
+	}
+
+	if (_vm.count("surface-cache"))
+	{
+		int megabytes = std::max(0, _vm["surface-cache"].as<int>());
+		SurfaceCache::instance().set_budget((size_t)megabytes*1024*1024);
+		VERBOSE_OUT(1) << _("Surface cache set to ") << megabytes << " MB" << std::endl;
+	}
 }
 
 void OptionsProcessor::process_info_options()
@@ -492,6 +523,30 @@ TargetParam OptionsProcessor::extract_targetparam()
 	return params;
 }
 
+void OptionsProcessor::process_precompile_options()
+{
+	if (!_vm.count("precompile"))
+		return;
+
+	if (!_vm.count("input-file"))
+		throw SynfigToolException(SYNFIGTOOL_MISSINGARGUMENT,
+								  _("No input file provided."));
+
+	string filename = _vm["input-file"].as<string>();
+	// todo: literal ".sfg"
+	if (bfs::path(filename).extension().string() == ".sfg")
+		throw SynfigToolException(SYNFIGTOOL_INVALIDJOB,
+								  (boost::format(_("Unable to precompile '%s', files in containers have no cache.")) % filename).str());
+
+	string errors;
+	if (!XMLCache::create(FileSystemNative::instance()->get_identifier(filename), errors))
+		throw SynfigToolException(SYNFIGTOOL_FILENOTFOUND,
+								  (boost::format(_("Unable to precompile '%s': %s")) % filename % errors).str());
+
+	VERBOSE_OUT(1) << _("Cache written to ") << XMLCache::get_filename(filename) << std::endl;
+	throw (SynfigToolException(SYNFIGTOOL_OK));
+}
+
 Job OptionsProcessor::extract_job()
 {
 	Job job;
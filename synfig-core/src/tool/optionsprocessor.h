@@ -44,13 +44,18 @@ public:
 #endif
 
 	/// Settings options
-	/// verbose, quiet, threads, benchmarks
+	/// verbose, quiet, threads, frame-workers, frame-queue, surface-cache, benchmarks, benchmark-threads
 	void process_settings_options();
 
 	/// Information options
 	/// Options that will only display information
 	void process_info_options();
 
+	/// Precompile option
+	/// Writes the cache of the input file which is loaded instead of it
+	/// while the file is unchanged, and exits
+	void process_precompile_options();
+
 	/// Extract the necessary options to create a job
 	/// After this, it is necessary to overwrite the necessary RendDesc options
 	/// and set the target parameters, if provided. Then can be processed
@@ -0,0 +1,159 @@
+/* === S Y N F I G ========================================================= */
+/*!	\file animated.cpp
+**	\brief Animated ValueNode lookup benchmark
+**
+**	$Id$
+**
+**	\legal
+**	Copyright (c) 2016 Synfig contributors
+**
+**	This package is free software; you can redistribute it and/or
+**	modify it under the terms of the GNU General Public License as
+**	published by the Free Software Foundation; either version 2 of
+**	the License, or (at your option) any later version.
+**
+**	This package is distributed in the hope that it will be useful,
+**	but WITHOUT ANY WARRANTY; without even the implied warranty of
+**	MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE. See the GNU
+**	General Public License for more details.
+**	\endlegal
+*/
+/* ========================================================================= */
+
+/* === H E A D E R S ======================================================= */
+
+#ifdef USING_PCH
+#	include "pch.h"
+#else
+#ifdef HAVE_CONFIG_H
+#	include <config.h>
+#endif
+
+#include <cstdio>
+#include <cstdlib>
+#include <cmath>
+#include <vector>
+#include <ETL/clock>
+#include <ETL/stringf>
+#include <synfig/main.h>
+#include <synfig/valuenodes/valuenode_animated.h>
+
+#endif
+
+/* === U S I N G =========================================================== */
+
+using namespace std;
+using namespace etl;
+using namespace synfig;
+
+/* === M A C R O S ========================================================= */
+
+#define WAYPOINTS	10000
+
+/* === G L O B A L S ======================================================= */
+
+/* === P R O C E D U R E S ================================================= */
+
+//! Value of waypoint \a i of the channels
+Real waypoint_value(int i)
+{
+	return sin(i*0.1)*100.0;
+}
+
+//! Creates a real channel with a waypoint every frame at 24 fps
+ValueNode_Animated::Handle create_channel(Interpolation interpolation, Real temporal_tension)
+{
+	ValueNode_Animated::Handle channel(ValueNode_Animated::create(type_real));
+	ValueNode_Animated::WaypointList &list(channel->editable_waypoint_list());
+	for(int i = 0; i < WAYPOINTS; i++)
+	{
+		Waypoint waypoint(ValueBase(waypoint_value(i)), Time(i/24.0));
+		waypoint.set_parent_value_node(channel.get());
+		waypoint.set_before(interpolation);
+		waypoint.set_after(interpolation);
+		waypoint.set_temporal_tension(temporal_tension);
+		list.push_back(waypoint);
+	}
+	// rebuild the curves once, not once per waypoint
+	channel->changed();
+	return channel;
+}
+
+//! Value of \a channel at \a time, found by the binary search alone
+/*!	The lookup before is half the channel away, so the segment it found
+**	can't be the one of \a time or the one next to it */
+Real searched_value(ValueNode_Animated::Handle channel, Time time)
+{
+	const Time half((WAYPOINTS - 1)/48.0);
+	(*channel)(time < half ? time + half : time - half);
+	return (*channel)(time).get(Real());
+}
+
+int sample_test(const char *name, ValueNode_Animated::Handle channel, ValueNode_Animated::Handle reference, float fps)
+{
+	int frames = (int)floor((WAYPOINTS - 1)/24.0*fps);
+	vector<Real> values(frames);
+	etl::clock timer;
+
+	timer.reset();
+	for(int i = 0; i < frames; i++)
+		values[i] = (*channel)(Time(i/fps)).get(Real());
+	float sequential_time = timer();
+
+	// the same samples in random order must give the same values
+	int failures = 0;
+	srand(0);
+	timer.reset();
+	for(int i = 0; i < frames; i++)
+	{
+		int frame = rand() % frames;
+		if ((*channel)(Time(frame/fps)).get(Real()) != values[frame])
+			failures++;
+	}
+	float random_time = timer();
+
+	printf("%s, %d waypoints, %.0f fps: sequential %.3f us/sample, random %.3f us/sample\n",
+		name, WAYPOINTS, fps,
+		sequential_time*1000000.0f/frames, random_time*1000000.0f/frames);
+	if (failures)
+		printf("%s: %d samples differ in random order\n", name, failures);
+
+	// the segments found through the hint must be the ones of the search
+	int search_failures = 0;
+	for(int i = 0; i < frames; i++)
+		if (searched_value(reference, Time(i/fps)) != values[i])
+			search_failures++;
+	if (search_failures)
+		printf("%s: %d samples differ from the binary search\n", name, search_failures);
+
+	// and the curve must pass through the waypoints
+	int waypoint_failures = 0;
+	for(int i = 0; i < WAYPOINTS; i++)
+		if (fabs((*channel)(Time(i/24.0)).get(Real()) - waypoint_value(i)) > 1e-6)
+			waypoint_failures++;
+	if (waypoint_failures)
+		printf("%s: %d samples differ from their waypoints\n", name, waypoint_failures);
+
+	return failures || search_failures || waypoint_failures ? 1 : 0;
+}
+
+/* === E N T R Y P O I N T ================================================= */
+
+int main(int /*argc*/, char *argv[])
+{
+	Main synfig_main(dirname(argv[0]));
+
+	int failures = 0;
+
+	ValueNode_Animated::Handle clamped(create_channel(INTERPOLATION_CLAMPED, 0.0));
+	ValueNode_Animated::Handle clamped_reference(create_channel(INTERPOLATION_CLAMPED, 0.0));
+	failures += sample_test("clamped", clamped, clamped_reference, 24);
+	failures += sample_test("clamped", clamped, clamped_reference, 60);
+
+	ValueNode_Animated::Handle tension(create_channel(INTERPOLATION_TCB, 0.5));
+	ValueNode_Animated::Handle tension_reference(create_channel(INTERPOLATION_TCB, 0.5));
+	failures += sample_test("tcb, temporal tension", tension, tension_reference, 24);
+	failures += sample_test("tcb, temporal tension", tension, tension_reference, 60);
+
+	return failures;
+}
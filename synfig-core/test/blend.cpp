@@ -0,0 +1,145 @@
+/* === S Y N F I G ========================================================= */
+/*!	\file blend.cpp
+**	\brief Per-pixel and span blending benchmark
+**
+**	$Id$
+**
+**	\legal
+**	Copyright (c) 2016 Synfig contributors
+**
+**	This package is free software; you can redistribute it and/or
+**	modify it under the terms of the GNU General Public License as
+**	published by the Free Software Foundation; either version 2 of
+**	the License, or (at your option) any later version.
+**
+**	This package is distributed in the hope that it will be useful,
+**	but WITHOUT ANY WARRANTY; without even the implied warranty of
+**	MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE. See the GNU
+**	General Public License for more details.
+**	\endlegal
+*/
+/* ========================================================================= */
+
+/* === H E A D E R S ======================================================= */
+
+#ifdef USING_PCH
+#	include "pch.h"
+#else
+#ifdef HAVE_CONFIG_H
+#	include <config.h>
+#endif
+
+#include <cstdio>
+#include <cstdlib>
+#include <cmath>
+#include <vector>
+#include <algorithm>
+#include <ETL/clock>
+#include <synfig/color.h>
+#include <synfig/color/colorblendingspans.h>
+
+#endif
+
+/* === U S I N G =========================================================== */
+
+using namespace std;
+using namespace etl;
+using namespace synfig;
+
+/* === M A C R O S ========================================================= */
+
+#define PIXELS		(1920*1080)
+#define TOLERANCE	1e-4f
+
+/* === G L O B A L S ======================================================= */
+
+static const char *blend_method_names[Color::BLEND_END] =
+{
+	"composite", "straight", "brighten", "darken", "add",
+	"subtract", "multiply", "divide", "color", "hue",
+	"saturation", "luminance", "behind", "onto", "alpha brighten",
+	"alpha darken", "screen", "hard light", "difference", "alpha over",
+	"overlay", "straight onto"
+};
+
+/* === P R O C E D U R E S ================================================= */
+
+float random_real()
+	{ return (float)rand()/(float)RAND_MAX; }
+
+Color random_color()
+	{ return Color(random_real(), random_real(), random_real(), random_real()); }
+
+//! Returns \c true if the channels differ by more than the tolerance, relative to their size
+bool differ(float a, float b)
+{
+	// NaN is never equal to itself
+	if (a != a || b != b)
+		return (a != a) != (b != b);
+	return fabsf(a - b) > TOLERANCE*std::max(1.0f, std::max(fabsf(a), fabsf(b)));
+}
+
+bool differ(const Color &a, const Color &b)
+{
+	return differ(a.get_r(), b.get_r()) || differ(a.get_g(), b.get_g())
+	    || differ(a.get_b(), b.get_b()) || differ(a.get_a(), b.get_a());
+}
+
+int blend_test(Color::BlendMethod method, float amount, const vector<Color> &src, const vector<Color> &dest)
+{
+	vector<Color> pixel_result(dest), span_result(dest);
+	etl::clock timer;
+
+	timer.reset();
+	for(int i = 0; i < PIXELS; i++)
+		pixel_result[i] = Color::blend(src[i], pixel_result[i], amount, method);
+	float pixel_time = timer();
+
+	// blend by rows, like Surface::blit_to() does
+	timer.reset();
+	for(int i = 0; i < PIXELS; i += 1920)
+		Color::blend_span(&span_result[i], &src[i], 1920, amount, method);
+	float span_time = timer();
+
+	int failures = 0;
+	for(int i = 0; i < PIXELS; i++)
+		if (differ(pixel_result[i], span_result[i]))
+			failures++;
+
+	printf("%-14s amount %5.2f: per pixel %7.2f Mpx/s, span %7.2f Mpx/s (x%.1f)\n",
+		blend_method_names[method], amount,
+		PIXELS/pixel_time/1000000.0f, PIXELS/span_time/1000000.0f, pixel_time/span_time);
+	if (failures)
+		printf("%s: %d pixels differ\n", blend_method_names[method], failures);
+	return failures ? 1 : 0;
+}
+
+/* === E N T R Y P O I N T ================================================= */
+
+int main()
+{
+	srand(0);
+	vector<Color> src(PIXELS), dest(PIXELS);
+	for(int i = 0; i < PIXELS; i++)
+	{
+		src[i] = random_color();
+		dest[i] = random_color();
+	}
+	// fully transparent colors take their own branches
+	for(int i = 0; i < PIXELS; i += 7)
+		src[i].set_a(0);
+	for(int i = 0; i < PIXELS; i += 11)
+		dest[i].set_a(0);
+
+	printf("span instruction set: %s\n", get_blend_span_isa());
+
+	int failures = 0;
+	for(int method = 0; method < Color::BLEND_END; method++)
+	{
+		failures += blend_test((Color::BlendMethod)method, 1.0f, src, dest);
+		failures += blend_test((Color::BlendMethod)method, 0.6f, src, dest);
+		failures += blend_test((Color::BlendMethod)method, -0.6f, src, dest);
+	}
+
+	return failures;
+}
@@ -0,0 +1,184 @@
+/* === S Y N F I G ========================================================= */
+/*!	\file blur.cpp
+**	\brief Surface blur correctness check and benchmark
+**
+**	$Id$
+**
+**	\legal
+**	Copyright (c) 2016 Synfig contributors
+**
+**	This package is free software; you can redistribute it and/or
+**	modify it under the terms of the GNU General Public License as
+**	published by the Free Software Foundation; either version 2 of
+**	the License, or (at your option) any later version.
+**
+**	This package is distributed in the hope that it will be useful,
+**	but WITHOUT ANY WARRANTY; without even the implied warranty of
+**	MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE. See the GNU
+**	General Public License for more details.
+**	\endlegal
+*/
+/* ========================================================================= */
+
+/* === H E A D E R S ======================================================= */
+
+#ifdef USING_PCH
+#	include "pch.h"
+#else
+#ifdef HAVE_CONFIG_H
+#	include <config.h>
+#endif
+
+#include <cstdio>
+#include <cstdlib>
+#include <cmath>
+#include <algorithm>
+#include <ETL/clock>
+#include <synfig/general.h>
+#include <synfig/surface.h>
+#include <synfig/blur.h>
+
+#endif
+
+/* === U S I N G =========================================================== */
+
+using namespace std;
+using namespace etl;
+using namespace synfig;
+
+/* === M A C R O S ========================================================= */
+
+#define TOLERANCE	1e-4f
+
+/* === G L O B A L S ======================================================= */
+
+static const char *blur_type_names[] =
+	{ "box", "fast gaussian", "cross", "gaussian", "disc" };
+
+/* === P R O C E D U R E S ================================================= */
+
+float random_real()
+	{ return (float)rand()/(float)RAND_MAX; }
+
+//! Opaque random colors, so the alpha premultiplication does not matter
+void random_surface(Surface &surface, int w, int h)
+{
+	surface.set_wh(w, h);
+	for(int y = 0; y < h; y++)
+		for(int x = 0; x < w; x++)
+			surface[y][x] = Color(random_real(), random_real(), random_real(), 1);
+}
+
+const Color& clamped(const Surface &surface, int x, int y)
+{
+	x = max(0, min(surface.get_w() - 1, x));
+	y = max(0, min(surface.get_h() - 1, y));
+	return surface[y][x];
+}
+
+//! The plain per pixel average over a rectangle or an ellipse
+Color reference(const Surface &surface, int x, int y, int bw, int bh, bool disc)
+{
+	Color color = Color::alpha();
+	int total = 0;
+	for(int y2 = -bh; y2 <= bh; y2++)
+		for(int x2 = -bw; x2 <= bw; x2++)
+		{
+			float tmp_x = (float)x2/bw, tmp_y = (float)y2/bh;
+			if (disc && tmp_x*tmp_x + tmp_y*tmp_y > 1.0)
+				continue;
+			color += clamped(surface, x + x2, y + y2);
+			total++;
+		}
+	return color/total;
+}
+
+bool differ(const Color &a, const Color &b)
+{
+	return fabsf(a.get_r() - b.get_r()) > TOLERANCE || fabsf(a.get_g() - b.get_g()) > TOLERANCE
+	    || fabsf(a.get_b() - b.get_b()) > TOLERANCE || fabsf(a.get_a() - b.get_a()) > TOLERANCE;
+}
+
+//! Compares box and disc blurs with the plain averages
+int accuracy_test(int type, Real size_x, Real size_y)
+{
+	const int w = 61, h = 47;
+	Surface surface, out;
+	random_surface(surface, w, h);
+
+	// one unit per pixel
+	Blur(size_x, size_y, type)(surface, Vector(w, h), out);
+
+	int bw = (int)(size_x*.5 + 1), bh = (int)(size_y*.5 + 1);
+	int failures = 0;
+	for(int y = 0; y < h; y++)
+		for(int x = 0; x < w; x++)
+			if (differ(out[y][x], reference(surface, x, y, bw, bh, type == Blur::DISC)))
+				failures++;
+
+	if (failures)
+		printf("%s %gx%g: %d pixels differ\n", blur_type_names[type], size_x, size_y, failures);
+	return failures ? 1 : 0;
+}
+
+//! A blur must keep a flat surface flat
+int flat_test(int type)
+{
+	const int w = 200, h = 120;
+	const Color color(0.25, 0.5, 0.75, 1);
+	Surface surface(w, h), out;
+	surface.fill(color);
+
+	Blur(40, 25, type)(surface, Vector(w, h), out);
+
+	int failures = 0;
+	for(int y = 0; y < h; y++)
+		for(int x = 0; x < w; x++)
+			if (differ(out[y][x], color))
+				failures++;
+
+	if (failures)
+		printf("%s: %d pixels of a flat surface changed\n", blur_type_names[type], failures);
+	return failures ? 1 : 0;
+}
+
+void benchmark(int w, int h)
+{
+	static const int radii[] = { 2, 8, 32, 128 };
+	Surface surface, out;
+	random_surface(surface, w, h);
+	etl::clock timer;
+
+	for(int type = Blur::BOX; type <= Blur::DISC; type++)
+	{
+		printf("%4dx%-4d %-14s", w, h, blur_type_names[type]);
+		for(int i = 0; i < (int)(sizeof(radii)/sizeof(radii[0])); i++)
+		{
+			timer.reset();
+			Blur(2*radii[i], 2*radii[i], type)(surface, Vector(w, h), out);
+			printf("  r%-3d %8.2f ms", radii[i], timer()*1000.0);
+		}
+		printf("\n");
+	}
+}
+
+/* === E N T R Y P O I N T ================================================= */
+
+int main()
+{
+	srand(0);
+
+	int failures = 0;
+	failures += accuracy_test(Blur::BOX, 6, 6);
+	failures += accuracy_test(Blur::BOX, 13, 4);
+	failures += accuracy_test(Blur::DISC, 6, 6);
+	failures += accuracy_test(Blur::DISC, 20, 9);
+	failures += accuracy_test(Blur::DISC, 3, 70);
+	for(int type = Blur::BOX; type <= Blur::DISC; type++)
+		failures += flat_test(type);
+
+	benchmark(640, 360);
+	benchmark(1920, 1080);
+
+	return failures;
+}
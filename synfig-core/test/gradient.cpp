@@ -0,0 +1,210 @@
+/* === S Y N F I G ========================================================= */
+/*!	\file gradient.cpp
+**	\brief Compiled gradient correctness check and benchmark
+**
+**	$Id$
+**
+**	\legal
+**	Copyright (c) 2016 Synfig contributors
+**
+**	This package is free software; you can redistribute it and/or
+**	modify it under the terms of the GNU General Public License as
+**	published by the Free Software Foundation; either version 2 of
+**	the License, or (at your option) any later version.
+**
+**	This package is distributed in the hope that it will be useful,
+**	but WITHOUT ANY WARRANTY; without even the implied warranty of
+**	MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE. See the GNU
+**	General Public License for more details.
+**	\endlegal
+*/
+/* ========================================================================= */
+
+/* === H E A D E R S ======================================================= */
+
+#ifdef USING_PCH
+#	include "pch.h"
+#else
+#ifdef HAVE_CONFIG_H
+#	include <config.h>
+#endif
+
+#include <cstdio>
+#include <cstdlib>
+#include <cmath>
+#include <cstring>
+#include <vector>
+#include <algorithm>
+#include <ETL/clock>
+#include <synfig/gradient.h>
+
+#endif
+
+/* === U S I N G =========================================================== */
+
+using namespace std;
+using namespace etl;
+using namespace synfig;
+
+/* === M A C R O S ========================================================= */
+
+/* === G L O B A L S ======================================================= */
+
+/* === P R O C E D U R E S ================================================= */
+
+Real random_real()
+	{ return (Real)rand()/(Real)RAND_MAX; }
+
+Color random_color()
+	{ return Color(random_real(), random_real(), random_real(), random_real() < 0.3 ? 1.0 : random_real()); }
+
+//! Random cpoints over [-0.2, 1.2], with hard steps and a fully transparent one now and then
+Gradient random_gradient(int count)
+{
+	Gradient gradient;
+	for(int i = 0; i < count; i++)
+	{
+		Real pos = random_real()*1.4 - 0.2;
+		Color color = i % 7 == 3 ? Color::alpha() : random_color();
+		gradient.push_back(Gradient::CPoint(pos, color));
+		if (i % 5 == 4)
+			gradient.push_back(Gradient::CPoint(pos, random_color()));
+	}
+	gradient.sort();
+	return gradient;
+}
+
+//! The way the gradient layers look up a color, as in LinearGradient
+Color layer_color(const Gradient &gradient, bool loop, bool zigzag, Real dist, Real supersample)
+{
+	if(loop)
+		dist-=floor(dist);
+
+	if(zigzag)
+	{
+		dist*=2.0;
+		supersample*=2.0;
+		if(dist>1)dist=2.0-dist;
+	}
+
+	if(loop)
+	{
+		if(dist+supersample*0.5>1.0)
+		{
+			Real  left(supersample*0.5-(dist-1.0));
+			Real right(supersample*0.5+(dist-1.0));
+			Color pool(gradient(1.0-(left*0.5),left).premult_alpha()*left/supersample);
+			if (zigzag) pool+=gradient(1.0-right*0.5,right).premult_alpha()*right/supersample;
+			else		pool+=gradient(right*0.5,right).premult_alpha()*right/supersample;
+			return pool.demult_alpha();
+		}
+		if(dist-supersample*0.5<0.0)
+		{
+			Real  left(supersample*0.5-dist);
+			Real right(supersample*0.5+dist);
+			Color pool(gradient(right*0.5,right).premult_alpha()*right/supersample);
+			if (zigzag) pool+=gradient(left*0.5,left).premult_alpha()*left/supersample;
+			else		pool+=gradient(1.0-left*0.5,left).premult_alpha()*left/supersample;
+			return pool.demult_alpha();
+		}
+	}
+	return gradient(dist,supersample);
+}
+
+//! Largest difference of the premultiplied channels
+Real difference(const Color &a, const Color &b)
+{
+	Color pa = a.premult_alpha(), pb = b.premult_alpha();
+	return max(max(fabs(pa.get_r() - pb.get_r()), fabs(pa.get_g() - pb.get_g())),
+	           max(fabs(pa.get_b() - pb.get_b()), fabs(pa.get_a() - pb.get_a())));
+}
+
+//! The compiled gradient must give the colors of Gradient::operator()
+int accuracy_test(int count, bool loop, bool zigzag)
+{
+	int failures = 0;
+	Real worst = 0;
+	for(int g = 0; g < 20; g++)
+	{
+		Gradient gradient = random_gradient(count);
+		Real resolution = 0.0005 + random_real()*0.01;
+		CompiledGradient compiled(gradient, loop, zigzag, resolution);
+		CompiledGradient baked(gradient, loop, zigzag, resolution, resolution);
+		for(int i = 0; i < 2000; i++)
+		{
+			Real x = random_real()*3.0 - 1.0;
+			Real supersample = i % 10 ? resolution*(1.0 + random_real()*4.0) : 0.0;
+			Real diff = max(
+				difference(layer_color(gradient, loop, zigzag, x, supersample), compiled(x, supersample)),
+				difference(layer_color(gradient, loop, zigzag, x, resolution), baked(x)) );
+			worst = max(worst, diff);
+			if (diff > 1e-4)
+				failures++;
+		}
+
+		// a span over a few loops, at the supersample given to the constructor
+		Color span[256];
+		Real x = random_real()*2.0 - 1.0, dx = resolution*10.0*random_real();
+		baked.fill(span, 256, x, dx);
+		for(int i = 0; i < 256; i++)
+		{
+			Real diff = difference(layer_color(gradient, loop, zigzag, x + i*dx, resolution), span[i]);
+			worst = max(worst, diff);
+			if (diff > 1e-4)
+				failures++;
+		}
+	}
+
+	if (failures)
+		printf("%d cpoints%s%s: %d colors differ, by up to %f\n",
+			count, loop ? ", loop" : "", zigzag ? ", zigzag" : "", failures, worst);
+	return failures ? 1 : 0;
+}
+
+void benchmark(int count, bool loop)
+{
+	const int w = 1920, h = 108;
+	Gradient gradient = random_gradient(count);
+	const Real supersample = 1.0/w;
+	std::vector<Color> row(w), surface(w*h);
+
+	etl::clock timer;
+	for(int y = 0; y < h; y++)
+		for(int x = 0; x < w; x++)
+			surface[y*w + x] = layer_color(gradient, loop, false, (x + y*0.1)*supersample, supersample);
+	Real direct_time = timer();
+
+	timer.reset();
+	CompiledGradient compiled(gradient, loop, false, supersample, supersample);
+	for(int y = 0; y < h; y++)
+		compiled.fill(&surface[y*w], w, y*0.1*supersample, supersample);
+	Real compiled_time = timer();
+
+	timer.reset();
+	for(int y = 0; y < h; y++)
+		memcpy(&surface[y*w], &row[0], w*sizeof(Color));
+	Real copy_time = timer();
+
+	printf("%3d cpoints%s: direct %8.1f Mpixels/s, compiled %8.1f Mpixels/s, copy %8.1f Mpixels/s\n",
+		count, loop ? ", loop" : "      ",
+		w*h/direct_time*1e-6, w*h/compiled_time*1e-6, w*h/copy_time*1e-6);
+}
+
+/* === E N T R Y P O I N T ================================================= */
+
+int main()
+{
+	srand(0);
+
+	int failures = 0;
+	for(int count = 1; count <= 32; count *= 2)
+		for(int mode = 0; mode < 4; mode++)
+			failures += accuracy_test(count, mode & 1, mode & 2);
+
+	benchmark(2, false);
+	benchmark(8, false);
+	benchmark(8, true);
+	benchmark(32, false);
+
+	return failures;
+}
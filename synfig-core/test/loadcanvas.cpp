@@ -0,0 +1,525 @@
+/* === S Y N F I G ========================================================= */
+/*!	\file loadcanvas.cpp
+**	\brief Streaming XML reader, cache and canvas round trip check, and parse time and memory benchmark against the DOM
+**
+**	$Id$
+**
+**	\legal
+**	Copyright (c) 2016 Synfig contributors
+**
+**	This package is free software; you can redistribute it and/or
+**	modify it under the terms of the GNU General Public License as
+**	published by the Free Software Foundation; either version 2 of
+**	the License, or (at your option) any later version.
+**
+**	This package is distributed in the hope that it will be useful,
+**	but WITHOUT ANY WARRANTY; without even the implied warranty of
+**	MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE. See the GNU
+**	General Public License for more details.
+**	\endlegal
+*/
+/* ========================================================================= */
+
+/* === H E A D E R S ======================================================= */
+
+#ifdef USING_PCH
+#	include "pch.h"
+#else
+#ifdef HAVE_CONFIG_H
+#	include <config.h>
+#endif
+
+#include <cstdio>
+#include <cstdlib>
+#include <iterator>
+#include <vector>
+#include <unistd.h>
+#include <spawn.h>
+#include <sys/wait.h>
+#include <sys/resource.h>
+#include <libxml++/libxml++.h>
+#include <ETL/clock>
+#include <ETL/stringf>
+#include <synfig/real.h>
+#include <synfig/main.h>
+#include <synfig/canvas.h>
+#include <synfig/loadcanvas.h>
+#include <synfig/savecanvas.h>
+#include <synfig/filesystemnative.h>
+#include <synfig/zstreambuf.h>
+#include <synfig/xmlreader.h>
+#include <synfig/xmlcache.h>
+
+#endif
+
+/* === U S I N G =========================================================== */
+
+using namespace std;
+using namespace etl;
+using namespace synfig;
+
+/* === M A C R O S ========================================================= */
+
+#ifndef EXAMPLES_DIR
+#define EXAMPLES_DIR "../examples"
+#endif
+
+#ifndef REFERENCE_DIR
+#define REFERENCE_DIR "loadcanvas-reference"
+#endif
+
+#define ROUNDS	5
+
+/* === G L O B A L S ======================================================= */
+
+static const char *examples[] = {
+	"about_dialog.sifz", "backdrop.sifz", "business_card.sifz", "candy.sifz",
+	"cells.sifz", "eye.sifz", "eyes.sifz", "gamma.sifz", "gradient.sifz",
+	"headmo.sifz", "installer-logo.sifz", "japan.sifz", "logo.sifz",
+	"macwolfen.sifz", "mandelbrot.sifz", "newjulia.sifz", "newjulia2.sifz",
+	"noise.sifz", "pirates.sifz", "preambletaffy.sifz", "prologue_kid.sifz",
+	"sparkle.sifz", "splat.sifz", "star.sifz", "wallpaper.sifz",
+	"warpcube.sifz", "warptext.sifz", "z_depth_test.sifz",
+	NULL };
+
+/* === P R O C E D U R E S ================================================= */
+
+FileSystem::ReadStreamHandle open_example(const String &filename)
+{
+	FileSystem::ReadStreamHandle stream =
+		FileSystemNative::instance()->get_read_stream(String(EXAMPLES_DIR) + "/" + filename);
+	if (stream && filename_extension(filename) == ".sifz")
+		stream = FileSystem::ReadStreamHandle(new ZReadStream(stream));
+	return stream;
+}
+
+//! Elements whose text is read, the way CanvasParser reads it
+bool has_text(const String &name)
+{
+	return name == "string" || name == "name" || name == "desc" || name == "author"
+	    || name == "keyframe" || name == "x" || name == "y"
+	    || name == "r" || name == "g" || name == "b" || name == "a";
+}
+
+//! Writes the elements under \a node to \a out, as the loader read them from the DOM
+void dump(const xmlpp::Element *node, String &out)
+{
+	out += strprintf("%s %d", node->get_name().c_str(), node->get_line());
+	const xmlpp::Element::AttributeList attributes = node->get_attributes();
+	for(xmlpp::Element::AttributeList::const_iterator i = attributes.begin(); i != attributes.end(); ++i)
+		out += " " + (*i)->get_name() + "=" + (*i)->get_value();
+	out += "\n";
+
+	const xmlpp::Node::NodeList children = node->get_children();
+	if (has_text(node->get_name()))
+	{
+		for(xmlpp::Node::NodeList::const_iterator i = children.begin(); i != children.end(); ++i)
+			if (const xmlpp::ContentNode *text = dynamic_cast<const xmlpp::ContentNode*>(*i))
+				if (dynamic_cast<const xmlpp::TextNode*>(*i) || dynamic_cast<const xmlpp::CdataNode*>(*i))
+					out += text->get_content();
+		out += "\n";
+		return;
+	}
+	for(xmlpp::Node::NodeList::const_iterator i = children.begin(); i != children.end(); ++i)
+		if (const xmlpp::Element *child = dynamic_cast<const xmlpp::Element*>(*i))
+			dump(child, out);
+}
+
+//! Writes the elements under \a element to \a out, as the loader reads them now
+void dump(XMLElement *element, String &out)
+{
+	out += strprintf("%s %d", element->get_name().c_str(), element->get_line());
+	for(int i = 0; i < element->get_attribute_count(); i++)
+		out += " " + element->get_attribute_at(i).get_name() + "=" + element->get_attribute_at(i).get_value();
+	out += "\n";
+
+	if (has_text(element->get_name()))
+	{
+		out += element->get_child_text();
+		out += "\n";
+		return;
+	}
+	for(XMLElement child(element); child.next(); )
+		dump(&child, out);
+}
+
+String dump_dom(const String &filename)
+{
+	String out;
+	FileSystem::ReadStreamHandle stream = open_example(filename);
+	xmlpp::DomParser parser;
+	parser.parse_stream(*stream);
+	if (parser)
+		dump(parser.get_document()->get_root_node(), out);
+	return out;
+}
+
+String dump_reader(XMLReader &reader)
+{
+	String out;
+	XMLElement root(reader);
+	if (root.next())
+		dump(&root, out);
+	return out;
+}
+
+String dump_stream(const String &filename)
+{
+	FileSystem::ReadStreamHandle stream = open_example(filename);
+	XMLReader reader;
+	reader.open_stream(*stream, filename);
+	return dump_reader(reader);
+}
+
+//! Names of the children of the root element, read by \a reader with the first grandchild of each left half read
+String partly_read_children(XMLReader &reader)
+{
+	String names;
+	XMLElement root(reader);
+	if (root.next())
+		for(XMLElement child(&root); child.next(); )
+		{
+			names += child.get_name() + "\n";
+			XMLElement(&child).next();
+		}
+	return names;
+}
+
+String dom_children(const String &filename)
+{
+	String names;
+	FileSystem::ReadStreamHandle stream = open_example(filename);
+	xmlpp::DomParser parser;
+	parser.parse_stream(*stream);
+	const xmlpp::Node::NodeList children = parser.get_document()->get_root_node()->get_children();
+	for(xmlpp::Node::NodeList::const_iterator i = children.begin(); i != children.end(); ++i)
+		if (dynamic_cast<const xmlpp::Element*>(*i))
+			names += (*i)->get_name() + "\n";
+	return names;
+}
+
+//! Copy of an example in the current directory, with its cache next to it
+FileSystem::Identifier cached_example(const String &filename)
+{
+	FileSystem::Identifier copy = FileSystemNative::instance()->get_identifier("cache-" + filename);
+	String errors;
+	if (!FileSystem::copy(FileSystemNative::instance(), String(EXAMPLES_DIR) + "/" + filename, copy.file_system, copy.filename)
+	 || !XMLCache::create(copy, errors))
+		printf("%s: the cache can't be written: %s\n", filename.c_str(), errors.c_str());
+	return copy;
+}
+
+void remove_cached_example(const FileSystem::Identifier &copy)
+{
+	copy.file_system->file_remove(copy.filename);
+	copy.file_system->file_remove(XMLCache::get_filename(copy.filename));
+}
+
+//! The streaming reader sees the same elements, attributes and text as the DOM
+int reader_test(const String &filename)
+{
+	String dom = dump_dom(filename), stream = dump_stream(filename);
+	if (dom.empty() || dom != stream)
+	{
+		printf("%s: the streaming reader and the DOM differ\n", filename.c_str());
+		return 1;
+	}
+
+	// leaving the children half read has to resume at the next one
+	FileSystem::ReadStreamHandle file = open_example(filename);
+	XMLReader reader;
+	reader.open_stream(*file, filename);
+	if (partly_read_children(reader) != dom_children(filename))
+	{
+		printf("%s: the streaming reader lost its place after a partly read element\n", filename.c_str());
+		return 1;
+	}
+	return 0;
+}
+
+//! Reading the cache gives the same as reading the document, as long as the document is unchanged
+int cache_test(const String &filename)
+{
+	int failures = 0;
+	FileSystem::Identifier copy = cached_example(filename);
+	XMLCache cache;
+	XMLReader reader;
+	if (!cache.open(copy))
+	{
+		printf("%s: the cache can't be opened\n", filename.c_str());
+		failures++;
+	}
+	else
+	{
+		reader.open_cache(cache);
+		if (dump_reader(reader) != dump_dom(filename))
+		{
+			printf("%s: the cache and the DOM differ\n", filename.c_str());
+			failures++;
+		}
+		reader.open_cache(cache);
+		if (partly_read_children(reader) != dom_children(filename))
+		{
+			printf("%s: the cache reader lost its place after a partly read element\n", filename.c_str());
+			failures++;
+		}
+		reader.close();
+		cache.close();
+	}
+
+	// one more byte in the document makes the cache stale
+	FileSystem::ReadStreamHandle in = copy.get_read_stream();
+	String data((istreambuf_iterator<char>(*in)), istreambuf_iterator<char>());
+	in.reset();
+	data += '\n';
+	FileSystem::WriteStreamHandle out = copy.get_write_stream();
+	out->write_whole_block(data.data(), data.size());
+	out.reset();
+	if (cache.open(copy))
+	{
+		printf("%s: the cache is used after the document changed\n", filename.c_str());
+		failures++;
+	}
+
+	remove_cached_example(copy);
+	return failures;
+}
+
+//! Loads a document with CanvasParser and saves it again
+String load_and_save(const FileSystem::Identifier &identifier, String &errors)
+{
+	String warnings;
+	Canvas::Handle canvas = open_canvas_as(identifier, absolute_path(identifier.filename), errors, warnings);
+	return canvas ? canvas_to_string(canvas) : String();
+}
+
+//! Loads the text of a document with CanvasParser and saves it again
+String load_and_save_string(const String &text, const FileSystem::Identifier &identifier, String &errors)
+{
+	String warnings;
+	Canvas::Handle canvas = open_canvas_from_string_as(text, identifier, absolute_path(identifier.filename), errors, warnings);
+	return canvas ? canvas_to_string(canvas) : String();
+}
+
+//! \a saved with the GUIDs which are not in \a source left empty
+/*!	Value nodes without a GUID in the document get a random one when they
+**	are loaded, so those differ between any two loads */
+String without_new_guids(String saved, const String &source)
+{
+	for(String::size_type i = saved.find(" guid=\""); i != String::npos; i = saved.find(" guid=\"", i + 1))
+	{
+		String::size_type begin = i + 7, end = saved.find('"', begin);
+		if (end != String::npos && source.find(saved.substr(begin, end - begin)) == String::npos)
+			saved.erase(begin, end - begin);
+	}
+	return saved;
+}
+
+String example_path(const String &filename)
+{
+	return String(EXAMPLES_DIR) + "/" + filename;
+}
+
+//! File with the saved example, as the parser of the DOM built it, compressed
+String reference_path(const String &filename)
+{
+	return String(REFERENCE_DIR) + "/" + filename_sans_extension(filename) + ".sifz";
+}
+
+//! Writes the reference of every example into REFERENCE_DIR
+/*!	To be run by a build whose parser is known to be right, the references
+**	are then compared with what the current parser builds */
+int save_references()
+{
+	int failures = 0;
+	FileSystemNative::instance()->directory_create(REFERENCE_DIR);
+	for(const char **i = examples; *i; i++)
+	{
+		String errors;
+		String saved = load_and_save(FileSystemNative::instance()->get_identifier(example_path(*i)), errors);
+		FileSystem::WriteStreamHandle out = saved.empty() ? FileSystem::WriteStreamHandle()
+			: FileSystemNative::instance()->get_write_stream(reference_path(*i));
+		if (out)
+			out = FileSystem::WriteStreamHandle(new ZWriteStream(out));
+		if (!out || !out->write_whole_block(saved.data(), saved.size()))
+		{
+			printf("%s: the reference can't be written: %s\n", *i, errors.c_str());
+			failures++;
+		}
+	}
+	return failures;
+}
+
+//! A loaded example saves as its reference, and saving and loading it again settles
+/*!	Times and angles may be rounded by the first save, so the canvas saved a
+**	second time only has to be the same as the one saved a third time */
+int round_trip_test(const String &filename)
+{
+	String errors;
+	FileSystem::Identifier identifier = FileSystemNative::instance()->get_identifier(example_path(filename));
+	String saved = load_and_save(identifier, errors);
+	if (saved.empty())
+	{
+		printf("%s: the canvas can't be loaded: %s\n", filename.c_str(), errors.c_str());
+		return 1;
+	}
+
+	FileSystem::ReadStreamHandle source = open_example(filename);
+	String source_text((istreambuf_iterator<char>(*source)), istreambuf_iterator<char>());
+	source.reset();
+
+	int failures = 0;
+	FileSystem::ReadStreamHandle in = FileSystemNative::instance()->get_read_stream(reference_path(filename));
+	if (in)
+		in = FileSystem::ReadStreamHandle(new ZReadStream(in));
+	if (!in)
+	{
+		printf("%s: there is no reference %s, written by \"loadcanvas --save-references\"\n", filename.c_str(), reference_path(filename).c_str());
+		failures++;
+	}
+	else
+	if (without_new_guids(String((istreambuf_iterator<char>(*in)), istreambuf_iterator<char>()), source_text)
+	 != without_new_guids(saved, source_text))
+	{
+		printf("%s: the saved canvas differs from %s\n", filename.c_str(), reference_path(filename).c_str());
+		failures++;
+	}
+
+	String resaved = load_and_save_string(saved, identifier, errors);
+	if (resaved.empty() || load_and_save_string(resaved, identifier, errors) != resaved)
+	{
+		printf("%s: the saved canvas keeps changing when it is loaded and saved again\n", filename.c_str());
+		failures++;
+	}
+	return failures;
+}
+
+//! Walks the whole document the way the old loader did: DOM first, then its nodes
+void walk_dom(const xmlpp::Element *node, int &count)
+{
+	count++;
+	const xmlpp::Node::NodeList children = node->get_children();
+	for(xmlpp::Node::NodeList::const_iterator i = children.begin(); i != children.end(); ++i)
+		if (const xmlpp::Element *child = dynamic_cast<const xmlpp::Element*>(*i))
+			walk_dom(child, count);
+}
+
+void walk_stream(XMLElement *element, int &count)
+{
+	count++;
+	for(XMLElement child(element); child.next(); )
+		walk_stream(&child, count);
+}
+
+int parse_dom(const String &filename)
+{
+	int count = 0;
+	FileSystem::ReadStreamHandle stream = open_example(filename);
+	xmlpp::DomParser parser;
+	parser.parse_stream(*stream);
+	if (parser)
+		walk_dom(parser.get_document()->get_root_node(), count);
+	return count;
+}
+
+int parse_stream(const String &filename)
+{
+	int count = 0;
+	FileSystem::ReadStreamHandle stream = open_example(filename);
+	XMLReader reader;
+	reader.open_stream(*stream, filename);
+	XMLElement root(reader);
+	if (root.next())
+		walk_stream(&root, count);
+	return count;
+}
+
+//! Walks the cache of the copy of the example written by cached_example()
+int parse_cache(const String &filename)
+{
+	int count = 0;
+	XMLCache cache;
+	if (!cache.open(FileSystemNative::instance()->get_identifier("cache-" + filename)))
+		return count;
+	XMLReader reader;
+	reader.open_cache(cache);
+	XMLElement root(reader);
+	if (root.next())
+		walk_stream(&root, count);
+	return count;
+}
+
+//! Parses every example in a new process running this program, and returns the peak resident set size of that process in kB
+/*!	The peak of this process until then counts as well, so it has to be called before anything big is loaded */
+long peak_memory(const char *program, const char *parser)
+{
+	pid_t pid;
+	char *argv[] = { const_cast<char*>(program), const_cast<char*>(parser), NULL };
+	if (posix_spawn(&pid, program, NULL, NULL, argv, environ))
+		return -1;
+	int status;
+	struct rusage usage;
+	if (wait4(pid, &status, 0, &usage) != pid || !WIFEXITED(status) || WEXITSTATUS(status))
+		return -1;
+	return usage.ru_maxrss;
+}
+
+//! Seconds to parse every example once, best of several rounds
+Real parse_time(int (*parse)(const String &))
+{
+	Real best = 0;
+	for(int round = 0; round < ROUNDS; round++)
+	{
+		etl::clock timer;
+		for(const char **i = examples; *i; i++)
+			parse(*i);
+		Real time = timer();
+		if (round == 0 || time < best)
+			best = time;
+	}
+	return best;
+}
+
+int main(int argc, char *argv[])
+{
+	if (argc > 1 && String(argv[1]) == "--save-references")
+	{
+		Main synfig_main(dirname(argv[0]));
+		return save_references();
+	}
+
+	// only parse, to measure the memory used
+	if (argc > 1)
+	{
+		int (*parse)(const String &) = String(argv[1]) == "dom" ? parse_dom : parse_stream;
+		for(const char **i = examples; *i; i++)
+			parse(*i);
+		return 0;
+	}
+
+	long dom_memory = peak_memory(argv[0], "dom");
+	long stream_memory = peak_memory(argv[0], "stream");
+
+	int failures = 0;
+	for(const char **i = examples; *i; i++)
+	{
+		failures += reader_test(*i);
+		failures += cache_test(*i);
+	}
+
+	Main synfig_main(dirname(argv[0]));
+	for(const char **i = examples; *i; i++)
+		failures += round_trip_test(*i);
+
+	printf("all examples: DOM %7.1f ms, %6ld kB peak; streaming %7.1f ms, %6ld kB peak\n",
+		parse_time(parse_dom)*1e3, dom_memory, parse_time(parse_stream)*1e3, stream_memory);
+
+	vector<FileSystem::Identifier> copies;
+	for(const char **i = examples; *i; i++)
+		copies.push_back(cached_example(*i));
+	printf("all examples: cached %7.1f ms\n", parse_time(parse_cache)*1e3);
+	for(vector<FileSystem::Identifier>::const_iterator i = copies.begin(); i != copies.end(); ++i)
+		remove_cached_example(*i);
+
+	return failures;
+}
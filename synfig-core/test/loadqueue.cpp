@@ -0,0 +1,147 @@
+/* === S Y N F I G ========================================================= */
+/*!	\file loadqueue.cpp
+**	\brief LoadQueue check and benchmark
+**
+**	$Id$
+**
+**	\legal
+**	Copyright (c) 2016 Synfig contributors
+**
+**	This package is free software; you can redistribute it and/or
+**	modify it under the terms of the GNU General Public License as
+**	published by the Free Software Foundation; either version 2 of
+**	the License, or (at your option) any later version.
+**
+**	This package is distributed in the hope that it will be useful,
+**	but WITHOUT ANY WARRANTY; without even the implied warranty of
+**	MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE. See the GNU
+**	General Public License for more details.
+**	\endlegal
+*/
+/* ========================================================================= */
+
+/* === H E A D E R S ======================================================= */
+
+#ifdef USING_PCH
+#	include "pch.h"
+#else
+#ifdef HAVE_CONFIG_H
+#	include <config.h>
+#endif
+
+#include <cstdio>
+#include <glibmm/thread.h>
+#include <glibmm/timer.h>
+#include <ETL/clock>
+#include <synfig/loadqueue.h>
+#include <synfig/mutex.h>
+#include <synfig/real.h>
+
+#endif
+
+/* === U S I N G =========================================================== */
+
+using namespace std;
+using namespace etl;
+using namespace synfig;
+
+/* === M A C R O S ========================================================= */
+
+#define CHECK(x) \
+	if (!(x)) { printf("%s:%d: check failed: %s\n", __FILE__, __LINE__, #x); failures++; }
+
+#define TASKS		32
+#define TASK_TIME	0.01
+
+/* === G L O B A L S ======================================================= */
+
+static Mutex counter_mutex;
+static int runs, finishes, wrong_thread;
+static Glib::Thread *queue_thread;
+
+/* === C L A S S E S ======================================================= */
+
+//! Stands for a file which takes a while to read
+class SleepTask: public LoadQueue::Task
+{
+public:
+	bool done;
+	SleepTask(): done(false) { }
+
+	virtual void run()
+	{
+		Glib::usleep((unsigned long)(TASK_TIME*1e6));
+		done = true;
+		Mutex::Lock lock(counter_mutex);
+		runs++;
+	}
+
+	virtual void finish()
+	{
+		if (!done || Glib::Thread::self() != queue_thread)
+			wrong_thread++;
+		finishes++;
+	}
+};
+
+/* === P R O C E D U R E S ================================================= */
+
+int queue_test()
+{
+	int failures = 0;
+	runs = finishes = wrong_thread = 0;
+	queue_thread = Glib::Thread::self();
+
+	CHECK(LoadQueue::current() == NULL);
+
+	// without a queue the task is done at once
+	LoadQueue::load(new SleepTask());
+	CHECK(runs == 1 && finishes == 1);
+
+	{
+		LoadQueue queue;
+		CHECK(LoadQueue::current() == &queue);
+
+		LoadQueue::load(new SleepTask());
+		{
+			// an inner queue adds to the outer one
+			LoadQueue inner;
+			CHECK(LoadQueue::current() == &queue);
+			inner.push(new SleepTask());
+		}
+		CHECK(runs == 1);
+
+		for(int i = 0; i < TASKS; i++)
+			queue.push(new SleepTask());
+		CHECK(runs == 1);
+	}
+
+	CHECK(LoadQueue::current() == NULL);
+	CHECK(runs == TASKS + 3);
+	CHECK(finishes == TASKS + 3);
+	CHECK(wrong_thread == 0);
+	return failures;
+}
+
+void benchmark()
+{
+	etl::clock timer;
+	{
+		LoadQueue queue;
+		for(int i = 0; i < TASKS; i++)
+			queue.push(new SleepTask());
+	}
+	Real time = timer();
+
+	printf("%d loads of %.0f ms on %d threads: %.1f ms, %.1fx faster than one after the other\n",
+		TASKS, TASK_TIME*1e3, ThreadPool::instance().get_threads(),
+		time*1e3, TASKS*TASK_TIME/time);
+}
+
+int main()
+{
+	int failures = 0;
+	failures += queue_test();
+	benchmark();
+	return failures;
+}
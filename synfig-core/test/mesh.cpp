@@ -0,0 +1,184 @@
+/* === S Y N F I G ========================================================= */
+/*!	\file mesh.cpp
+**	\brief Mesh coordinate lookup correctness check and benchmark
+**
+**	$Id$
+**
+**	\legal
+**	Copyright (c) 2016 Synfig contributors
+**
+**	This package is free software; you can redistribute it and/or
+**	modify it under the terms of the GNU General Public License as
+**	published by the Free Software Foundation; either version 2 of
+**	the License, or (at your option) any later version.
+**
+**	This package is distributed in the hope that it will be useful,
+**	but WITHOUT ANY WARRANTY; without even the implied warranty of
+**	MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE. See the GNU
+**	General Public License for more details.
+**	\endlegal
+*/
+/* ========================================================================= */
+
+/* === H E A D E R S ======================================================= */
+
+#ifdef USING_PCH
+#	include "pch.h"
+#else
+#ifdef HAVE_CONFIG_H
+#	include <config.h>
+#endif
+
+#include <cstdio>
+#include <cstdlib>
+#include <cmath>
+#include <vector>
+#include <algorithm>
+#include <ETL/clock>
+#include <synfig/mesh.h>
+
+#endif
+
+/* === U S I N G =========================================================== */
+
+using namespace std;
+using namespace etl;
+using namespace synfig;
+
+/* === M A C R O S ========================================================= */
+
+/* === G L O B A L S ======================================================= */
+
+/* === P R O C E D U R E S ================================================= */
+
+Real random_real()
+	{ return (Real)rand()/(Real)RAND_MAX; }
+
+//! A deformed grid of \a side by \a side squares, like the skeleton deformation makes
+/*!	The positions are jittered and swirled, so triangles overlap in world space
+**	and the order of the triangles matters. */
+void build_grid(Mesh &mesh, int side)
+{
+	mesh.clear();
+	for(int j = 0; j <= side; j++)
+		for(int i = 0; i <= side; i++)
+		{
+			Vector tex(i/(Real)side - 0.5, j/(Real)side - 0.5);
+			Real angle = 2.0*(0.5 - tex.mag());
+			Vector pos(tex[0]*cos(angle) - tex[1]*sin(angle), tex[0]*sin(angle) + tex[1]*cos(angle));
+			pos += Vector(random_real() - 0.5, random_real() - 0.5)*(1.5/side);
+			mesh.vertices.push_back(Mesh::Vertex(pos, tex));
+		}
+	for(int j = 0; j < side; j++)
+		for(int i = 0; i < side; i++)
+		{
+			int v0 = j*(side + 1) + i, v1 = v0 + 1, v2 = v1 + side + 1, v3 = v0 + side + 1;
+			mesh.triangles.push_back(Mesh::Triangle(v0, v1, v3));
+			mesh.triangles.push_back(Mesh::Triangle(v1, v2, v3));
+		}
+	mesh.changed();
+}
+
+//! The backward scan of every triangle
+bool scan(const Mesh &mesh, const Vector &src, Vector &dest, bool world)
+{
+	for(Mesh::TriangleList::const_reverse_iterator ri = mesh.triangles.rbegin(); ri != mesh.triangles.rend(); ++ri)
+	{
+		const Mesh::Vertex &a = mesh.vertices[ri->vertices[0]];
+		const Mesh::Vertex &b = mesh.vertices[ri->vertices[1]];
+		const Mesh::Vertex &c = mesh.vertices[ri->vertices[2]];
+		if (world
+		  ? Mesh::transform_coord_world_to_texture(src, dest, a.position, a.tex_coords, b.position, b.tex_coords, c.position, c.tex_coords)
+		  : Mesh::transform_coord_texture_to_world(src, dest, a.position, a.tex_coords, b.position, b.tex_coords, c.position, c.tex_coords))
+			return true;
+	}
+	return false;
+}
+
+bool lookup(const Mesh &mesh, const Vector &src, Vector &dest, bool world)
+{
+	return world
+	     ? mesh.transform_coord_world_to_texture(src, dest)
+	     : mesh.transform_coord_texture_to_world(src, dest);
+}
+
+Vector random_point()
+	{ return Vector(random_real()*1.4 - 0.7, random_real()*1.4 - 0.7); }
+
+//! The lookups must find the same triangle as the backward scan
+int accuracy_test(int side)
+{
+	Mesh mesh;
+	build_grid(mesh, side);
+
+	int failures = 0;
+	for(int k = 0; k < 2; k++)
+	{
+		const bool world = k == 0;
+		for(int i = 0; i < 5000; i++)
+		{
+			// some points exactly on the vertices
+			Vector src = i % 10 ? random_point()
+			           : world ? mesh.vertices[rand() % mesh.vertices.size()].position
+			           : mesh.vertices[rand() % mesh.vertices.size()].tex_coords;
+			Vector a(INFINITY, INFINITY), b(INFINITY, INFINITY);
+			bool found_a = scan(mesh, src, a, world);
+			bool found_b = lookup(mesh, src, b, world);
+			if (found_a != found_b || (found_a && (a[0] != b[0] || a[1] != b[1])))
+				failures++;
+		}
+	}
+
+	if (failures)
+		printf("%d triangles: %d lookups differ\n", (int)mesh.triangles.size(), failures);
+	return failures ? 1 : 0;
+}
+
+void benchmark(int side)
+{
+	Mesh mesh;
+	build_grid(mesh, side);
+	const int triangles = mesh.triangles.size();
+	const int count = 200000;
+	// the scan is slow, a few points are enough
+	const int scan_count = std::max(100, std::min(count, 20000000/triangles));
+	std::vector<Vector> points(count);
+	for(int i = 0; i < count; i++)
+		points[i] = random_point();
+
+	etl::clock timer;
+	Vector dest;
+	for(int i = 0; i < scan_count; i++)
+		scan(mesh, points[i], dest, true);
+	Real scan_time = timer();
+
+	timer.reset();
+	for(int i = 0; i < count; i++)
+		lookup(mesh, points[i], dest, true);
+	Real lookup_time = timer();
+
+	printf("%7d triangles: scan %10.0f lookups/s, grid %10.0f lookups/s\n",
+		triangles, scan_count/scan_time, count/lookup_time);
+}
+
+/* === E N T R Y P O I N T ================================================= */
+
+int main()
+{
+	srand(0);
+
+	int failures = 0;
+	failures += accuracy_test(2);
+	failures += accuracy_test(3);
+	failures += accuracy_test(16);
+	failures += accuracy_test(45);
+
+	benchmark(4);
+	benchmark(16);
+	benchmark(32);
+	benchmark(64);
+	benchmark(128);
+	benchmark(256);
+
+	return failures;
+}
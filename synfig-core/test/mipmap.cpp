@@ -0,0 +1,200 @@
+/* === S Y N F I G ========================================================= */
+/*!	\file mipmap.cpp
+**	\brief Mipmap correctness check and benchmark
+**
+**	$Id$
+**
+**	\legal
+**	Copyright (c) 2016 Synfig contributors
+**
+**	This package is free software; you can redistribute it and/or
+**	modify it under the terms of the GNU General Public License as
+**	published by the Free Software Foundation; either version 2 of
+**	the License, or (at your option) any later version.
+**
+**	This package is distributed in the hope that it will be useful,
+**	but WITHOUT ANY WARRANTY; without even the implied warranty of
+**	MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE. See the GNU
+**	General Public License for more details.
+**	\endlegal
+*/
+/* ========================================================================= */
+
+/* === H E A D E R S ======================================================= */
+
+#ifdef USING_PCH
+#	include "pch.h"
+#else
+#ifdef HAVE_CONFIG_H
+#	include <config.h>
+#endif
+
+#include <cstdio>
+#include <cstdlib>
+#include <cmath>
+#include <algorithm>
+#include <ETL/clock>
+#include <synfig/mipmap.h>
+
+#endif
+
+/* === U S I N G =========================================================== */
+
+using namespace std;
+using namespace etl;
+using namespace synfig;
+
+/* === M A C R O S ========================================================= */
+
+/* === G L O B A L S ======================================================= */
+
+/* === P R O C E D U R E S ================================================= */
+
+Real random_real()
+	{ return (Real)rand()/(Real)RAND_MAX; }
+
+void random_surface(Surface &surface, int w, int h)
+{
+	surface.set_wh(w, h);
+	for(int y = 0; y < h; y++)
+		for(int x = 0; x < w; x++)
+			surface[y][x] = Color(random_real(), random_real(), random_real(), random_real() < 0.2 ? 0.0 : random_real());
+}
+
+Real difference(const Color &a, const Color &b)
+{
+	Color pa = a.premult_alpha(), pb = b.premult_alpha();
+	return max(max(fabs(pa.get_r() - pb.get_r()), fabs(pa.get_g() - pb.get_g())),
+	           max(fabs(pa.get_b() - pb.get_b()), fabs(pa.get_a() - pb.get_a())));
+}
+
+//! Straight color averaged over the texels [x0, x1) x [y0, y1) of \a surface
+Color box_average(const Surface &surface, int x0, int y0, int x1, int y1)
+{
+	Color sum(0, 0, 0, 0);
+	for(int y = y0; y < y1; y++)
+		for(int x = x0; x < x1; x++)
+			sum += surface[y][x].premult_alpha();
+	sum *= 1.0f/((x1 - x0)*(y1 - y0));
+	return sum.get_a() ? sum.demult_alpha() : Color(0, 0, 0, 0);
+}
+
+//! Checks footprints which fall exactly on the texels of a level
+int accuracy_test(int w, int h)
+{
+	Surface surface;
+	random_surface(surface, w, h);
+	Mipmap mipmap;
+	mipmap.build(surface);
+
+	int failures = 0;
+	Real worst = 0;
+
+	// square footprints of 2^k texels
+	for(int size = 1; size < min(w, h); size *= 2)
+	{
+		Mipmap::Sampler sampler(mipmap, surface, size, size);
+		for(int y = 0; y + size <= h; y += size)
+			for(int x = 0; x + size <= w; x += size)
+			{
+				Color c = sampler(x + 0.5f*size - 0.5f, y + 0.5f*size - 0.5f);
+				Real diff = difference(c, box_average(surface, x, y, x + size, y + size));
+				worst = max(worst, diff);
+				if (diff > 1e-5)
+					failures++;
+			}
+	}
+
+	// footprints stretched along either axis
+	for(int size = 2; size <= Mipmap::MAX_ANISOTROPY; size *= 2)
+	{
+		Mipmap::Sampler horizontal(mipmap, surface, size, 1), vertical(mipmap, surface, 1, size);
+		for(int y = 0; y + size <= h; y += size)
+			for(int x = 0; x + size <= w; x += size)
+			{
+				Real diff = max(
+					difference(horizontal(x + 0.5f*size - 0.5f, y), box_average(surface, x, y, x + size, y + 1)),
+					difference(vertical(x, y + 0.5f*size - 0.5f), box_average(surface, x, y, x + 1, y + size)) );
+				worst = max(worst, diff);
+				if (diff > 1e-5)
+					failures++;
+			}
+	}
+
+	// a mipmap built for another size is not reused
+	Surface other(w + 1, h);
+	if (mipmap.build(other))
+		failures++;
+
+	if (failures)
+		printf("%dx%d: %d colors differ, by up to %f\n", w, h, failures, worst);
+	return failures ? 1 : 0;
+}
+
+//! Any footprint over a flat color gives that color back
+int flat_test()
+{
+	const Color color(0.25, 0.5, 0.75, 0.5);
+	Surface surface(37, 23);
+	surface.fill(color);
+	Mipmap mipmap;
+	mipmap.build(surface);
+
+	int failures = 0;
+	for(int i = 0; i < 1000; i++)
+	{
+		Mipmap::Sampler sampler(mipmap, surface, random_real()*64, random_real()*64);
+		if (difference(sampler(random_real()*40 - 2, random_real()*26 - 2), color) > 1e-5)
+			failures++;
+	}
+
+	if (failures)
+		printf("flat: %d colors differ\n", failures);
+	return failures ? 1 : 0;
+}
+
+void benchmark(Real scale)
+{
+	const int w = 2048, h = 2048;
+	const int ow = (int)(w/scale), oh = (int)(h/scale);
+	Surface surface, target(ow, oh);
+	random_surface(surface, w, h);
+
+	etl::clock timer;
+	for(int y = 0; y < oh; y++)
+		for(int x = 0; x < ow; x++)
+			target[y][x] = surface.sample_rect_clip(x*scale, y*scale, (x + 1)*scale, (y + 1)*scale);
+	Real box_time = timer();
+
+	timer.reset();
+	Mipmap mipmap;
+	mipmap.build(surface);
+	Real build_time = timer();
+
+	timer.reset();
+	Mipmap::Sampler sampler(mipmap, surface, scale, scale);
+	for(int y = 0; y < oh; y++)
+		for(int x = 0; x < ow; x++)
+			target[y][x] = sampler((x + 0.5f)*scale - 0.5f, (y + 0.5f)*scale - 0.5f);
+	Real mipmap_time = timer();
+
+	printf("downscale %4.1fx: box filter %8.1f Mpixels/s, mipmap %8.1f Mpixels/s (built in %.1f ms)\n",
+		scale, ow*oh/box_time*1e-6, ow*oh/mipmap_time*1e-6, build_time*1e3);
+}
+
+int main()
+{
+	srand(0);
+
+	int failures = 0;
+	failures += accuracy_test(64, 64);
+	failures += accuracy_test(100, 37);
+	failures += accuracy_test(1, 33);
+	failures += flat_test();
+
+	benchmark(2);
+	benchmark(3.3);
+	benchmark(8);
+
+	return failures;
+}
@@ -0,0 +1,159 @@
+/* === S Y N F I G ========================================================= */
+/*!	\file value.cpp
+**	\brief ValueBase copy semantics check and benchmark
+**
+**	$Id$
+**
+**	\legal
+**	Copyright (c) 2016 Synfig contributors
+**
+**	This package is free software; you can redistribute it and/or
+**	modify it under the terms of the GNU General Public License as
+**	published by the Free Software Foundation; either version 2 of
+**	the License, or (at your option) any later version.
+**
+**	This package is distributed in the hope that it will be useful,
+**	but WITHOUT ANY WARRANTY; without even the implied warranty of
+**	MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE. See the GNU
+**	General Public License for more details.
+**	\endlegal
+*/
+/* ========================================================================= */
+
+/* === H E A D E R S ======================================================= */
+
+#ifdef USING_PCH
+#	include "pch.h"
+#else
+#ifdef HAVE_CONFIG_H
+#	include <config.h>
+#endif
+
+#include <cstdio>
+#include <vector>
+#include <ETL/clock>
+#include <synfig/value.h>
+#include <synfig/vector.h>
+#include <synfig/color.h>
+#include <synfig/time.h>
+#include <synfig/string.h>
+
+#endif
+
+/* === U S I N G =========================================================== */
+
+using namespace std;
+using namespace etl;
+using namespace synfig;
+
+/* === M A C R O S ========================================================= */
+
+#define CHECK(x) \
+	if (!(x)) { printf("%s:%d: check failed: %s\n", __FILE__, __LINE__, #x); failures++; }
+
+/* === G L O B A L S ======================================================= */
+
+static const int ITERATIONS = 1000000;
+
+/* === P R O C E D U R E S ================================================= */
+
+//! Copies of a value are independent of it and compare equal to it
+template<typename T>
+int copy_test(const T &a, const T &b)
+{
+	int failures = 0;
+
+	ValueBase x(a);
+	CHECK(x.is_valid());
+	CHECK(x.get(T()) == a);
+
+	ValueBase y(x);
+	CHECK(y.is_valid());
+	CHECK(y.get_type() == x.get_type());
+	CHECK(y == x);
+	y = b;
+	CHECK(y.get(T()) == b);
+	CHECK(x.get(T()) == a);
+
+	ValueBase z;
+	z = x;
+	CHECK(z == x);
+	z = y;
+	CHECK(z.get(T()) == b);
+	CHECK(x.get(T()) == a);
+
+	x.set(b);
+	CHECK(x == z);
+
+	std::vector<ValueBase> list(8, x);
+	list.push_back(y);
+	list.insert(list.begin(), ValueBase(a));
+	CHECK(list.front().get(T()) == a);
+	CHECK(list.back().get(T()) == b);
+
+	ValueBase w(list);
+	ValueBase v(w);
+	CHECK(v.get_list().size() == list.size());
+	CHECK(v.get_list().front().get(T()) == a);
+
+	x.clear();
+	CHECK(!x.is_valid());
+	CHECK(y.get(T()) == b);
+	return failures;
+}
+
+template<typename T>
+void benchmark(const char *name, const T &a, const T &b)
+{
+	ValueBase x(a), y(b), z;
+
+	etl::clock timer;
+	for(int i = 0; i < ITERATIONS; i++)
+		{ ValueBase copy(i & 1 ? x : y); z = copy; }
+	Real copy_time = timer();
+
+	timer.reset();
+	for(int i = 0; i < ITERATIONS; i++)
+		z = i & 1 ? x : y;
+	Real assign_time = timer();
+
+	timer.reset();
+	for(int i = 0; i < ITERATIONS; i++)
+		z = i & 1 ? a : b;
+	Real set_time = timer();
+
+	timer.reset();
+	int equal = 0;
+	for(int i = 0; i < ITERATIONS; i++)
+		if ((i & 1 ? x : y).get(T()) == a) equal++;
+	Real get_time = timer();
+
+	printf("%-8s copy %7.2f Mops/s, assign %7.2f Mops/s, set %7.2f Mops/s, get %7.2f Mops/s (%d)\n",
+		name, ITERATIONS/copy_time*1e-6, ITERATIONS/assign_time*1e-6,
+		ITERATIONS/set_time*1e-6, ITERATIONS/get_time*1e-6, equal);
+}
+
+int main()
+{
+	Type::subsys_init();
+
+	int failures = 0;
+	failures += copy_test<bool>(false, true);
+	failures += copy_test<int>(1, 2);
+	failures += copy_test<Real>(1.5, 2.5);
+	failures += copy_test<Time>(Time(1), Time(2));
+	failures += copy_test<Angle>(Angle::deg(10), Angle::deg(20));
+	failures += copy_test<Vector>(Vector(1, 2), Vector(3, 4));
+	failures += copy_test<Color>(Color(1, 0, 0, 1), Color(0, 1, 0, 0.5));
+	failures += copy_test<String>("first", "second");
+
+	benchmark<bool>("bool", false, true);
+	benchmark<int>("integer", 1, 2);
+	benchmark<Real>("real", 1.5, 2.5);
+	benchmark<Vector>("vector", Vector(1, 2), Vector(3, 4));
+	benchmark<Color>("color", Color(1, 0, 0, 1), Color(0, 1, 0, 0.5));
+	benchmark<String>("string", "first", "second");
+
+	Type::subsys_stop();
+	return failures;
+}
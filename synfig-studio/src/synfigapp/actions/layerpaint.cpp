@@ -170,6 +170,7 @@ Action::LayerPaint::PaintStroke::add_point_and_apply(const PaintPoint &point)
 		Mutex::Lock lock(layer->mutex);
 		brush_.stroke_to(&wrapper, point.x, point.y, point.pressure, 0.f, 0.f, point.dtime);
 		copy_to_cairo_surface(layer->surface, layer->csurface);
+		layer->surface_changed();
 	}
 
 	if (wrapper.extra_left > 0 || wrapper.extra_top > 0) {
@@ -222,6 +223,7 @@ Action::LayerPaint::PaintStroke::undo()
 		Mutex::Lock lock(layer->mutex);
 		paint_prev(layer->surface);
 		copy_to_cairo_surface(layer->surface, layer->csurface);
+		layer->surface_changed();
 	}
 	applied = false;
 	layer->set_param("tl", ValueBase(tl));
@@ -238,6 +240,7 @@ Action::LayerPaint::PaintStroke::apply()
 		Mutex::Lock lock(layer->mutex);
 		paint_self(layer->surface);
 		copy_to_cairo_surface(layer->surface, layer->csurface);
+		layer->surface_changed();
 	}
 	applied = true;
 	layer->set_param("tl", ValueBase(new_tl));